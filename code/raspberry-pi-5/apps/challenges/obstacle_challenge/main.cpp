@@ -1,14 +1,23 @@
+#include "alloc_counter.h"
 #include "camera_module.h"
 #include "camera_processor.h"
 #include "combined_processor.h"
 #include "direction.h"
 #include "lidar_module.h"
 #include "lidar_processor.h"
+#include "loop_driver.h"
 #include "pico2_module.h"
 #include "pid_controller.h"
 #include "robot_pose_struct.h"
+#include "sensor_replay.h"
+#include "stage_profiler.h"
+#include "task_graph.hpp"
+#include "thread_config.h"
+#include "tick_arena.hpp"
+#include "trace.h"
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
 #include <csignal>
@@ -16,7 +25,9 @@
 #include <iostream>
 #include <map>
 #include <memory>
+#include <memory_resource>
 #include <optional>
+#include <string>
 #include <thread>
 #include <wiringPi.h>
 
@@ -32,11 +43,67 @@ void signalHandler(int signum) {
 // Pins
 const int BUTTON_PIN = 16;
 
+// Threads: the control loop and the Pico2 polling get a core each, the lidar and camera threads share the other two
+// (needs root or CAP_SYS_NICE; without it the threads keep running with the default scheduling).
+// The control thread waits for the perception workers every tick, so they run ahead of the lidar thread on its cores.
+const bool LOCK_MEMORY = true;
+const ThreadConfig CONTROL_THREAD{"control", SchedulingPolicy::FIFO, 80, {3}};
+const ThreadConfig PICO2_THREAD{"pico2", SchedulingPolicy::FIFO, 70, {2}};
+const ThreadConfig LIDAR_THREAD{"lidar", SchedulingPolicy::FIFO, 60, {0, 1}};
+const ThreadConfig CAMERA_THREAD{"camera", SchedulingPolicy::OTHER, 0, {0, 1}};
+const ThreadConfig PERCEPTION_THREAD{"perception", SchedulingPolicy::FIFO, 75, {0, 1}};
+
+// Timeline of every thread, written to trace.json in the run's log folder (open it in ui.perfetto.dev)
+const bool TRACE_TIMELINE = true;
+
 // Camera
 const uint32_t CAM_WIDTH = 1296;
 const uint32_t CAM_HEIGHT = 972;
 const float CAM_HFOV = 98.0f;
 
+// Perception
+const size_t PERCEPTION_WORKERS = 2;  // The control thread runs a third branch of the perception graph itself
+const size_t PERCEPTION_ARENA_BYTES = 64 * 1024;  // Per arena; a full scan's points take ~12 KB
+
+// Stage timing, appended to stage_latency.csv in the run's log folder
+enum Stage : StageProfiler::StageId {
+    UPDATE,
+    FILTER_LIDAR_DATA,
+    APROXIMATE_ROBOT_POSE,
+    GET_LINES,
+    GET_RELATIVE_WALLS,
+    RESOLVE_WALLS,
+    GET_TURN_DIRECTION,
+    GET_TRAFFIC_LIGHT_POINTS,
+    FILTER_COLORS,
+    COMPUTE_BLOCK_ANGLES,
+    PERCEPTION_GRAPH,
+    COMBINE_TRAFFIC_LIGHT_INFO,
+    CLASSIFY_TRAFFIC_LIGHTS,
+    STATE_MACHINE,
+    STAGE_COUNT
+};
+const std::vector<std::string> STAGE_NAMES{
+    "update",
+    "filterLidarData",
+    "aproximateRobotPose",
+    "getLines",
+    "getRelativeWalls",
+    "resolveWalls",
+    "getTurnDirection",
+    "getTrafficLightPoints",
+    "filterColors",
+    "computeBlockAngles",
+    "perceptionGraph",
+    "combineTrafficLightInfo",
+    "classifyTrafficLights",
+    "stateMachine"
+};
+const auto STAGE_REPORT_INTERVAL = std::chrono::seconds(5);
+
+// Only the newest frame is used each tick, so there is no need for 30 full-resolution frames (~113 MB)
+const CameraHistoryOptions CAM_HISTORY{2};  // frameDepth; no thumbnails
+
 const auto cameraOptionCallback = [](lccv::PiCamera &cam) {
     libcamera::ControlList &camControls = cam.getControlList();
 
@@ -158,15 +225,19 @@ public:
         STOP
     };
 
-    Robot(LidarModule &lidar, Pico2Module &pico2, CameraModule &camera, Logger &obstacleChallengeLogger)
+    Robot(LidarSource &lidar, Pico2Source &pico2, CameraSource &camera, Logger &obstacleChallengeLogger, StageProfiler &stageProfiler)
         : lidar_(lidar)
         , pico2_(pico2)
         , camera_(camera)
         , obstacleChallengeLogger_(obstacleChallengeLogger)
+        , stageProfiler_(stageProfiler)
         , headingPid_(HEADING_PID_P, HEADING_PID_I, HEADING_PID_D, -100.0, 100.0)
-        , wallPid_(WALL_PID_P, WALL_PID_I, WALL_PID_D, -90.0, 90.0) {
+        , wallPid_(WALL_PID_P, WALL_PID_I, WALL_PID_D, -90.0, 90.0)
+        , perception_(lidarWallsArena_.resource(), trafficLightPointsArena_.resource(), cameraBlocksArena_.resource())
+        , perceptionWorkers_(PERCEPTION_WORKERS, [this](size_t worker) { startPerceptionWorker(worker); }) {
         headingPid_.setActive(true);
         wallPid_.setActive(true);
+        buildPerceptionGraph();
     }
 
     /**
@@ -174,6 +245,12 @@ public:
      * @param dt The time delta since the last update in seconds.
      */
     void update(float dt) {
+        ScopedStageTimer updateTimer(stageProfiler_, UPDATE);
+        tickAllocations_.reset();
+        perceptionAllocations_.reset();
+        openCvAllocations_.reset();
+        ScopedAllocSink tickSink(tickAllocations_);
+
         auto robotDataOpt = updateRobotData(dt);
         if (!robotDataOpt) {
             // Not enough data yet, do nothing.
@@ -183,6 +260,8 @@ public:
 
         RobotData robotData = *robotDataOpt;
 
+        // The mode step and the steering that follows it
+        ScopedStageTimer stateMachineTimer(stageProfiler_, STATE_MACHINE);
         bool instantUpdate;
         do {
             instantUpdate = false;
@@ -303,14 +382,140 @@ public:
         pico2_.setMovementInfo(motorSpeed_, steeringPercent_);
     }
 
+    /**
+     * @brief Heap allocations of the last update(), on the control thread and the perception workers.
+     *
+     * Leaves out filterColors(), see openCvAllocations().
+     */
+    AllocCounts tickAllocations() const {
+        return tickAllocations_.counts() + perceptionAllocations_.counts();
+    }
+
+    /**
+     * @brief The part of tickAllocations() made by the processors, from the arena reset to the classified traffic lights.
+     *
+     * This section runs on the tick arenas and is meant not to allocate once
+     * warmed up. The mode logic around it still does (the traffic light
+     * history, the debug output), so this is what --fail-on-alloc checks.
+     */
+    AllocCounts perceptionAllocations() const {
+        return perceptionAllocations_.counts();
+    }
+
+    /**
+     * @brief Heap allocations of filterColors() in the last update().
+     *
+     * cv::findContours only fills std::vector, so this stage allocates every
+     * tick that looks for traffic lights and is counted apart from the rest.
+     */
+    AllocCounts openCvAllocations() const {
+        return openCvAllocations_.counts();
+    }
+
+    /**
+     * @brief Jitter of each perception worker, from one tick it takes part in to the next.
+     */
+    std::vector<JitterStats> perceptionJitter() const {
+        std::vector<JitterStats> jitter;
+        for (const auto &worker : perceptionWorkerStats_) {
+            jitter.push_back(worker.jitter.stats());
+        }
+        return jitter;
+    }
+
+    /**
+     * @brief Buffer size and heap fallback of every per-tick arena, by name.
+     */
+    std::vector<std::pair<std::string, TickArenaStats>> arenaStats() const {
+        return {
+            {"lidar walls", lidarWallsArena_.stats()},
+            {"turn direction", turnDirectionArena_.stats()},
+            {"traffic light points", trafficLightPointsArena_.stats()},
+            {"camera blocks", cameraBlocksArena_.stats()},
+            {"fusion", fusionArena_.stats()}
+        };
+    }
+
 private:
-    LidarModule &lidar_;
-    Pico2Module &pico2_;
-    CameraModule &camera_;
+    LidarSource &lidar_;
+    Pico2Source &pico2_;
+    CameraSource &camera_;
     Logger &obstacleChallengeLogger_;
+    StageProfiler &stageProfiler_;
     PIDController headingPid_;
     PIDController wallPid_;
 
+    // Reused every tick so reading the sensor history neither copies nor allocates
+    RingBufferSnapshot<TimedCompactLidarData> lidarSnapshot_;
+    RingBufferSnapshot<TimedFrame> frameSnapshot_;
+    RingBufferSnapshot<TimedPico2Data> pico2Window_;
+    RingBufferSnapshot<TimedPico2Data> pico2Recent_;
+    TimedLidarData timedLidarData_;
+
+    // The temporaries of a tick are allocated from these and dropped all at once at the start of the next tick.
+    // One arena per perception node, since the nodes run at the same time, and one for the fusion on the control thread.
+    TickArena lidarWallsArena_{PERCEPTION_ARENA_BYTES};
+    TickArena turnDirectionArena_{PERCEPTION_ARENA_BYTES};
+    TickArena trafficLightPointsArena_{PERCEPTION_ARENA_BYTES};
+    TickArena cameraBlocksArena_{PERCEPTION_ARENA_BYTES};
+    TickArena fusionArena_{PERCEPTION_ARENA_BYTES};
+
+    // Inputs and outputs of the perception graph, which runs the independent stages of a tick at the same time
+    struct Perception {
+        Perception(
+            std::pmr::memory_resource *lidarWallsMemory,
+            std::pmr::memory_resource *trafficLightPointsMemory,
+            std::pmr::memory_resource *cameraBlocksMemory
+        )
+            : lineSegments(lidarWallsMemory)
+            , trafficLightPoints(trafficLightPointsMemory)
+            , blockAngles(cameraBlocksMemory) {}
+
+        /**
+         * @brief Drop the arena-backed results of the last run, so their arenas can be reset.
+         */
+        void clearResults() {
+            lineSegments = std::pmr::vector<lidar_processor::LineSegment>(lineSegments.get_allocator());
+            trafficLightPoints = std::pmr::vector<cv::Point2f>(trafficLightPoints.get_allocator());
+            blockAngles = std::pmr::vector<camera_processor::BlockAngle>(blockAngles.get_allocator());
+        }
+
+        // Set before each run
+        const TimedLidarData *timedLidarData = nullptr;
+        const TimedFrame *timedFrame = nullptr;
+        float heading = 0.0f;
+        bool detectTurnDirection = false;
+        bool findTrafficLights = false;
+
+        // Filled by the graph
+        TimedLidarData filteredLidarData;
+        RobotDeltaPose deltaPose{};
+        std::pmr::vector<lidar_processor::LineSegment> lineSegments;  ///< In lidarWallsArena_
+        lidar_processor::ResolvedWalls resolvedWalls;
+        std::optional<RotationDirection> detectedTurnDirection;
+        std::pmr::vector<cv::Point2f> trafficLightPoints;           ///< In trafficLightPointsArena_
+        std::pmr::vector<camera_processor::BlockAngle> blockAngles;  ///< In cameraBlocksArena_
+    };
+    Perception perception_;
+    uint64_t perceptionRun_ = 0;  ///< Number of perception graph runs; published to the workers by TaskGraph::run()
+
+    struct PerceptionWorkerStats {
+        JitterMeter jitter;
+        uint64_t lastRun = 0;  ///< Last graph run the worker took part in; only touched by the worker
+    };
+    std::array<PerceptionWorkerStats, PERCEPTION_WORKERS> perceptionWorkerStats_;
+    inline static thread_local PerceptionWorkerStats *currentWorkerStats_ = nullptr;  ///< Set on each perception worker
+
+    ThreadPool perceptionWorkers_;
+    TaskGraph perceptionGraph_{perceptionWorkers_};
+    AllocSink tickAllocations_;        ///< Allocations of the current tick outside the perception section
+    AllocSink perceptionAllocations_;  ///< Allocations of the current tick's processors, from every thread running them
+    AllocSink openCvAllocations_;      ///< Allocations of filterColors() in the current tick
+
+    // The number of samples to look back for the heading rate.
+    // (size - 1) vs (size - 13) is a 12-sample difference.
+    static constexpr size_t HEADING_RATE_LOOKBACK = 12;
+
     // --- State Variables ---
     Mode mode_ = Mode::UNKNOWN;
     Direction headingDirection_ = Direction::NORTH;
@@ -368,26 +573,171 @@ private:
 
     // --- Method Implementations ---
 
+    /**
+     * @brief Declares the perception stages of a tick and what each one waits for.
+     *
+     * The lidar chain (filter and pose, then walls, then traffic light points)
+     * runs next to the camera color masks, and the turn direction detection
+     * next to the walls. The nodes only read the robot state, which the
+     * control thread leaves alone while the graph runs, and write to perception_.
+     * Every stage is timed; the profiler takes records from any thread.
+     */
+    void buildPerceptionGraph() {
+        auto lidarPose = addPerceptionNode("lidar pose", [this] {
+            stageProfiler_.measure(FILTER_LIDAR_DATA, [&] {
+                lidar_processor::filterLidarData(*perception_.timedLidarData, perception_.filteredLidarData);
+            });
+            perception_.deltaPose = stageProfiler_.measure(APROXIMATE_ROBOT_POSE, [&] {
+                return combined_processor::aproximateRobotPose(perception_.filteredLidarData, pico2Window_);
+            });
+        });
+
+        auto lidarWalls = addPerceptionNode(
+            "lidar walls",
+            [this] {
+                perception_.lineSegments = stageProfiler_.measure(GET_LINES, [&] {
+                    return lidar_processor::getLines(
+                        perception_.filteredLidarData,
+                        perception_.deltaPose,
+                        lidarWallsArena_.resource(),
+                        0.05f,
+                        10,
+                        0.10f,
+                        0.10f,
+                        18.0f,
+                        0.20f
+                    );
+                });
+                auto relativeWalls = stageProfiler_.measure(GET_RELATIVE_WALLS, [&] {
+                    return lidar_processor::getRelativeWalls(
+                        perception_.lineSegments,
+                        headingDirection_,
+                        perception_.heading,
+                        lidarWallsArena_.resource(),
+                        0.30f,
+                        25.0f,
+                        0.22f
+                    );
+                });
+                perception_.resolvedWalls =
+                    stageProfiler_.measure(RESOLVE_WALLS, [&] { return lidar_processor::resolveWalls(relativeWalls); });
+            },
+            {lidarPose}
+        );
+
+        // TODO: Test this more extensively
+        addPerceptionNode(
+            "turn direction",
+            [this] {
+                if (!perception_.detectTurnDirection) return;
+                // The whole detection, which runs its own getLines and getRelativeWalls on the unfiltered scan
+                ScopedStageTimer timer(stageProfiler_, GET_TURN_DIRECTION);
+                auto unfilteredLineSegments = lidar_processor::getLines(
+                    *perception_.timedLidarData,
+                    perception_.deltaPose,
+                    turnDirectionArena_.resource(),
+                    0.05f,
+                    10,
+                    0.10f,
+                    0.10f,
+                    18.0f,
+                    0.20f
+                );
+                auto unfilteredRelativeWalls = lidar_processor::getRelativeWalls(
+                    unfilteredLineSegments,
+                    headingDirection_,
+                    perception_.heading,
+                    turnDirectionArena_.resource(),
+                    0.30f,
+                    25.0f,
+                    0.22f
+                );
+                perception_.detectedTurnDirection = lidar_processor::getTurnDirection(unfilteredRelativeWalls);
+            },
+            {lidarPose}
+        );
+
+        addPerceptionNode(
+            "traffic light points",
+            [this] {
+                if (!perception_.findTrafficLights) return;
+                ScopedStageTimer timer(stageProfiler_, GET_TRAFFIC_LIGHT_POINTS);
+                perception_.trafficLightPoints = lidar_processor::getTrafficLightPoints(
+                    perception_.filteredLidarData,
+                    perception_.resolvedWalls,
+                    perception_.deltaPose,
+                    turnDirection_,
+                    trafficLightPointsArena_.resource()
+                );
+            },
+            {lidarWalls}
+        );
+
+        addPerceptionNode("camera blocks", [this] {
+            if (!perception_.findTrafficLights) return;
+            auto colorMasks = stageProfiler_.measure(FILTER_COLORS, [&] {
+                ScopedAllocSink openCvSink(openCvAllocations_);
+                return camera_processor::filterColors(*perception_.timedFrame);
+            });
+            perception_.blockAngles = stageProfiler_.measure(COMPUTE_BLOCK_ANGLES, [&] {
+                return camera_processor::computeBlockAngles(colorMasks, cameraBlocksArena_.resource(), CAM_WIDTH, CAM_HFOV);
+            });
+        });
+    }
+
+    /**
+     * @brief Runs on each perception worker when it starts.
+     *
+     * The workers would otherwise inherit whatever scheduling the thread
+     * constructing the Robot has, and the control thread waits for them.
+     */
+    void startPerceptionWorker(size_t worker) {
+        applyThreadConfig(PERCEPTION_THREAD);
+        trace::registerThread();
+        currentWorkerStats_ = &perceptionWorkerStats_[worker];
+    }
+
+    /**
+     * @brief Adds a node to the perception graph whose allocations count towards the perception section, whichever thread runs it.
+     */
+    TaskGraph::NodeId addPerceptionNode(
+        const std::string &name,
+        std::function<void()> work,
+        const std::vector<TaskGraph::NodeId> &dependencies = {}
+    ) {
+        return perceptionGraph_.addNode(
+            name,
+            [this, work = std::move(work)] {
+                // A worker marks its jitter at the first node it runs in a tick
+                PerceptionWorkerStats *worker = currentWorkerStats_;
+                if (worker && worker->lastRun != perceptionRun_) {
+                    worker->lastRun = perceptionRun_;
+                    worker->jitter.mark();
+                }
+
+                ScopedAllocSink perceptionSink(perceptionAllocations_);
+                work();
+            },
+            dependencies
+        );
+    }
+
     /**
      * @brief Calculates the recent rate of heading change in degrees per second.
      *
      * It compares the latest heading measurement with one from a fixed number of samples
      * in the past to determine the angular velocity.
      *
-     * @param picoHistory The vector of recent pico2 data points.
+     * @param picoHistory The newest HEADING_RATE_LOOKBACK + 1 pico2 data points.
      * @return The angular velocity in degrees per second.
      */
-    float calculateRecentHeadingRate(const std::vector<TimedPico2Data> &picoHistory) {
-        // The number of samples to look back for the calculation.
-        // (size - 1) vs (size - 13) is a 12-sample difference.
-        const size_t HEADING_RATE_LOOKBACK = 12;
-
+    float calculateRecentHeadingRate(const RingBufferSnapshot<TimedPico2Data> &picoHistory) {
         if (picoHistory.size() < HEADING_RATE_LOOKBACK + 1) {
             return 0.0f;  // Not enough data to compute
         }
 
-        const auto &latestData = picoHistory.back();
-        const auto &olderData = picoHistory[picoHistory.size() - 1 - HEADING_RATE_LOOKBACK];
+        const auto &latestData = *picoHistory.back();
+        const auto &olderData = *picoHistory[picoHistory.size() - 1 - HEADING_RATE_LOOKBACK];
 
         // Calculate the shortest angle difference (handles 360->0 wrap-around)
         float diff_deg = latestData.euler.h - olderData.euler.h;
@@ -406,30 +756,25 @@ private:
     }
 
     std::optional<RobotData> updateRobotData(float dt) {
-        std::vector<TimedLidarData> timedLidarDatas;
-        lidar_.getAllTimedLidarData(timedLidarDatas);
-        if (timedLidarDatas.size() < lidar_.bufferSize()) return std::nullopt;
+        if (!lidar_.getCompactSnapshot(lidarSnapshot_)) return std::nullopt;
 
-        std::vector<TimedPico2Data> timedPico2Datas;
-        pico2_.getAllTimedData(timedPico2Datas);
-        if (timedPico2Datas.size() < pico2_.bufferSize()) return std::nullopt;
+        // Only the newest scan is expanded to floats, into the buffer of the previous tick
+        lidarSnapshot_.back()->expand(timedLidarData_);
+        const TimedLidarData &timedLidarData = timedLidarData_;
 
-        std::vector<TimedFrame> timedFrames;
-        camera_.getAllTimedFrame(timedFrames);
-        if (timedFrames.size() < camera_.bufferSize()) return std::nullopt;
+        // Pose integration only needs the Pico2 samples since the scan, the heading rate only the last few
+        if (!pico2_.getSnapshotSince(timedLidarData.timestamp, pico2Window_)) return std::nullopt;
+        if (!pico2_.getLatestSnapshot(HEADING_RATE_LOOKBACK + 1, pico2Recent_)) return std::nullopt;
 
-        auto &timedLidarData = timedLidarDatas.back();
-        auto &timedPico2Data = timedPico2Datas.back();
-        auto &timedFrame = timedFrames.back();
+        if (!camera_.getFrameSnapshot(frameSnapshot_)) return std::nullopt;
+
+        const TimedPico2Data &timedPico2Data = *pico2Window_.back();
+        const TimedFrame &timedFrame = *frameSnapshot_.back();
 
         // Log main loop timestamp
         auto now = std::chrono::steady_clock::now();
         uint64_t timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
-        struct {
-            uint64_t lidarTimestamp_ns;
-            uint64_t pico2Timestamp_ns;
-            uint64_t cameraTimestamp_ns;
-        } obstacleChallengeData{
+        log_records::LoopTimestampsRecord obstacleChallengeData{
             static_cast<uint64_t>(
                 std::chrono::duration_cast<std::chrono::nanoseconds>(timedLidarData.timestamp.time_since_epoch()).count()
             ),
@@ -438,7 +783,7 @@ private:
             ),
             static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(timedFrame.timestamp.time_since_epoch()).count())
         };
-        obstacleChallengeLogger_.writeData(timestamp_ns, &obstacleChallengeData, sizeof(obstacleChallengeData));
+        obstacleChallengeLogger_.writeRecord(timestamp_ns, obstacleChallengeData);
 
         if (!initialHeading_) {
             initialHeading_ = timedPico2Data.euler.h;
@@ -451,19 +796,38 @@ private:
         if (data.heading < 0.0f) data.heading += 360.0f;
         data.encoderAngle = timedPico2Data.encoderAngle;
 
-        auto filteredLidarData = lidar_processor::filterLidarData(timedLidarData);
-        auto deltaPose = combined_processor::aproximateRobotPose(filteredLidarData, timedPico2Datas);
-        auto lineSegments = lidar_processor::getLines(filteredLidarData, deltaPose, 0.05f, 10, 0.10f, 0.10f, 18.0f, 0.20f);
-        auto relativeWalls = lidar_processor::getRelativeWalls(lineSegments, headingDirection_, data.heading, 0.30f, 25.0f, 0.22f);
-        auto resolvedWalls = lidar_processor::resolveWalls(relativeWalls);
+        // The traffic light gate only depends on state from before this tick: mode_ leaves UNKNOWN below,
+        // but only for an unpark mode, which skips traffic lights anyway
+        float headingRate = calculateRecentHeadingRate(pico2Recent_);
+        // FIXME: Changing from 10.0f to 20.0f
+        // if (mode_ != Mode::TURNING && turnDirection_ && abs(headingRate) <= 10.0f) {
+
+        bool isCorrectMode = (mode_ != Mode::UNKNOWN) and (mode_ != Mode::TURNING) and (mode_ != Mode::CW_UNPARK_1) and
+                             (mode_ != Mode::CW_UNPARK_2) and (mode_ != Mode::CCW_UNPARK_1) and (mode_ != Mode::CCW_UNPARK_2);
+        bool isPushingLap = turnCount_ >= 5;
 
-        // TODO: Test this more extensively
-        if (!turnDirection_) {
-            auto unfilteredLineSegments = lidar_processor::getLines(timedLidarData, deltaPose, 0.05f, 10, 0.10f, 0.10f, 18.0f, 0.20f);
-            auto unfilteredRelativeWalls =
-                lidar_processor::getRelativeWalls(unfilteredLineSegments, headingDirection_, data.heading, 0.30f, 25.0f, 0.22f);
-            turnDirection_ = lidar_processor::getTurnDirection(unfilteredRelativeWalls);
+        {
+            ScopedAllocSink perceptionSink(perceptionAllocations_);
+
+            // The results of the previous tick are dropped before their arenas are reused
+            perception_.clearResults();
+            for (TickArena *arena :
+                 {&lidarWallsArena_, &turnDirectionArena_, &trafficLightPointsArena_, &cameraBlocksArena_, &fusionArena_})
+            {
+                arena->reset();
+            }
+
+            perception_.timedLidarData = &timedLidarData;
+            perception_.timedFrame = &timedFrame;
+            perception_.heading = data.heading;
+            perception_.detectTurnDirection = !turnDirection_;
+            perception_.findTrafficLights = isCorrectMode && turnDirection_ && abs(headingRate) <= 20.0f && (!isPushingLap);
+            perceptionRun_++;
+            stageProfiler_.measure(PERCEPTION_GRAPH, [this] { perceptionGraph_.run(); });
         }
+
+        const auto &resolvedWalls = perception_.resolvedWalls;
+        if (!turnDirection_) turnDirection_ = perception_.detectedTurnDirection;
         if (!turnDirection_) return std::nullopt;
 
         if (mode_ == Mode::UNKNOWN) {
@@ -481,25 +845,26 @@ private:
             data.innerWall = (*turnDirection_ == RotationDirection::CLOCKWISE) ? resolvedWalls.rightWall : resolvedWalls.leftWall;
         }
 
-        using namespace std::chrono_literals;
-        float headingRate = calculateRecentHeadingRate(timedPico2Datas);
-        // FIXME: Changing from 10.0f to 20.0f
-        // if (mode_ != Mode::TURNING && turnDirection_ && abs(headingRate) <= 10.0f) {
-
-        bool isCorrectMode = (mode_ != Mode::TURNING) and (mode_ != Mode::CW_UNPARK_1) and (mode_ != Mode::CW_UNPARK_2) and
-                             (mode_ != Mode::CCW_UNPARK_1) and (mode_ != Mode::CCW_UNPARK_2);
-        bool isPushingLap = turnCount_ >= 5;
-        if (isCorrectMode && turnDirection_ && abs(headingRate) <= 20.0f && (!isPushingLap)) {
-            auto trafficLightPoints = lidar_processor::getTrafficLightPoints(filteredLidarData, resolvedWalls, deltaPose, turnDirection_);
-            auto colorMasks = camera_processor::filterColors(timedFrame);
-            auto blockAngles = camera_processor::computeBlockAngles(colorMasks, CAM_WIDTH, CAM_HFOV);
-            auto trafficLightInfos = combined_processor::combineTrafficLightInfo(blockAngles, trafficLightPoints);
-            auto classifiedLights = combined_processor::classifyTrafficLights(
-                trafficLightInfos,
-                resolvedWalls,
-                *turnDirection_,
-                Segment::fromDirection(headingDirection_)
-            );
+        if (perception_.findTrafficLights) {
+            // Both branches of the perception graph have joined by now
+            auto trafficLightInfos = stageProfiler_.measure(COMBINE_TRAFFIC_LIGHT_INFO, [&] {
+                ScopedAllocSink perceptionSink(perceptionAllocations_);
+                return combined_processor::combineTrafficLightInfo(
+                    perception_.blockAngles,
+                    perception_.trafficLightPoints,
+                    fusionArena_.resource()
+                );
+            });
+            auto classifiedLights = stageProfiler_.measure(CLASSIFY_TRAFFIC_LIGHTS, [&] {
+                ScopedAllocSink perceptionSink(perceptionAllocations_);
+                return combined_processor::classifyTrafficLights(
+                    trafficLightInfos,
+                    resolvedWalls,
+                    *turnDirection_,
+                    Segment::fromDirection(headingDirection_),
+                    fusionArena_.resource()
+                );
+            });
 
             for (const auto &cl : classifiedLights) {
                 // DEBUG
@@ -572,8 +937,10 @@ private:
         }
 
         if (mode_ == Mode::CW_FIND_PARKING || mode_ == Mode::CCW_FIND_PARKING) {
-            auto lineSegmentsForParking = lidar_processor::getLines(filteredLidarData, deltaPose, 0.05f, 10, 0.10f, 0.10f, 18.0f, 0.20f);
-            data.parkingWalls = lidar_processor::getParkingWalls(lineSegmentsForParking, headingDirection_, data.heading, 0.30f);
+            // Same parameters as the wall lines, so the graph's segments are reused
+            auto parkingWalls =
+                lidar_processor::getParkingWalls(perception_.lineSegments, headingDirection_, data.heading, fusionArena_.resource(), 0.30f);
+            data.parkingWalls.assign(parkingWalls.begin(), parkingWalls.end());
         }
 
         return data;
@@ -1344,75 +1711,179 @@ private:
 
 // --- Main Function ---
 
-int main() {
+int main(int argc, char **argv) {
     std::signal(SIGINT, signalHandler);
 
+    // --replay runs the robot again on the sensor logs of a previous run, with no hardware attached
+    std::optional<std::string> replayFolder;
+    double replaySpeed = 1.0;
+    // --fail-on-alloc stops a replay at the first tick after the warm-up whose perception section allocates
+    std::optional<uint64_t> allocCheckWarmup;
+    bool validArgs = true;
+    for (int i = 1; i < argc && validArgs; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--replay" && i + 1 < argc) {
+            replayFolder = argv[++i];
+        } else if (arg == "--speed" && i + 1 < argc) {
+            replaySpeed = std::stod(argv[++i]);
+        } else if (arg == "--fail-on-alloc" && i + 1 < argc) {
+            allocCheckWarmup = std::stoull(argv[++i]);
+        } else {
+            validArgs = false;
+        }
+    }
+    if (!validArgs || (allocCheckWarmup && !replayFolder)) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--replay log_folder [--speed factor (0 = as fast as possible)] [--fail-on-alloc warmup_ticks]]" << std::endl;
+        return -1;
+    }
+
     const char *home = std::getenv("HOME");
     if (!home) {
         std::cerr << "HOME environment variable not set" << std::endl;
         return -1;
     }
-    std::string logFolder = std::string(home) + "/gfm_logs/obstacle_challenge";
+    // Replayed runs are logged apart from the real ones
+    std::string logFolder = std::string(home) + (replayFolder ? "/gfm_logs/obstacle_challenge_replay" : "/gfm_logs/obstacle_challenge");
     std::string timedstampedLogFolder = Logger::generateTimestampedFolder(logFolder);
 
-    Logger lidarLogger(timedstampedLogFolder + "/lidar.bin");
-    Logger pico2Logger(timedstampedLogFolder + "/pico2.bin");
-    Logger cameraLogger(timedstampedLogFolder + "/camera.bin");
-    Logger obstacleChallengeLogger(timedstampedLogFolder + "/obstacleChallenge.bin");
-
-    LidarModule lidar(&lidarLogger);
-    Pico2Module pico2(&pico2Logger);
-    CameraModule camera(&cameraLogger, cameraOptionCallback);
-
-    if (!lidar.initialize() || !lidar.start()) {
-        std::cerr << "LidarModule initialization failed." << std::endl;
-        return -1;
-    }
-    if (!pico2.initialize()) {
-        std::cerr << "Pico2Module initialization failed." << std::endl;
-        return -1;
+    // Before the loggers and sensor threads start, so all their threads are on the timeline
+    if (TRACE_TIMELINE) trace::start(timedstampedLogFolder + "/trace.json");
+
+    // Loggers drain to disk on their own writer thread so SD card stalls never reach the sensor threads
+    const Logger::AsyncOptions sensorLogOptions{4 * 1024 * 1024, Logger::BackpressurePolicy::DROP_NEWEST};
+    const Logger::AsyncOptions cameraLogOptions{32 * 1024 * 1024, Logger::BackpressurePolicy::DROP_NEWEST};
+    Logger lidarLogger(timedstampedLogFolder + "/lidar.bin", sensorLogOptions);
+    Logger pico2Logger(timedstampedLogFolder + "/pico2.bin", sensorLogOptions);
+    Logger cameraLogger(timedstampedLogFolder + "/camera.bin", cameraLogOptions);
+    Logger obstacleChallengeLogger(timedstampedLogFolder + "/obstacleChallenge.bin", sensorLogOptions);
+
+    // Before the sensor threads start, so their buffers are locked too. Not for a replay: it would lock every mapped log in RAM
+    if (LOCK_MEMORY && !replayFolder) lockProcessMemory();
+
+    // OpenCV starts its worker pool on first use, and new threads inherit the scheduling and CPUs of their creator:
+    // start it from here, so the workers are not pinned next to the camera or the control loop
+    cv::parallel_for_(cv::Range(0, cv::getNumThreads()), [](const cv::Range &) {});
+
+    // Declared before the modules so it outlives their threads, which notify it
+    LoopDriver loopDriver(std::chrono::milliseconds(33));  // ~30 Hz when no new scan arrives
+
+    // The robot only sees the sensor interfaces, backed by the hardware modules or by a replay of the logs
+    std::unique_ptr<LidarModule> lidarModule;
+    std::unique_ptr<Pico2Module> pico2Module;
+    std::unique_ptr<CameraModule> cameraModule;
+    std::unique_ptr<SensorReplay> replay;
+    if (replayFolder) {
+        replay = std::make_unique<SensorReplay>(
+            *replayFolder,
+            &lidarLogger,
+            &pico2Logger,
+            &cameraLogger,
+            ReplayOptions{replaySpeed, CAM_HISTORY}
+        );
+    } else {
+        lidarModule = std::make_unique<LidarModule>(&lidarLogger);
+        pico2Module = std::make_unique<Pico2Module>(&pico2Logger);
+        cameraModule = std::make_unique<CameraModule>(&cameraLogger, cameraOptionCallback, 2, CAM_HISTORY);
     }
-    if (!camera.start()) {
-        std::cerr << "CameraModule failed to start." << std::endl;
-        return -1;
+    LidarSource &lidar = replay ? static_cast<LidarSource &>(replay->lidar()) : *lidarModule;
+    Pico2Source &pico2 = replay ? static_cast<Pico2Source &>(replay->pico2()) : *pico2Module;
+    CameraSource &camera = replay ? static_cast<CameraSource &>(replay->camera()) : *cameraModule;
+
+    loopDriver.addTrigger("lidar", [&lidar] { return lidar.sequence(); });
+    lidar.setUpdateSignal(&loopDriver.signal());
+    lidar.setThreadConfig(LIDAR_THREAD);
+    pico2.setThreadConfig(PICO2_THREAD);
+    camera.setThreadConfig(CAMERA_THREAD);
+
+    if (!replay) {
+        if (!lidarModule->initialize() || !lidarModule->start()) {
+            std::cerr << "LidarModule initialization failed." << std::endl;
+            return -1;
+        }
+        if (!pico2Module->initialize()) {
+            std::cerr << "Pico2Module initialization failed." << std::endl;
+            return -1;
+        }
+        if (!cameraModule->start()) {
+            std::cerr << "CameraModule failed to start." << std::endl;
+            return -1;
+        }
     }
 
-    Robot robot(lidar, pico2, camera, obstacleChallengeLogger);
+    StageProfiler stageProfiler(STAGE_NAMES);
+    Robot robot(lidar, pico2, camera, obstacleChallengeLogger, stageProfiler);
 
-    if (wiringPiSetupGpio() == -1) {
-        std::cerr << "WiringPi setup failed." << std::endl;
-        return -1;
-    }
-    pinMode(BUTTON_PIN, INPUT);
-    pullUpDnControl(BUTTON_PIN, PUD_UP);
+    // A replay has no button: it starts right away
+    if (!replay) {
+        if (wiringPiSetupGpio() == -1) {
+            std::cerr << "WiringPi setup failed." << std::endl;
+            return -1;
+        }
+        pinMode(BUTTON_PIN, INPUT);
+        pullUpDnControl(BUTTON_PIN, PUD_UP);
 
-    std::cout << "Press the button to start..." << std::endl;
-    while (digitalRead(BUTTON_PIN) == HIGH && !stop_flag) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::cout << "Press the button to start..." << std::endl;
+        while (digitalRead(BUTTON_PIN) == HIGH && !stop_flag) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
     }
 
+    JitterMeter controlJitter;
+    AllocTally tickAllocations;
+    AllocTally perceptionAllocations;
+    AllocTally openCvAllocations;
+    uint64_t ticks = 0;
+    bool allocatingTick = false;
     if (!stop_flag) {
-        std::cout << "Starting in 1.0 seconds..." << std::endl;
-        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        if (!replay) {
+            std::cout << "Starting in 1.0 seconds..." << std::endl;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        }
 
         lidar.startLogging();
         pico2.startLogging();
         camera.startLogging();
 
-        const auto loopDuration = std::chrono::milliseconds(33);  // ~30 Hz
+        // Before the control thread turns real-time, so the reporting thread does not inherit it
+        stageProfiler.startReporting(timedstampedLogFolder + "/stage_latency.csv", STAGE_REPORT_INTERVAL);
+
+        // Once logging is on, so the replayed run is logged from its first sample
+        if (replay && !replay->start()) {
+            std::cerr << "SensorReplay failed to start." << std::endl;
+            return -1;
+        }
+
+        applyThreadConfig(CONTROL_THREAD);
+
         auto lastTime = std::chrono::steady_clock::now();
         std::cout << "Robot running." << std::endl;
         while (!stop_flag) {
-            auto loopStart = std::chrono::steady_clock::now();
-            float dt = std::chrono::duration<float>(loopStart - lastTime).count();
-            lastTime = loopStart;
+            // Run as soon as a new scan is in, or one loop period after the previous tick at the latest
+            loopDriver.waitForTick();
+            if (replay && replay->finished()) break;
+            controlJitter.mark();
+
+            auto now = std::chrono::steady_clock::now();
+            float dt = std::chrono::duration<float>(now - lastTime).count();
+            lastTime = now;
 
             robot.update(dt);
 
-            auto elapsed = std::chrono::steady_clock::now() - loopStart;
-            if (elapsed < loopDuration) {
-                std::this_thread::sleep_for(loopDuration - elapsed);
+            AllocCounts allocations = robot.tickAllocations();
+            tickAllocations.add(allocations);
+            openCvAllocations.add(robot.openCvAllocations());
+            trace::counter("tick allocations", static_cast<double>(allocations.allocations));
+
+            AllocCounts perception = robot.perceptionAllocations();
+            perceptionAllocations.add(perception);
+            if (allocCheckWarmup && ticks >= *allocCheckWarmup && perception.allocations > 0) {
+                std::cerr << "[AllocCounter] Tick " << ticks << " allocated " << perception.allocations << " times (" << perception.bytes
+                          << " bytes) in the perception section" << std::endl;
+                allocatingTick = true;
+                break;
             }
+            ++ticks;
         }
     } else {
         std::filesystem::remove_all(timedstampedLogFolder);
@@ -1421,11 +1892,83 @@ int main() {
 
     std::cout << "Shutting down..." << std::endl;
     pico2.setMovementInfo(0.0f, 0.0f);
-    lidar.stop();
-    lidar.shutdown();
-    pico2.shutdown();
-    camera.stop();
+    stageProfiler.stopReporting();
+    if (replay) {
+        replay->stop();
+    } else {
+        lidarModule->stop();
+        lidarModule->shutdown();
+        pico2Module->shutdown();
+        cameraModule->stop();
+    }
+    trace::stop();
     std::cout << "Shutdown complete." << std::endl;
+    auto printLoggerDrops = [](const char *name, const Logger &logger) {
+        std::cout << "[Logger] " << name << " dropped " << logger.droppedRecords() << " records (" << logger.droppedBytes() << " bytes)"
+                  << std::endl;
+    };
+    printLoggerDrops("lidar.bin", lidarLogger);
+    printLoggerDrops("pico2.bin", pico2Logger);
+    printLoggerDrops("camera.bin", cameraLogger);
+    printLoggerDrops("obstacleChallenge.bin", obstacleChallengeLogger);
+    if (cameraModule) std::cout << "[CameraModule] dropped " << cameraModule->droppedLogFrames() << " frames before encoding" << std::endl;
+    PoolStats scanPool = lidar.scanPoolStats();
+    std::cout << "[LidarModule] scan pool " << scanPool.hits << " hits, " << scanPool.misses << " misses (" << scanPool.size << " scans)"
+              << std::endl;
+    LoopDriver::Stats loopStats = loopDriver.stats();
+    double savedMean_ms = loopStats.triggeredTicks > 0 ? loopStats.savedTotal_ms / loopStats.triggeredTicks : 0.0;
+    std::cout << "[LoopDriver] " << loopStats.triggeredTicks << " of " << loopStats.ticks << " ticks woken by a scan, " << savedMean_ms
+              << " ms earlier on average (max " << loopStats.savedMax_ms << " ms)" << std::endl;
+    auto printJitter = [](const char *name, const JitterStats &jitter) {
+        std::cout << "[ThreadConfig] " << name << " thread " << jitter.intervals << " intervals, mean " << jitter.mean_ms << " ms, jitter "
+                  << jitter.stddev_ms << " ms (min " << jitter.min_ms << " ms, max " << jitter.max_ms << " ms)" << std::endl;
+    };
+    printJitter("control", controlJitter.stats());
+    printJitter("pico2", pico2.threadJitter());
+    printJitter("lidar", lidar.threadJitter());
+    printJitter("camera", camera.threadJitter());
+    std::vector<JitterStats> perceptionJitter = robot.perceptionJitter();
+    for (size_t i = 0; i < perceptionJitter.size(); ++i) {
+        printJitter(("perception " + std::to_string(i)).c_str(), perceptionJitter[i]);
+    }
+    auto printPeriodic = [](const char *name, const PeriodicStats &stats) {
+        std::cout << "[PeriodicExecutor] " << name << " " << stats.periods << " periods, " << stats.overruns << " overruns ("
+                  << stats.missedPeriods << " periods missed), lateness p50/p99/max " << stats.latenessP50_us << "/" << stats.latenessP99_us
+                  << "/" << stats.latenessMax_us << " us, jitter p50/p99/max " << stats.jitterP50_us << "/" << stats.jitterP99_us << "/"
+                  << stats.jitterMax_us << " us" << std::endl;
+    };
+    printPeriodic("control (period ticks)", loopDriver.periodStats());
+    if (pico2Module) printPeriodic("pico2", pico2Module->pollingStats());
+    trace::TraceStats traceStats = trace::stats();
+    std::cout << "[Trace] " << traceStats.events << " events from " << traceStats.threads << " threads, " << traceStats.dropped
+              << " dropped" << std::endl;
+    for (const StageStats &stage : stageProfiler.stats()) {
+        std::cout << "[StageProfiler] " << stage.name << " " << stage.count << " runs, mean " << stage.mean_us << " us, p50/p99/max "
+                  << stage.p50_us << "/" << stage.p99_us << "/" << stage.max_us << " us, " << stage.allocations << " allocations ("
+                  << stage.allocatedBytes << " bytes) per run" << std::endl;
+    }
+    AllocTallyStats tickAllocationStats = tickAllocations.stats();
+    std::cout << "[AllocCounter] " << tickAllocationStats.allocatingSamples << " of " << tickAllocationStats.samples
+              << " control ticks allocated, mean " << tickAllocationStats.meanAllocations << " allocations ("
+              << tickAllocationStats.meanBytes << " bytes) per tick, max " << tickAllocationStats.maxAllocations << " ("
+              << tickAllocationStats.maxBytes << " bytes)" << std::endl;
+    AllocTallyStats perceptionAllocationStats = perceptionAllocations.stats();
+    std::cout << "[AllocCounter] perception section allocated in " << perceptionAllocationStats.allocatingSamples << " ticks, mean "
+              << perceptionAllocationStats.meanAllocations << " allocations (" << perceptionAllocationStats.meanBytes << " bytes) per tick"
+              << std::endl;
+    AllocTallyStats openCvAllocationStats = openCvAllocations.stats();
+    std::cout << "[AllocCounter] filterColors (not counted above) allocated in " << openCvAllocationStats.allocatingSamples
+              << " ticks, mean " << openCvAllocationStats.meanAllocations << " allocations (" << openCvAllocationStats.meanBytes
+              << " bytes) per tick" << std::endl;
+    for (const auto &[name, arena] : robot.arenaStats()) {
+        std::cout << "[TickArena] " << name << " " << arena.capacity << " bytes, " << arena.overflows << " heap fallbacks ("
+                  << arena.overflowBytes << " bytes)" << std::endl;
+    }
+    if (cameraModule) {
+        PoolStats framePool = cameraModule->framePoolStats();
+        std::cout << "[CameraModule] frame pool " << framePool.hits << " hits, " << framePool.misses << " times dry (" << framePool.size
+                  << " frames)" << std::endl;
+    }
 
-    return 0;
+    return allocatingTick ? -1 : 0;
 }
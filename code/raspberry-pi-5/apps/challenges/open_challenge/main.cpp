@@ -2,9 +2,13 @@
 #include "lidar_module.h"
 #include "lidar_processor.h"
 #include "lidar_struct.h"
+#include "loop_driver.h"
 #include "pico2_module.h"
 #include "pico2_struct.h"
 #include "pid_controller.h"
+#include "sensor_replay.h"
+#include "thread_config.h"
+#include "trace.h"
 
 #include <atomic>
 #include <chrono>
@@ -13,6 +17,7 @@
 #include <iostream>
 #include <memory>
 #include <optional>
+#include <string>
 #include <thread>
 #include <wiringPi.h>
 
@@ -28,6 +33,16 @@ void signalHandler(int signum) {
 // Pins
 const int BUTTON_PIN = 16;
 
+// Threads: the control loop and the Pico2 polling get a core each, the lidar thread gets the other two
+// (needs root or CAP_SYS_NICE; without it the threads keep running with the default scheduling)
+const bool LOCK_MEMORY = true;
+const ThreadConfig CONTROL_THREAD{"control", SchedulingPolicy::FIFO, 80, {3}};
+const ThreadConfig PICO2_THREAD{"pico2", SchedulingPolicy::FIFO, 70, {2}};
+const ThreadConfig LIDAR_THREAD{"lidar", SchedulingPolicy::FIFO, 60, {0, 1}};
+
+// Timeline of every thread, written to trace.json in the run's log folder (open it in ui.perfetto.dev)
+const bool TRACE_TIMELINE = true;
+
 // Robot Control Parameters
 
 const float TARGET_OUTER_WALL_DISTANCE = 0.30f;
@@ -80,7 +95,7 @@ public:
         STOP
     };
 
-    Robot(LidarModule &lidar, Pico2Module &pico2, Logger &openChallengeLogger)
+    Robot(LidarSource &lidar, Pico2Source &pico2, Logger &openChallengeLogger)
         : lidar_(lidar)
         , pico2_(pico2)
         , openChallengeLogger_(openChallengeLogger)
@@ -143,14 +158,18 @@ public:
 
 private:
     // Store references to the hardware modules
-    LidarModule &lidar_;
-    Pico2Module &pico2_;
+    LidarSource &lidar_;
+    Pico2Source &pico2_;
     Logger &openChallengeLogger_;
 
     // PID controllers
     PIDController headingPid_;
     PIDController wallPid_;
 
+    // Reused every tick so reading the sensor history neither copies nor allocates
+    RingBufferSnapshot<TimedCompactLidarData> lidarSnapshot_;
+    RingBufferSnapshot<TimedPico2Data> pico2Window_;
+
     // Robot state
     Mode mode_ = Mode::NORMAL;
     int turnCount_ = 0;
@@ -181,42 +200,37 @@ private:
      * @return An optional RobotData struct. Returns nullopt if data is incomplete.
      */
     std::optional<RobotData> updateRobotData(float dt) {
-        std::vector<TimedLidarData> lidarDatas;
-        lidar_.getAllTimedLidarData(lidarDatas);
-        if (lidarDatas.size() < lidar_.bufferSize()) return std::nullopt;
+        if (!lidar_.getCompactSnapshot(lidarSnapshot_)) return std::nullopt;
 
-        std::vector<TimedPico2Data> pico2Datas;
-        pico2_.getAllTimedData(pico2Datas);
-        if (pico2Datas.size() < pico2_.bufferSize()) return std::nullopt;
+        // Pose integration only needs the Pico2 samples since the scan
+        if (!pico2_.getSnapshotSince(lidarSnapshot_.back()->timestamp, pico2Window_)) return std::nullopt;
+        const TimedPico2Data &pico2Data = *pico2Window_.back();
 
         if (!initialHeading_) {
-            initialHeading_ = pico2Datas.back().euler.h;
+            initialHeading_ = pico2Data.euler.h;
             return std::nullopt;  // Wait for the next cycle to have a valid heading
         }
 
         // Log main loop timestamp
         auto now = std::chrono::steady_clock::now();
         uint64_t timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
-        struct {
-            uint64_t lidarTimestamp_ns;
-            uint64_t pico2Timestamp_ns;
-        } openChallengeData{
+        log_records::OpenLoopTimestampsRecord openChallengeData{
             static_cast<uint64_t>(
-                std::chrono::duration_cast<std::chrono::nanoseconds>(lidarDatas.back().timestamp.time_since_epoch()).count()
+                std::chrono::duration_cast<std::chrono::nanoseconds>(lidarSnapshot_.back()->timestamp.time_since_epoch()).count()
             ),
             static_cast<uint64_t>(
-                std::chrono::duration_cast<std::chrono::nanoseconds>(pico2Datas.back().timestamp.time_since_epoch()).count()
+                std::chrono::duration_cast<std::chrono::nanoseconds>(pico2Data.timestamp.time_since_epoch()).count()
             )
         };
-        openChallengeLogger_.writeData(timestamp_ns, &openChallengeData, sizeof(openChallengeData));
+        openChallengeLogger_.writeRecord(timestamp_ns, openChallengeData);
 
         RobotData data;
-        data.heading = pico2Datas.back().euler.h - *initialHeading_;
+        data.heading = pico2Data.euler.h - *initialHeading_;
         data.heading = std::fmod(data.heading, 360.0f);
         if (data.heading < 0.0f) data.heading += 360.0f;
 
-        auto filteredLidarData = lidar_processor::filterLidarData(lidarDatas.back());
-        auto deltaPose = combined_processor::aproximateRobotPose(filteredLidarData, pico2Datas);
+        auto filteredLidarData = lidar_processor::filterLidarData(lidarSnapshot_.back()->expand());
+        auto deltaPose = combined_processor::aproximateRobotPose(filteredLidarData, pico2Window_);
         auto lineSegments = lidar_processor::getLines(filteredLidarData, deltaPose, 0.05f, 10, 0.10f, 0.10f, 18.0f, 0.20f);
         auto relativeWalls = lidar_processor::getRelativeWalls(lineSegments, headingDirection_, data.heading, 0.30f, 25.0f, 0.22f);
         auto resolvedWalls = lidar_processor::resolveWalls(relativeWalls);
@@ -332,84 +346,141 @@ private:
     }
 };
 
-int main() {
+int main(int argc, char **argv) {
     std::signal(SIGINT, signalHandler);
 
+    // --- Parse Arguments ---
+    // --replay runs the robot again on the sensor logs of a previous run, with no hardware attached
+    std::optional<std::string> replayFolder;
+    double replaySpeed = 1.0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--replay" && i + 1 < argc) {
+            replayFolder = argv[++i];
+        } else if (arg == "--speed" && i + 1 < argc) {
+            replaySpeed = std::stod(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--replay log_folder [--speed factor (0 = as fast as possible)]]" << std::endl;
+            return -1;
+        }
+    }
+
     // --- Setup Logging ---
     const char *home = std::getenv("HOME");
     if (!home) {
         std::cerr << "HOME environment variable not set" << std::endl;
         return -1;
     }
-    std::string logFolder = std::string(home) + "/gfm_logs/open_challenge";
+    // Replayed runs are logged apart from the real ones
+    std::string logFolder = std::string(home) + (replayFolder ? "/gfm_logs/open_challenge_replay" : "/gfm_logs/open_challenge");
     std::string timedstampedLogFolder = Logger::generateTimestampedFolder(logFolder);
 
+    // Before the loggers and sensor threads start, so all their threads are on the timeline
+    if (TRACE_TIMELINE) trace::start(timedstampedLogFolder + "/trace.json");
+
     // Create logger instances on the stack
-    Logger lidarLogger(timedstampedLogFolder + "/lidar.bin");
-    Logger pico2Logger(timedstampedLogFolder + "/pico2.bin");
-    Logger openChallengeLogger(timedstampedLogFolder + "/openChallenge.bin");
+    // Each drains to disk on its own writer thread so SD card stalls never reach the sensor threads
+    const Logger::AsyncOptions sensorLogOptions{4 * 1024 * 1024, Logger::BackpressurePolicy::DROP_NEWEST};
+    Logger lidarLogger(timedstampedLogFolder + "/lidar.bin", sensorLogOptions);
+    Logger pico2Logger(timedstampedLogFolder + "/pico2.bin", sensorLogOptions);
+    Logger openChallengeLogger(timedstampedLogFolder + "/openChallenge.bin", sensorLogOptions);
 
     // --- Initialize Hardware Modules ---
-    LidarModule lidar(&lidarLogger);
-    Pico2Module pico2(&pico2Logger);
-
-    if (!lidar.initialize()) {
-        std::cerr << "LidarModule initialization failed." << std::endl;
-        return -1;
-    }
-    lidar.printDeviceInfo();
-    if (!lidar.start()) {
-        std::cerr << "LidarModule failed to start." << std::endl;
-        return -1;
+    // Before the sensor threads start, so their buffers are locked too. Not for a replay: it would lock every mapped log in RAM
+    if (LOCK_MEMORY && !replayFolder) lockProcessMemory();
+
+    // Declared before the modules so it outlives their threads, which notify it
+    LoopDriver loopDriver(std::chrono::milliseconds(16));  // ~60 Hz when no new scan arrives
+
+    // The robot only sees the sensor interfaces, backed by the hardware modules or by a replay of the logs
+    std::unique_ptr<LidarModule> lidarModule;
+    std::unique_ptr<Pico2Module> pico2Module;
+    std::unique_ptr<SensorReplay> replay;
+    if (replayFolder) {
+        replay = std::make_unique<SensorReplay>(*replayFolder, &lidarLogger, &pico2Logger, nullptr, ReplayOptions{replaySpeed});
+    } else {
+        lidarModule = std::make_unique<LidarModule>(&lidarLogger);
+        pico2Module = std::make_unique<Pico2Module>(&pico2Logger);
     }
-    if (!pico2.initialize()) {
-        std::cerr << "Pico2Module initialization failed." << std::endl;
-        return -1;
+    LidarSource &lidar = replay ? static_cast<LidarSource &>(replay->lidar()) : *lidarModule;
+    Pico2Source &pico2 = replay ? static_cast<Pico2Source &>(replay->pico2()) : *pico2Module;
+
+    loopDriver.addTrigger("lidar", [&lidar] { return lidar.sequence(); });
+    lidar.setUpdateSignal(&loopDriver.signal());
+    lidar.setThreadConfig(LIDAR_THREAD);
+    pico2.setThreadConfig(PICO2_THREAD);
+
+    if (!replay) {
+        if (!lidarModule->initialize()) {
+            std::cerr << "LidarModule initialization failed." << std::endl;
+            return -1;
+        }
+        lidarModule->printDeviceInfo();
+        if (!lidarModule->start()) {
+            std::cerr << "LidarModule failed to start." << std::endl;
+            return -1;
+        }
+        if (!pico2Module->initialize()) {
+            std::cerr << "Pico2Module initialization failed." << std::endl;
+            return -1;
+        }
     }
 
     // --- Initialize Robot Controller ---
     Robot robot(lidar, pico2, openChallengeLogger);  // Pass modules by reference
 
-    // --- Setup GPIO ---
-    if (wiringPiSetupGpio() == -1) {
-        std::cerr << "WiringPi setup failed." << std::endl;
-        return -1;
-    }
-    pinMode(BUTTON_PIN, INPUT);
-    pullUpDnControl(BUTTON_PIN, PUD_UP);
+    // A replay has no button: it starts right away
+    if (!replay) {
+        // --- Setup GPIO ---
+        if (wiringPiSetupGpio() == -1) {
+            std::cerr << "WiringPi setup failed." << std::endl;
+            return -1;
+        }
+        pinMode(BUTTON_PIN, INPUT);
+        pullUpDnControl(BUTTON_PIN, PUD_UP);
 
-    // --- Wait for Start Button ---
-    std::cout << "Press the button to start..." << std::endl;
-    while (digitalRead(BUTTON_PIN) == HIGH && !stop_flag) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        // --- Wait for Start Button ---
+        std::cout << "Press the button to start..." << std::endl;
+        while (digitalRead(BUTTON_PIN) == HIGH && !stop_flag) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
     }
 
+    JitterMeter controlJitter;
     if (!stop_flag) {
-        std::cout << "Starting in 1.5 seconds..." << std::endl;
-        std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+        if (!replay) {
+            std::cout << "Starting in 1.5 seconds..." << std::endl;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+        }
 
         lidar.startLogging();
         pico2.startLogging();
 
+        // Once logging is on, so the replayed run is logged from its first sample
+        if (replay && !replay->start()) {
+            std::cerr << "SensorReplay failed to start." << std::endl;
+            return -1;
+        }
+
+        applyThreadConfig(CONTROL_THREAD);
+
         // --- Main Loop ---
-        const auto loopDuration = std::chrono::milliseconds(16);  // ~60 Hz
         auto lastTime = std::chrono::steady_clock::now();
 
         std::cout << "Robot running." << std::endl;
         while (!stop_flag) {
-            auto loopStart = std::chrono::steady_clock::now();
+            // Run as soon as a new scan is in, or one loop period after the previous tick at the latest
+            loopDriver.waitForTick();
+            if (replay && replay->finished()) break;
+            controlJitter.mark();
 
-            float dt = std::chrono::duration<float>(loopStart - lastTime).count();
-            lastTime = loopStart;
+            auto now = std::chrono::steady_clock::now();
+            float dt = std::chrono::duration<float>(now - lastTime).count();
+            lastTime = now;
 
+            trace::begin("tick");
             robot.update(dt);
-
-            // Maintain loop rate
-            auto loopEnd = std::chrono::steady_clock::now();
-            auto elapsed = loopEnd - loopStart;
-            if (elapsed < loopDuration) {
-                std::this_thread::sleep_for(loopDuration - elapsed);
-            }
+            trace::end("tick");
         }
     } else {
         // If stopped before starting, clean up the created log folder
@@ -420,10 +491,47 @@ int main() {
     // --- Shutdown ---
     std::cout << "Shutting down..." << std::endl;
     pico2.setMovementInfo(0.0f, 0.0f);  // Ensure motors are stopped
-    lidar.stop();
-    lidar.shutdown();
-    pico2.shutdown();
+    if (replay) {
+        replay->stop();
+    } else {
+        lidarModule->stop();
+        lidarModule->shutdown();
+        pico2Module->shutdown();
+    }
+    trace::stop();
     std::cout << "Shutdown complete." << std::endl;
+    auto printLoggerDrops = [](const char *name, const Logger &logger) {
+        std::cout << "[Logger] " << name << " dropped " << logger.droppedRecords() << " records (" << logger.droppedBytes() << " bytes)"
+                  << std::endl;
+    };
+    printLoggerDrops("lidar.bin", lidarLogger);
+    printLoggerDrops("pico2.bin", pico2Logger);
+    printLoggerDrops("openChallenge.bin", openChallengeLogger);
+    PoolStats scanPool = lidar.scanPoolStats();
+    std::cout << "[LidarModule] scan pool " << scanPool.hits << " hits, " << scanPool.misses << " misses (" << scanPool.size << " scans)"
+              << std::endl;
+    LoopDriver::Stats loopStats = loopDriver.stats();
+    double savedMean_ms = loopStats.triggeredTicks > 0 ? loopStats.savedTotal_ms / loopStats.triggeredTicks : 0.0;
+    std::cout << "[LoopDriver] " << loopStats.triggeredTicks << " of " << loopStats.ticks << " ticks woken by a scan, " << savedMean_ms
+              << " ms earlier on average (max " << loopStats.savedMax_ms << " ms)" << std::endl;
+    auto printJitter = [](const char *name, const JitterStats &jitter) {
+        std::cout << "[ThreadConfig] " << name << " thread " << jitter.intervals << " intervals, mean " << jitter.mean_ms << " ms, jitter "
+                  << jitter.stddev_ms << " ms (min " << jitter.min_ms << " ms, max " << jitter.max_ms << " ms)" << std::endl;
+    };
+    printJitter("control", controlJitter.stats());
+    printJitter("pico2", pico2.threadJitter());
+    printJitter("lidar", lidar.threadJitter());
+    auto printPeriodic = [](const char *name, const PeriodicStats &stats) {
+        std::cout << "[PeriodicExecutor] " << name << " " << stats.periods << " periods, " << stats.overruns << " overruns ("
+                  << stats.missedPeriods << " periods missed), lateness p50/p99/max " << stats.latenessP50_us << "/" << stats.latenessP99_us
+                  << "/" << stats.latenessMax_us << " us, jitter p50/p99/max " << stats.jitterP50_us << "/" << stats.jitterP99_us << "/"
+                  << stats.jitterMax_us << " us" << std::endl;
+    };
+    printPeriodic("control (period ticks)", loopDriver.periodStats());
+    if (pico2Module) printPeriodic("pico2", pico2Module->pollingStats());
+    trace::TraceStats traceStats = trace::stats();
+    std::cout << "[Trace] " << traceStats.events << " events from " << traceStats.threads << " threads, " << traceStats.dropped
+              << " dropped" << std::endl;
 
     return 0;
 }
@@ -1,8 +1,13 @@
-#include <cstring>
+#include <algorithm>
+#include <deque>
 #include <filesystem>
+#include <future>
 #include <iostream>
+#include <memory>
 #include <opencv2/imgproc.hpp>  // <-- ADD THIS
 #include <opencv2/videoio.hpp>  // <-- ADD THIS
+#include <optional>
+#include <sstream>
 #include <vector>
 
 #include "camera_processor.h"
@@ -12,6 +17,7 @@
 #include "lidar_struct.h"
 #include "log_reader.h"
 #include "pico2_struct.h"
+#include "thread_pool.hpp"
 
 namespace fs = std::filesystem;
 
@@ -86,10 +92,19 @@ void computeHSVBounds(const cv::Mat &frame, cv::Scalar &lower1, cv::Scalar &uppe
     }
 }
 
-TimedLidarData reconstructTimedLidar(const LogEntry &entry) {
-    std::vector<RawLidarNode> nodes(entry.data.size() / sizeof(RawLidarNode));
-    if (!entry.data.empty()) {
-        std::memcpy(nodes.data(), entry.data.data(), entry.data.size());
+TimedLidarData reconstructTimedLidar(const LogEntryView &entry) {
+    // Current logs store the compact fixed-point scan, older ones an array of RawLidarNode
+    std::vector<RawLidarNode> nodes;
+    bool ok;
+    if (entry.type == log_records::LIDAR_SCAN_COMPACT) {
+        CompactLidarScan scan;
+        ok = scan.assign(entry.data, entry.size);
+        scan.toNodes(nodes);
+    } else {
+        ok = readArray(entry, nodes);
+    }
+    if (!ok) {
+        std::cerr << "Warning: Skipping corrupt Lidar entry (type " << entry.type << ", size " << entry.size << ")" << std::endl;
     }
 
     // Convert timestamp in nanoseconds back to steady_clock::time_point
@@ -99,16 +114,13 @@ TimedLidarData reconstructTimedLidar(const LogEntry &entry) {
     return TimedLidarData{std::move(nodes), timestamp};
 }
 
-TimedPico2Data reconstructTimedPico2(const LogEntry &entry) {
+TimedPico2Data reconstructTimedPico2(const LogEntryView &entry) {
     TimedPico2Data pico2Data{};
 
-    struct {
-        ImuAccel accel;
-        ImuEuler euler;
-        double encoderAngle;
-    } payload;
-
-    std::memcpy(&payload, entry.data.data(), sizeof(payload));
+    log_records::Pico2Record payload{};
+    if (!readRecord(entry, payload)) {
+        std::cerr << "Warning: Corrupt Pico2 entry (type " << entry.type << ", size " << entry.size << ")" << std::endl;
+    }
 
     // Assign fields
     pico2Data.accel = payload.accel;
@@ -123,7 +135,7 @@ TimedPico2Data reconstructTimedPico2(const LogEntry &entry) {
 }
 
 std::vector<TimedPico2Data> reconstructPico2RingBufferVector(
-    const std::vector<LogEntry> &pico2Entries,
+    const std::vector<LogEntryView> &pico2Entries,
     size_t currentIdx,
     size_t windowSize = 30
 ) {
@@ -144,13 +156,14 @@ std::vector<TimedPico2Data> reconstructPico2RingBufferVector(
     return result;
 }
 
-TimedFrame reconstructTimedFrame(const LogEntry &entry) {
-    if (entry.data.empty()) {
+TimedFrame reconstructTimedFrame(const LogEntryView &entry) {
+    if (entry.size == 0) {
         throw std::runtime_error("Empty image entry data");
     }
 
-    // Decode image from memory
-    cv::Mat frame = cv::imdecode(entry.data, cv::IMREAD_UNCHANGED);
+    // Decode image straight from the mapped bytes, without copying them
+    cv::Mat encoded(1, static_cast<int>(entry.size), CV_8UC1, const_cast<uint8_t *>(entry.data));
+    cv::Mat frame = cv::imdecode(encoded, cv::IMREAD_UNCHANGED);
     if (frame.empty()) {
         throw std::runtime_error("Failed to decode image from entry data");
     }
@@ -174,6 +187,177 @@ void drawLineFromAngle(cv::Mat &img, int cx, int cy, float angle, const cv::Scal
     cv::line(img, cv::Point(cx, cy), cv::Point(x2, y2), color, thickness);
 }
 
+// Entries are sorted by timestamp, so the closest one is either the lower bound or the entry before it
+size_t findClosestIndex(const std::vector<LogEntryView> &entries, uint64_t targetTs) {
+    auto it = std::lower_bound(entries.begin(), entries.end(), targetTs, [](const LogEntryView &entry, uint64_t ts) {
+        return entry.timestamp < ts;
+    });
+    if (it == entries.begin()) return 0;
+    if (it == entries.end()) return entries.size() - 1;
+
+    size_t idx = static_cast<size_t>(it - entries.begin());
+    if (targetTs - entries[idx - 1].timestamp <= entries[idx].timestamp - targetTs) idx--;
+
+    return idx;
+}
+
+/**
+ * Logs shared read-only by every pipeline task.
+ */
+struct ReplayLogs {
+    const std::vector<LogEntryView> &lidarEntries;
+    const std::vector<LogEntryView> &pico2Entries;
+    const MappedLogReader *cameraReader;  // nullptr if there is no camera log
+};
+
+/**
+ * Decode and process stage result for one loop timestamp.
+ *
+ * Holds everything that depends only on the logs at that timestamp. The sticky
+ * turn direction is resolved afterwards, in loop order, by the main thread.
+ */
+struct FrameAnalysis {
+    bool valid = false;  // false if the Lidar or Pico2 log has no entry to use
+    float heading = 0.0f;
+    TimedLidarData timedLidarData;
+    TimedLidarData filteredLidarData;
+    RobotDeltaPose deltaPose{};
+    TimedFrame timedFrame;
+    camera_processor::ColorMasks colorMasks;
+    std::vector<camera_processor::BlockAngle> blockAngles;
+    std::vector<lidar_processor::LineSegment> parkingWalls;
+    lidar_processor::ResolvedWalls resolveWalls;
+    std::optional<RotationDirection> turnDirection;  // Turn direction detected in this frame alone
+};
+
+/**
+ * Render stage result for one loop timestamp, written out by the main thread in loop order.
+ */
+struct RenderedFrame {
+    bool valid = false;
+    cv::Mat lidarMat;
+    cv::Mat cameraMat;  // Empty if there is no camera frame
+    std::string output;  // Console output, printed when the frame is written
+};
+
+FrameAnalysis analyzeFrame(const ReplayLogs &logs, uint64_t currentTime, float initialHeading) {
+    FrameAnalysis analysis;
+
+    // ---- LIDAR ----
+    size_t lidarIdx = findClosestIndex(logs.lidarEntries, currentTime);
+    if (lidarIdx >= logs.lidarEntries.size()) return analysis;
+    analysis.timedLidarData = reconstructTimedLidar(logs.lidarEntries[lidarIdx]);
+
+    // ---- Pico2 ----
+    size_t pico2Idx = findClosestIndex(logs.pico2Entries, currentTime);
+    if (pico2Idx >= logs.pico2Entries.size()) return analysis;
+    TimedPico2Data timedPico2Data = reconstructTimedPico2(logs.pico2Entries[pico2Idx]);
+    auto timedPico2Datas = reconstructPico2RingBufferVector(logs.pico2Entries, pico2Idx);
+
+    float heading = timedPico2Data.euler.h - initialHeading;
+    heading = std::fmod(heading, 360.0f);
+    if (heading < 0.0f) heading += 360.0f;
+    analysis.heading = heading;
+
+    // ---- Camera ----
+    LogEntryView cameraEntry;
+    if (logs.cameraReader && logs.cameraReader->findClosest(currentTime, cameraEntry)) {
+        analysis.timedFrame = reconstructTimedFrame(cameraEntry);
+        analysis.colorMasks = camera_processor::filterColors(analysis.timedFrame);
+        analysis.blockAngles = camera_processor::computeBlockAngles(analysis.colorMasks, camWidth, camHFov);
+    }
+
+    // ---- Lidar processing ----
+    analysis.filteredLidarData = lidar_processor::filterLidarData(analysis.timedLidarData);
+    analysis.deltaPose = combined_processor::aproximateRobotPose(analysis.filteredLidarData, timedPico2Datas);
+
+    auto lineSegments = lidar_processor::getLines(analysis.filteredLidarData, analysis.deltaPose, 0.05f, 10, 0.10f, 0.10f, 18.0f, 0.20f);
+    auto relativeWalls = lidar_processor::getRelativeWalls(lineSegments, Direction::fromHeading(heading), heading, 0.30f, 25.0f, 0.22f);
+
+    analysis.turnDirection = lidar_processor::getTurnDirection(relativeWalls);
+    analysis.resolveWalls = lidar_processor::resolveWalls(relativeWalls);
+    analysis.parkingWalls = lidar_processor::getParkingWalls(lineSegments, Direction::fromHeading(heading), heading, 0.25f);
+
+    analysis.valid = true;
+    return analysis;
+}
+
+RenderedFrame renderFrame(const FrameAnalysis &analysis, std::optional<RotationDirection> robotTurnDirection) {
+    RenderedFrame rendered;
+    if (!analysis.valid) return rendered;
+
+    const auto &resolveWalls = analysis.resolveWalls;
+    std::ostringstream out;
+
+    auto trafficLightPoints =
+        lidar_processor::getTrafficLightPoints(analysis.filteredLidarData, resolveWalls, analysis.deltaPose, robotTurnDirection);
+    auto trafficLightInfos = combined_processor::combineTrafficLightInfo(analysis.blockAngles, trafficLightPoints);
+
+    if (robotTurnDirection) {
+        auto classifiedLights = combined_processor::classifyTrafficLights(
+            trafficLightInfos,
+            resolveWalls,
+            *robotTurnDirection,
+            Segment::fromHeading(analysis.heading)
+        );
+
+        for (const auto &ct : classifiedLights) {
+            out << "Traffic Light at LiDAR position (" << ct.info.lidarPosition.x << ", " << ct.info.lidarPosition.y << ")"
+                << " mapped to Segment " << static_cast<int>(ct.location.segment) << ", Location "
+                << static_cast<int>(ct.location.location) << ", WallSide " << (ct.location.side == WallSide::INNER ? "INNER" : "OUTER")
+                << std::endl;
+        }
+    }
+
+    const float SCALE = 6.0f;
+
+    cv::Mat lidarMat(800, 800, CV_8UC3, cv::Scalar(0, 0, 0));
+    lidar_processor::drawLidarData(lidarMat, analysis.timedLidarData, SCALE);
+
+    // Draw walls, parking, traffic lights as before
+    if (resolveWalls.leftWall) lidar_processor::drawLineSegment(lidarMat, *resolveWalls.leftWall, SCALE, {0, 0, 255});
+    if (resolveWalls.rightWall) lidar_processor::drawLineSegment(lidarMat, *resolveWalls.rightWall, SCALE, {0, 255, 255});
+    if (resolveWalls.frontWall) lidar_processor::drawLineSegment(lidarMat, *resolveWalls.frontWall, SCALE, {0, 255, 0});
+    if (resolveWalls.backWall) lidar_processor::drawLineSegment(lidarMat, *resolveWalls.backWall, SCALE, {255, 255, 0});
+    if (resolveWalls.farLeftWall) lidar_processor::drawLineSegment(lidarMat, *resolveWalls.farLeftWall, SCALE, {0, 0, 100});
+    if (resolveWalls.farRightWall) lidar_processor::drawLineSegment(lidarMat, *resolveWalls.farRightWall, SCALE, {0, 100, 100});
+
+    for (auto &parkingWall : analysis.parkingWalls)
+        lidar_processor::drawLineSegment(lidarMat, parkingWall, SCALE, {146, 22, 199});
+
+    for (auto &trafficLightPoint : trafficLightPoints)
+        lidar_processor::drawTrafficLightPoint(lidarMat, trafficLightPoint, SCALE);
+
+    for (auto &trafficLightInfo : trafficLightInfos)
+        combined_processor::drawTrafficLightInfo(lidarMat, trafficLightInfo, SCALE);
+
+    for (const auto &block : analysis.blockAngles) {
+        // Choose color for drawing
+        cv::Scalar lineColor = (block.color == camera_processor::Color::RED) ? cv::Scalar(0, 0, 255)   // Red in BGR
+                                                                             : cv::Scalar(0, 255, 0);  // Green in BGR
+        drawLineFromAngle(lidarMat, 400, 400 - (800 / 6.0f * 0.15), block.angle, lineColor, 2);
+    }
+
+    if (robotTurnDirection) {
+        if (*robotTurnDirection == RotationDirection::CLOCKWISE)
+            out << "CLOCKWISE" << std::endl;
+        else if (*robotTurnDirection == RotationDirection::COUNTER_CLOCKWISE)
+            out << "COUNTER_CLOCKWISE" << std::endl;
+    } else {
+        out << "N/A" << std::endl;
+    }
+
+    if (!analysis.timedFrame.frame.empty()) {
+        rendered.cameraMat = analysis.timedFrame.frame.clone();
+        camera_processor::drawColorMasks(rendered.cameraMat, analysis.colorMasks);
+    }
+
+    rendered.lidarMat = std::move(lidarMat);
+    rendered.output = out.str();
+    rendered.valid = true;
+    return rendered;
+}
+
 int main(int argc, char **argv) {
     if (argc < 2) {
         std::cerr << "Usage: " << argv[0] << " <log_folder>" << std::endl;
@@ -205,35 +389,36 @@ int main(int argc, char **argv) {
     std::string cameraLogFile = (fs::path(folderPath) / "camera.bin").string();
 
     // ---- Lidar ----
-    LogReader lidarReader(lidarLogFile);
-    std::vector<LogEntry> lidarEntries;
-    if (!lidarReader.readAll(lidarEntries)) {
+    MappedLogReader lidarReader(lidarLogFile);
+    std::vector<LogEntryView> lidarEntries;
+    if (!lidarReader.open() || !lidarReader.readAll(lidarEntries)) {
         std::cerr << "Failed to read Lidar log file: " << lidarLogFile << std::endl;
         return 1;
     }
     std::cout << "Loaded " << lidarEntries.size() << " Lidar log entries." << std::endl;
 
     // ---- Pico2 ----
-    LogReader pico2Reader(pico2File);
-    std::vector<LogEntry> pico2Entries;
-    if (!pico2Reader.readAll(pico2Entries)) {
+    MappedLogReader pico2Reader(pico2File);
+    std::vector<LogEntryView> pico2Entries;
+    if (!pico2Reader.open() || !pico2Reader.readAll(pico2Entries)) {
         std::cerr << "Failed to read Pico2 log file: " << pico2File << std::endl;
         return 1;
     }
     std::cout << "Loaded " << pico2Entries.size() << " Pico2 log entries." << std::endl;
 
     // ---- Camera (only for scanMap & obstacleChallenge) ----
-    std::vector<LogEntry> cameraEntries;
+    // Frames are looked up through the index on demand instead of being listed up front
+    MappedLogReader cameraReader(cameraLogFile);
     bool hasCamera = false;
 
     if (!isOpenChallenge) {
         if (fs::exists(cameraLogFile)) {
-            LogReader cameraReader(cameraLogFile);
-            if (!cameraReader.readAll(cameraEntries)) {
+            if (!cameraReader.open()) {
                 std::cerr << "Failed to read Camera log file: " << cameraLogFile << std::endl;
                 return 1;
             }
-            std::cout << "Loaded " << cameraEntries.size() << " Camera log entries." << std::endl;
+            std::cout << "Mapped " << cameraReader.fileSize() / (1024 * 1024) << " MiB Camera log ("
+                      << (cameraReader.hasIndex() ? "indexed" : "no index, seeking linearly") << ")." << std::endl;
             hasCamera = true;
         } else {
             std::cerr << "Expected camera log file, but not found: " << cameraLogFile << std::endl;
@@ -244,52 +429,51 @@ int main(int argc, char **argv) {
     }
 
     // ---- Main loop logs ----
-    std::vector<LogEntry> openChallengeEntries;
-    std::vector<LogEntry> scanMapEntries;
-    std::vector<LogEntry> obstacleChallengeEntries;
-
     std::vector<std::chrono::steady_clock::time_point> loopTimestamps;
 
     if (isOpenChallenge) {
-        LogReader openChallengeReader((fs::path(folderPath) / "openChallenge.bin").string());
-        if (!openChallengeReader.readAll(openChallengeEntries)) {
+        MappedLogReader openChallengeReader((fs::path(folderPath) / "openChallenge.bin").string());
+        if (!openChallengeReader.open()) {
             std::cerr << "Failed to read openChallenge log" << std::endl;
             return 1;
         }
-        std::cout << "Loaded " << openChallengeEntries.size() << " openChallenge entries." << std::endl;
-
-        for (const auto &entry : openChallengeEntries) {
+        size_t openChallengeCount = 0;
+        for (const auto &entry : openChallengeReader) {
+            openChallengeCount++;
             auto tp = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(entry.timestamp));
             loopTimestamps.push_back(tp);
         }
+        std::cout << "Loaded " << openChallengeCount << " openChallenge entries." << std::endl;
     }
 
     if (isScanMap) {
-        LogReader scanMapReader((fs::path(folderPath) / "scanMap.bin").string());
-        if (!scanMapReader.readAll(scanMapEntries)) {
+        MappedLogReader scanMapReader((fs::path(folderPath) / "scanMap.bin").string());
+        if (!scanMapReader.open()) {
             std::cerr << "Failed to read scanMap log" << std::endl;
             return 1;
         }
-        std::cout << "Loaded " << scanMapEntries.size() << " scanMap entries." << std::endl;
-
-        for (const auto &entry : scanMapEntries) {
+        size_t scanMapCount = 0;
+        for (const auto &entry : scanMapReader) {
+            scanMapCount++;
             auto tp = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(entry.timestamp));
             loopTimestamps.push_back(tp);
         }
+        std::cout << "Loaded " << scanMapCount << " scanMap entries." << std::endl;
     }
 
     if (isObstacleChallenge) {
-        LogReader obstacleChallengeReader((fs::path(folderPath) / "obstacleChallenge.bin").string());
-        if (!obstacleChallengeReader.readAll(obstacleChallengeEntries)) {
+        MappedLogReader obstacleChallengeReader((fs::path(folderPath) / "obstacleChallenge.bin").string());
+        if (!obstacleChallengeReader.open()) {
             std::cerr << "Failed to read obstacleChallenge log" << std::endl;
             return 1;
         }
-        std::cout << "Loaded " << obstacleChallengeEntries.size() << " obstacleChallenge entries." << std::endl;
-
-        for (const auto &entry : obstacleChallengeEntries) {
+        size_t obstacleChallengeCount = 0;
+        for (const auto &entry : obstacleChallengeReader) {
+            obstacleChallengeCount++;
             auto tp = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(entry.timestamp));
             loopTimestamps.push_back(tp);
         }
+        std::cout << "Loaded " << obstacleChallengeCount << " obstacleChallenge entries." << std::endl;
     }
 
     // --- ADD THIS BLOCK: Start VideoWriter setup ---
@@ -344,222 +528,78 @@ int main(int argc, char **argv) {
         cv::setMouseCallback("Camera View", mouseCallback);
     }
 
-    std::optional<float> initialHeading;
-    std::optional<RotationDirection> robotTurnDirection;
-
-    size_t lidarIdx = 0;
-    size_t pico2Idx = 0;
-    size_t cameraIdx = 0;
-
-    auto findClosestIndex = [](const std::vector<LogEntry> &entries, size_t startIdx, uint64_t targetTs) -> size_t {
-        size_t idx = startIdx;
-
-        // Move forward if next entry is closer
-        while (idx + 1 < entries.size() && std::abs(static_cast<int64_t>(entries[idx + 1].timestamp - targetTs)) <
-                                               std::abs(static_cast<int64_t>(entries[idx].timestamp - targetTs)))
-        {
-            idx++;
-        }
-
-        // Move backward if previous entry is closer
-        while (idx > 0 && std::abs(static_cast<int64_t>(entries[idx - 1].timestamp - targetTs)) <
-                              std::abs(static_cast<int64_t>(entries[idx].timestamp - targetTs)))
-        {
-            idx--;
-        }
+    if (loopTimestamps.size() < 2) {
+        std::cerr << "Not enough main loop entries to replay." << std::endl;
+        return 1;
+    }
 
-        return idx;
+    auto loopTime = [&](size_t idx) -> uint64_t {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(loopTimestamps[idx].time_since_epoch()).count();
     };
 
-    size_t currentTimeIdx = 0;
-    int playDirection = 0;  // -1 = backward, +1 = forward, 0 = stopped
-    auto lastPressTime = std::chrono::steady_clock::now();
-
-    while (true) {
-        if (currentTimeIdx < loopTimestamps.size() - 1)
-            currentTimeIdx++;
-        else
-            break;
-
-        // int key = cv::waitKey(1);
-        // if (key == 'q') break;
-
-        //// --- Handle taps ---
-        // if (key == 'j') {  // step one frame back (single frame mode)
-        //     if (currentTimeIdx > 0) currentTimeIdx--;
-        // } else if (key == 'l') {  // step one frame forward
-        //     if (currentTimeIdx < loopTimestamps.size() - 1) currentTimeIdx++;
-        // }
-
-        //// --- Handle continuous ---
-        // if (key == 'a') {
-        //     playDirection = -1;
-        //     lastPressTime = std::chrono::steady_clock::now();
-        // } else if (key == 'd') {
-        //     playDirection = +1;
-        //     lastPressTime = std::chrono::steady_clock::now();
-        // } else if (key == -1) {
-        //     // check how long since last press
-        //     auto now = std::chrono::steady_clock::now();
-        //     auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastPressTime).count();
-
-        //    if (elapsed > 50) {
-        //        // more than ~50ms without real press → stop auto-move
-        //        playDirection = 0;
-        //    }
-        //}
-
-        // if (playDirection == -1 && currentTimeIdx > 0)
-        //     currentTimeIdx--;
-        // else if (playDirection == +1 && currentTimeIdx < loopTimestamps.size() - 1)
-        //     currentTimeIdx++;
-        // else if (key == -1 && playDirection == 0)
-        //     continue;
-        uint64_t currentTime =
-            std::chrono::duration_cast<std::chrono::nanoseconds>(loopTimestamps[currentTimeIdx].time_since_epoch()).count();
-
-        // ---- LIDAR ----
-        lidarIdx = findClosestIndex(lidarEntries, lidarIdx, currentTime);
-        if (lidarIdx >= lidarEntries.size()) continue;
-        const auto &lidarEntry = lidarEntries[lidarIdx];
-        TimedLidarData timedLidarData = reconstructTimedLidar(lidarEntry);
-
-        // ---- Pico2 ----
-        pico2Idx = findClosestIndex(pico2Entries, pico2Idx, currentTime);
-        if (pico2Idx >= pico2Entries.size()) continue;
-        const auto &pico2Entry = pico2Entries[pico2Idx];
-        TimedPico2Data timedPico2Data = reconstructTimedPico2(pico2Entry);
-        auto timedPico2Datas = reconstructPico2RingBufferVector(pico2Entries, pico2Idx);
-
-        if (not initialHeading) initialHeading = timedPico2Data.euler.h;
-
-        float heading = timedPico2Data.euler.h - initialHeading.value_or(0.0f);
-        heading = std::fmod(heading, 360.0f);
-        if (heading < 0.0f) heading += 360.0f;
-
-        // ---- Camera ----
-        TimedFrame timedFrame;
-        camera_processor::ColorMasks colorMasks;
-        std::vector<camera_processor::BlockAngle> blockAngles;
-        if (hasCamera) {
-            cameraIdx = findClosestIndex(cameraEntries, cameraIdx, currentTime);
-            if (cameraIdx < cameraEntries.size()) {
-                timedFrame = reconstructTimedFrame(cameraEntries[cameraIdx]);
-                colorMasks = camera_processor::filterColors(timedFrame);
-                blockAngles = camera_processor::computeBlockAngles(colorMasks, camWidth, camHFov);
-
-                // if (key == 'i') {
-                //     selectMode = true;
-                //     polygonPoints.clear();
-                //     std::cout << "Click points to define polygon, then press 'c' to confirm.\n";
-
-                //    continue;
-                //} else if (key == 'c') {
-                //    selectMode = false;
-                //    cv::Scalar lower1, upper1, lower2, upper2;
-                //    computeHSVBounds(timedFrame.frame, lower1, upper1, lower2, upper2);
-                //    std::cout << "Lower1 HSV: " << lower1 << "\n";
-                //    std::cout << "Upper1 HSV: " << upper1 << "\n";
-                //    std::cout << "Lower2 HSV: " << lower2 << "\n";
-                //    std::cout << "Upper2 HSV: " << upper2 << "\n";
-
-                //    continue;
-                //}
-            }
-        }
-
-        // ---- Lidar processing ----
-        auto filteredLidarData = lidar_processor::filterLidarData(timedLidarData);
-
-        auto deltaPose = combined_processor::aproximateRobotPose(filteredLidarData, timedPico2Datas);
-
-        // std::cout << "Encoder: " << timedPico2Data.encoderAngle << std::endl;
-
-        // std::cout << "[DeltaPose] ΔX: " << deltaPose.deltaX << " m, ΔY: " << deltaPose.deltaY << " m, ΔH: " << deltaPose.deltaH << " deg"
-        //           << std::endl;
-
-        auto lineSegments = lidar_processor::getLines(filteredLidarData, deltaPose, 0.05f, 10, 0.10f, 0.10f, 18.0f, 0.20f);
-        auto relativeWalls = lidar_processor::getRelativeWalls(lineSegments, Direction::fromHeading(heading), heading, 0.30f, 25.0f, 0.22f);
-
-        auto newRobotTurnDirecton = lidar_processor::getTurnDirection(relativeWalls);
-        if (newRobotTurnDirecton) robotTurnDirection = newRobotTurnDirecton;
-
-        auto resolveWalls = lidar_processor::resolveWalls(relativeWalls);
-        auto parkingWalls = lidar_processor::getParkingWalls(lineSegments, Direction::fromHeading(heading), heading, 0.25f);
-        auto trafficLightPoints = lidar_processor::getTrafficLightPoints(filteredLidarData, resolveWalls, deltaPose, robotTurnDirection);
-
-        auto trafficLightInfos = combined_processor::combineTrafficLightInfo(blockAngles, trafficLightPoints);
-
-        if (robotTurnDirection) {
-            auto classifiedLights = combined_processor::classifyTrafficLights(
-                trafficLightInfos,
-                resolveWalls,
-                *robotTurnDirection,
-                Segment::fromHeading(heading)
-            );
-
-            for (const auto &ct : classifiedLights) {
-                std::cout << "Traffic Light at LiDAR position (" << ct.info.lidarPosition.x << ", " << ct.info.lidarPosition.y << ")"
-                          << " mapped to Segment " << static_cast<int>(ct.location.segment) << ", Location "
-                          << static_cast<int>(ct.location.location) << ", WallSide "
-                          << (ct.location.side == WallSide::INNER ? "INNER" : "OUTER") << std::endl;
-            }
-        }
-
-        const float SCALE = 6.0f;
+    // The first replayed loop (index 0 is skipped) defines the zero heading
+    float initialHeading = 0.0f;
+    if (!pico2Entries.empty()) {
+        initialHeading = reconstructTimedPico2(pico2Entries[findClosestIndex(pico2Entries, loopTime(1))]).euler.h;
+    }
 
-        cv::Mat lidarMat(800, 800, CV_8UC3, cv::Scalar(0, 0, 0));
-        lidar_processor::drawLidarData(lidarMat, timedLidarData, SCALE);
+    ReplayLogs logs{lidarEntries, pico2Entries, hasCamera ? &cameraReader : nullptr};
 
-        // Draw walls, parking, traffic lights as before
-        if (resolveWalls.leftWall) lidar_processor::drawLineSegment(lidarMat, *resolveWalls.leftWall, SCALE, {0, 0, 255});
-        if (resolveWalls.rightWall) lidar_processor::drawLineSegment(lidarMat, *resolveWalls.rightWall, SCALE, {0, 255, 255});
-        if (resolveWalls.frontWall) lidar_processor::drawLineSegment(lidarMat, *resolveWalls.frontWall, SCALE, {0, 255, 0});
-        if (resolveWalls.backWall) lidar_processor::drawLineSegment(lidarMat, *resolveWalls.backWall, SCALE, {255, 255, 0});
-        if (resolveWalls.farLeftWall) lidar_processor::drawLineSegment(lidarMat, *resolveWalls.farLeftWall, SCALE, {0, 0, 100});
-        if (resolveWalls.farRightWall) lidar_processor::drawLineSegment(lidarMat, *resolveWalls.farRightWall, SCALE, {0, 100, 100});
+    // Pipeline: decode+process and render run on the pool, in parallel across loop
+    // timestamps. The main thread resolves the sticky turn direction and writes
+    // the videos strictly in loop order, so the output matches a serial replay.
+    ThreadPool pool;
+    const size_t maxInFlight = 2 * pool.size();
+    std::cout << "Rendering with " << pool.size() << " worker threads." << std::endl;
 
-        for (auto &parkingWall : parkingWalls)
-            lidar_processor::drawLineSegment(lidarMat, parkingWall, SCALE, {146, 22, 199});
+    std::deque<std::future<FrameAnalysis>> analyses;
+    std::deque<std::future<RenderedFrame>> renders;
+    std::optional<RotationDirection> robotTurnDirection;
+    size_t nextToAnalyze = 1;
 
-        for (auto &trafficLightPoint : trafficLightPoints)
-            lidar_processor::drawTrafficLightPoint(lidarMat, trafficLightPoint, SCALE);
+    auto writeFrame = [&](RenderedFrame rendered) {
+        if (!rendered.valid) return;
+        std::cout << rendered.output;
 
-        for (auto &trafficLightInfo : trafficLightInfos)
-            combined_processor::drawTrafficLightInfo(lidarMat, trafficLightInfo, SCALE);
+        cv::imshow("Lidar View", rendered.lidarMat);
+        lidarVideoWriter.write(rendered.lidarMat);
 
-        for (const auto &block : blockAngles) {
-            // Choose color for drawing
-            cv::Scalar lineColor = (block.color == camera_processor::Color::RED) ? cv::Scalar(0, 0, 255)   // Red in BGR
-                                                                                 : cv::Scalar(0, 255, 0);  // Green in BGR
-            drawLineFromAngle(lidarMat, 400, 400 - (800 / 6.0f * 0.15), block.angle, lineColor, 2);
+        // Only show camera view if available
+        if (hasCamera && !rendered.cameraMat.empty()) {
+            cv::imshow("Camera View", rendered.cameraMat);
+            cameraVideoWriter.write(rendered.cameraMat);
         }
+    };
 
-        if (robotTurnDirection) {
-            if (*robotTurnDirection == RotationDirection::CLOCKWISE)
-                std::cout << "CLOCKWISE" << std::endl;
-            else if (*robotTurnDirection == RotationDirection::COUNTER_CLOCKWISE)
-                std::cout << "COUNTER_CLOCKWISE" << std::endl;
-        } else {
-            std::cout << "N/A" << std::endl;
+    for (size_t currentTimeIdx = 1; currentTimeIdx < loopTimestamps.size(); ++currentTimeIdx) {
+        // Keep the decode/process stage ahead of the ordered stage
+        while (nextToAnalyze < loopTimestamps.size() && nextToAnalyze < currentTimeIdx + maxInFlight) {
+            analyses.push_back(pool.submit(analyzeFrame, logs, loopTime(nextToAnalyze), initialHeading));
+            nextToAnalyze++;
         }
 
-        // std::cout << "Heading: " << heading << std::endl;
+        auto analysis = std::make_shared<FrameAnalysis>(analyses.front().get());
+        analyses.pop_front();
 
-        cv::imshow("Lidar View", lidarMat);
-        lidarVideoWriter.write(lidarMat);  // <-- ADD THIS
+        if (analysis->valid && analysis->turnDirection) robotTurnDirection = analysis->turnDirection;
+        renders.push_back(pool.submit([analysis, robotTurnDirection] { return renderFrame(*analysis, robotTurnDirection); }));
 
-        // Only show camera view if available
-        if (hasCamera && !timedFrame.frame.empty()) {
-            cv::Mat cameraMat = timedFrame.frame.clone();
-            camera_processor::drawColorMasks(cameraMat, colorMasks);
-            cv::imshow("Camera View", cameraMat);
-            cameraVideoWriter.write(cameraMat);  // <-- ADD THIS
+        // Write every render that is already done, and block once too many are pending
+        while (!renders.empty() &&
+               (renders.size() > maxInFlight || renders.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready))
+        {
+            writeFrame(renders.front().get());
+            renders.pop_front();
         }
     }
 
-    lidarVideoWriter.release();   // <-- ADD THIS
-    cameraVideoWriter.release();  // <-- ADD THIS (Safe even if not opened)
+    while (!renders.empty()) {
+        writeFrame(renders.front().get());
+        renders.pop_front();
+    }
+
+    lidarVideoWriter.release();
+    cameraVideoWriter.release();  // Safe even if not opened
     cv::destroyAllWindows();
     return 0;
 }
@@ -0,0 +1,159 @@
+#include "frame_cache.h"
+
+#include <algorithm>
+
+FrameCache::FrameCache(const std::vector<LogEntryView> &entries, Decoder decoder, size_t memoryBudget, size_t workerCount)
+    : entries_(entries)
+    , decoder_(std::move(decoder))
+    , memoryBudget_(memoryBudget) {
+    workerCount = std::max<size_t>(workerCount, 1);
+    workers_.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers_.emplace_back(&FrameCache::workerLoop, this);
+    }
+}
+
+FrameCache::~FrameCache() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        wanted_.clear();
+    }
+    workAvailable_.notify_all();
+
+    for (auto &worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+TimedFrame FrameCache::get(size_t index) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        // A worker is already decoding it; waiting is cheaper than decoding it twice
+        decoded_.wait(lock, [&] { return inFlight_.count(index) == 0; });
+
+        auto it = frames_.find(index);
+        if (it != frames_.end()) {
+            hits_++;
+            touchLocked(it->second);
+            return it->second.timedFrame;
+        }
+
+        misses_++;
+        inFlight_.insert(index);
+    }
+
+    TimedFrame timedFrame;
+    try {
+        timedFrame = decoder_(entries_.at(index));
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            inFlight_.erase(index);
+        }
+        decoded_.notify_all();
+        throw;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        inFlight_.erase(index);
+        insertLocked(index, TimedFrame(timedFrame));
+    }
+    decoded_.notify_all();
+    return timedFrame;
+}
+
+void FrameCache::prefetch(const std::vector<size_t> &indices) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Never prefetch more than fits next to the frame on screen, or the list would evict itself
+        size_t limit = indices.size();
+        if (frameBytes_ > 0) limit = std::min(limit, memoryBudget_ / frameBytes_ > 0 ? memoryBudget_ / frameBytes_ - 1 : 0);
+
+        wanted_.clear();
+        for (size_t i = 0; i < limit; ++i) {
+            if (indices[i] < entries_.size() && frames_.count(indices[i]) == 0) wanted_.push_back(indices[i]);
+        }
+
+        // Keep cached wanted frames away from the eviction end, most wanted last so it ends up in front
+        for (size_t i = limit; i-- > 0;) {
+            auto it = frames_.find(indices[i]);
+            if (it != frames_.end()) touchLocked(it->second);
+        }
+    }
+    workAvailable_.notify_all();
+}
+
+size_t FrameCache::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memoryUsage_;
+}
+
+uint64_t FrameCache::hits() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+uint64_t FrameCache::misses() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return misses_;
+}
+
+void FrameCache::workerLoop() {
+    while (true) {
+        size_t index;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            workAvailable_.wait(lock, [this] { return stopping_ || !wanted_.empty(); });
+            if (stopping_) break;
+
+            index = wanted_.front();
+            wanted_.pop_front();
+            if (frames_.count(index) || inFlight_.count(index)) continue;
+
+            inFlight_.insert(index);
+        }
+
+        TimedFrame timedFrame;
+        bool ok = true;
+        try {
+            timedFrame = decoder_(entries_[index]);
+        } catch (...) {
+            // Leave it uncached; get() decodes it again and reports the error
+            ok = false;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            inFlight_.erase(index);
+            if (ok) insertLocked(index, std::move(timedFrame));
+        }
+        decoded_.notify_all();
+    }
+}
+
+void FrameCache::insertLocked(size_t index, TimedFrame &&timedFrame) {
+    size_t bytes = timedFrame.frame.total() * timedFrame.frame.elemSize();
+    frameBytes_ = bytes;
+
+    lru_.push_front(index);
+    frames_[index] = CachedFrame{std::move(timedFrame), bytes, lru_.begin()};
+    memoryUsage_ += bytes;
+
+    // Evict from the least recently used end, but always keep the frame just inserted
+    while (memoryUsage_ > memoryBudget_ && lru_.size() > 1) {
+        size_t victim = lru_.back();
+        lru_.pop_back();
+
+        auto it = frames_.find(victim);
+        memoryUsage_ -= it->second.bytes;
+        frames_.erase(it);
+    }
+}
+
+void FrameCache::touchLocked(CachedFrame &cached) {
+    lru_.splice(lru_.begin(), lru_, cached.lruPosition);
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "camera_struct.h"
+#include "log_reader.h"
+
+/**
+ * @brief LRU cache of decoded camera frames, keyed by camera log entry index, with background prefetch.
+ *
+ * get() returns a cached frame immediately or decodes it on the calling
+ * thread. prefetch() hands the worker threads a priority-ordered list of
+ * indices to decode ahead of time (e.g. ahead of and behind the cursor in
+ * the current play direction). Decoded frames are kept until the memory
+ * budget is reached, then the least recently used ones are evicted.
+ *
+ * Returned frames share pixel data with the cache, so callers must not
+ * modify them in place.
+ */
+class FrameCache
+{
+public:
+    using Decoder = std::function<TimedFrame(const LogEntryView &)>;
+
+    /**
+     * @brief Start the prefetch workers.
+     *
+     * @param entries Camera log entries. The views (and their reader) must outlive the cache.
+     * @param decoder Decodes one entry; may throw on corrupt data.
+     * @param memoryBudget Maximum bytes of decoded pixel data kept in the cache.
+     * @param workerCount Number of prefetch threads (at least 1).
+     */
+    FrameCache(const std::vector<LogEntryView> &entries, Decoder decoder, size_t memoryBudget, size_t workerCount = 2);
+
+    /**
+     * @brief Stop the workers. Frames being decoded are finished first.
+     */
+    ~FrameCache();
+
+    FrameCache(const FrameCache &) = delete;
+    FrameCache &operator=(const FrameCache &) = delete;
+
+    /**
+     * @brief Get the decoded frame of an entry.
+     *
+     * Waits for the decode if a worker is already on it, otherwise decodes on
+     * the calling thread. Decoder exceptions propagate to the caller.
+     */
+    TimedFrame get(size_t index);
+
+    /**
+     * @brief Replace the list of entries to decode in the background.
+     *
+     * @param indices Entry indices, most wanted first. Already cached or invalid indices are skipped.
+     */
+    void prefetch(const std::vector<size_t> &indices);
+
+    /**
+     * @brief Bytes of decoded pixel data currently cached.
+     */
+    size_t memoryUsage() const;
+
+    uint64_t hits() const;
+    uint64_t misses() const;
+
+private:
+    struct CachedFrame {
+        TimedFrame timedFrame;
+        size_t bytes;
+        std::list<size_t>::iterator lruPosition;
+    };
+
+    /**
+     * @brief Worker thread: decodes the next wanted entry that is neither cached nor in flight.
+     */
+    void workerLoop();
+
+    /**
+     * @brief Insert a decoded frame and evict least recently used frames over the budget. Requires mutex_.
+     */
+    void insertLocked(size_t index, TimedFrame &&timedFrame);
+
+    /**
+     * @brief Move an entry to the most recently used position. Requires mutex_.
+     */
+    void touchLocked(CachedFrame &cached);
+
+    const std::vector<LogEntryView> &entries_;
+    Decoder decoder_;
+    size_t memoryBudget_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable decoded_;
+
+    std::unordered_map<size_t, CachedFrame> frames_;
+    std::list<size_t> lru_;  ///< Front is the most recently used index
+    size_t memoryUsage_ = 0;
+    size_t frameBytes_ = 0;  ///< Size of the last decoded frame, used to fit the prefetch list into the budget
+
+    std::deque<size_t> wanted_;            ///< Prefetch list, most wanted first
+    std::unordered_set<size_t> inFlight_;  ///< Indices currently being decoded
+    bool stopping_ = false;
+
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+
+    std::vector<std::thread> workers_;
+};
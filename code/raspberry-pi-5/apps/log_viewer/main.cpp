@@ -1,11 +1,14 @@
-#include <cstring>
+#include <algorithm>
 #include <filesystem>
 #include <iostream>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "camera_processor.h"
 #include "camera_struct.h"
 #include "combined_processor.h"
+#include "frame_cache.h"
 #include "lidar_processor.h"
 #include "lidar_struct.h"
 #include "log_reader.h"
@@ -17,6 +20,11 @@ const uint32_t camWidth = 1296;
 const uint32_t camHeight = 972;
 const float camHFov = 98.0f;
 
+// Decoded camera frames kept for scrubbing, and how far around the cursor to decode ahead of time
+const size_t defaultFrameCacheMiB = 512;
+const size_t prefetchAhead = 45;   // 1.5 s at 30 fps in the play direction
+const size_t prefetchBehind = 15;  // 0.5 s against it
+
 struct SensorTimestamps {
     uint64_t mainLoop_ns;
     uint64_t lidar_ns;
@@ -91,10 +99,19 @@ void computeHSVBounds(const cv::Mat &frame, cv::Scalar &lower1, cv::Scalar &uppe
     }
 }
 
-TimedLidarData reconstructTimedLidar(const LogEntry &entry) {
-    std::vector<RawLidarNode> nodes(entry.data.size() / sizeof(RawLidarNode));
-    if (!entry.data.empty()) {
-        std::memcpy(nodes.data(), entry.data.data(), entry.data.size());
+TimedLidarData reconstructTimedLidar(const LogEntryView &entry) {
+    // Current logs store the compact fixed-point scan, older ones an array of RawLidarNode
+    std::vector<RawLidarNode> nodes;
+    bool ok;
+    if (entry.type == log_records::LIDAR_SCAN_COMPACT) {
+        CompactLidarScan scan;
+        ok = scan.assign(entry.data, entry.size);
+        scan.toNodes(nodes);
+    } else {
+        ok = readArray(entry, nodes);
+    }
+    if (!ok) {
+        std::cerr << "Warning: Skipping corrupt Lidar entry (type " << entry.type << ", size " << entry.size << ")" << std::endl;
     }
 
     // Convert timestamp in nanoseconds back to steady_clock::time_point
@@ -104,16 +121,13 @@ TimedLidarData reconstructTimedLidar(const LogEntry &entry) {
     return TimedLidarData{std::move(nodes), timestamp};
 }
 
-TimedPico2Data reconstructTimedPico2(const LogEntry &entry) {
+TimedPico2Data reconstructTimedPico2(const LogEntryView &entry) {
     TimedPico2Data pico2Data{};
 
-    struct {
-        ImuAccel accel;
-        ImuEuler euler;
-        double encoderAngle;
-    } payload;
-
-    std::memcpy(&payload, entry.data.data(), sizeof(payload));
+    log_records::Pico2Record payload{};
+    if (!readRecord(entry, payload)) {
+        std::cerr << "Warning: Corrupt Pico2 entry (type " << entry.type << ", size " << entry.size << ")" << std::endl;
+    }
 
     // Assign fields
     pico2Data.accel = payload.accel;
@@ -128,7 +142,7 @@ TimedPico2Data reconstructTimedPico2(const LogEntry &entry) {
 }
 
 std::vector<TimedPico2Data> reconstructPico2RingBufferVector(
-    const std::vector<LogEntry> &pico2Entries,
+    const std::vector<LogEntryView> &pico2Entries,
     size_t currentIdx,
     size_t windowSize = 30
 ) {
@@ -149,13 +163,14 @@ std::vector<TimedPico2Data> reconstructPico2RingBufferVector(
     return result;
 }
 
-TimedFrame reconstructTimedFrame(const LogEntry &entry) {
-    if (entry.data.empty()) {
+TimedFrame reconstructTimedFrame(const LogEntryView &entry) {
+    if (entry.size == 0) {
         throw std::runtime_error("Empty image entry data");
     }
 
-    // Decode image from memory
-    cv::Mat frame = cv::imdecode(entry.data, cv::IMREAD_UNCHANGED);
+    // Decode image straight from the mapped bytes, without copying them
+    cv::Mat encoded(1, static_cast<int>(entry.size), CV_8UC1, const_cast<uint8_t *>(entry.data));
+    cv::Mat frame = cv::imdecode(encoded, cv::IMREAD_UNCHANGED);
     if (frame.empty()) {
         throw std::runtime_error("Failed to decode image from entry data");
     }
@@ -179,13 +194,28 @@ void drawLineFromAngle(cv::Mat &img, int cx, int cy, float angle, const cv::Scal
     cv::line(img, cv::Point(cx, cy), cv::Point(x2, y2), color, thickness);
 }
 
+// Entries are sorted by timestamp, so the closest one is either the lower bound or the entry before it
+size_t findClosestIndex(const std::vector<LogEntryView> &entries, uint64_t targetTs) {
+    auto it = std::lower_bound(entries.begin(), entries.end(), targetTs, [](const LogEntryView &entry, uint64_t ts) {
+        return entry.timestamp < ts;
+    });
+    if (it == entries.begin()) return 0;
+    if (it == entries.end()) return entries.size() - 1;
+
+    size_t idx = static_cast<size_t>(it - entries.begin());
+    if (targetTs - entries[idx - 1].timestamp <= entries[idx].timestamp - targetTs) idx--;
+
+    return idx;
+}
+
 int main(int argc, char **argv) {
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <log_folder>" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " <log_folder> [frame_cache_MiB]" << std::endl;
         return 1;
     }
 
     std::string folderPath = argv[1];
+    size_t frameCacheMiB = argc > 2 ? std::stoul(argv[2]) : defaultFrameCacheMiB;
 
     // Detect challenge type
     bool isOpenChallenge = fs::exists(fs::path(folderPath) / "openChallenge.bin");
@@ -210,36 +240,38 @@ int main(int argc, char **argv) {
     std::string cameraLogFile = (fs::path(folderPath) / "camera.bin").string();
 
     // ---- Lidar ----
-    LogReader lidarReader(lidarLogFile);
-    std::vector<LogEntry> lidarEntries;
-    if (!lidarReader.readAll(lidarEntries)) {
+    MappedLogReader lidarReader(lidarLogFile);
+    std::vector<LogEntryView> lidarEntries;
+    if (!lidarReader.open() || !lidarReader.readAll(lidarEntries)) {
         std::cerr << "Failed to read Lidar log file: " << lidarLogFile << std::endl;
         return 1;
     }
     std::cout << "Loaded " << lidarEntries.size() << " Lidar log entries." << std::endl;
 
     // ---- Pico2 ----
-    LogReader pico2Reader(pico2File);
-    std::vector<LogEntry> pico2Entries;
-    if (!pico2Reader.readAll(pico2Entries)) {
+    MappedLogReader pico2Reader(pico2File);
+    std::vector<LogEntryView> pico2Entries;
+    if (!pico2Reader.open() || !pico2Reader.readAll(pico2Entries)) {
         std::cerr << "Failed to read Pico2 log file: " << pico2File << std::endl;
         return 1;
     }
     std::cout << "Loaded " << pico2Entries.size() << " Pico2 log entries." << std::endl;
 
     // ---- Camera (only for scanMap & obstacleChallenge) ----
-    std::vector<LogEntry> cameraEntries;
+    // Only the views are listed; frames are decoded on demand through the frame cache
+    MappedLogReader cameraReader(cameraLogFile);
+    std::vector<LogEntryView> cameraEntries;
     bool hasCamera = false;
 
     if (!isOpenChallenge) {
         if (fs::exists(cameraLogFile)) {
-            LogReader cameraReader(cameraLogFile);
-            if (!cameraReader.readAll(cameraEntries)) {
+            if (!cameraReader.open() || !cameraReader.readAll(cameraEntries)) {
                 std::cerr << "Failed to read Camera log file: " << cameraLogFile << std::endl;
                 return 1;
             }
-            std::cout << "Loaded " << cameraEntries.size() << " Camera log entries." << std::endl;
-            hasCamera = true;
+            std::cout << "Loaded " << cameraEntries.size() << " Camera log entries (" << cameraReader.fileSize() / (1024 * 1024)
+                      << " MiB mapped)." << std::endl;
+            hasCamera = !cameraEntries.empty();
         } else {
             std::cerr << "Expected camera log file, but not found: " << cameraLogFile << std::endl;
             return 1;
@@ -249,35 +281,24 @@ int main(int argc, char **argv) {
     }
 
     // ---- Main loop logs ----
-    std::vector<LogEntry> openChallengeEntries;
-    std::vector<LogEntry> scanMapEntries;
-    std::vector<LogEntry> obstacleChallengeEntries;
-
     std::vector<SensorTimestamps> challengeTimestamps;
 
     if (isOpenChallenge) {
-        LogReader openChallengeReader((fs::path(folderPath) / "openChallenge.bin").string());
-        if (!openChallengeReader.readAll(openChallengeEntries)) {
+        MappedLogReader openChallengeReader((fs::path(folderPath) / "openChallenge.bin").string());
+        if (!openChallengeReader.open()) {
             std::cerr << "Failed to read openChallenge log" << std::endl;
             return 1;
         }
-        std::cout << "Loaded " << openChallengeEntries.size() << " openChallenge entries." << std::endl;
-
-        for (const auto &entry : openChallengeEntries) {
-            // This struct must match exactly what was logged
-            struct {
-                uint64_t lidarTimestamp_ns;
-                uint64_t pico2Timestamp_ns;
-            } openChallengeData;
-
-            // Check if data size is correct before copying
-            if (entry.data.size() != sizeof(openChallengeData)) {
-                std::cerr << "Warning: Skipping corrupt openChallenge entry (size " << entry.data.size() << ")" << std::endl;
+        size_t openChallengeCount = 0;
+        for (const auto &entry : openChallengeReader) {
+            openChallengeCount++;
+
+            log_records::OpenLoopTimestampsRecord openChallengeData;
+            if (!readRecord(entry, openChallengeData)) {
+                std::cerr << "Warning: Skipping corrupt openChallenge entry (type " << entry.type << ", size " << entry.size << ")" << std::endl;
                 continue;
             }
 
-            std::memcpy(&openChallengeData, entry.data.data(), sizeof(openChallengeData));
-
             challengeTimestamps.push_back({
                 entry.timestamp,  // mainLoop_ns
                 openChallengeData.lidarTimestamp_ns,
@@ -285,32 +306,25 @@ int main(int argc, char **argv) {
                 0  // No camera in openChallenge
             });
         }
+        std::cout << "Loaded " << openChallengeCount << " openChallenge entries." << std::endl;
     }
 
     if (isScanMap) {
-        LogReader scanMapReader((fs::path(folderPath) / "scanMap.bin").string());
-        if (!scanMapReader.readAll(scanMapEntries)) {
+        MappedLogReader scanMapReader((fs::path(folderPath) / "scanMap.bin").string());
+        if (!scanMapReader.open()) {
             std::cerr << "Failed to read scanMap log" << std::endl;
             return 1;
         }
-        std::cout << "Loaded " << scanMapEntries.size() << " scanMap entries." << std::endl;
-
-        for (const auto &entry : scanMapEntries) {
-            // This struct must match exactly what was logged
-            struct {
-                uint64_t lidarTimestamp_ns;
-                uint64_t pico2Timestamp_ns;
-                uint64_t cameraTimestamp_ns;
-            } scanMapData;
-
-            // Check if data size is correct before copying
-            if (entry.data.size() != sizeof(scanMapData)) {
-                std::cerr << "Warning: Skipping corrupt scanMap entry (size " << entry.data.size() << ")" << std::endl;
+        size_t scanMapCount = 0;
+        for (const auto &entry : scanMapReader) {
+            scanMapCount++;
+
+            log_records::LoopTimestampsRecord scanMapData;
+            if (!readRecord(entry, scanMapData)) {
+                std::cerr << "Warning: Skipping corrupt scanMap entry (type " << entry.type << ", size " << entry.size << ")" << std::endl;
                 continue;
             }
 
-            std::memcpy(&scanMapData, entry.data.data(), sizeof(scanMapData));
-
             challengeTimestamps.push_back(
                 {entry.timestamp,  // mainLoop_ns
                  scanMapData.lidarTimestamp_ns,
@@ -318,32 +332,25 @@ int main(int argc, char **argv) {
                  scanMapData.cameraTimestamp_ns}
             );
         }
+        std::cout << "Loaded " << scanMapCount << " scanMap entries." << std::endl;
     }
 
     if (isObstacleChallenge) {
-        LogReader obstacleChallengeReader((fs::path(folderPath) / "obstacleChallenge.bin").string());
-        if (!obstacleChallengeReader.readAll(obstacleChallengeEntries)) {
+        MappedLogReader obstacleChallengeReader((fs::path(folderPath) / "obstacleChallenge.bin").string());
+        if (!obstacleChallengeReader.open()) {
             std::cerr << "Failed to read obstacleChallenge log" << std::endl;
             return 1;
         }
-        std::cout << "Loaded " << obstacleChallengeEntries.size() << " obstacleChallenge entries." << std::endl;
-
-        for (const auto &entry : obstacleChallengeEntries) {
-            // This struct must match exactly what was logged
-            struct {
-                uint64_t lidarTimestamp_ns;
-                uint64_t pico2Timestamp_ns;
-                uint64_t cameraTimestamp_ns;
-            } obstacleChallengeData;
-
-            // Check if data size is correct before copying
-            if (entry.data.size() != sizeof(obstacleChallengeData)) {
-                std::cerr << "Warning: Skipping corrupt obstacleChallenge entry (size " << entry.data.size() << ")" << std::endl;
+        size_t obstacleChallengeCount = 0;
+        for (const auto &entry : obstacleChallengeReader) {
+            obstacleChallengeCount++;
+
+            log_records::LoopTimestampsRecord obstacleChallengeData;
+            if (!readRecord(entry, obstacleChallengeData)) {
+                std::cerr << "Warning: Skipping corrupt obstacleChallenge entry (type " << entry.type << ", size " << entry.size << ")" << std::endl;
                 continue;
             }
 
-            std::memcpy(&obstacleChallengeData, entry.data.data(), sizeof(obstacleChallengeData));
-
             challengeTimestamps.push_back(
                 {entry.timestamp,  // mainLoop_ns
                  obstacleChallengeData.lidarTimestamp_ns,
@@ -351,6 +358,20 @@ int main(int argc, char **argv) {
                  obstacleChallengeData.cameraTimestamp_ns}
             );
         }
+        std::cout << "Loaded " << obstacleChallengeCount << " obstacleChallenge entries." << std::endl;
+    }
+
+    // Camera entry shown at each loop timestamp, so the cache can prefetch by loop index
+    std::vector<size_t> cameraIdxForLoop;
+    std::unique_ptr<FrameCache> frameCache;
+    if (hasCamera) {
+        cameraIdxForLoop.reserve(challengeTimestamps.size());
+        for (const auto &timestamps : challengeTimestamps) {
+            cameraIdxForLoop.push_back(findClosestIndex(cameraEntries, timestamps.camera_ns));
+        }
+
+        frameCache = std::make_unique<FrameCache>(cameraEntries, reconstructTimedFrame, frameCacheMiB * 1024 * 1024);
+        std::cout << "Frame cache: " << frameCacheMiB << " MiB." << std::endl;
     }
 
     // Windows: only open Camera View if we have camera data
@@ -365,30 +386,10 @@ int main(int argc, char **argv) {
 
     size_t lidarIdx = 0;
     size_t pico2Idx = 0;
-    size_t cameraIdx = 0;
-
-    auto findClosestIndex = [](const std::vector<LogEntry> &entries, size_t startIdx, uint64_t targetTs) -> size_t {
-        size_t idx = startIdx;
-
-        // Move forward if next entry is closer
-        while (idx + 1 < entries.size() && std::abs(static_cast<int64_t>(entries[idx + 1].timestamp - targetTs)) <
-                                               std::abs(static_cast<int64_t>(entries[idx].timestamp - targetTs)))
-        {
-            idx++;
-        }
-
-        // Move backward if previous entry is closer
-        while (idx > 0 && std::abs(static_cast<int64_t>(entries[idx - 1].timestamp - targetTs)) <
-                              std::abs(static_cast<int64_t>(entries[idx].timestamp - targetTs)))
-        {
-            idx--;
-        }
-
-        return idx;
-    };
 
     size_t currentTimeIdx = 0;
-    int playDirection = 0;  // -1 = backward, +1 = forward, 0 = stopped
+    int playDirection = 0;   // -1 = backward, +1 = forward, 0 = stopped
+    int lastDirection = +1;  // Direction of the last step, used for prefetching while stopped
     auto lastPressTime = std::chrono::steady_clock::now();
 
     while (true) {
@@ -398,8 +399,10 @@ int main(int argc, char **argv) {
         // --- Handle taps ---
         if (key == 'j') {  // step one frame back (single frame mode)
             if (currentTimeIdx > 0) currentTimeIdx--;
+            lastDirection = -1;
         } else if (key == 'l') {  // step one frame forward
             if (currentTimeIdx < challengeTimestamps.size() - 1) currentTimeIdx++;
+            lastDirection = +1;
         }
 
         // --- Handle continuous ---
@@ -427,15 +430,16 @@ int main(int argc, char **argv) {
         else if (key == -1 && playDirection == 0)
             continue;
         uint64_t currentTime = challengeTimestamps[currentTimeIdx].mainLoop_ns;
+        if (playDirection != 0) lastDirection = playDirection;
 
         // ---- LIDAR ----
-        lidarIdx = findClosestIndex(lidarEntries, lidarIdx, challengeTimestamps[currentTimeIdx].lidar_ns);
+        lidarIdx = findClosestIndex(lidarEntries, challengeTimestamps[currentTimeIdx].lidar_ns);
         if (lidarIdx >= lidarEntries.size()) continue;
         const auto &lidarEntry = lidarEntries[lidarIdx];
         TimedLidarData timedLidarData = reconstructTimedLidar(lidarEntry);
 
         // ---- Pico2 ----
-        pico2Idx = findClosestIndex(pico2Entries, pico2Idx, challengeTimestamps[currentTimeIdx].pico2_ns);
+        pico2Idx = findClosestIndex(pico2Entries, challengeTimestamps[currentTimeIdx].pico2_ns);
         if (pico2Idx >= pico2Entries.size()) continue;
         const auto &pico2Entry = pico2Entries[pico2Idx];
         TimedPico2Data timedPico2Data = reconstructTimedPico2(pico2Entry);
@@ -452,29 +456,41 @@ int main(int argc, char **argv) {
         camera_processor::ColorMasks colorMasks;
         std::vector<camera_processor::BlockAngle> blockAngles;
         if (hasCamera) {
-            cameraIdx = findClosestIndex(cameraEntries, cameraIdx, challengeTimestamps[currentTimeIdx].camera_ns);
-            if (cameraIdx < cameraEntries.size()) {
-                timedFrame = reconstructTimedFrame(cameraEntries[cameraIdx]);
-                colorMasks = camera_processor::filterColors(timedFrame);
-                blockAngles = camera_processor::computeBlockAngles(colorMasks, camWidth, camHFov);
-
-                if (key == 'i') {
-                    selectMode = true;
-                    polygonPoints.clear();
-                    std::cout << "Click points to define polygon, then press 'c' to confirm.\n";
-
-                    continue;
-                } else if (key == 'c') {
-                    selectMode = false;
-                    cv::Scalar lower1, upper1, lower2, upper2;
-                    computeHSVBounds(timedFrame.frame, lower1, upper1, lower2, upper2);
-                    std::cout << "Lower1 HSV: " << lower1 << "\n";
-                    std::cout << "Upper1 HSV: " << upper1 << "\n";
-                    std::cout << "Lower2 HSV: " << lower2 << "\n";
-                    std::cout << "Upper2 HSV: " << upper2 << "\n";
-
-                    continue;
-                }
+            // Decode around the cursor in the background: mostly ahead in the play direction, some behind
+            std::vector<size_t> prefetchIndices;
+            prefetchIndices.reserve(prefetchAhead + prefetchBehind);
+            for (size_t step = 1; step <= prefetchAhead + prefetchBehind; ++step) {
+                bool ahead = step <= prefetchAhead;
+                size_t distance = ahead ? step : step - prefetchAhead;
+                int direction = ahead ? lastDirection : -lastDirection;
+
+                if (direction < 0 && distance > currentTimeIdx) continue;
+                size_t loopIdx = direction > 0 ? currentTimeIdx + distance : currentTimeIdx - distance;
+                if (loopIdx >= cameraIdxForLoop.size()) continue;
+                prefetchIndices.push_back(cameraIdxForLoop[loopIdx]);
+            }
+            frameCache->prefetch(prefetchIndices);
+
+            timedFrame = frameCache->get(cameraIdxForLoop[currentTimeIdx]);
+            colorMasks = camera_processor::filterColors(timedFrame);
+            blockAngles = camera_processor::computeBlockAngles(colorMasks, camWidth, camHFov);
+
+            if (key == 'i') {
+                selectMode = true;
+                polygonPoints.clear();
+                std::cout << "Click points to define polygon, then press 'c' to confirm.\n";
+
+                continue;
+            } else if (key == 'c') {
+                selectMode = false;
+                cv::Scalar lower1, upper1, lower2, upper2;
+                computeHSVBounds(timedFrame.frame, lower1, upper1, lower2, upper2);
+                std::cout << "Lower1 HSV: " << lower1 << "\n";
+                std::cout << "Upper1 HSV: " << upper1 << "\n";
+                std::cout << "Lower2 HSV: " << lower2 << "\n";
+                std::cout << "Upper2 HSV: " << upper2 << "\n";
+
+                continue;
             }
         }
 
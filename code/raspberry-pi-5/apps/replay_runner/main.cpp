@@ -0,0 +1,622 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory_resource>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "alloc_counter.h"
+#include "camera_processor.h"
+#include "camera_struct.h"
+#include "combined_processor.h"
+#include "lidar_processor.h"
+#include "lidar_struct.h"
+#include "log_reader.h"
+#include "pico2_struct.h"
+#include "thread_pool.hpp"
+#include "tick_arena.hpp"
+
+namespace fs = std::filesystem;
+
+// Same camera parameters as log_viewer, so the results match what it shows
+const uint32_t camWidth = 1296;
+const float camHFov = 98.0f;
+
+struct SensorTimestamps {
+    uint64_t mainLoop_ns;
+    uint64_t lidar_ns;
+    uint64_t pico2_ns;
+    uint64_t camera_ns;  // Will be 0 if not available
+};
+
+// Pipeline stages timed for every tick, in execution order
+enum Stage
+{
+    DECODE_SENSORS,
+    DECODE_CAMERA,
+    FILTER_LIDAR_DATA,
+    APROXIMATE_ROBOT_POSE,
+    GET_LINES,
+    GET_RELATIVE_WALLS,
+    RESOLVE_WALLS,
+    GET_TRAFFIC_LIGHT_POINTS,
+    FILTER_COLORS,
+    COMPUTE_BLOCK_ANGLES,
+    COMBINE_TRAFFIC_LIGHT_INFO,
+    CLASSIFY_TRAFFIC_LIGHTS,
+    STAGE_COUNT
+};
+
+// The stages of the control tick itself; the decode stages only stand in for the sensor threads
+const int FIRST_TICK_STAGE = FILTER_LIDAR_DATA;
+
+// Every container of the tick stages comes from one arena, reset each tick (the obstacle challenge's five arenas in one)
+const size_t TICK_ARENA_BYTES = 5 * 64 * 1024;
+
+// Whether a stage's allocations make a tick fail --fail-on-alloc. filterColors() is left out: its contours come from
+// cv::findContours, which only fills std::vector (see camera_processor.h). Its allocations are still reported.
+bool checkedForAllocations(int stage) {
+    return stage >= FIRST_TICK_STAGE && stage != FILTER_COLORS;
+}
+
+const char *const STAGE_NAMES[STAGE_COUNT] = {
+    "decodeSensors",
+    "decodeCamera",
+    "filterLidarData",
+    "aproximateRobotPose",
+    "getLines",
+    "getRelativeWalls",
+    "resolveWalls",
+    "getTrafficLightPoints",
+    "filterColors",
+    "computeBlockAngles",
+    "combineTrafficLightInfo",
+    "classifyTrafficLights",
+};
+
+struct RunSummary {
+    std::string folder;
+    std::string challenge;
+    std::string outputFile;
+    bool ok = false;
+    std::string error;
+    size_t ticks = 0;
+    double wallSeconds = 0.0;
+    double stageTotal_us[STAGE_COUNT] = {};
+    uint64_t stageTotalAllocations[STAGE_COUNT] = {};
+    uint64_t stageTotalAllocatedBytes[STAGE_COUNT] = {};
+    size_t allocatingTicks = 0;  ///< Ticks whose checked tick stages allocated
+};
+
+TimedLidarData reconstructTimedLidar(const LogEntryView &entry) {
+    // Current logs store the compact fixed-point scan, older ones an array of RawLidarNode
+    std::vector<RawLidarNode> nodes;
+    bool ok;
+    if (entry.type == log_records::LIDAR_SCAN_COMPACT) {
+        CompactLidarScan scan;
+        ok = scan.assign(entry.data, entry.size);
+        scan.toNodes(nodes);
+    } else {
+        ok = readArray(entry, nodes);
+    }
+    if (!ok) {
+        std::cerr << "Warning: Skipping corrupt Lidar entry (type " << entry.type << ", size " << entry.size << ")" << std::endl;
+    }
+
+    return TimedLidarData{std::move(nodes), std::chrono::steady_clock::time_point(std::chrono::nanoseconds(entry.timestamp))};
+}
+
+TimedPico2Data reconstructTimedPico2(const LogEntryView &entry) {
+    TimedPico2Data pico2Data{};
+
+    log_records::Pico2Record payload{};
+    if (!readRecord(entry, payload)) {
+        std::cerr << "Warning: Corrupt Pico2 entry (type " << entry.type << ", size " << entry.size << ")" << std::endl;
+    }
+
+    pico2Data.accel = payload.accel;
+    pico2Data.euler = payload.euler;
+    pico2Data.encoderAngle = payload.encoderAngle;
+    pico2Data.timestamp = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(entry.timestamp));
+
+    return pico2Data;
+}
+
+std::vector<TimedPico2Data> reconstructPico2RingBufferVector(
+    const std::vector<LogEntryView> &pico2Entries,
+    size_t currentIdx,
+    size_t windowSize = 30
+) {
+    std::vector<TimedPico2Data> result;
+    if (pico2Entries.empty() || currentIdx >= pico2Entries.size()) {
+        return result;
+    }
+
+    size_t startIdx = (currentIdx >= windowSize - 1) ? currentIdx - (windowSize - 1) : 0;
+
+    result.reserve(currentIdx - startIdx + 1);
+    for (size_t i = startIdx; i <= currentIdx; ++i) {
+        result.push_back(reconstructTimedPico2(pico2Entries[i]));
+    }
+
+    return result;
+}
+
+TimedFrame reconstructTimedFrame(const LogEntryView &entry) {
+    if (entry.size == 0) {
+        throw std::runtime_error("Empty image entry data");
+    }
+
+    cv::Mat encoded(1, static_cast<int>(entry.size), CV_8UC1, const_cast<uint8_t *>(entry.data));
+    cv::Mat frame = cv::imdecode(encoded, cv::IMREAD_UNCHANGED);
+    if (frame.empty()) {
+        throw std::runtime_error("Failed to decode image from entry data");
+    }
+
+    return TimedFrame{std::move(frame), std::chrono::steady_clock::time_point(std::chrono::nanoseconds(entry.timestamp))};
+}
+
+// Entries are sorted by timestamp, so the closest one is either the lower bound or the entry before it
+size_t findClosestIndex(const std::vector<LogEntryView> &entries, uint64_t targetTs) {
+    auto it = std::lower_bound(entries.begin(), entries.end(), targetTs, [](const LogEntryView &entry, uint64_t ts) {
+        return entry.timestamp < ts;
+    });
+    if (it == entries.begin()) return 0;
+    if (it == entries.end()) return entries.size() - 1;
+
+    size_t idx = static_cast<size_t>(it - entries.begin());
+    if (targetTs - entries[idx - 1].timestamp <= entries[idx].timestamp - targetTs) idx--;
+
+    return idx;
+}
+
+/**
+ * Read the main loop log of a run, whichever challenge wrote it.
+ * @return false (with @p error set) if the folder has no single readable challenge log.
+ */
+bool loadTicks(const fs::path &folder, std::string &challenge, std::vector<SensorTimestamps> &ticks, std::string &error) {
+    const char *const CHALLENGE_LOGS[] = {"openChallenge", "scanMap", "obstacleChallenge"};
+
+    int found = 0;
+    for (const char *name : CHALLENGE_LOGS) {
+        if (fs::exists(folder / (std::string(name) + ".bin"))) {
+            challenge = name;
+            found++;
+        }
+    }
+    if (found != 1) {
+        error = found == 0 ? "No challenge log file found" : "More than one challenge log file found";
+        return false;
+    }
+
+    MappedLogReader reader((folder / (challenge + ".bin")).string());
+    if (!reader.open()) {
+        error = "Failed to read " + challenge + " log";
+        return false;
+    }
+
+    for (const auto &entry : reader) {
+        if (challenge == "openChallenge") {
+            log_records::OpenLoopTimestampsRecord record;
+            if (!readRecord(entry, record)) continue;
+            ticks.push_back({entry.timestamp, record.lidarTimestamp_ns, record.pico2Timestamp_ns, 0});
+        } else {
+            log_records::LoopTimestampsRecord record;
+            if (!readRecord(entry, record)) continue;
+            ticks.push_back({entry.timestamp, record.lidarTimestamp_ns, record.pico2Timestamp_ns, record.cameraTimestamp_ns});
+        }
+    }
+    return true;
+}
+
+/**
+ * Write @p text as a quoted JSON string, escaping quotes, backslashes and control characters.
+ */
+void writeJsonString(std::ostream &out, const std::string &text) {
+    out << '"';
+    for (char c : text) {
+        switch (c) {
+        case '"':
+            out << "\\\"";
+            break;
+        case '\\':
+            out << "\\\\";
+            break;
+        case '\n':
+            out << "\\n";
+            break;
+        case '\r':
+            out << "\\r";
+            break;
+        case '\t':
+            out << "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+            } else {
+                out << c;
+            }
+        }
+    }
+    out << '"';
+}
+
+/**
+ * Write the name of every stage as a JSON object key, followed by its value.
+ */
+template <typename Value>
+void writeStageObject(std::ostream &out, Value &&value) {
+    out << '{';
+    for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+        if (stage) out << ',';
+        writeJsonString(out, STAGE_NAMES[stage]);
+        out << ':' << value(stage);
+    }
+    out << '}';
+}
+
+/**
+ * The log folder itself, without a trailing separator, so its filename() is the folder's name.
+ */
+fs::path normalizedFolder(const std::string &folderPath) {
+    fs::path folder = fs::path(folderPath).lexically_normal();
+    if (folder.filename().empty()) folder = folder.parent_path();
+    return folder;
+}
+
+void writeSegment(std::ostream &out, const std::optional<lidar_processor::LineSegment> &segment) {
+    if (!segment) {
+        out << "null";
+        return;
+    }
+    out << '[' << segment->x1 << ',' << segment->y1 << ',' << segment->x2 << ',' << segment->y2 << ']';
+}
+
+const char *turnDirectionName(const std::optional<RotationDirection> &direction) {
+    if (!direction) return "null";
+    return *direction == RotationDirection::CLOCKWISE ? "\"CLOCKWISE\"" : "\"COUNTER_CLOCKWISE\"";
+}
+
+/**
+ * Replay one log folder through the perception pipeline and write one JSON line per tick.
+ * @param outputFile File the ticks are written to, unique to this folder.
+ * @param allocCheckWarmup If set, fail the run at the first tick after this many ticks whose checked tick stages allocate.
+ */
+RunSummary replayRun(const std::string &folderPath, const std::string &outputFile, std::optional<size_t> allocCheckWarmup) {
+    RunSummary summary;
+    summary.folder = folderPath;
+
+    fs::path folder = normalizedFolder(folderPath);
+
+    std::vector<SensorTimestamps> ticks;
+    if (!loadTicks(folder, summary.challenge, ticks, summary.error)) return summary;
+
+    MappedLogReader lidarReader((folder / "lidar.bin").string());
+    std::vector<LogEntryView> lidarEntries;
+    if (!lidarReader.open() || !lidarReader.readAll(lidarEntries) || lidarEntries.empty()) {
+        summary.error = "Failed to read Lidar log file";
+        return summary;
+    }
+
+    MappedLogReader pico2Reader((folder / "pico2.bin").string());
+    std::vector<LogEntryView> pico2Entries;
+    if (!pico2Reader.open() || !pico2Reader.readAll(pico2Entries) || pico2Entries.empty()) {
+        summary.error = "Failed to read Pico2 log file";
+        return summary;
+    }
+
+    MappedLogReader cameraReader((folder / "camera.bin").string());
+    bool hasCamera = summary.challenge != "openChallenge";
+    if (hasCamera && !cameraReader.open()) {
+        summary.error = "Failed to read Camera log file";
+        return summary;
+    }
+
+    summary.outputFile = outputFile;
+    std::ofstream out(summary.outputFile);
+    if (!out) {
+        summary.error = "Failed to open output file " + summary.outputFile;
+        return summary;
+    }
+    out << std::setprecision(std::numeric_limits<float>::max_digits10);
+
+    std::optional<float> initialHeading;
+    std::optional<RotationDirection> robotTurnDirection;
+
+    // Reused from tick to tick, as in the obstacle challenge's Robot, so a warmed-up tick does not allocate
+    TickArena arena(TICK_ARENA_BYTES);
+    TimedLidarData filteredLidarData;
+
+    auto runStart = std::chrono::steady_clock::now();
+    for (size_t tick = 0; tick < ticks.size(); ++tick) {
+        const SensorTimestamps &timestamps = ticks[tick];
+        arena.reset();  // The previous tick's containers went out of scope with it
+        double stage_us[STAGE_COUNT] = {};
+        AllocCounts stageAllocations[STAGE_COUNT] = {};
+
+        // Each run replays on a single thread, so the thread's allocation counts are the run's
+        auto stageStart = std::chrono::steady_clock::now();
+        AllocCounts stageStartAllocations = alloc_counter::threadCounts();
+        auto endStage = [&](Stage stage) {
+            auto now = std::chrono::steady_clock::now();
+            AllocCounts allocations = alloc_counter::threadCounts();
+            stage_us[stage] = std::chrono::duration<double, std::micro>(now - stageStart).count();
+            stageAllocations[stage] = allocations - stageStartAllocations;
+            stageStart = now;
+            stageStartAllocations = allocations;
+        };
+
+        // ---- Decode ----
+        TimedLidarData timedLidarData = reconstructTimedLidar(lidarEntries[findClosestIndex(lidarEntries, timestamps.lidar_ns)]);
+        size_t pico2Idx = findClosestIndex(pico2Entries, timestamps.pico2_ns);
+        TimedPico2Data timedPico2Data = reconstructTimedPico2(pico2Entries[pico2Idx]);
+        auto timedPico2Datas = reconstructPico2RingBufferVector(pico2Entries, pico2Idx);
+
+        if (not initialHeading) initialHeading = timedPico2Data.euler.h;
+
+        float heading = timedPico2Data.euler.h - initialHeading.value_or(0.0f);
+        heading = std::fmod(heading, 360.0f);
+        if (heading < 0.0f) heading += 360.0f;
+        endStage(DECODE_SENSORS);
+
+        TimedFrame timedFrame;
+        LogEntryView cameraEntry;
+        bool hasFrame = hasCamera && cameraReader.findClosest(timestamps.camera_ns, cameraEntry);
+        if (hasFrame) timedFrame = reconstructTimedFrame(cameraEntry);
+        endStage(DECODE_CAMERA);
+
+        // ---- Lidar processing ----
+        lidar_processor::filterLidarData(timedLidarData, filteredLidarData);
+        endStage(FILTER_LIDAR_DATA);
+
+        auto deltaPose = combined_processor::aproximateRobotPose(filteredLidarData, timedPico2Datas);
+        endStage(APROXIMATE_ROBOT_POSE);
+
+        auto lineSegments = lidar_processor::getLines(filteredLidarData, deltaPose, arena.resource(), 0.05f, 10, 0.10f, 0.10f, 18.0f, 0.20f);
+        endStage(GET_LINES);
+
+        auto relativeWalls =
+            lidar_processor::getRelativeWalls(lineSegments, Direction::fromHeading(heading), heading, arena.resource(), 0.30f, 25.0f, 0.22f);
+        auto newRobotTurnDirecton = lidar_processor::getTurnDirection(relativeWalls);
+        if (newRobotTurnDirecton) robotTurnDirection = newRobotTurnDirecton;
+        endStage(GET_RELATIVE_WALLS);
+
+        auto resolveWalls = lidar_processor::resolveWalls(relativeWalls);
+        endStage(RESOLVE_WALLS);
+
+        auto trafficLightPoints =
+            lidar_processor::getTrafficLightPoints(filteredLidarData, resolveWalls, deltaPose, robotTurnDirection, arena.resource());
+        endStage(GET_TRAFFIC_LIGHT_POINTS);
+
+        // ---- Camera processing ----
+        camera_processor::ColorMasks colorMasks;
+        if (hasFrame) colorMasks = camera_processor::filterColors(timedFrame);
+        endStage(FILTER_COLORS);
+
+        std::pmr::vector<camera_processor::BlockAngle> blockAngles(arena.resource());
+        if (hasFrame) blockAngles = camera_processor::computeBlockAngles(colorMasks, arena.resource(), camWidth, camHFov);
+        endStage(COMPUTE_BLOCK_ANGLES);
+
+        // ---- Combined processing ----
+        auto trafficLightInfos = combined_processor::combineTrafficLightInfo(blockAngles, trafficLightPoints, arena.resource());
+        endStage(COMBINE_TRAFFIC_LIGHT_INFO);
+
+        std::pmr::vector<combined_processor::ClassifiedTrafficLight> classifiedLights(arena.resource());
+        if (robotTurnDirection) {
+            classifiedLights = combined_processor::classifyTrafficLights(
+                trafficLightInfos,
+                resolveWalls,
+                *robotTurnDirection,
+                Segment::fromHeading(heading),
+                arena.resource()
+            );
+        }
+        endStage(CLASSIFY_TRAFFIC_LIGHTS);
+
+        AllocCounts tickAllocations;
+        for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+            summary.stageTotal_us[stage] += stage_us[stage];
+            summary.stageTotalAllocations[stage] += stageAllocations[stage].allocations;
+            summary.stageTotalAllocatedBytes[stage] += stageAllocations[stage].bytes;
+            if (checkedForAllocations(stage)) {
+                tickAllocations.allocations += stageAllocations[stage].allocations;
+                tickAllocations.bytes += stageAllocations[stage].bytes;
+            }
+        }
+        if (tickAllocations.allocations > 0) summary.allocatingTicks++;
+
+        // ---- Output ----
+        out << "{\"tick\":" << tick << ",\"mainLoop_ns\":" << timestamps.mainLoop_ns << ",\"heading\":" << heading
+            << ",\"turnDirection\":" << turnDirectionName(robotTurnDirection);
+
+        out << ",\"timing_us\":";
+        writeStageObject(out, [&](int stage) { return stage_us[stage]; });
+        out << ",\"allocations\":";
+        writeStageObject(out, [&](int stage) { return stageAllocations[stage].allocations; });
+        out << ",\"allocatedBytes\":";
+        writeStageObject(out, [&](int stage) { return stageAllocations[stage].bytes; });
+
+        out << ",\"walls\":{\"front\":";
+        writeSegment(out, resolveWalls.frontWall);
+        out << ",\"right\":";
+        writeSegment(out, resolveWalls.rightWall);
+        out << ",\"back\":";
+        writeSegment(out, resolveWalls.backWall);
+        out << ",\"left\":";
+        writeSegment(out, resolveWalls.leftWall);
+        out << ",\"farLeft\":";
+        writeSegment(out, resolveWalls.farLeftWall);
+        out << ",\"farRight\":";
+        writeSegment(out, resolveWalls.farRightWall);
+
+        out << "},\"trafficLightPoints\":[";
+        for (size_t i = 0; i < trafficLightPoints.size(); ++i) {
+            out << (i ? "," : "") << '[' << trafficLightPoints[i].x << ',' << trafficLightPoints[i].y << ']';
+        }
+
+        out << "],\"classifiedLights\":[";
+        for (size_t i = 0; i < classifiedLights.size(); ++i) {
+            const auto &ct = classifiedLights[i];
+            out << (i ? "," : "") << "{\"x\":" << ct.info.lidarPosition.x << ",\"y\":" << ct.info.lidarPosition.y << ",\"color\":\""
+                << (ct.info.cameraBlock.color == camera_processor::Color::RED ? "RED" : "GREEN")
+                << "\",\"segment\":" << static_cast<int>(ct.location.segment) << ",\"location\":" << static_cast<int>(ct.location.location)
+                << ",\"side\":\"" << (ct.location.side == WallSide::INNER ? "INNER" : "OUTER") << "\"}";
+        }
+        out << "]}\n";
+
+        summary.ticks++;
+
+        if (allocCheckWarmup && tick >= *allocCheckWarmup && tickAllocations.allocations > 0) {
+            std::ostringstream error;
+            error << "Tick " << tick << " allocated " << tickAllocations.allocations << " times (" << tickAllocations.bytes
+                  << " bytes):";
+            for (int stage = FIRST_TICK_STAGE; stage < STAGE_COUNT; ++stage) {
+                if (!checkedForAllocations(stage) || stageAllocations[stage].allocations == 0) continue;
+                error << ' ' << STAGE_NAMES[stage] << '=' << stageAllocations[stage].allocations;
+            }
+            summary.error = error.str();
+            return summary;
+        }
+    }
+
+    summary.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+    summary.ok = static_cast<bool>(out);
+    if (!summary.ok) summary.error = "Failed to write output file " + summary.outputFile;
+    return summary;
+}
+
+std::string summaryJson(const RunSummary &summary) {
+    std::ostringstream out;
+    out << std::setprecision(std::numeric_limits<float>::max_digits10);
+    out << "{\"folder\":";
+    writeJsonString(out, summary.folder);
+    out << ",\"challenge\":";
+    writeJsonString(out, summary.challenge);
+    out << ",\"ok\":" << (summary.ok ? "true" : "false");
+    if (!summary.ok) {
+        out << ",\"error\":";
+        writeJsonString(out, summary.error);
+        out << "}";
+        return out.str();
+    }
+
+    out << ",\"output\":";
+    writeJsonString(out, summary.outputFile);
+    out << ",\"ticks\":" << summary.ticks << ",\"wall_s\":" << summary.wallSeconds
+        << ",\"ticks_per_s\":" << (summary.wallSeconds > 0.0 ? summary.ticks / summary.wallSeconds : 0.0) << ",\"stageMean_us\":";
+    writeStageObject(out, [&](int stage) { return summary.ticks ? summary.stageTotal_us[stage] / summary.ticks : 0.0; });
+    out << ",\"allocatingTicks\":" << summary.allocatingTicks << ",\"stageMeanAllocations\":";
+    writeStageObject(out, [&](int stage) {
+        return summary.ticks ? static_cast<double>(summary.stageTotalAllocations[stage]) / summary.ticks : 0.0;
+    });
+    out << ",\"stageMeanAllocatedBytes\":";
+    writeStageObject(out, [&](int stage) {
+        return summary.ticks ? static_cast<double>(summary.stageTotalAllocatedBytes[stage]) / summary.ticks : 0.0;
+    });
+    out << "}";
+    return out.str();
+}
+
+/**
+ * Name each run's output file after its folder. Folders sharing a name (e.g. a/run1 and b/run1) get
+ * a counter appended, in argument order, so no run overwrites another or the summary.
+ */
+std::vector<std::string> outputFiles(const std::vector<std::string> &folders, const fs::path &outputDir) {
+    std::set<std::string> used = {"summary"};
+    std::vector<std::string> files;
+    for (const auto &folder : folders) {
+        std::string base = normalizedFolder(folder).filename().string();
+        std::string name = base;
+        for (int copy = 2; !used.insert(name).second; ++copy) {
+            name = base + "_" + std::to_string(copy);
+        }
+        files.push_back((outputDir / (name + ".jsonl")).string());
+    }
+    return files;
+}
+
+int main(int argc, char **argv) {
+    std::string outputDir = "replay_results";
+    size_t threadCount = 0;
+    std::optional<size_t> allocCheckWarmup;
+    std::vector<std::string> folders;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            outputDir = argv[++i];
+        } else if (arg == "-j" && i + 1 < argc) {
+            threadCount = std::stoul(argv[++i]);
+        } else if (arg == "--fail-on-alloc" && i + 1 < argc) {
+            allocCheckWarmup = std::stoul(argv[++i]);
+        } else {
+            folders.push_back(arg);
+        }
+    }
+
+    if (folders.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [-o output_dir] [-j threads] [--fail-on-alloc warmup_ticks] <log_folder>..."
+                  << std::endl;
+        return 1;
+    }
+
+    fs::create_directories(outputDir);
+
+    // Runs are replayed in parallel, so keep OpenCV single-threaded inside each one for stable stage timings
+    cv::setNumThreads(1);
+
+    ThreadPool pool(threadCount);
+    std::cout << "Replaying " << folders.size() << " runs on " << pool.size() << " threads." << std::endl;
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::string> files = outputFiles(folders, outputDir);
+    std::vector<std::future<RunSummary>> runs;
+    runs.reserve(folders.size());
+    for (size_t i = 0; i < folders.size(); ++i) {
+        runs.push_back(pool.submit(replayRun, folders[i], files[i], allocCheckWarmup));
+    }
+
+    std::ofstream summaryFile(fs::path(outputDir) / "summary.jsonl");
+    size_t totalTicks = 0;
+    int failures = 0;
+
+    // Collect in argument order so the summary is stable between invocations
+    for (size_t i = 0; i < runs.size(); ++i) {
+        RunSummary summary;
+        try {
+            summary = runs[i].get();
+        } catch (const std::exception &e) {
+            // e.g. a corrupt camera frame; the run's partial summary is lost, so name it here
+            summary.folder = folders[i];
+            summary.outputFile = files[i];
+            summary.error = e.what();
+        }
+
+        if (summary.ok) {
+            totalTicks += summary.ticks;
+            std::cout << summary.folder << ": " << summary.ticks << " ticks in " << summary.wallSeconds << " s ("
+                      << (summary.wallSeconds > 0.0 ? summary.ticks / summary.wallSeconds : 0.0) << " ticks/s)" << std::endl;
+        } else {
+            failures++;
+            std::cerr << summary.folder << ": " << summary.error << std::endl;
+        }
+        summaryFile << summaryJson(summary) << "\n";
+    }
+
+    double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Replayed " << totalTicks << " ticks in " << totalSeconds << " s (" << (totalSeconds > 0.0 ? totalTicks / totalSeconds : 0.0)
+              << " ticks/s overall), " << failures << " failed." << std::endl;
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lock_free_ring_buffer.hpp"
+#include "ring_buffer.hpp"
+
+// Stand-in for a buffered sensor sample, sized like a compact lidar scan by default
+struct Payload {
+    std::vector<uint8_t> bytes;
+    std::chrono::steady_clock::time_point timestamp;
+};
+
+// A RingBuffer behind a mutex, the way the sensor modules used it before LockFreeRingBuffer
+template <typename T>
+class MutexRingBuffer
+{
+public:
+    explicit MutexRingBuffer(size_t capacity)
+        : buffer_(capacity) {}
+
+    void push(T &&item) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffer_.push(std::move(item));
+    }
+
+    std::optional<T> latest() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return buffer_.latest();
+    }
+
+    std::vector<T> getAll() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return buffer_.getAll();
+    }
+
+private:
+    mutable std::mutex mutex_;
+    RingBuffer<T> buffer_;
+};
+
+struct BenchConfig {
+    size_t readers = 2;
+    double seconds = 3.0;
+    size_t capacity = 10;
+    size_t payloadBytes = 7 * 1500;
+    std::chrono::microseconds pushInterval{1000};
+};
+
+struct BenchResult {
+    std::vector<double> push_us;  ///< Duration of every push() call
+    uint64_t latestReads = 0;
+    uint64_t getAllReads = 0;
+};
+
+double percentile(std::vector<double> &sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[rank];
+}
+
+/**
+ * One producer pushes payloads at a fixed interval while the readers alternate
+ * latest() and getAll() as fast as they can, like a control loop reading history.
+ */
+template <typename Buffer>
+BenchResult runBench(const BenchConfig &config) {
+    using namespace std::chrono;
+
+    Buffer buffer(config.capacity);
+    BenchResult result;
+    std::atomic<bool> running = true;
+    std::atomic<uint64_t> latestReads = 0;
+    std::atomic<uint64_t> getAllReads = 0;
+    std::atomic<size_t> sink = 0;  // Keeps the reads from being optimized away
+
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < config.readers; ++i) {
+        readers.emplace_back([&] {
+            uint64_t latestCount = 0;
+            uint64_t getAllCount = 0;
+            size_t checksum = 0;
+            while (running) {
+                if (auto item = buffer.latest()) checksum += item->bytes.size();
+                latestCount++;
+                checksum += buffer.getAll().size();
+                getAllCount++;
+            }
+            latestReads += latestCount;
+            getAllReads += getAllCount;
+            sink += checksum;
+        });
+    }
+
+    auto end = steady_clock::now() + duration_cast<steady_clock::duration>(duration<double>(config.seconds));
+    auto nextPush = steady_clock::now();
+    while (steady_clock::now() < end) {
+        // Allocate outside the timed section, as a sensor thread fills its sample before pushing
+        Payload payload{std::vector<uint8_t>(config.payloadBytes, 0x5a), steady_clock::now()};
+
+        auto start = steady_clock::now();
+        buffer.push(std::move(payload));
+        result.push_us.push_back(duration<double, std::micro>(steady_clock::now() - start).count());
+
+        nextPush += config.pushInterval;
+        std::this_thread::sleep_until(nextPush);
+    }
+
+    running = false;
+    for (auto &reader : readers) reader.join();
+
+    result.latestReads = latestReads;
+    result.getAllReads = getAllReads;
+    return result;
+}
+
+void printResult(const std::string &name, BenchResult &result, double seconds) {
+    std::sort(result.push_us.begin(), result.push_us.end());
+    std::cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(2) << "push p50 " << std::setw(8)
+              << percentile(result.push_us, 50.0) << " us  p99 " << std::setw(8) << percentile(result.push_us, 99.0) << " us  max "
+              << std::setw(9) << (result.push_us.empty() ? 0.0 : result.push_us.back()) << " us  |  latest " << std::setw(10)
+              << result.latestReads / seconds << " /s  getAll " << std::setw(10) << result.getAllReads / seconds << " /s" << std::endl;
+}
+
+int main(int argc, char **argv) {
+    BenchConfig config;
+    if (argc > 5) {
+        std::cerr << "Usage: " << argv[0] << " [readers] [seconds] [capacity] [payload_bytes]" << std::endl;
+        return 1;
+    }
+    if (argc > 1) config.readers = std::stoul(argv[1]);
+    if (argc > 2) config.seconds = std::stod(argv[2]);
+    if (argc > 3) config.capacity = std::max<size_t>(1, std::stoul(argv[3]));
+    if (argc > 4) config.payloadBytes = std::stoul(argv[4]);
+
+    std::cout << config.readers << " reader(s), " << config.seconds << " s per run, capacity " << config.capacity << ", "
+              << config.payloadBytes << " byte payload, one push every " << config.pushInterval.count() << " us" << std::endl;
+
+    BenchResult mutexResult = runBench<MutexRingBuffer<Payload>>(config);
+    printResult("mutex RingBuffer", mutexResult, config.seconds);
+
+    BenchResult lockFreeResult = runBench<LockFreeRingBuffer<Payload>>(config);
+    printResult("LockFreeRingBuffer", lockFreeResult, config.seconds);
+
+    return 0;
+}
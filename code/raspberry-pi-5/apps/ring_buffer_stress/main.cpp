@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "lock_free_ring_buffer.hpp"
+
+// Every word holds the push index, so a reader can tell a torn or refilled element apart
+struct StressItem {
+    std::array<uint64_t, 32> words{};
+};
+
+struct StressConfig {
+    size_t readers = 4;
+    double seconds = 2.0;
+    size_t capacity = 2;  ///< Small, so the slot a reader just shared is the next one the writer claims
+};
+
+// Whether the element is whole, and still the one the reader first saw
+bool intact(const StressItem &item, uint64_t expected) {
+    return std::all_of(item.words.begin(), item.words.end(), [expected](uint64_t word) { return word == expected; });
+}
+
+/**
+ * One writer pushes as fast as it can while the readers pin, share and drop
+ * elements in a tight loop, and check each one twice while they hold it. A
+ * writer that refills a slot a reader still shares shows up as a changed
+ * element.
+ */
+int main(int argc, char **argv) {
+    StressConfig config;
+    if (argc > 4) {
+        std::cerr << "Usage: " << argv[0] << " [readers] [seconds] [capacity]" << std::endl;
+        return 1;
+    }
+    if (argc > 1) config.readers = std::stoul(argv[1]);
+    if (argc > 2) config.seconds = std::stod(argv[2]);
+    if (argc > 3) config.capacity = std::max<size_t>(1, std::stoul(argv[3]));
+
+    LockFreeRingBuffer<StressItem> buffer(config.capacity);
+    std::atomic<bool> running = true;
+    std::atomic<uint64_t> reads = 0;
+    std::atomic<uint64_t> torn = 0;
+
+    std::vector<std::thread> readers;
+    for (size_t i = 0; i < config.readers; ++i) {
+        readers.emplace_back([&, i] {
+            RingBufferSnapshot<StressItem> history;
+            uint64_t readCount = 0;
+            uint64_t tornCount = 0;
+            while (running) {
+                // Alternate the newest element and the whole buffer, whose oldest slots are the next to be claimed
+                if (i % 2 == 0) {
+                    history.clear();
+                    if (auto item = buffer.latestShared()) history.push_back(std::move(item));
+                } else {
+                    buffer.snapshot(history);
+                }
+                for (const auto &item : history) {
+                    uint64_t expected = item->words[0];
+                    if (!intact(*item, expected)) tornCount++;
+                    std::this_thread::yield();  // Hold the reference while the writer moves on
+                    if (!intact(*item, expected)) tornCount++;
+                    readCount++;
+                }
+            }
+            reads += readCount;
+            torn += tornCount;
+        });
+    }
+
+    uint64_t pushes = 0;
+    auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(config.seconds);
+    while (std::chrono::steady_clock::now() < end) {
+        for (int i = 0; i < 1000; ++i, ++pushes) {
+            buffer.pushRecycled([pushes](StressItem &item) { item.words.fill(pushes); });
+        }
+    }
+
+    running = false;
+    for (auto &reader : readers) reader.join();
+
+    PoolStats pool = buffer.poolStats();
+    std::cout << pushes << " pushes, " << reads << " reads by " << config.readers << " reader(s), capacity " << config.capacity << ", "
+              << pool.size << " slots: " << torn << " torn or refilled while shared" << std::endl;
+    return torn == 0 ? 0 : 1;
+}
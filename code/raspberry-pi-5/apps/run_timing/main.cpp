@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "log_reader.h"
+#include "log_records.h"
+
+namespace fs = std::filesystem;
+
+// Control loop period the challenges aim for (~30 Hz)
+const double defaultDeadline_ms = 33.0;
+
+// Histogram layout, in milliseconds
+const double histogramBinWidth_ms = 2.0;
+const size_t histogramBinCount = 25;  // Plus one overflow bin
+const size_t histogramBarWidth = 50;
+
+struct SensorTimestamps {
+    uint64_t mainLoop_ns;
+    uint64_t lidar_ns;
+    uint64_t pico2_ns;
+    uint64_t camera_ns;  // Will be 0 if not available
+};
+
+struct Stats {
+    size_t count = 0;
+    double min = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+    double stddev = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+};
+
+Stats computeStats(std::vector<double> values) {
+    Stats stats;
+    if (values.empty()) return stats;
+
+    std::sort(values.begin(), values.end());
+    stats.count = values.size();
+    stats.min = values.front();
+    stats.max = values.back();
+
+    double sum = 0.0;
+    for (double value : values) sum += value;
+    stats.mean = sum / values.size();
+
+    double squares = 0.0;
+    for (double value : values) squares += (value - stats.mean) * (value - stats.mean);
+    stats.stddev = std::sqrt(squares / values.size());
+
+    // Nearest-rank percentiles
+    auto percentile = [&](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * values.size()));
+        return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+    };
+    stats.p50 = percentile(50.0);
+    stats.p95 = percentile(95.0);
+    stats.p99 = percentile(99.0);
+
+    return stats;
+}
+
+void writeStats(std::ostream &out, const std::string &name, const std::vector<double> &values_ms) {
+    Stats stats = computeStats(values_ms);
+    out << "  " << std::left << std::setw(26) << name << std::right;
+    if (stats.count == 0) {
+        out << "no samples\n";
+        return;
+    }
+    out << "n=" << std::setw(6) << stats.count << "  min " << std::setw(7) << stats.min << "  mean " << std::setw(7) << stats.mean << "  p50 "
+        << std::setw(7) << stats.p50 << "  p95 " << std::setw(7) << stats.p95 << "  p99 " << std::setw(7) << stats.p99 << "  max "
+        << std::setw(7) << stats.max << "  sd " << std::setw(7) << stats.stddev << "  (ms)\n";
+}
+
+void writeHistogram(std::ostream &out, const std::string &name, const std::vector<double> &values_ms) {
+    out << "\n  " << name << " (ms)\n";
+    if (values_ms.empty()) {
+        out << "    no samples\n";
+        return;
+    }
+
+    std::vector<size_t> bins(histogramBinCount + 1, 0);
+    for (double value : values_ms) {
+        size_t bin = value < 0.0 ? 0 : static_cast<size_t>(value / histogramBinWidth_ms);
+        bins[std::min(bin, histogramBinCount)]++;
+    }
+
+    // Leave out the empty tail so short runs stay readable
+    size_t lastBin = bins.size() - 1;
+    while (lastBin > 0 && bins[lastBin] == 0) lastBin--;
+
+    size_t peak = *std::max_element(bins.begin(), bins.end());
+    for (size_t i = 0; i <= lastBin; ++i) {
+        std::ostringstream label;
+        label << std::fixed << std::setprecision(0);
+        if (i < histogramBinCount) {
+            label << i * histogramBinWidth_ms << "-" << (i + 1) * histogramBinWidth_ms;
+        } else {
+            label << ">=" << histogramBinCount * histogramBinWidth_ms;
+        }
+
+        size_t barLength = (bins[i] * histogramBarWidth + peak - 1) / peak;
+        out << "    " << std::setw(7) << label.str() << " | " << std::setw(6) << bins[i] << (barLength ? " " : "") << std::string(barLength, '#') << "\n";
+    }
+}
+
+/**
+ * Differences between consecutive timestamps, in milliseconds.
+ */
+std::vector<double> intervals_ms(const std::vector<uint64_t> &timestamps_ns) {
+    std::vector<double> result;
+    for (size_t i = 1; i < timestamps_ns.size(); ++i) {
+        result.push_back((static_cast<double>(timestamps_ns[i]) - static_cast<double>(timestamps_ns[i - 1])) / 1e6);
+    }
+    return result;
+}
+
+/**
+ * Read the timestamps of every record in a sensor log.
+ * @return false if the file cannot be opened.
+ */
+bool readSensorTimestamps(const fs::path &path, std::vector<uint64_t> &timestamps_ns) {
+    MappedLogReader reader(path.string());
+    if (!reader.open()) return false;
+
+    for (const auto &entry : reader) {
+        timestamps_ns.push_back(entry.timestamp);
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 3) {
+        std::cerr << "Usage: " << argv[0] << " <log_folder> [deadline_ms]" << std::endl;
+        return 1;
+    }
+
+    fs::path logFolder = argv[1];
+    double deadline_ms = argc == 3 ? std::stod(argv[2]) : defaultDeadline_ms;
+
+    // ---- Detect challenge ----
+    fs::path openChallengeFile = logFolder / "openChallenge.bin";
+    fs::path scanMapFile = logFolder / "scanMap.bin";
+    fs::path obstacleChallengeFile = logFolder / "obstacleChallenge.bin";
+
+    std::vector<fs::path> challengeFiles;
+    for (const auto &file : {openChallengeFile, scanMapFile, obstacleChallengeFile}) {
+        if (fs::exists(file)) challengeFiles.push_back(file);
+    }
+    if (challengeFiles.size() != 1) {
+        std::cerr << (challengeFiles.empty() ? "No challenge log file found." : "More than one challenge log file found.") << std::endl;
+        return 1;
+    }
+    fs::path challengeFile = challengeFiles.front();
+    bool isOpenChallenge = challengeFile == openChallengeFile;
+
+    // ---- Load per-tick timestamps ----
+    MappedLogReader challengeReader(challengeFile.string());
+    if (!challengeReader.open()) {
+        std::cerr << "Failed to read " << challengeFile << std::endl;
+        return 1;
+    }
+
+    std::vector<SensorTimestamps> ticks;
+    for (const auto &entry : challengeReader) {
+        if (isOpenChallenge) {
+            log_records::OpenLoopTimestampsRecord record;
+            if (!readRecord(entry, record)) {
+                std::cerr << "Warning: Skipping corrupt loop entry (type " << entry.type << ", size " << entry.size << ")" << std::endl;
+                continue;
+            }
+            ticks.push_back({entry.timestamp, record.lidarTimestamp_ns, record.pico2Timestamp_ns, 0});
+        } else {
+            log_records::LoopTimestampsRecord record;
+            if (!readRecord(entry, record)) {
+                std::cerr << "Warning: Skipping corrupt loop entry (type " << entry.type << ", size " << entry.size << ")" << std::endl;
+                continue;
+            }
+            ticks.push_back({entry.timestamp, record.lidarTimestamp_ns, record.pico2Timestamp_ns, record.cameraTimestamp_ns});
+        }
+    }
+    if (ticks.size() < 2) {
+        std::cerr << "Not enough loop entries to analyze (" << ticks.size() << ")." << std::endl;
+        return 1;
+    }
+
+    // ---- Loop period ----
+    std::vector<uint64_t> loopTimestamps;
+    for (const auto &tick : ticks) loopTimestamps.push_back(tick.mainLoop_ns);
+    std::vector<double> loopPeriods = intervals_ms(loopTimestamps);
+
+    std::vector<double> loopJitter;
+    size_t missedDeadlines = 0;
+    double worstOverrun_ms = 0.0;
+    for (double period : loopPeriods) {
+        loopJitter.push_back(std::abs(period - deadline_ms));
+        if (period > deadline_ms) {
+            missedDeadlines++;
+            worstOverrun_ms = std::max(worstOverrun_ms, period - deadline_ms);
+        }
+    }
+
+    // ---- Sensor age at use (main loop timestamp minus sample timestamp) ----
+    // A sample counts as reused when the tick used the same sample as the previous tick
+    struct SensorUsage {
+        const char *name;
+        uint64_t SensorTimestamps::*timestamp;
+        std::vector<double> ages_ms;
+        size_t reused = 0;
+        size_t used = 0;
+    };
+    std::vector<SensorUsage> sensors = {
+        {"Lidar", &SensorTimestamps::lidar_ns, {}},
+        {"Pico2", &SensorTimestamps::pico2_ns, {}},
+        {"Camera", &SensorTimestamps::camera_ns, {}},
+    };
+
+    for (auto &sensor : sensors) {
+        uint64_t previous = 0;
+        for (const auto &tick : ticks) {
+            uint64_t sample = tick.*sensor.timestamp;
+            if (sample == 0) continue;  // Not recorded
+
+            sensor.used++;
+            if (sample == previous) sensor.reused++;
+            previous = sample;
+            sensor.ages_ms.push_back((static_cast<double>(tick.mainLoop_ns) - static_cast<double>(sample)) / 1e6);
+        }
+    }
+
+    // ---- Sensor inter-arrival from the sensor logs ----
+    struct SensorArrival {
+        const char *name;
+        fs::path file;
+        std::vector<double> intervals_ms;
+        bool available = false;
+    };
+    std::vector<SensorArrival> arrivals = {
+        {"Lidar", logFolder / "lidar.bin", {}},
+        {"Pico2", logFolder / "pico2.bin", {}},
+        {"Camera", logFolder / "camera.bin", {}},
+    };
+    for (auto &arrival : arrivals) {
+        std::vector<uint64_t> timestamps_ns;
+        arrival.available = fs::exists(arrival.file) && readSensorTimestamps(arrival.file, timestamps_ns);
+        arrival.intervals_ms = intervals_ms(timestamps_ns);
+    }
+
+    // ---- Report ----
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(2);
+
+    double duration_s = (static_cast<double>(ticks.back().mainLoop_ns) - static_cast<double>(ticks.front().mainLoop_ns)) / 1e9;
+    report << "Run timing report: " << logFolder.string() << "\n";
+    report << "Challenge log: " << challengeFile.filename().string() << "\n";
+    report << "Ticks: " << ticks.size() << " over " << duration_s << " s (" << (duration_s > 0.0 ? (ticks.size() - 1) / duration_s : 0.0)
+           << " Hz)\n";
+
+    report << "\nLoop period (deadline " << deadline_ms << " ms)\n";
+    writeStats(report, "Period", loopPeriods);
+    writeStats(report, "Jitter |period-deadline|", loopJitter);
+    report << "  Missed deadlines          " << missedDeadlines << " / " << loopPeriods.size() << " ("
+           << 100.0 * missedDeadlines / loopPeriods.size() << "%), worst overrun " << worstOverrun_ms << " ms\n";
+    writeHistogram(report, "Loop period", loopPeriods);
+
+    report << "\nSensor age at use (loop timestamp - sample timestamp)\n";
+    for (const auto &sensor : sensors) {
+        writeStats(report, sensor.name, sensor.ages_ms);
+    }
+    for (const auto &sensor : sensors) {
+        if (sensor.used == 0) continue;
+        report << "  " << std::left << std::setw(26) << (std::string(sensor.name) + " reused") << std::right << sensor.reused << " / "
+               << sensor.used << " ticks (" << 100.0 * sensor.reused / sensor.used << "%)\n";
+    }
+    for (const auto &sensor : sensors) {
+        if (sensor.ages_ms.empty()) continue;
+        writeHistogram(report, std::string(sensor.name) + " age", sensor.ages_ms);
+    }
+
+    report << "\nSensor inter-arrival (from sensor logs)\n";
+    for (const auto &arrival : arrivals) {
+        if (!arrival.available) {
+            report << "  " << std::left << std::setw(26) << arrival.name << std::right << "log not available\n";
+            continue;
+        }
+        writeStats(report, arrival.name, arrival.intervals_ms);
+    }
+    for (const auto &arrival : arrivals) {
+        if (arrival.intervals_ms.empty()) continue;
+        writeHistogram(report, std::string(arrival.name) + " inter-arrival", arrival.intervals_ms);
+    }
+
+    std::cout << report.str();
+
+    fs::path reportFile = logFolder / "run_timing.txt";
+    std::ofstream out(reportFile);
+    if (!out || !(out << report.str())) {
+        std::cerr << "Failed to write " << reportFile << std::endl;
+        return 1;
+    }
+    std::cout << "\nReport written to " << reportFile.string() << std::endl;
+
+    return 0;
+}
@@ -3,9 +3,12 @@
 #include "lidar_module.h"
 #include "lidar_processor.h"
 #include "lidar_struct.h"
+#include "loop_driver.h"
 #include "pico2_module.h"
 #include "pico2_struct.h"
 #include "pid_controller.h"
+#include "thread_config.h"
+#include "trace.h"
 
 #include <atomic>
 #include <chrono>
@@ -29,11 +32,25 @@ void signalHandler(int signum) {
 // Pins
 const int BUTTON_PIN = 16;
 
+// Threads: the control loop and the Pico2 polling get a core each, the lidar and camera threads share the other two
+// (needs root or CAP_SYS_NICE; without it the threads keep running with the default scheduling)
+const bool LOCK_MEMORY = true;
+const ThreadConfig CONTROL_THREAD{"control", SchedulingPolicy::FIFO, 80, {3}};
+const ThreadConfig PICO2_THREAD{"pico2", SchedulingPolicy::FIFO, 70, {2}};
+const ThreadConfig LIDAR_THREAD{"lidar", SchedulingPolicy::FIFO, 60, {0, 1}};
+const ThreadConfig CAMERA_THREAD{"camera", SchedulingPolicy::OTHER, 0, {0, 1}};
+
+// Timeline of every thread, written to trace.json in the run's log folder (open it in ui.perfetto.dev)
+const bool TRACE_TIMELINE = true;
+
 // Camera
 const uint32_t CAM_WIDTH = 1296;
 const uint32_t CAM_HEIGHT = 972;
 const float CAM_HFOV = 98.0f;
 
+// Only the newest frame is used each tick, so there is no need for 30 full-resolution frames (~113 MB)
+const CameraHistoryOptions CAM_HISTORY{2};  // frameDepth; no thumbnails
+
 const auto cameraOptionCallback = [](lccv::PiCamera &cam) {
     libcamera::ControlList &camControls = cam.getControlList();
 
@@ -183,6 +200,11 @@ private:
     PIDController headingPid_;
     PIDController wallPid_;
 
+    // Reused every tick so reading the sensor history neither copies nor allocates
+    RingBufferSnapshot<TimedCompactLidarData> lidarSnapshot_;
+    RingBufferSnapshot<TimedFrame> frameSnapshot_;
+    RingBufferSnapshot<TimedPico2Data> pico2Window_;
+
     // Robot state
     Mode mode_ = Mode::NORMAL;
     int turnCount_ = 0;
@@ -213,30 +235,23 @@ private:
      * @return An optional RobotData struct. Returns nullopt if data is incomplete.
      */
     std::optional<RobotData> updateRobotData(float dt) {
-        std::vector<TimedLidarData> timedLidarDatas;
-        lidar_.getAllTimedLidarData(timedLidarDatas);
-        if (timedLidarDatas.size() < lidar_.bufferSize()) return std::nullopt;
+        if (!lidar_.getCompactSnapshot(lidarSnapshot_)) return std::nullopt;
 
-        std::vector<TimedPico2Data> timedPico2Datas;
-        pico2_.getAllTimedData(timedPico2Datas);
-        if (timedPico2Datas.size() < pico2_.bufferSize()) return std::nullopt;
+        // Only the newest scan is expanded to floats
+        TimedLidarData timedLidarData = lidarSnapshot_.back()->expand();
 
-        std::vector<TimedFrame> timedFrames;
-        camera_.getAllTimedFrame(timedFrames);
-        if (timedFrames.size() < camera_.bufferSize()) return std::nullopt;
+        // Pose integration only needs the Pico2 samples since the scan
+        if (!pico2_.getSnapshotSince(timedLidarData.timestamp, pico2Window_)) return std::nullopt;
 
-        auto &timedLidarData = timedLidarDatas.back();
-        auto &timedPico2Data = timedPico2Datas.back();
-        auto &timedFrame = timedFrames.back();
+        if (!camera_.getFrameSnapshot(frameSnapshot_)) return std::nullopt;
+
+        const TimedPico2Data &timedPico2Data = *pico2Window_.back();
+        const TimedFrame &timedFrame = *frameSnapshot_.back();
 
         // Log main loop timestamp
         auto now = std::chrono::steady_clock::now();
         uint64_t timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
-        struct {
-            uint64_t lidarTimestamp_ns;
-            uint64_t pico2Timestamp_ns;
-            uint64_t cameraTimestamp_ns;
-        } scanMapData{
+        log_records::LoopTimestampsRecord scanMapData{
             static_cast<uint64_t>(
                 std::chrono::duration_cast<std::chrono::nanoseconds>(timedLidarData.timestamp.time_since_epoch()).count()
             ),
@@ -245,7 +260,7 @@ private:
             ),
             static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(timedFrame.timestamp.time_since_epoch()).count())
         };
-        scanMapLogger_.writeData(timestamp_ns, &scanMapData, sizeof(scanMapData));
+        scanMapLogger_.writeRecord(timestamp_ns, scanMapData);
 
         if (!initialHeading_) {
             initialHeading_ = timedPico2Data.euler.h;
@@ -253,12 +268,12 @@ private:
         }
 
         RobotData data;
-        data.heading = timedPico2Datas.back().euler.h - *initialHeading_;
+        data.heading = timedPico2Data.euler.h - *initialHeading_;
         data.heading = std::fmod(data.heading, 360.0f);
         if (data.heading < 0.0f) data.heading += 360.0f;
 
-        auto filteredLidarData = lidar_processor::filterLidarData(timedLidarDatas.back());
-        auto deltaPose = combined_processor::aproximateRobotPose(filteredLidarData, timedPico2Datas);
+        auto filteredLidarData = lidar_processor::filterLidarData(timedLidarData);
+        auto deltaPose = combined_processor::aproximateRobotPose(filteredLidarData, pico2Window_);
         auto lineSegments = lidar_processor::getLines(filteredLidarData, deltaPose, 0.05f, 10, 0.10f, 0.10f, 18.0f, 0.20f);
         auto relativeWalls = lidar_processor::getRelativeWalls(lineSegments, headingDirection_, data.heading, 0.30f, 25.0f, 0.22f);
         auto resolvedWalls = lidar_processor::resolveWalls(relativeWalls);
@@ -400,16 +415,33 @@ int main() {
     std::string logFolder = std::string(home) + "/gfm_logs/scan_map_outer";
     std::string timedstampedLogFolder = Logger::generateTimestampedFolder(logFolder);
 
+    // Before the loggers and sensor threads start, so all their threads are on the timeline
+    if (TRACE_TIMELINE) trace::start(timedstampedLogFolder + "/trace.json");
+
     // Create logger instances on the stack
-    Logger lidarLogger(timedstampedLogFolder + "/lidar.bin");
-    Logger pico2Logger(timedstampedLogFolder + "/pico2.bin");
-    Logger cameraLogger(timedstampedLogFolder + "/camera.bin");
-    Logger openChallengeLogger(timedstampedLogFolder + "/scanMap.bin");
+    // Each drains to disk on its own writer thread so SD card stalls never reach the sensor threads
+    const Logger::AsyncOptions sensorLogOptions{4 * 1024 * 1024, Logger::BackpressurePolicy::DROP_NEWEST};
+    const Logger::AsyncOptions cameraLogOptions{32 * 1024 * 1024, Logger::BackpressurePolicy::DROP_NEWEST};
+    Logger lidarLogger(timedstampedLogFolder + "/lidar.bin", sensorLogOptions);
+    Logger pico2Logger(timedstampedLogFolder + "/pico2.bin", sensorLogOptions);
+    Logger cameraLogger(timedstampedLogFolder + "/camera.bin", cameraLogOptions);
+    Logger openChallengeLogger(timedstampedLogFolder + "/scanMap.bin", sensorLogOptions);
 
     // --- Initialize Hardware Modules ---
+    // Before the sensor threads start, so their buffers are locked too
+    if (LOCK_MEMORY) lockProcessMemory();
+
+    // Declared before the modules so it outlives their threads, which notify it
+    LoopDriver loopDriver(std::chrono::milliseconds(32));  // ~30 Hz when no new scan arrives
+
     LidarModule lidar(&lidarLogger);
     Pico2Module pico2(&pico2Logger);
-    CameraModule camera(&cameraLogger, cameraOptionCallback);
+    CameraModule camera(&cameraLogger, cameraOptionCallback, 2, CAM_HISTORY);
+    loopDriver.addTrigger("lidar", [&lidar] { return lidar.sequence(); });
+    lidar.setUpdateSignal(&loopDriver.signal());
+    lidar.setThreadConfig(LIDAR_THREAD);
+    pico2.setThreadConfig(PICO2_THREAD);
+    camera.setThreadConfig(CAMERA_THREAD);
 
     if (!lidar.initialize()) {
         std::cerr << "LidarModule initialization failed." << std::endl;
@@ -446,6 +478,7 @@ int main() {
         std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
 
+    JitterMeter controlJitter;
     if (!stop_flag) {
         std::cout << "Starting in 1.5 seconds..." << std::endl;
         std::this_thread::sleep_for(std::chrono::milliseconds(1500));
@@ -454,25 +487,24 @@ int main() {
         pico2.startLogging();
         camera.startLogging();
 
+        applyThreadConfig(CONTROL_THREAD);
+
         // --- Main Loop ---
-        const auto loopDuration = std::chrono::milliseconds(32);  // ~30 Hz
         auto lastTime = std::chrono::steady_clock::now();
 
         std::cout << "Robot running." << std::endl;
         while (!stop_flag) {
-            auto loopStart = std::chrono::steady_clock::now();
+            // Run as soon as a new scan is in, or one loop period after the previous tick at the latest
+            loopDriver.waitForTick();
+            controlJitter.mark();
 
-            float dt = std::chrono::duration<float>(loopStart - lastTime).count();
-            lastTime = loopStart;
+            auto now = std::chrono::steady_clock::now();
+            float dt = std::chrono::duration<float>(now - lastTime).count();
+            lastTime = now;
 
+            trace::begin("tick");
             robot.update(dt);
-
-            // Maintain loop rate
-            auto loopEnd = std::chrono::steady_clock::now();
-            auto elapsed = loopEnd - loopStart;
-            if (elapsed < loopDuration) {
-                std::this_thread::sleep_for(loopDuration - elapsed);
-            }
+            trace::end("tick");
         }
     } else {
         // If stopped before starting, clean up the created log folder
@@ -486,7 +518,45 @@ int main() {
     lidar.stop();
     lidar.shutdown();
     pico2.shutdown();
+    trace::stop();
     std::cout << "Shutdown complete." << std::endl;
+    auto printLoggerDrops = [](const char *name, const Logger &logger) {
+        std::cout << "[Logger] " << name << " dropped " << logger.droppedRecords() << " records (" << logger.droppedBytes() << " bytes)"
+                  << std::endl;
+    };
+    printLoggerDrops("lidar.bin", lidarLogger);
+    printLoggerDrops("pico2.bin", pico2Logger);
+    printLoggerDrops("camera.bin", cameraLogger);
+    printLoggerDrops("scanMap.bin", openChallengeLogger);
+    PoolStats scanPool = lidar.scanPoolStats();
+    std::cout << "[LidarModule] scan pool " << scanPool.hits << " hits, " << scanPool.misses << " misses (" << scanPool.size << " scans)"
+              << std::endl;
+    LoopDriver::Stats loopStats = loopDriver.stats();
+    double savedMean_ms = loopStats.triggeredTicks > 0 ? loopStats.savedTotal_ms / loopStats.triggeredTicks : 0.0;
+    std::cout << "[LoopDriver] " << loopStats.triggeredTicks << " of " << loopStats.ticks << " ticks woken by a scan, " << savedMean_ms
+              << " ms earlier on average (max " << loopStats.savedMax_ms << " ms)" << std::endl;
+    auto printJitter = [](const char *name, const JitterStats &jitter) {
+        std::cout << "[ThreadConfig] " << name << " thread " << jitter.intervals << " intervals, mean " << jitter.mean_ms << " ms, jitter "
+                  << jitter.stddev_ms << " ms (min " << jitter.min_ms << " ms, max " << jitter.max_ms << " ms)" << std::endl;
+    };
+    printJitter("control", controlJitter.stats());
+    printJitter("pico2", pico2.threadJitter());
+    printJitter("lidar", lidar.threadJitter());
+    printJitter("camera", camera.threadJitter());
+    auto printPeriodic = [](const char *name, const PeriodicStats &stats) {
+        std::cout << "[PeriodicExecutor] " << name << " " << stats.periods << " periods, " << stats.overruns << " overruns ("
+                  << stats.missedPeriods << " periods missed), lateness p50/p99/max " << stats.latenessP50_us << "/" << stats.latenessP99_us
+                  << "/" << stats.latenessMax_us << " us, jitter p50/p99/max " << stats.jitterP50_us << "/" << stats.jitterP99_us << "/"
+                  << stats.jitterMax_us << " us" << std::endl;
+    };
+    printPeriodic("control (period ticks)", loopDriver.periodStats());
+    printPeriodic("pico2", pico2.pollingStats());
+    trace::TraceStats traceStats = trace::stats();
+    std::cout << "[Trace] " << traceStats.events << " events from " << traceStats.threads << " threads, " << traceStats.dropped
+              << " dropped" << std::endl;
+    PoolStats framePool = camera.framePoolStats();
+    std::cout << "[CameraModule] frame pool " << framePool.hits << " hits, " << framePool.misses << " times dry (" << framePool.size
+              << " frames)" << std::endl;
 
     return 0;
 }
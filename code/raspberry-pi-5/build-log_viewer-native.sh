@@ -13,3 +13,6 @@ cmake -B build_native -DCMAKE_EXPORT_COMPILE_COMMANDS=OFF
 
 cmake --build build_native --target log_viewer -j$(nproc)
 cmake --build build_native --target log_to_video -j$(nproc)
+cmake --build build_native --target replay_runner -j$(nproc)
+cmake --build build_native --target run_timing -j$(nproc)
+cmake --build build_native --target ring_buffer_bench -j$(nproc)
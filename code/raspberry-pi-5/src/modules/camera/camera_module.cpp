@@ -1,12 +1,24 @@
 #include "camera_module.h"
-
-CameraModule::CameraModule(CameraOptionCallback callback)
-    : logger_(nullptr) {
-    callback(cam_);
-}
-
-CameraModule::CameraModule(Logger *logger, CameraOptionCallback callback)
-    : logger_(logger) {
+#include "trace.h"
+
+#include <algorithm>
+#include <utility>
+
+CameraModule::CameraModule(CameraOptionCallback callback, const CameraHistoryOptions &history)
+    : CameraModule(nullptr, std::move(callback), 0, history) {}
+
+CameraModule::CameraModule(Logger *logger, CameraOptionCallback callback, size_t encoderWorkers, const CameraHistoryOptions &history)
+    : history_(history)
+    , frameBuffer_(std::max<size_t>(history.frameDepth, 1))
+    , framePool_(
+          std::max<size_t>(history.frameDepth, 1) + READER_FRAMES +
+          (logger ? std::max<size_t>(encoderWorkers, 1) + ENCODER_QUEUE_CAPACITY : 0)
+      )
+    , thumbnailBuffer_(std::max<size_t>(history.thumbnailDepth, 1))
+    , logger_(logger) {
+    if (logger_) {
+        encoder_ = std::make_unique<FrameEncoder>(logger_, encoderWorkers, ENCODER_QUEUE_CAPACITY);
+    }
     callback(cam_);
 }
 
@@ -41,6 +53,9 @@ bool CameraModule::start() {
         return false;
     }
 
+    // lccv delivers BGR frames at the configured video size; already matching buffers are kept
+    framePool_.allocate(cam_.options->video_height, cam_.options->video_width, CV_8UC3);
+
     running_ = true;
 
     cameraThread_ = std::thread(&CameraModule::captureLoop, this);
@@ -60,67 +75,156 @@ void CameraModule::stop() {
     }
 
     cam_.stopVideo();
+
+    if (encoder_) encoder_->flush();
 }
 
 bool CameraModule::getFrame(TimedFrame &outTimedFrame) const {
-    std::lock_guard<std::mutex> lock(frameMutex_);
-    if (frameBuffer_.empty()) return false;
+    auto latest = frameBuffer_.latest();
+    if (!latest) return false;
 
-    outTimedFrame = frameBuffer_.latest().value();
+    outTimedFrame = std::move(*latest);
     return true;
 }
 
 size_t CameraModule::bufferSize() const {
-    std::lock_guard<std::mutex> lock(frameMutex_);
     return frameBuffer_.size();
 }
 
 bool CameraModule::getAllTimedFrame(std::vector<TimedFrame> &outTimedFrames) const {
-    std::lock_guard<std::mutex> lock(frameMutex_);
+    outTimedFrames = frameBuffer_.getAll();
+    return !outTimedFrames.empty();
+}
+
+bool CameraModule::getFrameSnapshot(RingBufferSnapshot<TimedFrame> &outSnapshot) const {
+    frameBuffer_.snapshot(outSnapshot);
+    return !outSnapshot.empty();
+}
 
-    if (frameBuffer_.empty()) return false;
+bool CameraModule::getFrameSnapshotBetween(
+    std::chrono::steady_clock::time_point from,
+    std::chrono::steady_clock::time_point to,
+    RingBufferSnapshot<TimedFrame> &outSnapshot
+) const {
+    frameBuffer_.snapshotBetween(from, to, outSnapshot);
+    return !outSnapshot.empty();
+}
 
-    outTimedFrames = frameBuffer_.getAll();
+bool CameraModule::getThumbnail(TimedFrame &outTimedFrame) const {
+    auto latest = thumbnailBuffer_.latest();
+    if (!latest) return false;
+
+    outTimedFrame = std::move(*latest);
     return true;
 }
 
+bool CameraModule::getAllThumbnails(std::vector<TimedFrame> &outTimedFrames) const {
+    outTimedFrames = thumbnailBuffer_.getAll();
+    return !outTimedFrames.empty();
+}
+
+bool CameraModule::getThumbnailSnapshot(RingBufferSnapshot<TimedFrame> &outSnapshot) const {
+    thumbnailBuffer_.snapshot(outSnapshot);
+    return !outSnapshot.empty();
+}
+
+bool CameraModule::getThumbnailSnapshotBetween(
+    std::chrono::steady_clock::time_point from,
+    std::chrono::steady_clock::time_point to,
+    RingBufferSnapshot<TimedFrame> &outSnapshot
+) const {
+    thumbnailBuffer_.snapshotBetween(from, to, outSnapshot);
+    return !outSnapshot.empty();
+}
+
+uint64_t CameraModule::sequence() const {
+    return frameBuffer_.sequence();
+}
+
+bool CameraModule::waitForNewer(uint64_t sequence, std::chrono::milliseconds timeout) {
+    return frameUpdated_.waitFor(timeout, [&] { return frameBuffer_.sequence() > sequence; });
+}
+
+void CameraModule::setUpdateSignal(UpdateSignal *signal) {
+    updateSignal_ = signal;
+}
+
+void CameraModule::setThreadConfig(const ThreadConfig &config) {
+    threadConfig_ = config;
+}
+
+JitterStats CameraModule::threadJitter() const {
+    return threadJitter_.stats();
+}
+
 bool CameraModule::waitForFrame(TimedFrame &outTimedFrame) {
-    std::unique_lock<std::mutex> lock(frameMutex_);
-    frameUpdated_.wait(lock, [&] { return !frameBuffer_.empty(); });
+    frameUpdated_.wait([&] { return !frameBuffer_.empty(); });
 
     outTimedFrame = frameBuffer_.latest().value();
     return true;
 }
 
 void CameraModule::captureLoop() {
+    applyThreadConfig(threadConfig_);
+    trace::registerThread();
+
     while (running_) {
-        cv::Mat frame;
-        if (!cam_.getVideoFrame(frame, 1000)) {
+        // Capture into a free pooled buffer; lccv and the in-place rotate then reuse its pixels
+        cv::Mat frame = framePool_.acquire();
+        trace::begin("getVideoFrame");
+        bool captured = cam_.getVideoFrame(frame, 1000);
+        trace::end("getVideoFrame");
+        if (!captured) {
             std::cerr << "[CameraModule] Timeout error" << std::endl;
             continue;
         }
 
+        threadJitter_.mark();
+        trace::instant("frame arrival");
+        trace::ScopedTrace publishTrace("publish frame");
         cv::rotate(frame, frame, cv::ROTATE_180);
 
         TimedFrame timedFrame{std::move(frame), std::chrono::steady_clock::now()};
 
-        if (logger_ and logging_) {
-            std::vector<uchar> buffer;
-            cv::imencode(".png", timedFrame.frame, buffer);
+        // Keep a handle for the encoder; the pixel data is shared, not copied
+        TimedFrame loggedFrame;
+        if (encoder_ and logging_) loggedFrame = timedFrame;
 
-            uint64_t ts = std::chrono::duration_cast<std::chrono::nanoseconds>(timedFrame.timestamp.time_since_epoch()).count();
-            logger_->writeData(ts, buffer.data(), buffer.size());
-        }
+        // A plain push: the slot is freed with the frame, so it never keeps a pooled buffer alive
+        frameBuffer_.push(std::move(timedFrame));
 
-        {
-            std::lock_guard<std::mutex> lock(frameMutex_);
-            frameBuffer_.push(std::move(timedFrame));
+        // waitForNewer() callers wait for every frame, not just the first one
+        frameUpdated_.notify();
+        if (UpdateSignal *signal = updateSignal_.load()) signal->notify();
+
+        // The frame is published to readers before it is queued for encoding, so
+        // delivery latency is the same with logging on and off
+        if (!loggedFrame.frame.empty()) {
+            encoder_->submit(loggedFrame);
         }
 
-        frameUpdated_.notify_all();
+        // Made after the full frame is published, so thumbnails never delay it
+        if (history_.thumbnailDepth > 0) {
+            auto latest = frameBuffer_.latestShared();
+            if (latest) pushThumbnail(*latest);
+        }
     }
 }
 
+void CameraModule::pushThumbnail(const TimedFrame &timedFrame) {
+    cv::Rect bounds(0, 0, timedFrame.frame.cols, timedFrame.frame.rows);
+    cv::Rect roi = history_.thumbnailRoi.area() > 0 ? history_.thumbnailRoi & bounds : bounds;
+    if (roi.area() <= 0) return;
+
+    thumbnailBuffer_.pushRecycled([&](TimedFrame &thumbnail) {
+        // Resize into the old thumbnail's pixels, unless a reader still shares them through a copied cv::Mat
+        if (thumbnail.frame.u && CV_XADD(&thumbnail.frame.u->refcount, 0) != 1) thumbnail.frame = cv::Mat();
+
+        cv::resize(timedFrame.frame(roi), thumbnail.frame, cv::Size(), history_.thumbnailScale, history_.thumbnailScale, cv::INTER_AREA);
+        thumbnail.timestamp = timedFrame.timestamp;
+    });
+}
+
 void CameraModule::startLogging() {
     logging_ = true;
 }
@@ -128,3 +232,11 @@ void CameraModule::startLogging() {
 void CameraModule::stopLogging() {
     logging_ = false;
 }
+
+uint64_t CameraModule::droppedLogFrames() const {
+    return encoder_ ? encoder_->droppedFrames() : 0;
+}
+
+PoolStats CameraModule::framePoolStats() const {
+    return framePool_.stats();
+}
@@ -5,13 +5,19 @@
 #include <condition_variable>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <opencv2/opencv.hpp>
 #include <thread>
 
+#include "camera_source.h"
 #include "camera_struct.h"
+#include "frame_encoder.h"
+#include "frame_pool.h"
 #include "logger.h"
-#include "ring_buffer.hpp"
+#include "lock_free_ring_buffer.hpp"
+#include "thread_config.h"
+#include "update_signal.hpp"
 
 /**
  * @brief Camera module that captures frames in a background thread.
@@ -19,8 +25,9 @@
  * Uses lccv::PiCamera to get frames from the camera device.
  * Runs a thread that keeps capturing frames, storing the latest one.
  * Provides thread-safe access to the latest frame and timestamp.
+ * Implements CameraSource, so the apps can run on a CameraReplay instead.
  */
-class CameraModule
+class CameraModule : public CameraSource
 {
 public:
     /**
@@ -35,8 +42,12 @@ public:
      * @brief Create the camera module.
      *
      * Sets up internal state but does not start capturing.
+     *
+     * @param callback Callback used to configure the internal lccv::PiCamera
+     *        before capture starts.
+     * @param history Depth of the full-resolution and thumbnail histories.
      */
-    CameraModule(CameraOptionCallback callback);
+    CameraModule(CameraOptionCallback callback, const CameraHistoryOptions &history = CameraHistoryOptions());
 
     /**
      * @brief Create the camera module with logging support.
@@ -44,11 +55,21 @@ public:
      * Initializes the camera module and stores the provided logger instance.
      * Capture does not begin until start() is called.
      *
+     * Frames are encoded for the log on a FrameEncoder worker pool, so the
+     * capture thread never waits on cv::imencode.
+     *
      * @param logger Pointer to a Logger instance for optional frame logging.
      * @param callback Callback used to configure the internal lccv::PiCamera
      *        before capture starts.
+     * @param encoderWorkers Number of threads encoding frames for the log.
+     * @param history Depth of the full-resolution and thumbnail histories.
      */
-    CameraModule(Logger *logger, CameraOptionCallback callback);
+    CameraModule(
+        Logger *logger,
+        CameraOptionCallback callback,
+        size_t encoderWorkers = 2,
+        const CameraHistoryOptions &history = CameraHistoryOptions()
+    );
 
     /**
      * @brief Destroy the camera module.
@@ -84,7 +105,8 @@ public:
      * @brief Stop capturing frames and wait for the capture thread to exit.
      *
      * Safe to call even if the camera is not currently running.
-     * Cleans up internal resources associated with frame capture.
+     * Cleans up internal resources associated with frame capture and waits
+     * until every frame queued for logging has been written to the Logger.
      */
     void stop();
 
@@ -98,17 +120,17 @@ public:
      *
      * @return true if a frame is available, false otherwise.
      */
-    bool getFrame(TimedFrame &outTimedFrame) const;
+    bool getFrame(TimedFrame &outTimedFrame) const override;
 
     /**
      * @brief Get the current number of frames stored in the buffer.
      *
      * This function is thread-safe and returns how many frames are
-     * currently stored in the internal RingBuffer.
+     * currently stored in the internal ring buffer.
      *
      * @return The number of frames currently in the buffer.
      */
-    size_t bufferSize() const;
+    size_t bufferSize() const override;
 
     /**
      * @brief Retrieve all frames currently stored in the buffer along with their timestamps.
@@ -119,7 +141,77 @@ public:
      * @param[out] outTimedFrames Vector to be filled with all frames and their timestamps.
      * @return true if the buffer contains at least one frame, false if empty.
      */
-    bool getAllTimedFrame(std::vector<TimedFrame> &outTimedFrames) const;
+    bool getAllTimedFrame(std::vector<TimedFrame> &outTimedFrames) const override;
+
+    /**
+     * @brief Share all buffered frames, oldest to newest, without copying them.
+     *
+     * This function is thread-safe. The frames stay valid for as long as the
+     * snapshot holds them; their pixel data is shared with the buffer and must
+     * not be modified. Reusing the same vector between calls avoids any allocation.
+     *
+     * @param[out] outSnapshot Replaced with the buffered frames.
+     * @return true if the buffer contains at least one frame, false if empty.
+     */
+    bool getFrameSnapshot(RingBufferSnapshot<TimedFrame> &outSnapshot) const override;
+
+    /**
+     * @brief Share the frames covering [@p from, @p to], oldest to newest, without copying them.
+     *
+     * This function is thread-safe. That is every frame captured in the window,
+     * preceded by the last frame captured at or before @p from, if still buffered.
+     *
+     * @param[out] outSnapshot Replaced with the frames.
+     * @return true if at least one frame was found.
+     */
+    bool getFrameSnapshotBetween(
+        std::chrono::steady_clock::time_point from,
+        std::chrono::steady_clock::time_point to,
+        RingBufferSnapshot<TimedFrame> &outSnapshot
+    ) const override;
+
+    /**
+     * @brief Get the latest thumbnail and its timestamp.
+     *
+     * Thread-safe. The timestamp is the one of the full-resolution frame it was made from.
+     *
+     * @param[out] outTimedFrame Receives the thumbnail, sharing its pixel data with the buffer.
+     * @return true if a thumbnail is available, false if there is none or thumbnails are disabled.
+     */
+    bool getThumbnail(TimedFrame &outTimedFrame) const override;
+
+    /**
+     * @brief Retrieve all buffered thumbnails, oldest to newest.
+     *
+     * Thread-safe. Only the cv::Mat headers are copied, so this is cheap enough
+     * to feed combined_processor::syncLidarCamera every tick.
+     *
+     * @param[out] outTimedFrames Vector to be filled with the thumbnails.
+     * @return true if at least one thumbnail is available.
+     */
+    bool getAllThumbnails(std::vector<TimedFrame> &outTimedFrames) const override;
+
+    /**
+     * @brief Share all buffered thumbnails, oldest to newest, without copying them.
+     *
+     * @param[out] outSnapshot Replaced with the thumbnails.
+     * @return true if at least one thumbnail is available.
+     */
+    bool getThumbnailSnapshot(RingBufferSnapshot<TimedFrame> &outSnapshot) const override;
+
+    /**
+     * @brief Share the thumbnails covering [@p from, @p to], oldest to newest, without copying them.
+     *
+     * Same window as getFrameSnapshotBetween(), over the longer thumbnail history.
+     *
+     * @param[out] outSnapshot Replaced with the thumbnails.
+     * @return true if at least one thumbnail was found.
+     */
+    bool getThumbnailSnapshotBetween(
+        std::chrono::steady_clock::time_point from,
+        std::chrono::steady_clock::time_point to,
+        RingBufferSnapshot<TimedFrame> &outSnapshot
+    ) const override;
 
     /**
      * @brief Block until a new frame is available, then return it.
@@ -133,7 +225,47 @@ public:
      *
      * @return true if a new frame was retrieved successfully, false otherwise.
      */
-    bool waitForFrame(TimedFrame &outTimedFrame);
+    bool waitForFrame(TimedFrame &outTimedFrame) override;
+
+    /**
+     * @brief Sequence number of the latest frame: the number of frames captured so far (0 if none).
+     *
+     * Thread-safe. Read it before a getter to know that the frame returned is at
+     * least that recent, then pass it to waitForNewer() to wait for the next one.
+     */
+    uint64_t sequence() const override;
+
+    /**
+     * @brief Block until a frame newer than @p sequence is available.
+     *
+     * Unlike waitForFrame(), which returns as soon as the buffer is non-empty,
+     * this waits for the sequence number to move past the one the caller has seen.
+     *
+     * @param sequence Last sequence number the caller has seen.
+     * @param timeout Maximum time to wait.
+     * @return true if a newer frame is available, false on timeout.
+     */
+    bool waitForNewer(uint64_t sequence, std::chrono::milliseconds timeout) override;
+
+    /**
+     * @brief Also notify @p signal after every new frame, or stop doing so with nullptr.
+     *
+     * Lets one thread wait on several modules through a shared UpdateSignal
+     * (see LoopDriver). The signal must outlive the capture thread.
+     */
+    void setUpdateSignal(UpdateSignal *signal) override;
+
+    /**
+     * @brief Set the name, scheduling policy and CPU set of the capture thread.
+     *
+     * The thread applies it when it starts, so call this before start().
+     */
+    void setThreadConfig(const ThreadConfig &config) override;
+
+    /**
+     * @brief How regularly the capture thread delivers frames: the mean interval, its jitter and extremes.
+     */
+    JitterStats threadJitter() const override;
 
     /**
      * @brief Enable frame logging.
@@ -141,14 +273,30 @@ public:
      * When logging is enabled, captured frames (and/or metadata) are passed
      * to the Logger provided during construction, if any.
      */
-    void startLogging();
+    void startLogging() override;
 
     /**
      * @brief Disable frame logging.
      *
      * Stops sending captured frame information to the Logger.
      */
-    void stopLogging();
+    void stopLogging() override;
+
+    /**
+     * @brief Number of frames not logged because the encoder queue was full.
+     */
+    uint64_t droppedLogFrames() const;
+
+    /**
+     * @brief Get the hit/miss counters of the capture frame pool.
+     *
+     * Thread-safe. A miss means every pooled buffer was still held by the ring
+     * buffer, a reader or the encoder, so the frame was captured into a newly
+     * allocated cv::Mat instead.
+     *
+     * @return Pool hits, misses and size.
+     */
+    PoolStats framePoolStats() const;
 
 private:
     /**
@@ -161,16 +309,33 @@ private:
      */
     void captureLoop();
 
+    /**
+     * @brief Downscale (and crop) a captured frame into the thumbnail history.
+     */
+    void pushThumbnail(const TimedFrame &timedFrame);
+
     lccv::PiCamera cam_;
 
     std::thread cameraThread_;
     std::atomic<bool> running_ = false;
+    ThreadConfig threadConfig_;  ///< Applied by the capture thread when it starts
+    JitterMeter threadJitter_;   ///< Marked once per frame
+
+    UpdateSignal frameUpdated_;                          ///< Wakes waitForFrame() and waitForNewer(); the buffer itself needs no lock
+    std::atomic<UpdateSignal *> updateSignal_{nullptr};  ///< Optional extra signal set by setUpdateSignal()
 
-    mutable std::mutex frameMutex_;
-    std::condition_variable frameUpdated_;
+    // The frame pool covers the history plus every other place a frame can be held
+    static constexpr size_t READER_FRAMES = 2;           ///< Frames readers may hold beyond the history
+    static constexpr size_t ENCODER_QUEUE_CAPACITY = 8;  ///< Frames waiting to be encoded for the log
 
-    RingBuffer<TimedFrame> frameBuffer_{30};
+    CameraHistoryOptions history_;
+
+    LockFreeRingBuffer<TimedFrame> frameBuffer_;      ///< history_.frameDepth full-resolution frames
+    FramePool framePool_;                             ///< Capture buffers, allocated in start()
+    LockFreeRingBuffer<TimedFrame> thumbnailBuffer_;  ///< history_.thumbnailDepth thumbnails, if enabled
 
     Logger *logger_;
     bool logging_ = false;
+
+    std::unique_ptr<FrameEncoder> encoder_;  ///< Encodes logged frames off the capture thread.
 };
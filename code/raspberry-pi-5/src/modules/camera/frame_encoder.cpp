@@ -0,0 +1,99 @@
+#include "frame_encoder.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+
+FrameEncoder::FrameEncoder(Logger *logger, size_t workerCount, size_t queueCapacity, const std::string &extension)
+    : logger_(logger)
+    , extension_(extension)
+    , queueCapacity_(std::max<size_t>(queueCapacity, 1)) {
+    workerCount = std::max<size_t>(workerCount, 1);
+    workers_.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers_.emplace_back(&FrameEncoder::workerLoop, this);
+    }
+}
+
+FrameEncoder::~FrameEncoder() {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stopping_ = true;
+    }
+    queueUpdated_.notify_all();
+
+    for (auto &worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+bool FrameEncoder::submit(const TimedFrame &timedFrame) {
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (stopping_ || queue_.size() >= queueCapacity_) {
+            droppedFrames_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        // Sequence numbers are only handed to accepted frames, so the reorder
+        // stage never waits for a frame that was dropped.
+        queue_.push_back({nextSequence_++, timedFrame});
+    }
+
+    queueUpdated_.notify_one();
+    return true;
+}
+
+void FrameEncoder::flush() {
+    uint64_t target;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        target = nextSequence_;
+    }
+
+    std::unique_lock<std::mutex> lock(writeMutex_);
+    written_.wait(lock, [&] { return nextWrite_ >= target; });
+}
+
+void FrameEncoder::workerLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex_);
+            queueUpdated_.wait(lock, [this] { return !queue_.empty() || stopping_; });
+            if (queue_.empty()) break;  // Stopping and fully drained
+
+            job = std::move(queue_.front());
+            queue_.pop_front();
+        }
+
+        EncodedFrame encoded;
+        encoded.timestamp_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(job.timedFrame.timestamp.time_since_epoch()).count();
+        trace::begin("imencode");
+        encoded.ok = cv::imencode(extension_, job.timedFrame.frame, encoded.buffer);
+        trace::end("imencode");
+        if (!encoded.ok) failedFrames_.fetch_add(1, std::memory_order_relaxed);
+
+        // Release the frame before waiting on the reorder stage
+        job.timedFrame.frame.release();
+
+        writeInOrder(job.sequence, std::move(encoded));
+    }
+}
+
+void FrameEncoder::writeInOrder(uint64_t sequence, EncodedFrame &&encoded) {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    pending_.emplace(sequence, std::move(encoded));
+
+    bool advanced = false;
+    for (auto it = pending_.begin(); it != pending_.end() && it->first == nextWrite_; it = pending_.erase(it)) {
+        if (it->second.ok && logger_) {
+            logger_->writeData(it->second.timestamp_ns, log_records::CAMERA_FRAME, it->second.buffer.data(), it->second.buffer.size());
+        }
+        ++nextWrite_;
+        advanced = true;
+    }
+
+    if (advanced) written_.notify_all();
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "camera_struct.h"
+#include "logger.h"
+
+/**
+ * @brief Encodes captured frames on a pool of worker threads and logs them in order.
+ *
+ * Frames are placed in a bounded queue by submit(), which never blocks. Each
+ * worker takes a frame, encodes it with cv::imencode and hands the result to
+ * a reorder stage that writes records to the Logger strictly in submission
+ * (and therefore timestamp) order, even when workers finish out of order.
+ *
+ * A submitted frame only holds a reference to the cv::Mat data, so the
+ * producer must not modify the pixels of a frame after submitting it.
+ */
+class FrameEncoder
+{
+public:
+    /**
+     * @brief Create the encoder and start its worker threads.
+     *
+     * @param logger Logger that receives the encoded records. Must outlive the encoder.
+     * @param workerCount Number of encoding threads (at least 1).
+     * @param queueCapacity Maximum number of frames waiting to be encoded.
+     * @param extension Image format passed to cv::imencode (e.g. ".png").
+     */
+    FrameEncoder(Logger *logger, size_t workerCount = 2, size_t queueCapacity = 8, const std::string &extension = ".png");
+
+    /**
+     * @brief Encode and log every queued frame, then stop the workers.
+     */
+    ~FrameEncoder();
+
+    FrameEncoder(const FrameEncoder &) = delete;
+    FrameEncoder &operator=(const FrameEncoder &) = delete;
+
+    /**
+     * @brief Queue a frame for encoding without blocking.
+     *
+     * @param timedFrame Frame and capture timestamp. The pixel data is shared, not copied.
+     * @return true if the frame was queued, false if the queue was full and the frame was dropped.
+     */
+    bool submit(const TimedFrame &timedFrame);
+
+    /**
+     * @brief Block until every frame queued so far has been written to the Logger.
+     */
+    void flush();
+
+    /**
+     * @brief Number of frames dropped because the queue was full.
+     */
+    uint64_t droppedFrames() const {
+        return droppedFrames_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Number of frames that cv::imencode failed to encode.
+     */
+    uint64_t failedFrames() const {
+        return failedFrames_.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Job {
+        uint64_t sequence;
+        TimedFrame timedFrame;
+    };
+
+    struct EncodedFrame {
+        uint64_t timestamp_ns;
+        std::vector<uchar> buffer;
+        bool ok;
+    };
+
+    /**
+     * @brief Worker thread: encodes queued frames and passes them to writeInOrder().
+     */
+    void workerLoop();
+
+    /**
+     * @brief Store an encoded frame and write every frame that is now next in sequence.
+     */
+    void writeInOrder(uint64_t sequence, EncodedFrame &&encoded);
+
+    Logger *logger_;
+    std::string extension_;
+    size_t queueCapacity_;
+
+    std::mutex queueMutex_;
+    std::condition_variable queueUpdated_;
+    std::deque<Job> queue_;
+    uint64_t nextSequence_ = 0;  ///< Sequence number given to the next accepted frame.
+    bool stopping_ = false;
+
+    std::mutex writeMutex_;
+    std::condition_variable written_;
+    std::map<uint64_t, EncodedFrame> pending_;  ///< Encoded frames waiting for an earlier sequence number.
+    uint64_t nextWrite_ = 0;                    ///< Sequence number of the next frame to be logged.
+
+    std::vector<std::thread> workers_;
+
+    std::atomic<uint64_t> droppedFrames_{0};
+    std::atomic<uint64_t> failedFrames_{0};
+};
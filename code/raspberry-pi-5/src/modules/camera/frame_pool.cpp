@@ -0,0 +1,36 @@
+#include "frame_pool.h"
+
+FramePool::FramePool(size_t frameCount)
+    : frames_(frameCount) {}
+
+void FramePool::allocate(int rows, int cols, int type) {
+    for (auto &frame : frames_) {
+        if (frame.rows == rows && frame.cols == cols && frame.type() == type) continue;
+
+        // Replace rather than resize, so a buffer a reader still holds is left untouched
+        frame = cv::Mat(rows, cols, type);
+    }
+    next_ = 0;
+}
+
+cv::Mat FramePool::acquire() {
+    for (size_t i = 0; i < frames_.size(); ++i) {
+        size_t index = (next_ + i) % frames_.size();
+        cv::Mat &frame = frames_[index];
+        if (!frame.u) continue;
+
+        // Atomic read of the count with a full barrier, so the last holder's reads of the pixels are done
+        if (CV_XADD(&frame.u->refcount, 0) != 1) continue;
+
+        next_ = index + 1;
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return frame;
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return cv::Mat();
+}
+
+PoolStats FramePool::stats() const {
+    return {hits_.load(std::memory_order_relaxed), misses_.load(std::memory_order_relaxed), frames_.size()};
+}
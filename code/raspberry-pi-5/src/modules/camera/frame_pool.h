@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+#include "object_pool.hpp"
+
+/**
+ * @brief A fixed set of preallocated frame buffers that the capture loop fills in place.
+ *
+ * acquire() returns a cv::Mat header sharing the pixels of a buffer that no
+ * other cv::Mat references anymore. cv::Mat counts its own references, so a
+ * buffer comes back to the pool by itself once the ring buffer, every
+ * TimedFrame copy and the encoder queue have let go of it.
+ *
+ * The pool never grows. When every buffer is held, acquire() returns an empty
+ * cv::Mat that the camera allocates as before, and the miss is counted so the
+ * pool can be sized from the stats.
+ *
+ * acquire() and allocate() must only be called from the capture thread (or
+ * while it is stopped); stats() may be called from any thread.
+ */
+class FramePool
+{
+public:
+    /**
+     * @brief Construct an empty pool. Buffers are allocated by allocate().
+     * @param frameCount Number of frame buffers.
+     */
+    explicit FramePool(size_t frameCount);
+
+    FramePool(const FramePool &) = delete;
+    FramePool &operator=(const FramePool &) = delete;
+
+    /**
+     * @brief Allocate every buffer with the given size and type, unless they already match.
+     *
+     * Frames still held elsewhere keep their old buffers; the pool just stops reusing them.
+     */
+    void allocate(int rows, int cols, int type);
+
+    /**
+     * @brief Get a free buffer to capture into.
+     * @return A header sharing a free buffer, or an empty cv::Mat if the pool ran dry.
+     */
+    cv::Mat acquire();
+
+    /**
+     * @brief Number of acquire() calls served from the pool (hits), that found it dry (misses), and the pool size.
+     */
+    PoolStats stats() const;
+
+private:
+    std::vector<cv::Mat> frames_;  ///< Pool-owned references; a reference count of 1 means free
+    size_t next_ = 0;              ///< Where the next search for a free buffer starts
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
@@ -1,4 +1,5 @@
 #include "lidar_module.h"
+#include "trace.h"
 
 LidarModule::LidarModule(const char *serialPort, int baudRate)
     : serialPort_(serialPort)
@@ -106,43 +107,103 @@ void LidarModule::shutdown() {
 }
 
 bool LidarModule::getData(TimedLidarData &outTimedLidarData) const {
-    std::lock_guard<std::mutex> lock(lidarDataMutex_);
+    TimedCompactLidarData compact;
+    if (!getCompactData(compact)) return false;
 
-    if (lidarDataBuffer_.empty()) return false;
+    // Expand outside the lock
+    outTimedLidarData = compact.expand();
+    return true;
+}
+
+bool LidarModule::getCompactData(TimedCompactLidarData &outTimedCompactLidarData) const {
+    auto latest = lidarDataBuffer_.latest();
+    if (!latest) return false;
 
-    outTimedLidarData = lidarDataBuffer_.latest().value();
+    outTimedCompactLidarData = std::move(*latest);
     return true;
 }
 
 size_t LidarModule::bufferSize() const {
-    std::lock_guard<std::mutex> lock(lidarDataMutex_);
     return lidarDataBuffer_.size();
 }
 
 bool LidarModule::getAllTimedLidarData(std::vector<TimedLidarData> &outTimedLidarData) const {
-    std::lock_guard<std::mutex> lock(lidarDataMutex_);
+    std::vector<TimedCompactLidarData> compact;
+    if (!getAllCompactLidarData(compact)) return false;
 
-    if (lidarDataBuffer_.empty()) return false;
-
-    outTimedLidarData = lidarDataBuffer_.getAll();
+    outTimedLidarData.clear();
+    outTimedLidarData.reserve(compact.size());
+    for (const auto &timedScan : compact) {
+        outTimedLidarData.push_back(timedScan.expand());
+    }
     return true;
 }
 
+bool LidarModule::getAllCompactLidarData(std::vector<TimedCompactLidarData> &outTimedCompactLidarData) const {
+    outTimedCompactLidarData = lidarDataBuffer_.getAll();
+    return !outTimedCompactLidarData.empty();
+}
+
+bool LidarModule::getCompactSnapshot(RingBufferSnapshot<TimedCompactLidarData> &outSnapshot) const {
+    lidarDataBuffer_.snapshot(outSnapshot);
+    return !outSnapshot.empty();
+}
+
+bool LidarModule::getCompactSnapshotBetween(
+    std::chrono::steady_clock::time_point from,
+    std::chrono::steady_clock::time_point to,
+    RingBufferSnapshot<TimedCompactLidarData> &outSnapshot
+) const {
+    lidarDataBuffer_.snapshotBetween(from, to, outSnapshot);
+    return !outSnapshot.empty();
+}
+
+PoolStats LidarModule::scanPoolStats() const {
+    return lidarDataBuffer_.poolStats();
+}
+
+uint64_t LidarModule::sequence() const {
+    return lidarDataBuffer_.sequence();
+}
+
+bool LidarModule::waitForNewer(uint64_t sequence, std::chrono::milliseconds timeout) {
+    return lidarDataUpdated_.waitFor(timeout, [&] { return lidarDataBuffer_.sequence() > sequence; });
+}
+
+void LidarModule::setUpdateSignal(UpdateSignal *signal) {
+    updateSignal_ = signal;
+}
+
+void LidarModule::setThreadConfig(const ThreadConfig &config) {
+    threadConfig_ = config;
+}
+
+JitterStats LidarModule::threadJitter() const {
+    return threadJitter_.stats();
+}
+
 bool LidarModule::waitForData(TimedLidarData &outTimedLidarData) {
-    std::unique_lock<std::mutex> lock(lidarDataMutex_);
-    lidarDataUpdated_.wait(lock, [this] { return !lidarDataBuffer_.empty(); });
+    lidarDataUpdated_.wait([this] { return !lidarDataBuffer_.empty(); });
 
-    outTimedLidarData = lidarDataBuffer_.latest().value();
+    outTimedLidarData = lidarDataBuffer_.latest().value().expand();
     return true;
 }
 
 void LidarModule::scanLoop() {
+    applyThreadConfig(threadConfig_);
+    trace::registerThread();
+
+    // Allocated once per run instead of 64 KB of stack every scan
+    std::vector<sl_lidar_response_measurement_node_hq_t> nodes(MAX_SCAN_NODES);
+
     int consecutiveFailures = 0;
     while (running_) {
-        sl_lidar_response_measurement_node_hq_t nodes[8192];
-        size_t count = sizeof(nodes) / sizeof(nodes[0]);
+        size_t count = nodes.size();
 
-        if (SL_IS_FAIL(lidarDriver_->grabScanDataHq(nodes, count))) {
+        trace::begin("grabScanDataHq");
+        sl_result grabResult = lidarDriver_->grabScanDataHq(nodes.data(), count);
+        trace::end("grabScanDataHq");
+        if (SL_IS_FAIL(grabResult)) {
             std::cerr << "[LidarModule] Timeout error" << std::endl;
             consecutiveFailures++;
 
@@ -169,29 +230,37 @@ void LidarModule::scanLoop() {
             consecutiveFailures = 0;
         }
 
-        lidarDriver_->ascendScanData(nodes, count);
-
-        std::vector<RawLidarNode> temp(count);
-        for (size_t i = 0; i < count; ++i) {
-            float angle = nodes[i].angle_z_q14 * 90.f / (1 << 14);
-            float distance = nodes[i].dist_mm_q2 / 1000.f / (1 << 2);
-            uint8_t quality = nodes[i].quality;
-
-            temp[i] = {angle, distance, quality};
-        }
-
-        TimedLidarData timedScan{std::move(temp), std::chrono::steady_clock::now()};
+        lidarDriver_->ascendScanData(nodes.data(), count);
+
+        threadJitter_.mark();
+        auto timestamp = std::chrono::steady_clock::now();
+        trace::instant("scan arrival");
+        trace::counter("scan nodes", static_cast<double>(count));
+        trace::ScopedTrace publishTrace("publish scan");
+
+        // Refill a scan nobody holds anymore, reusing its storage. Keep the driver's fixed-point values;
+        // consumers convert when they need floats
+        lidarDataBuffer_.pushRecycled([&](TimedCompactLidarData &timedScan) {
+            timedScan.timestamp = timestamp;
+            timedScan.scan.resize(count);
+            uint32_t *distances = timedScan.scan.distanceQ2();
+            uint16_t *angles = timedScan.scan.angleQ14();
+            uint8_t *qualities = timedScan.scan.quality();
+            for (size_t i = 0; i < count; ++i) {
+                distances[i] = nodes[i].dist_mm_q2;
+                angles[i] = nodes[i].angle_z_q14;
+                qualities[i] = nodes[i].quality;
+            }
 
-        if (logger_ and logging_) {
-            uint64_t ts = std::chrono::duration_cast<std::chrono::nanoseconds>(timedScan.timestamp.time_since_epoch()).count();
-            logger_->writeData(ts, timedScan.lidarData.data(), timedScan.lidarData.size() * sizeof(RawLidarNode));
-        }
+            if (logger_ and logging_) {
+                uint64_t ts = std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+                logger_->writeData(ts, log_records::LIDAR_SCAN_COMPACT, timedScan.scan.bytes.data(), timedScan.scan.bytes.size());
+            }
+        });
 
-        {
-            std::lock_guard<std::mutex> lock(lidarDataMutex_);
-            lidarDataBuffer_.push(std::move(timedScan));
-            lidarDataUpdated_.notify_all();
-        }
+        // waitForNewer() callers wait for every scan, not just the first one
+        lidarDataUpdated_.notify();
+        if (UpdateSignal *signal = updateSignal_.load()) signal->notify();
     }
 }
 
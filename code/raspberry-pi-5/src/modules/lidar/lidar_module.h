@@ -13,18 +13,24 @@
 #include <thread>
 #include <vector>
 
+#include "lidar_source.h"
 #include "lidar_struct.h"
 #include "logger.h"
-#include "ring_buffer.hpp"
+#include "lock_free_ring_buffer.hpp"
+#include "thread_config.h"
+#include "update_signal.hpp"
 
 /**
  * @brief Lidar module that manages scanning and data acquisition from a SLAMTEC LIDAR device.
  *
  * Runs a background thread that continuously collects scan data from the LIDAR.
  * Provides thread-safe access to the latest scan points and timestamps.
+ * Scans are buffered and logged as CompactLidarScan and only expanded to
+ * RawLidarNode floats when a consumer asks for them.
  * Handles initialization, shutdown, and motor control of the LIDAR hardware.
+ * Implements LidarSource, so the apps can run on a LidarReplay instead.
  */
-class LidarModule
+class LidarModule : public LidarSource
 {
 public:
     /**
@@ -102,7 +108,19 @@ public:
      *
      * @return true if data is available, false if no scan has been captured yet.
      */
-    bool getData(TimedLidarData &outTimedLidarData) const;
+    bool getData(TimedLidarData &outTimedLidarData) const override;
+
+    /**
+     * @brief Get the latest LIDAR scan in its compact fixed-point form.
+     *
+     * Thread-safe. Cheaper than getData() for consumers that only need some
+     * of the nodes or work on the raw q14 angles and q2 distances.
+     *
+     * @param[out] outTimedCompactLidarData Structure to receive the most recent scan.
+     *
+     * @return true if data is available, false if no scan has been captured yet.
+     */
+    bool getCompactData(TimedCompactLidarData &outTimedCompactLidarData) const override;
 
     /**
      * @brief Wait until new LIDAR scan data is available, then return it.
@@ -114,7 +132,47 @@ public:
      *
      * @return true if new data was successfully retrieved.
      */
-    bool waitForData(TimedLidarData &outTimedLidarData);
+    bool waitForData(TimedLidarData &outTimedLidarData) override;
+
+    /**
+     * @brief Sequence number of the latest scan: the number of scans captured so far (0 if none).
+     *
+     * Thread-safe. Read it before a getter to know that the scan returned is at
+     * least that recent, then pass it to waitForNewer() to wait for the next one.
+     */
+    uint64_t sequence() const override;
+
+    /**
+     * @brief Block until a scan newer than @p sequence is available.
+     *
+     * Unlike waitForData(), which returns as soon as the buffer is non-empty,
+     * this waits for the sequence number to move past the one the caller has seen.
+     *
+     * @param sequence Last sequence number the caller has seen.
+     * @param timeout Maximum time to wait.
+     * @return true if a newer scan is available, false on timeout.
+     */
+    bool waitForNewer(uint64_t sequence, std::chrono::milliseconds timeout) override;
+
+    /**
+     * @brief Also notify @p signal after every new scan, or stop doing so with nullptr.
+     *
+     * Lets one thread wait on several modules through a shared UpdateSignal
+     * (see LoopDriver). The signal must outlive the capture thread.
+     */
+    void setUpdateSignal(UpdateSignal *signal) override;
+
+    /**
+     * @brief Set the name, scheduling policy and CPU set of the scan thread.
+     *
+     * The thread applies it when it starts, so call this before start().
+     */
+    void setThreadConfig(const ThreadConfig &config) override;
+
+    /**
+     * @brief How regularly the scan thread delivers scans: the mean interval, its jitter and extremes.
+     */
+    JitterStats threadJitter() const override;
 
     /**
      * @brief Get the current number of scan frames stored in the buffer.
@@ -123,7 +181,7 @@ public:
      *
      * @return Number of scan frames in the buffer.
      */
-    size_t bufferSize() const;
+    size_t bufferSize() const override;
 
     /**
      * @brief Retrieve all scan frames currently stored in the buffer.
@@ -134,7 +192,59 @@ public:
      *
      * @return true if the buffer contains at least one frame, false if empty.
      */
-    bool getAllTimedLidarData(std::vector<TimedLidarData> &outTimedLidarData) const;
+    bool getAllTimedLidarData(std::vector<TimedLidarData> &outTimedLidarData) const override;
+
+    /**
+     * @brief Retrieve all buffered scan frames in their compact fixed-point form.
+     *
+     * Thread-safe. Frames are returned in order from oldest to newest.
+     *
+     * @param[out] outTimedCompactLidarData Vector to receive all buffered scan frames.
+     *
+     * @return true if the buffer contains at least one frame, false if empty.
+     */
+    bool getAllCompactLidarData(std::vector<TimedCompactLidarData> &outTimedCompactLidarData) const override;
+
+    /**
+     * @brief Share all buffered scan frames without copying them.
+     *
+     * Thread-safe. Frames are in order from oldest to newest and stay valid for
+     * as long as the snapshot holds them, even after the buffer overwrites them.
+     * Reusing the same vector between calls avoids any allocation.
+     *
+     * @param[out] outSnapshot Replaced with the buffered scan frames.
+     *
+     * @return true if the buffer contains at least one frame, false if empty.
+     */
+    bool getCompactSnapshot(RingBufferSnapshot<TimedCompactLidarData> &outSnapshot) const override;
+
+    /**
+     * @brief Share the scan frames covering [@p from, @p to] without copying them.
+     *
+     * Thread-safe. That is every frame captured in the window, preceded by the
+     * last frame captured at or before @p from, if still buffered. Frames are in
+     * order from oldest to newest.
+     *
+     * @param[out] outSnapshot Replaced with the scan frames.
+     *
+     * @return true if at least one frame was found.
+     */
+    bool getCompactSnapshotBetween(
+        std::chrono::steady_clock::time_point from,
+        std::chrono::steady_clock::time_point to,
+        RingBufferSnapshot<TimedCompactLidarData> &outSnapshot
+    ) const override;
+
+    /**
+     * @brief Get the hit/miss counters of the scan storage pool.
+     *
+     * Thread-safe. Scans are refilled in place once they have dropped out of
+     * the buffer and every snapshot; a miss means a new scan had to be
+     * allocated, which should stop once the pool has warmed up.
+     *
+     * @return Pool hits, misses and size.
+     */
+    PoolStats scanPoolStats() const override;
 
     /**
      * @brief Enable logging of scan frames.
@@ -142,14 +252,14 @@ public:
      * When enabled, captured scan frames are passed to the provided Logger
      * instance, if any.
      */
-    void startLogging();
+    void startLogging() override;
 
     /**
      * @brief Disable logging of scan frames.
      *
      * No further scan data will be forwarded to the Logger.
      */
-    void stopLogging();
+    void stopLogging() override;
 
     /**
      * @brief Print information about the connected LIDAR device.
@@ -186,15 +296,19 @@ private:
     const char *serialPort_;
     int baudRate_;
 
+    static constexpr size_t MAX_SCAN_NODES = 8192;  ///< Node capacity handed to grabScanDataHq()
+
     bool initialized_ = false;
 
     std::thread lidarThread_;
     std::atomic<bool> running_ = false;
+    ThreadConfig threadConfig_;  ///< Applied by the scan thread when it starts
+    JitterMeter threadJitter_;   ///< Marked once per scan
 
-    mutable std::mutex lidarDataMutex_;
-    std::condition_variable lidarDataUpdated_;
+    UpdateSignal lidarDataUpdated_;                      ///< Wakes waitForData() and waitForNewer(); the buffer itself needs no lock
+    std::atomic<UpdateSignal *> updateSignal_{nullptr};  ///< Optional extra signal set by setUpdateSignal()
 
-    RingBuffer<TimedLidarData> lidarDataBuffer_{10};
+    LockFreeRingBuffer<TimedCompactLidarData> lidarDataBuffer_{10};  ///< Scans kept in driver fixed-point form (7 bytes per node)
 
     Logger *logger_ = nullptr;
     bool logging_ = false;
@@ -1,5 +1,6 @@
 #include "pico2_module.h"
 #include "pico2_struct.h"
+#include "trace.h"
 
 #include <cmath>
 #include <iostream>
@@ -54,40 +55,89 @@ bool Pico2Module::setMovementInfo(float motorSpeed, float steeringPercent) {
 }
 
 bool Pico2Module::getData(TimedPico2Data &outData) const {
-    std::lock_guard<std::mutex> lock(dataMutex_);
-    if (dataBuffer_.empty()) return false;
+    auto latest = dataBuffer_.latest();
+    if (!latest) return false;
 
-    outData = dataBuffer_.latest().value();
+    outData = *latest;
     return true;
 }
 
+uint64_t Pico2Module::sequence() const {
+    return dataBuffer_.sequence();
+}
+
+bool Pico2Module::waitForNewer(uint64_t sequence, std::chrono::milliseconds timeout) {
+    return dataUpdated_.waitFor(timeout, [&] { return dataBuffer_.sequence() > sequence; });
+}
+
+void Pico2Module::setUpdateSignal(UpdateSignal *signal) {
+    updateSignal_ = signal;
+}
+
+void Pico2Module::setThreadConfig(const ThreadConfig &config) {
+    threadConfig_ = config;
+}
+
+JitterStats Pico2Module::threadJitter() const {
+    return threadJitter_.stats();
+}
+
+PeriodicStats Pico2Module::pollingStats() const {
+    return poller_.stats();
+}
+
 bool Pico2Module::waitForData(TimedPico2Data &outData) {
-    std::unique_lock<std::mutex> lock(dataMutex_);
-    dataUpdated_.wait(lock, [this] { return !dataBuffer_.empty(); });
+    dataUpdated_.wait([this] { return !dataBuffer_.empty(); });
 
     outData = dataBuffer_.latest().value();
     return true;
 }
 
 bool Pico2Module::getAllTimedData(std::vector<TimedPico2Data> &outData) const {
-    std::lock_guard<std::mutex> lock(dataMutex_);
-    if (dataBuffer_.empty()) return false;
-
     outData = dataBuffer_.getAll();
-    return true;
+    return !outData.empty();
+}
+
+bool Pico2Module::getSnapshot(RingBufferSnapshot<TimedPico2Data> &outSnapshot) const {
+    dataBuffer_.snapshot(outSnapshot);
+    return !outSnapshot.empty();
+}
+
+bool Pico2Module::getLatestSnapshot(size_t count, RingBufferSnapshot<TimedPico2Data> &outSnapshot) const {
+    dataBuffer_.snapshotLatest(count, outSnapshot);
+    return !outSnapshot.empty();
+}
+
+bool Pico2Module::getSnapshotSince(std::chrono::steady_clock::time_point since, RingBufferSnapshot<TimedPico2Data> &outSnapshot) const {
+    dataBuffer_.snapshotSince(since, outSnapshot);
+    return !outSnapshot.empty();
+}
+
+bool Pico2Module::getSnapshotBetween(
+    std::chrono::steady_clock::time_point from,
+    std::chrono::steady_clock::time_point to,
+    RingBufferSnapshot<TimedPico2Data> &outSnapshot
+) const {
+    dataBuffer_.snapshotBetween(from, to, outSnapshot);
+    return !outSnapshot.empty();
 }
 
 size_t Pico2Module::bufferSize() const {
-    std::lock_guard<std::mutex> lock(dataMutex_);
     return dataBuffer_.size();
 }
 
 void Pico2Module::pollingLoop() {
     using namespace std::chrono;
-    const auto interval = milliseconds(8);  // ~120 Hz
 
+    applyThreadConfig(threadConfig_);
+    trace::registerThread();
+
+    // Deadlines are absolute, so the polling time never makes the rate drift
+    poller_.restart();
     while (running_) {
-        auto start = steady_clock::now();
+        poller_.waitForNextPeriod();
+        threadJitter_.mark();
+        trace::begin("I2C poll");
 
         // Refresh status
         uint8_t statusByte = 0;
@@ -101,6 +151,8 @@ void Pico2Module::pollingLoop() {
 
         bool imuOk = master_.readImu(accel, euler);
         bool encOk = master_.readEncoder(encoderAngle);
+        trace::end("I2C poll");
+        trace::counter("I2C ok", imuOk && encOk ? 1.0 : 0.0);
 
         static float lastValidEulerH = 0.0f;
         static double lastValidEncoderAngle = 0.0;
@@ -126,25 +178,15 @@ void Pico2Module::pollingLoop() {
             if (logger_ and logging_) {
                 uint64_t ts = std::chrono::duration_cast<std::chrono::nanoseconds>(sample.timestamp.time_since_epoch()).count();
 
-                struct {
-                    ImuAccel accel;
-                    ImuEuler euler;
-                    double encoderAngle;
-                } payload{sample.accel, sample.euler, sample.encoderAngle};
-
-                logger_->writeData(ts, &payload, sizeof(payload));
+                logger_->writeRecord(ts, log_records::Pico2Record{sample.accel, sample.euler, sample.encoderAngle});
             }
 
-            {
-                std::lock_guard<std::mutex> lock(dataMutex_);
-                dataBuffer_.push(std::move(sample));
-                dataUpdated_.notify_all();
-            }
-        }
+            dataBuffer_.push(std::move(sample));
+            trace::instant("pico2 sample");
 
-        auto elapsed = steady_clock::now() - start;
-        if (elapsed < interval) {
-            std::this_thread::sleep_for(interval - elapsed);
+            // waitForNewer() callers wait for every sample, not just the first one
+            dataUpdated_.notify();
+            if (UpdateSignal *signal = updateSignal_.load()) signal->notify();
         }
     }
 }
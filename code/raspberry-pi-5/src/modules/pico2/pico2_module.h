@@ -2,8 +2,12 @@
 
 #include "i2c_master.h"
 #include "logger.h"
+#include "pico2_source.h"
 #include "pico2_struct.h"
-#include "ring_buffer.hpp"
+#include "lock_free_ring_buffer.hpp"
+#include "periodic_executor.h"
+#include "thread_config.h"
+#include "update_signal.hpp"
 
 #include <atomic>
 #include <chrono>
@@ -26,8 +30,10 @@
  *  2. Call initialize()
  *  3. Retrieve data using getData(), waitForData(), or getAllTimedData()
  *  4. Call shutdown() before destruction
+ *
+ * Implements Pico2Source, so the apps can run on a Pico2Replay instead.
  */
-class Pico2Module
+class Pico2Module : public Pico2Source
 {
 public:
     /**
@@ -98,7 +104,7 @@ public:
      * @param steeringPercent Steering command in percent, range -100..100.
      * @return true if the command was successfully written via I2C.
      */
-    bool setMovementInfo(float motorSpeed, float steeringPercent);
+    bool setMovementInfo(float motorSpeed, float steeringPercent) override;
 
     /**
      * @brief Retrieve the most recent data sample.
@@ -108,7 +114,7 @@ public:
      * @param[out] outData Filled with the most recent sample.
      * @return true if a sample was available, false if buffer is empty.
      */
-    bool getData(TimedPico2Data &outData) const;
+    bool getData(TimedPico2Data &outData) const override;
 
     /**
      * @brief Retrieve all available buffered samples in chronological order.
@@ -118,7 +124,68 @@ public:
      * @param[out] outData Vector that receives all stored samples.
      * @return true if at least one sample was available, false if buffer was empty.
      */
-    bool getAllTimedData(std::vector<TimedPico2Data> &outData) const;
+    bool getAllTimedData(std::vector<TimedPico2Data> &outData) const override;
+
+    /**
+     * @brief Share all buffered samples in chronological order without copying them.
+     *
+     * Thread-safe. The samples stay valid for as long as the snapshot holds them.
+     * Reusing the same vector between calls avoids any allocation.
+     *
+     * @param[out] outSnapshot Replaced with the buffered samples.
+     * @return true if at least one sample was available, false if buffer was empty.
+     */
+    bool getSnapshot(RingBufferSnapshot<TimedPico2Data> &outSnapshot) const override;
+
+    /**
+     * @brief Share the newest @p count samples (or fewer) in chronological order.
+     *
+     * Thread-safe. Only the requested samples are visited.
+     *
+     * @param count Maximum number of samples.
+     * @param[out] outSnapshot Replaced with the samples.
+     * @return true if at least one sample was available, false if buffer was empty.
+     */
+    bool getLatestSnapshot(size_t count, RingBufferSnapshot<TimedPico2Data> &outSnapshot) const override;
+
+    /**
+     * @brief Share the samples covering the time since @p since in chronological order.
+     *
+     * Thread-safe. That is every sample newer than @p since, preceded by the last
+     * sample at or before it (if still buffered), so the motion since @p since can
+     * be integrated. Only the returned samples are visited.
+     *
+     * @param since Start of the window, e.g. the timestamp of a lidar scan.
+     * @param[out] outSnapshot Replaced with the samples.
+     * @return true if at least one sample was available, false if buffer was empty.
+     */
+    bool getSnapshotSince(std::chrono::steady_clock::time_point since, RingBufferSnapshot<TimedPico2Data> &outSnapshot) const override;
+
+    /**
+     * @brief Share the samples covering [@p from, @p to] in chronological order.
+     *
+     * Thread-safe. Like getSnapshotSince(), but samples newer than @p to are left out.
+     *
+     * @param[out] outSnapshot Replaced with the samples.
+     * @return true if at least one sample was found.
+     */
+    bool getSnapshotBetween(
+        std::chrono::steady_clock::time_point from,
+        std::chrono::steady_clock::time_point to,
+        RingBufferSnapshot<TimedPico2Data> &outSnapshot
+    ) const override;
+
+    /**
+     * @brief Call @p visitor with every buffered sample, oldest to newest, without copying them.
+     *
+     * Thread-safe. The polling thread may push new samples during the visit.
+     *
+     * @param visitor Callable taking `const TimedPico2Data &`.
+     */
+    template <typename Visitor>
+    void forEachSample(Visitor &&visitor) const {
+        dataBuffer_.forEach(std::forward<Visitor>(visitor));
+    }
 
     /**
      * @brief Get the current number of stored samples in the buffer.
@@ -127,7 +194,7 @@ public:
      *
      * @return Current number of buffered samples.
      */
-    size_t bufferSize() const;
+    size_t bufferSize() const override;
 
     /**
      * @brief Block until a new sample is available.
@@ -138,7 +205,52 @@ public:
      * @param[out] outData Filled with the newly captured sample.
      * @return true if data was retrieved, false if the module was shut down.
      */
-    bool waitForData(TimedPico2Data &outData);
+    bool waitForData(TimedPico2Data &outData) override;
+
+    /**
+     * @brief Sequence number of the latest sample: the number of samples captured so far (0 if none).
+     *
+     * Thread-safe. Read it before a getter to know that the sample returned is at
+     * least that recent, then pass it to waitForNewer() to wait for the next one.
+     */
+    uint64_t sequence() const override;
+
+    /**
+     * @brief Block until a sample newer than @p sequence is available.
+     *
+     * Unlike waitForData(), which returns as soon as the buffer is non-empty,
+     * this waits for the sequence number to move past the one the caller has seen.
+     *
+     * @param sequence Last sequence number the caller has seen.
+     * @param timeout Maximum time to wait.
+     * @return true if a newer sample is available, false on timeout.
+     */
+    bool waitForNewer(uint64_t sequence, std::chrono::milliseconds timeout) override;
+
+    /**
+     * @brief Also notify @p signal after every new sample, or stop doing so with nullptr.
+     *
+     * Lets one thread wait on several modules through a shared UpdateSignal
+     * (see LoopDriver). The signal must outlive the capture thread.
+     */
+    void setUpdateSignal(UpdateSignal *signal) override;
+
+    /**
+     * @brief Set the name, scheduling policy and CPU set of the polling thread.
+     *
+     * The thread applies it when it starts, so call this before initialize().
+     */
+    void setThreadConfig(const ThreadConfig &config) override;
+
+    /**
+     * @brief How regularly the polling thread delivers samples: the mean interval, its jitter and extremes.
+     */
+    JitterStats threadJitter() const override;
+
+    /**
+     * @brief Overruns, wake-up lateness and jitter percentiles of the polling schedule.
+     */
+    PeriodicStats pollingStats() const;
 
     /**
      * @brief Enable logging of Pico2 samples.
@@ -146,12 +258,12 @@ public:
      * When enabled, each captured sample is forwarded to the Logger
      * provided during construction.
      */
-    void startLogging();
+    void startLogging() override;
 
     /**
      * @brief Disable logging of Pico2 samples.
      */
-    void stopLogging();
+    void stopLogging() override;
 
 private:
     /**
@@ -169,13 +281,18 @@ private:
 
     std::atomic<bool> running_ = false;
     std::thread pollingThread_;
+    ThreadConfig threadConfig_;  ///< Applied by the polling thread when it starts
+    JitterMeter threadJitter_;   ///< Marked once per sample
+
+    static constexpr auto POLL_PERIOD = std::chrono::milliseconds(8);  ///< ~120 Hz
+    PeriodicExecutor poller_{POLL_PERIOD};                             ///< Absolute-deadline schedule of the polling thread
 
-    mutable std::mutex dataMutex_;
-    std::condition_variable dataUpdated_;
+    UpdateSignal dataUpdated_;                           ///< Wakes waitForData() and waitForNewer(); the buffer itself needs no lock
+    std::atomic<UpdateSignal *> updateSignal_{nullptr};  ///< Optional extra signal set by setUpdateSignal()
 
     pico_i2c_mem_addr::StatusFlags status_{};
 
-    RingBuffer<TimedPico2Data> dataBuffer_{120};
+    LockFreeRingBuffer<TimedPico2Data> dataBuffer_{120};
 
     Logger *logger_ = nullptr;
     bool logging_ = false;
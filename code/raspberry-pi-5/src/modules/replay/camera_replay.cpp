@@ -0,0 +1,202 @@
+#include "camera_replay.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+CameraReplay::CameraReplay(ReplayClock &clock, size_t stream, Logger *logger, const CameraHistoryOptions &history)
+    : clock_(clock)
+    , stream_(stream)
+    , history_(history)
+    , frameBuffer_(std::max<size_t>(history.frameDepth, 1))
+    , thumbnailBuffer_(std::max<size_t>(history.thumbnailDepth, 1))
+    , logger_(logger) {}
+
+CameraReplay::~CameraReplay() {
+    if (replayThread_.joinable()) {
+        clock_.stop();
+        replayThread_.join();
+    }
+}
+
+bool CameraReplay::open(const std::string &path) {
+    reader_ = std::make_unique<MappedLogReader>(path);
+    if (!reader_->open()) {
+        reader_.reset();
+        return false;
+    }
+    return true;
+}
+
+bool CameraReplay::firstTimestamp(uint64_t &outTimestamp_ns) const {
+    if (!reader_ || reader_->begin() == reader_->end()) return false;
+
+    outTimestamp_ns = reader_->begin()->timestamp;
+    return true;
+}
+
+void CameraReplay::start() {
+    replayThread_ = std::thread(&CameraReplay::replayLoop, this);
+}
+
+void CameraReplay::join() {
+    if (replayThread_.joinable()) replayThread_.join();
+}
+
+bool CameraReplay::finished() const {
+    return finished_;
+}
+
+bool CameraReplay::getFrame(TimedFrame &outTimedFrame) const {
+    auto latest = frameBuffer_.latest();
+    if (!latest) return false;
+
+    outTimedFrame = std::move(*latest);
+    return true;
+}
+
+size_t CameraReplay::bufferSize() const {
+    return frameBuffer_.size();
+}
+
+bool CameraReplay::getAllTimedFrame(std::vector<TimedFrame> &outTimedFrames) const {
+    outTimedFrames = frameBuffer_.getAll();
+    return !outTimedFrames.empty();
+}
+
+bool CameraReplay::getFrameSnapshot(RingBufferSnapshot<TimedFrame> &outSnapshot) const {
+    frameBuffer_.snapshot(outSnapshot);
+    return !outSnapshot.empty();
+}
+
+bool CameraReplay::getFrameSnapshotBetween(
+    std::chrono::steady_clock::time_point from,
+    std::chrono::steady_clock::time_point to,
+    RingBufferSnapshot<TimedFrame> &outSnapshot
+) const {
+    frameBuffer_.snapshotBetween(from, to, outSnapshot);
+    return !outSnapshot.empty();
+}
+
+bool CameraReplay::getThumbnail(TimedFrame &outTimedFrame) const {
+    auto latest = thumbnailBuffer_.latest();
+    if (!latest) return false;
+
+    outTimedFrame = std::move(*latest);
+    return true;
+}
+
+bool CameraReplay::getAllThumbnails(std::vector<TimedFrame> &outTimedFrames) const {
+    outTimedFrames = thumbnailBuffer_.getAll();
+    return !outTimedFrames.empty();
+}
+
+bool CameraReplay::getThumbnailSnapshot(RingBufferSnapshot<TimedFrame> &outSnapshot) const {
+    thumbnailBuffer_.snapshot(outSnapshot);
+    return !outSnapshot.empty();
+}
+
+bool CameraReplay::getThumbnailSnapshotBetween(
+    std::chrono::steady_clock::time_point from,
+    std::chrono::steady_clock::time_point to,
+    RingBufferSnapshot<TimedFrame> &outSnapshot
+) const {
+    thumbnailBuffer_.snapshotBetween(from, to, outSnapshot);
+    return !outSnapshot.empty();
+}
+
+bool CameraReplay::waitForFrame(TimedFrame &outTimedFrame) {
+    frameUpdated_.wait([this] { return !frameBuffer_.empty(); });
+
+    outTimedFrame = frameBuffer_.latest().value();
+    return true;
+}
+
+uint64_t CameraReplay::sequence() const {
+    return frameBuffer_.sequence();
+}
+
+bool CameraReplay::waitForNewer(uint64_t sequence, std::chrono::milliseconds timeout) {
+    return frameUpdated_.waitFor(timeout, [&] { return frameBuffer_.sequence() > sequence; });
+}
+
+void CameraReplay::setUpdateSignal(UpdateSignal *signal) {
+    updateSignal_ = signal;
+}
+
+void CameraReplay::setThreadConfig(const ThreadConfig &config) {
+    threadConfig_ = config;
+}
+
+JitterStats CameraReplay::threadJitter() const {
+    return threadJitter_.stats();
+}
+
+void CameraReplay::startLogging() {
+    logging_ = true;
+}
+
+void CameraReplay::stopLogging() {
+    logging_ = false;
+}
+
+void CameraReplay::replayLoop() {
+    applyThreadConfig(threadConfig_);
+    trace::registerThread();
+
+    for (const LogEntryView &entry : *reader_) {
+        clock_.announce(stream_, entry.timestamp);
+
+        // Decoded before the turn comes, so decoding never delays the publication
+        cv::Mat frame;
+        if (entry.size > 0 && (entry.type == log_records::CAMERA_FRAME || entry.type == log_records::RAW)) {
+            trace::ScopedTrace decodeTrace("decode frame");
+            cv::Mat encoded(1, static_cast<int>(entry.size), CV_8UC1, const_cast<uint8_t *>(entry.data));
+            frame = cv::imdecode(encoded, cv::IMREAD_UNCHANGED);
+        }
+        if (frame.empty()) {
+            std::cerr << "[CameraReplay] Skipping undecodable entry (type " << entry.type << ", size " << entry.size << ")" << std::endl;
+            continue;
+        }
+        if (!clock_.waitTurn(stream_)) break;
+
+        threadJitter_.mark();
+        auto timestamp = clock_.localTime(entry.timestamp);
+        trace::instant("frame arrival");
+        trace::ScopedTrace publishTrace("publish frame");
+
+        frameBuffer_.push(TimedFrame{std::move(frame), timestamp});
+
+        frameUpdated_.notify();
+        if (UpdateSignal *signal = updateSignal_.load()) signal->notify();
+
+        // The logged bytes are still encoded, so they are written as they are
+        if (logger_ and logging_) {
+            uint64_t ts = std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+            logger_->writeData(ts, log_records::CAMERA_FRAME, entry.data, entry.size);
+        }
+
+        if (history_.thumbnailDepth > 0) {
+            auto latest = frameBuffer_.latestShared();
+            if (latest) pushThumbnail(*latest);
+        }
+    }
+
+    clock_.finish(stream_);
+    finished_ = true;
+}
+
+void CameraReplay::pushThumbnail(const TimedFrame &timedFrame) {
+    cv::Rect bounds(0, 0, timedFrame.frame.cols, timedFrame.frame.rows);
+    cv::Rect roi = history_.thumbnailRoi.area() > 0 ? history_.thumbnailRoi & bounds : bounds;
+    if (roi.area() <= 0) return;
+
+    thumbnailBuffer_.pushRecycled([&](TimedFrame &thumbnail) {
+        // Resize into the old thumbnail's pixels, unless a reader still shares them through a copied cv::Mat
+        if (thumbnail.frame.u && CV_XADD(&thumbnail.frame.u->refcount, 0) != 1) thumbnail.frame = cv::Mat();
+
+        cv::resize(timedFrame.frame(roi), thumbnail.frame, cv::Size(), history_.thumbnailScale, history_.thumbnailScale, cv::INTER_AREA);
+        thumbnail.timestamp = timedFrame.timestamp;
+    });
+}
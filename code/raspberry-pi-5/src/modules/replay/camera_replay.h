@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "camera_source.h"
+#include "camera_struct.h"
+#include "lock_free_ring_buffer.hpp"
+#include "log_reader.h"
+#include "logger.h"
+#include "replay_clock.h"
+#include "thread_config.h"
+#include "update_signal.hpp"
+
+/**
+ * @brief Republishes the frames of a camera.bin log through the CameraSource API.
+ *
+ * A background thread decodes each frame ahead of its turn and publishes it
+ * when the shared ReplayClock says so, into the same lock-free buffers,
+ * sequence numbers and update signals as CameraModule, thumbnails included.
+ * Logged frames are already rotated, so they are published as decoded, and
+ * stamped with ReplayClock::localTime().
+ *
+ * Usually owned by a SensorReplay, which opens the logs and runs the clock.
+ */
+class CameraReplay : public CameraSource
+{
+public:
+    /**
+     * @brief Construct the replay of one log.
+     * @param clock Clock shared with the other replays of the run.
+     * @param stream Index of this replay in @p clock.
+     * @param logger Logger the replayed frames are written to after startLogging(), or nullptr. They are not re-encoded.
+     * @param history Depth of the full-resolution and thumbnail histories.
+     */
+    CameraReplay(ReplayClock &clock, size_t stream, Logger *logger = nullptr, const CameraHistoryOptions &history = CameraHistoryOptions());
+
+    /**
+     * @brief Stop the replay thread.
+     */
+    ~CameraReplay();
+
+    CameraReplay(const CameraReplay &) = delete;
+    CameraReplay &operator=(const CameraReplay &) = delete;
+
+    /**
+     * @brief Map the log file.
+     * @return false if it is missing or unreadable.
+     */
+    bool open(const std::string &path);
+
+    /**
+     * @brief Log timestamp of the first frame, in nanoseconds. @return false if the log has no entries.
+     */
+    bool firstTimestamp(uint64_t &outTimestamp_ns) const;
+
+    /**
+     * @brief Start the replay thread. The clock must have been started.
+     */
+    void start();
+
+    /**
+     * @brief Wait for the replay thread to exit. Stop the clock first to end the replay early.
+     */
+    void join();
+
+    /**
+     * @brief Whether the replay has ended: every frame was published, or the clock was stopped.
+     */
+    bool finished() const;
+
+    bool getFrame(TimedFrame &outTimedFrame) const override;
+    size_t bufferSize() const override;
+    bool getAllTimedFrame(std::vector<TimedFrame> &outTimedFrames) const override;
+    bool getFrameSnapshot(RingBufferSnapshot<TimedFrame> &outSnapshot) const override;
+    bool getFrameSnapshotBetween(
+        std::chrono::steady_clock::time_point from,
+        std::chrono::steady_clock::time_point to,
+        RingBufferSnapshot<TimedFrame> &outSnapshot
+    ) const override;
+    bool getThumbnail(TimedFrame &outTimedFrame) const override;
+    bool getAllThumbnails(std::vector<TimedFrame> &outTimedFrames) const override;
+    bool getThumbnailSnapshot(RingBufferSnapshot<TimedFrame> &outSnapshot) const override;
+    bool getThumbnailSnapshotBetween(
+        std::chrono::steady_clock::time_point from,
+        std::chrono::steady_clock::time_point to,
+        RingBufferSnapshot<TimedFrame> &outSnapshot
+    ) const override;
+    bool waitForFrame(TimedFrame &outTimedFrame) override;
+    uint64_t sequence() const override;
+    bool waitForNewer(uint64_t sequence, std::chrono::milliseconds timeout) override;
+    void setUpdateSignal(UpdateSignal *signal) override;
+    void setThreadConfig(const ThreadConfig &config) override;
+    JitterStats threadJitter() const override;
+    void startLogging() override;
+    void stopLogging() override;
+
+private:
+    /**
+     * @brief Background thread: decodes each frame ahead of its turn, then publishes it.
+     */
+    void replayLoop();
+
+    /**
+     * @brief Downscale (and crop) a published frame into the thumbnail history.
+     */
+    void pushThumbnail(const TimedFrame &timedFrame);
+
+    ReplayClock &clock_;
+    size_t stream_;
+
+    std::unique_ptr<MappedLogReader> reader_;
+
+    std::thread replayThread_;
+    std::atomic<bool> finished_ = false;
+    ThreadConfig threadConfig_;  ///< Applied by the replay thread when it starts
+    JitterMeter threadJitter_;   ///< Marked once per frame
+
+    UpdateSignal frameUpdated_;                          ///< Wakes waitForFrame() and waitForNewer()
+    std::atomic<UpdateSignal *> updateSignal_{nullptr};  ///< Optional extra signal set by setUpdateSignal()
+
+    CameraHistoryOptions history_;
+
+    LockFreeRingBuffer<TimedFrame> frameBuffer_;      ///< history_.frameDepth full-resolution frames
+    LockFreeRingBuffer<TimedFrame> thumbnailBuffer_;  ///< history_.thumbnailDepth thumbnails, if enabled
+
+    Logger *logger_ = nullptr;
+    std::atomic<bool> logging_ = false;
+};
@@ -0,0 +1,192 @@
+#include "lidar_replay.h"
+#include "trace.h"
+
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+LidarReplay::LidarReplay(ReplayClock &clock, size_t stream, Logger *logger)
+    : clock_(clock)
+    , stream_(stream)
+    , logger_(logger) {}
+
+LidarReplay::~LidarReplay() {
+    if (replayThread_.joinable()) {
+        clock_.stop();
+        replayThread_.join();
+    }
+}
+
+bool LidarReplay::open(const std::string &path) {
+    reader_ = std::make_unique<MappedLogReader>(path);
+    if (!reader_->open()) {
+        reader_.reset();
+        return false;
+    }
+    return true;
+}
+
+bool LidarReplay::firstTimestamp(uint64_t &outTimestamp_ns) const {
+    if (!reader_ || reader_->begin() == reader_->end()) return false;
+
+    outTimestamp_ns = reader_->begin()->timestamp;
+    return true;
+}
+
+void LidarReplay::start() {
+    replayThread_ = std::thread(&LidarReplay::replayLoop, this);
+}
+
+void LidarReplay::join() {
+    if (replayThread_.joinable()) replayThread_.join();
+}
+
+bool LidarReplay::finished() const {
+    return finished_;
+}
+
+bool LidarReplay::getData(TimedLidarData &outTimedLidarData) const {
+    TimedCompactLidarData compact;
+    if (!getCompactData(compact)) return false;
+
+    outTimedLidarData = compact.expand();
+    return true;
+}
+
+bool LidarReplay::getCompactData(TimedCompactLidarData &outTimedCompactLidarData) const {
+    auto latest = lidarDataBuffer_.latest();
+    if (!latest) return false;
+
+    outTimedCompactLidarData = std::move(*latest);
+    return true;
+}
+
+bool LidarReplay::waitForData(TimedLidarData &outTimedLidarData) {
+    lidarDataUpdated_.wait([this] { return !lidarDataBuffer_.empty(); });
+
+    outTimedLidarData = lidarDataBuffer_.latest().value().expand();
+    return true;
+}
+
+uint64_t LidarReplay::sequence() const {
+    return lidarDataBuffer_.sequence();
+}
+
+bool LidarReplay::waitForNewer(uint64_t sequence, std::chrono::milliseconds timeout) {
+    return lidarDataUpdated_.waitFor(timeout, [&] { return lidarDataBuffer_.sequence() > sequence; });
+}
+
+void LidarReplay::setUpdateSignal(UpdateSignal *signal) {
+    updateSignal_ = signal;
+}
+
+void LidarReplay::setThreadConfig(const ThreadConfig &config) {
+    threadConfig_ = config;
+}
+
+JitterStats LidarReplay::threadJitter() const {
+    return threadJitter_.stats();
+}
+
+size_t LidarReplay::bufferSize() const {
+    return lidarDataBuffer_.size();
+}
+
+bool LidarReplay::getAllTimedLidarData(std::vector<TimedLidarData> &outTimedLidarData) const {
+    std::vector<TimedCompactLidarData> compact;
+    if (!getAllCompactLidarData(compact)) return false;
+
+    outTimedLidarData.clear();
+    outTimedLidarData.reserve(compact.size());
+    for (const auto &timedScan : compact) {
+        outTimedLidarData.push_back(timedScan.expand());
+    }
+    return true;
+}
+
+bool LidarReplay::getAllCompactLidarData(std::vector<TimedCompactLidarData> &outTimedCompactLidarData) const {
+    outTimedCompactLidarData = lidarDataBuffer_.getAll();
+    return !outTimedCompactLidarData.empty();
+}
+
+bool LidarReplay::getCompactSnapshot(RingBufferSnapshot<TimedCompactLidarData> &outSnapshot) const {
+    lidarDataBuffer_.snapshot(outSnapshot);
+    return !outSnapshot.empty();
+}
+
+bool LidarReplay::getCompactSnapshotBetween(
+    std::chrono::steady_clock::time_point from,
+    std::chrono::steady_clock::time_point to,
+    RingBufferSnapshot<TimedCompactLidarData> &outSnapshot
+) const {
+    lidarDataBuffer_.snapshotBetween(from, to, outSnapshot);
+    return !outSnapshot.empty();
+}
+
+PoolStats LidarReplay::scanPoolStats() const {
+    return lidarDataBuffer_.poolStats();
+}
+
+void LidarReplay::startLogging() {
+    logging_ = true;
+}
+
+void LidarReplay::stopLogging() {
+    logging_ = false;
+}
+
+bool LidarReplay::decode(const LogEntryView &entry, CompactLidarScan &outScan, std::vector<RawLidarNode> &nodes) {
+    if (entry.type == log_records::LIDAR_SCAN_COMPACT) return outScan.assign(entry.data, entry.size);
+    if (!readArray(entry, nodes)) return false;
+
+    // Older logs hold floats; go back to the driver's fixed-point form
+    outScan.resize(nodes.size());
+    uint32_t *distances = outScan.distanceQ2();
+    uint16_t *angles = outScan.angleQ14();
+    uint8_t *qualities = outScan.quality();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        distances[i] = static_cast<uint32_t>(std::lround(nodes[i].distance * 1000.0f * (1 << 2)));
+        angles[i] = static_cast<uint16_t>(std::lround(nodes[i].angle * (1 << 14) / 90.0f));
+        qualities[i] = nodes[i].quality;
+    }
+    return true;
+}
+
+void LidarReplay::replayLoop() {
+    applyThreadConfig(threadConfig_);
+    trace::registerThread();
+
+    // Decoded ahead of its turn, then swapped into a recycled buffer slot, so both keep their storage
+    CompactLidarScan pending;
+    std::vector<RawLidarNode> nodes;
+
+    for (const LogEntryView &entry : *reader_) {
+        clock_.announce(stream_, entry.timestamp);
+        if (!decode(entry, pending, nodes)) {
+            std::cerr << "[LidarReplay] Skipping corrupt entry (type " << entry.type << ", size " << entry.size << ")" << std::endl;
+            continue;
+        }
+        if (!clock_.waitTurn(stream_)) break;
+
+        threadJitter_.mark();
+        auto timestamp = clock_.localTime(entry.timestamp);
+        trace::instant("scan arrival");
+        trace::ScopedTrace publishTrace("publish scan");
+
+        lidarDataBuffer_.pushRecycled([&](TimedCompactLidarData &timedScan) {
+            timedScan.timestamp = timestamp;
+            std::swap(timedScan.scan, pending);
+
+            if (logger_ and logging_) {
+                uint64_t ts = std::chrono::duration_cast<std::chrono::nanoseconds>(timestamp.time_since_epoch()).count();
+                logger_->writeData(ts, log_records::LIDAR_SCAN_COMPACT, timedScan.scan.bytes.data(), timedScan.scan.bytes.size());
+            }
+        });
+
+        lidarDataUpdated_.notify();
+        if (UpdateSignal *signal = updateSignal_.load()) signal->notify();
+    }
+
+    clock_.finish(stream_);
+    finished_ = true;
+}
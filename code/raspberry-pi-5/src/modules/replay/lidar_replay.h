@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lidar_source.h"
+#include "lidar_struct.h"
+#include "lock_free_ring_buffer.hpp"
+#include "log_reader.h"
+#include "logger.h"
+#include "replay_clock.h"
+#include "thread_config.h"
+#include "update_signal.hpp"
+
+/**
+ * @brief Republishes the scans of a lidar.bin log through the LidarSource API.
+ *
+ * A background thread publishes every scan of the log when the shared
+ * ReplayClock says so, into the same lock-free buffer, sequence numbers and
+ * update signals as LidarModule, so consumers cannot tell the difference.
+ * Scans are stamped with ReplayClock::localTime(). Both the compact scans of
+ * current logs and the RawLidarNode arrays of older ones are read.
+ *
+ * Usually owned by a SensorReplay, which opens the logs and runs the clock.
+ */
+class LidarReplay : public LidarSource
+{
+public:
+    /**
+     * @brief Construct the replay of one log.
+     * @param clock Clock shared with the other replays of the run.
+     * @param stream Index of this replay in @p clock.
+     * @param logger Logger the replayed scans are written to after startLogging(), or nullptr.
+     */
+    LidarReplay(ReplayClock &clock, size_t stream, Logger *logger = nullptr);
+
+    /**
+     * @brief Stop the replay thread.
+     */
+    ~LidarReplay();
+
+    LidarReplay(const LidarReplay &) = delete;
+    LidarReplay &operator=(const LidarReplay &) = delete;
+
+    /**
+     * @brief Map the log file.
+     * @return false if it is missing or unreadable.
+     */
+    bool open(const std::string &path);
+
+    /**
+     * @brief Log timestamp of the first scan, in nanoseconds. @return false if the log has no entries.
+     */
+    bool firstTimestamp(uint64_t &outTimestamp_ns) const;
+
+    /**
+     * @brief Start the replay thread. The clock must have been started.
+     */
+    void start();
+
+    /**
+     * @brief Wait for the replay thread to exit. Stop the clock first to end the replay early.
+     */
+    void join();
+
+    /**
+     * @brief Whether the replay has ended: every scan was published, or the clock was stopped.
+     */
+    bool finished() const;
+
+    bool getData(TimedLidarData &outTimedLidarData) const override;
+    bool getCompactData(TimedCompactLidarData &outTimedCompactLidarData) const override;
+    bool waitForData(TimedLidarData &outTimedLidarData) override;
+    uint64_t sequence() const override;
+    bool waitForNewer(uint64_t sequence, std::chrono::milliseconds timeout) override;
+    void setUpdateSignal(UpdateSignal *signal) override;
+    void setThreadConfig(const ThreadConfig &config) override;
+    JitterStats threadJitter() const override;
+    size_t bufferSize() const override;
+    bool getAllTimedLidarData(std::vector<TimedLidarData> &outTimedLidarData) const override;
+    bool getAllCompactLidarData(std::vector<TimedCompactLidarData> &outTimedCompactLidarData) const override;
+    bool getCompactSnapshot(RingBufferSnapshot<TimedCompactLidarData> &outSnapshot) const override;
+    bool getCompactSnapshotBetween(
+        std::chrono::steady_clock::time_point from,
+        std::chrono::steady_clock::time_point to,
+        RingBufferSnapshot<TimedCompactLidarData> &outSnapshot
+    ) const override;
+    PoolStats scanPoolStats() const override;
+    void startLogging() override;
+    void stopLogging() override;
+
+private:
+    /**
+     * @brief Background thread: decodes each scan ahead of its turn, then publishes it.
+     */
+    void replayLoop();
+
+    /**
+     * @brief Load a log entry into @p outScan, converting RawLidarNode arrays to the compact form.
+     * @return false if the entry is corrupt.
+     */
+    static bool decode(const LogEntryView &entry, CompactLidarScan &outScan, std::vector<RawLidarNode> &nodes);
+
+    ReplayClock &clock_;
+    size_t stream_;
+
+    std::unique_ptr<MappedLogReader> reader_;
+
+    std::thread replayThread_;
+    std::atomic<bool> finished_ = false;
+    ThreadConfig threadConfig_;  ///< Applied by the replay thread when it starts
+    JitterMeter threadJitter_;   ///< Marked once per scan
+
+    UpdateSignal lidarDataUpdated_;                      ///< Wakes waitForData() and waitForNewer()
+    std::atomic<UpdateSignal *> updateSignal_{nullptr};  ///< Optional extra signal set by setUpdateSignal()
+
+    LockFreeRingBuffer<TimedCompactLidarData> lidarDataBuffer_{10};  ///< Same depth as LidarModule
+
+    Logger *logger_ = nullptr;
+    std::atomic<bool> logging_ = false;
+};
@@ -0,0 +1,166 @@
+#include "pico2_replay.h"
+#include "trace.h"
+
+#include <iostream>
+
+Pico2Replay::Pico2Replay(ReplayClock &clock, size_t stream, Logger *logger)
+    : clock_(clock)
+    , stream_(stream)
+    , logger_(logger) {}
+
+Pico2Replay::~Pico2Replay() {
+    if (replayThread_.joinable()) {
+        clock_.stop();
+        replayThread_.join();
+    }
+}
+
+bool Pico2Replay::open(const std::string &path) {
+    reader_ = std::make_unique<MappedLogReader>(path);
+    if (!reader_->open()) {
+        reader_.reset();
+        return false;
+    }
+    return true;
+}
+
+bool Pico2Replay::firstTimestamp(uint64_t &outTimestamp_ns) const {
+    if (!reader_ || reader_->begin() == reader_->end()) return false;
+
+    outTimestamp_ns = reader_->begin()->timestamp;
+    return true;
+}
+
+void Pico2Replay::start() {
+    replayThread_ = std::thread(&Pico2Replay::replayLoop, this);
+}
+
+void Pico2Replay::join() {
+    if (replayThread_.joinable()) replayThread_.join();
+}
+
+bool Pico2Replay::finished() const {
+    return finished_;
+}
+
+bool Pico2Replay::setMovementInfo(float motorSpeed, float steeringPercent) {
+    lastMotorSpeed_ = motorSpeed;
+    lastSteeringPercent_ = steeringPercent;
+    return true;
+}
+
+float Pico2Replay::lastMotorSpeed() const {
+    return lastMotorSpeed_;
+}
+
+float Pico2Replay::lastSteeringPercent() const {
+    return lastSteeringPercent_;
+}
+
+bool Pico2Replay::getData(TimedPico2Data &outData) const {
+    auto latest = dataBuffer_.latest();
+    if (!latest) return false;
+
+    outData = *latest;
+    return true;
+}
+
+bool Pico2Replay::getAllTimedData(std::vector<TimedPico2Data> &outData) const {
+    outData = dataBuffer_.getAll();
+    return !outData.empty();
+}
+
+bool Pico2Replay::getSnapshot(RingBufferSnapshot<TimedPico2Data> &outSnapshot) const {
+    dataBuffer_.snapshot(outSnapshot);
+    return !outSnapshot.empty();
+}
+
+bool Pico2Replay::getLatestSnapshot(size_t count, RingBufferSnapshot<TimedPico2Data> &outSnapshot) const {
+    dataBuffer_.snapshotLatest(count, outSnapshot);
+    return !outSnapshot.empty();
+}
+
+bool Pico2Replay::getSnapshotSince(std::chrono::steady_clock::time_point since, RingBufferSnapshot<TimedPico2Data> &outSnapshot) const {
+    dataBuffer_.snapshotSince(since, outSnapshot);
+    return !outSnapshot.empty();
+}
+
+bool Pico2Replay::getSnapshotBetween(
+    std::chrono::steady_clock::time_point from,
+    std::chrono::steady_clock::time_point to,
+    RingBufferSnapshot<TimedPico2Data> &outSnapshot
+) const {
+    dataBuffer_.snapshotBetween(from, to, outSnapshot);
+    return !outSnapshot.empty();
+}
+
+size_t Pico2Replay::bufferSize() const {
+    return dataBuffer_.size();
+}
+
+bool Pico2Replay::waitForData(TimedPico2Data &outData) {
+    dataUpdated_.wait([this] { return !dataBuffer_.empty(); });
+
+    outData = dataBuffer_.latest().value();
+    return true;
+}
+
+uint64_t Pico2Replay::sequence() const {
+    return dataBuffer_.sequence();
+}
+
+bool Pico2Replay::waitForNewer(uint64_t sequence, std::chrono::milliseconds timeout) {
+    return dataUpdated_.waitFor(timeout, [&] { return dataBuffer_.sequence() > sequence; });
+}
+
+void Pico2Replay::setUpdateSignal(UpdateSignal *signal) {
+    updateSignal_ = signal;
+}
+
+void Pico2Replay::setThreadConfig(const ThreadConfig &config) {
+    threadConfig_ = config;
+}
+
+JitterStats Pico2Replay::threadJitter() const {
+    return threadJitter_.stats();
+}
+
+void Pico2Replay::startLogging() {
+    logging_ = true;
+}
+
+void Pico2Replay::stopLogging() {
+    logging_ = false;
+}
+
+void Pico2Replay::replayLoop() {
+    applyThreadConfig(threadConfig_);
+    trace::registerThread();
+
+    for (const LogEntryView &entry : *reader_) {
+        clock_.announce(stream_, entry.timestamp);
+        log_records::Pico2Record record;
+        if (!readRecord(entry, record)) {
+            std::cerr << "[Pico2Replay] Skipping corrupt entry (type " << entry.type << ", size " << entry.size << ")" << std::endl;
+            continue;
+        }
+        if (!clock_.waitTurn(stream_)) break;
+
+        threadJitter_.mark();
+        TimedPico2Data sample{clock_.localTime(entry.timestamp), record.accel, record.euler, record.encoderAngle};
+
+        if (logger_ and logging_) {
+            uint64_t ts = std::chrono::duration_cast<std::chrono::nanoseconds>(sample.timestamp.time_since_epoch()).count();
+            logger_->writeRecord(ts, record);
+        }
+
+        dataBuffer_.push(std::move(sample));
+        trace::instant("pico2 sample");
+
+        dataUpdated_.notify();
+        if (UpdateSignal *signal = updateSignal_.load()) signal->notify();
+    }
+
+    clock_.finish(stream_);
+    finished_ = true;
+}
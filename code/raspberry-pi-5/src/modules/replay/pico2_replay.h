@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lock_free_ring_buffer.hpp"
+#include "log_reader.h"
+#include "logger.h"
+#include "pico2_source.h"
+#include "pico2_struct.h"
+#include "replay_clock.h"
+#include "thread_config.h"
+#include "update_signal.hpp"
+
+/**
+ * @brief Republishes the IMU and encoder samples of a pico2.bin log through the Pico2Source API.
+ *
+ * A background thread publishes every sample of the log when the shared
+ * ReplayClock says so, into the same lock-free buffer, sequence numbers and
+ * update signals as Pico2Module. Samples are stamped with
+ * ReplayClock::localTime().
+ *
+ * Movement commands go nowhere: the replayed motion is the one that was
+ * logged. The last command is kept for inspection.
+ *
+ * Usually owned by a SensorReplay, which opens the logs and runs the clock.
+ */
+class Pico2Replay : public Pico2Source
+{
+public:
+    /**
+     * @brief Construct the replay of one log.
+     * @param clock Clock shared with the other replays of the run.
+     * @param stream Index of this replay in @p clock.
+     * @param logger Logger the replayed samples are written to after startLogging(), or nullptr.
+     */
+    Pico2Replay(ReplayClock &clock, size_t stream, Logger *logger = nullptr);
+
+    /**
+     * @brief Stop the replay thread.
+     */
+    ~Pico2Replay();
+
+    Pico2Replay(const Pico2Replay &) = delete;
+    Pico2Replay &operator=(const Pico2Replay &) = delete;
+
+    /**
+     * @brief Map the log file.
+     * @return false if it is missing or unreadable.
+     */
+    bool open(const std::string &path);
+
+    /**
+     * @brief Log timestamp of the first sample, in nanoseconds. @return false if the log has no entries.
+     */
+    bool firstTimestamp(uint64_t &outTimestamp_ns) const;
+
+    /**
+     * @brief Start the replay thread. The clock must have been started.
+     */
+    void start();
+
+    /**
+     * @brief Wait for the replay thread to exit. Stop the clock first to end the replay early.
+     */
+    void join();
+
+    /**
+     * @brief Whether the replay has ended: every sample was published, or the clock was stopped.
+     */
+    bool finished() const;
+
+    /**
+     * @brief Keep the command as the last one and accept it; nothing is driven.
+     */
+    bool setMovementInfo(float motorSpeed, float steeringPercent) override;
+
+    /**
+     * @brief Motor speed of the last setMovementInfo() call.
+     */
+    float lastMotorSpeed() const;
+
+    /**
+     * @brief Steering percent of the last setMovementInfo() call.
+     */
+    float lastSteeringPercent() const;
+
+    bool getData(TimedPico2Data &outData) const override;
+    bool getAllTimedData(std::vector<TimedPico2Data> &outData) const override;
+    bool getSnapshot(RingBufferSnapshot<TimedPico2Data> &outSnapshot) const override;
+    bool getLatestSnapshot(size_t count, RingBufferSnapshot<TimedPico2Data> &outSnapshot) const override;
+    bool getSnapshotSince(std::chrono::steady_clock::time_point since, RingBufferSnapshot<TimedPico2Data> &outSnapshot) const override;
+    bool getSnapshotBetween(
+        std::chrono::steady_clock::time_point from,
+        std::chrono::steady_clock::time_point to,
+        RingBufferSnapshot<TimedPico2Data> &outSnapshot
+    ) const override;
+    size_t bufferSize() const override;
+    bool waitForData(TimedPico2Data &outData) override;
+    uint64_t sequence() const override;
+    bool waitForNewer(uint64_t sequence, std::chrono::milliseconds timeout) override;
+    void setUpdateSignal(UpdateSignal *signal) override;
+    void setThreadConfig(const ThreadConfig &config) override;
+    JitterStats threadJitter() const override;
+    void startLogging() override;
+    void stopLogging() override;
+
+private:
+    /**
+     * @brief Background thread: publishes each sample on its turn.
+     */
+    void replayLoop();
+
+    ReplayClock &clock_;
+    size_t stream_;
+
+    std::unique_ptr<MappedLogReader> reader_;
+
+    std::thread replayThread_;
+    std::atomic<bool> finished_ = false;
+    ThreadConfig threadConfig_;  ///< Applied by the replay thread when it starts
+    JitterMeter threadJitter_;   ///< Marked once per sample
+
+    UpdateSignal dataUpdated_;                           ///< Wakes waitForData() and waitForNewer()
+    std::atomic<UpdateSignal *> updateSignal_{nullptr};  ///< Optional extra signal set by setUpdateSignal()
+
+    LockFreeRingBuffer<TimedPico2Data> dataBuffer_{120};  ///< Same depth as Pico2Module
+
+    std::atomic<float> lastMotorSpeed_ = 0.0f;
+    std::atomic<float> lastSteeringPercent_ = 0.0f;
+
+    Logger *logger_ = nullptr;
+    std::atomic<bool> logging_ = false;
+};
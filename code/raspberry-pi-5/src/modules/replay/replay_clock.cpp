@@ -0,0 +1,60 @@
+#include "replay_clock.h"
+
+#include <limits>
+
+ReplayClock::ReplayClock(double speed, size_t streams)
+    : speed_(speed > 0.0 ? speed : 0.0)
+    , next_(streams, 0) {}
+
+void ReplayClock::start(uint64_t firstTimestamp_ns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    first_ = firstTimestamp_ns;
+    start_ = std::chrono::steady_clock::now();
+}
+
+std::chrono::steady_clock::time_point ReplayClock::localTime(uint64_t timestamp_ns) const {
+    uint64_t offset = timestamp_ns > first_ ? timestamp_ns - first_ : 0;
+    return start_ + std::chrono::nanoseconds(offset);
+}
+
+void ReplayClock::announce(size_t stream, uint64_t timestamp_ns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    next_[stream] = timestamp_ns;
+    turn_.notify_all();
+}
+
+bool ReplayClock::waitTurn(size_t stream) {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (speed_ > 0.0) {
+        uint64_t offset = next_[stream] > first_ ? next_[stream] - first_ : 0;
+        auto deadline = start_ + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                     std::chrono::duration<double, std::nano>(static_cast<double>(offset) / speed_)
+                                 );
+        turn_.wait_until(lock, deadline, [this] { return stopped_; });
+    } else {
+        turn_.wait(lock, [&] { return stopped_ || isOldest(stream); });
+    }
+    return !stopped_;
+}
+
+void ReplayClock::finish(size_t stream) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    next_[stream] = std::numeric_limits<uint64_t>::max();
+    turn_.notify_all();
+}
+
+void ReplayClock::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+    turn_.notify_all();
+}
+
+bool ReplayClock::isOldest(size_t stream) const {
+    for (size_t other = 0; other < next_.size(); ++other) {
+        if (other == stream) continue;
+        // A stream that has not announced yet (0) may still have an older entry
+        if (next_[other] < next_[stream] || (next_[other] == next_[stream] && other < stream)) return false;
+    }
+    return true;
+}
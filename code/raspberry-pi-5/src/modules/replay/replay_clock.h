@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Decides when each replayed log entry is published, shared by the replay threads of one run.
+ *
+ * Every replay thread (one per log, called a stream) announces the log
+ * timestamp of its next entry, prepares the entry, then waits for its turn:
+ *
+ * - At a speed above 0 the turn comes at the entry's original offset from the
+ *   start of the run, divided by the speed, so 1 reproduces the original timing.
+ * - At speed 0 the turn comes as soon as the entry is the oldest one announced
+ *   by any stream. Entries are published as fast as possible, but in the same
+ *   order across streams as they were logged, on every run.
+ *
+ * Published samples are stamped with localTime(), which keeps their original
+ * spacing whatever the speed.
+ */
+class ReplayClock
+{
+public:
+    /**
+     * @brief Construct a clock.
+     * @param speed Playback rate: 1 keeps the original timing, 2 plays twice as fast, 0 as fast as possible.
+     * @param streams Number of replay threads that take turns.
+     */
+    ReplayClock(double speed, size_t streams);
+
+    /**
+     * @brief Start the run now, at log timestamp @p firstTimestamp_ns (the oldest entry of every log).
+     */
+    void start(uint64_t firstTimestamp_ns);
+
+    /**
+     * @brief Steady-clock time a sample logged at @p timestamp_ns is stamped with: its offset since the first entry, from start().
+     */
+    std::chrono::steady_clock::time_point localTime(uint64_t timestamp_ns) const;
+
+    /**
+     * @brief Announce the log timestamp of the next entry of @p stream. Timestamps of a stream must not decrease.
+     */
+    void announce(size_t stream, uint64_t timestamp_ns);
+
+    /**
+     * @brief Block until the last entry announced by @p stream may be published.
+     * @return false if the clock was stopped.
+     */
+    bool waitTurn(size_t stream);
+
+    /**
+     * @brief Mark @p stream as played to the end, so it no longer holds back the others.
+     */
+    void finish(size_t stream);
+
+    /**
+     * @brief Wake every waiting stream and make waitTurn() return false from now on.
+     */
+    void stop();
+
+    /**
+     * @brief Playback rate given at construction.
+     */
+    double speed() const {
+        return speed_;
+    }
+
+private:
+    /**
+     * @brief Whether @p stream holds the oldest announced entry. Ties go to the lower stream index.
+     */
+    bool isOldest(size_t stream) const;
+
+    double speed_;
+    std::chrono::steady_clock::time_point start_;
+    uint64_t first_ = 0;
+
+    std::mutex mutex_;
+    std::condition_variable turn_;
+    std::vector<uint64_t> next_;  ///< Next log timestamp of every stream; 0 until announced, UINT64_MAX once finished
+    bool stopped_ = false;
+};
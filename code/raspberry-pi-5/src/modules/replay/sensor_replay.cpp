@@ -0,0 +1,72 @@
+#include "sensor_replay.h"
+
+#include <algorithm>
+#include <iostream>
+
+SensorReplay::SensorReplay(const std::string &logFolder, const ReplayOptions &options)
+    : SensorReplay(logFolder, nullptr, nullptr, nullptr, options) {}
+
+SensorReplay::SensorReplay(
+    const std::string &logFolder,
+    Logger *lidarLogger,
+    Logger *pico2Logger,
+    Logger *cameraLogger,
+    const ReplayOptions &options
+)
+    : logFolder_(logFolder)
+    , clock_(options.speed, STREAM_COUNT)
+    , lidar_(clock_, LIDAR, lidarLogger)
+    , pico2_(clock_, PICO2, pico2Logger)
+    , camera_(clock_, CAMERA, cameraLogger, options.cameraHistory) {}
+
+SensorReplay::~SensorReplay() {
+    stop();
+}
+
+bool SensorReplay::start() {
+    if (started_) {
+        std::cout << "[SensorReplay] Already started." << std::endl;
+        return true;
+    }
+
+    uint64_t lidarFirst = 0;
+    uint64_t pico2First = 0;
+    uint64_t cameraFirst = 0;
+    if (!lidar_.open(logFolder_ + "/lidar.bin") || !lidar_.firstTimestamp(lidarFirst)) {
+        std::cerr << "[SensorReplay] No scans in " << logFolder_ << "/lidar.bin" << std::endl;
+        return false;
+    }
+    if (!pico2_.open(logFolder_ + "/pico2.bin") || !pico2_.firstTimestamp(pico2First)) {
+        std::cerr << "[SensorReplay] No samples in " << logFolder_ << "/pico2.bin" << std::endl;
+        return false;
+    }
+    hasCamera_ = camera_.open(logFolder_ + "/camera.bin") && camera_.firstTimestamp(cameraFirst);
+    if (!hasCamera_) {
+        std::cout << "[SensorReplay] No frames in " << logFolder_ << "/camera.bin, the camera publishes none." << std::endl;
+        clock_.finish(CAMERA);
+    }
+
+    uint64_t first = std::min(lidarFirst, pico2First);
+    if (hasCamera_) first = std::min(first, cameraFirst);
+    clock_.start(first);
+
+    lidar_.start();
+    pico2_.start();
+    if (hasCamera_) camera_.start();
+    started_ = true;
+    return true;
+}
+
+void SensorReplay::stop() {
+    if (!started_) return;
+
+    clock_.stop();
+    lidar_.join();
+    pico2_.join();
+    camera_.join();
+    started_ = false;
+}
+
+bool SensorReplay::finished() const {
+    return lidar_.finished() && pico2_.finished() && (!hasCamera_ || camera_.finished());
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <string>
+
+#include "camera_replay.h"
+#include "camera_source.h"
+#include "lidar_replay.h"
+#include "logger.h"
+#include "pico2_replay.h"
+#include "replay_clock.h"
+
+/**
+ * @brief Options of a SensorReplay.
+ */
+struct ReplayOptions {
+    double speed = 1.0;                  ///< 1 keeps the original timing, 2 plays twice as fast, 0 as fast as possible
+    CameraHistoryOptions cameraHistory;  ///< Frame history of the camera replay, as for a CameraModule
+};
+
+/**
+ * @brief Replays the sensor logs of a run folder (lidar.bin, pico2.bin, camera.bin) in place of the hardware.
+ *
+ * Owns one LidarReplay, Pico2Replay and CameraReplay, each with its own
+ * thread, and the ReplayClock they share. Hand lidar(), pico2() and camera()
+ * to code written against LidarSource, Pico2Source and CameraSource, such as
+ * the challenge apps' Robot, and the run plays out again on any Linux
+ * machine, with no robot attached.
+ *
+ * lidar.bin and pico2.bin are required. Without camera.bin the camera
+ * publishes no frames.
+ *
+ * **Example usage:**
+ * @code
+ * SensorReplay replay("/home/pi/gfm_logs/obstacle_challenge/2025-09-20_14-03-11", ReplayOptions{0.0});
+ * if (!replay.start()) return -1;
+ *
+ * Robot robot(replay.lidar(), replay.pico2(), replay.camera(), ...);
+ * while (!replay.finished()) { ... }
+ * replay.stop();
+ * @endcode
+ */
+class SensorReplay
+{
+public:
+    /**
+     * @brief Construct the replay of a run folder. Nothing is read until start().
+     * @param logFolder Folder holding the run's lidar.bin, pico2.bin and, optionally, camera.bin.
+     * @param options Playback speed and camera history.
+     */
+    SensorReplay(const std::string &logFolder, const ReplayOptions &options = ReplayOptions());
+
+    /**
+     * @brief Construct the replay of a run folder with logging support.
+     *
+     * After startLogging() on a source, the entries it publishes are written
+     * to its Logger again, with their new timestamps, so the replayed run is
+     * itself a complete run folder.
+     *
+     * @param lidarLogger, pico2Logger, cameraLogger Loggers of each source, or nullptr.
+     */
+    SensorReplay(
+        const std::string &logFolder,
+        Logger *lidarLogger,
+        Logger *pico2Logger,
+        Logger *cameraLogger,
+        const ReplayOptions &options = ReplayOptions()
+    );
+
+    /**
+     * @brief Stops the replay.
+     */
+    ~SensorReplay();
+
+    SensorReplay(const SensorReplay &) = delete;
+    SensorReplay &operator=(const SensorReplay &) = delete;
+
+    /**
+     * @brief Map the logs, start the clock at the oldest entry and start the replay threads.
+     *
+     * Set the sources' thread configs and update signals before calling it.
+     *
+     * @return false if lidar.bin or pico2.bin is missing, unreadable or empty.
+     */
+    bool start();
+
+    /**
+     * @brief End the replay early and wait for the replay threads to exit. Safe to call more than once.
+     *
+     * A stopped replay cannot be started again.
+     */
+    void stop();
+
+    /**
+     * @brief Whether every log has been played to the end (or the replay was stopped).
+     */
+    bool finished() const;
+
+    LidarReplay &lidar() {
+        return lidar_;
+    }
+
+    Pico2Replay &pico2() {
+        return pico2_;
+    }
+
+    CameraReplay &camera() {
+        return camera_;
+    }
+
+private:
+    /// Index of each source in the clock
+    enum Stream
+    {
+        LIDAR,
+        PICO2,
+        CAMERA,
+        STREAM_COUNT
+    };
+
+    std::string logFolder_;
+    ReplayClock clock_;
+    LidarReplay lidar_;
+    Pico2Replay pico2_;
+    CameraReplay camera_;
+    bool hasCamera_ = false;
+    bool started_ = false;
+};
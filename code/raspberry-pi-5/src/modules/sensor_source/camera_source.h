@@ -0,0 +1,131 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "camera_struct.h"
+#include "lock_free_ring_buffer.hpp"
+#include "thread_config.h"
+#include "update_signal.hpp"
+
+/**
+ * @brief How much frame history a camera source keeps.
+ *
+ * A full-resolution 1296x972 BGR frame is about 3.8 MB, so the full history
+ * should only be as deep as its consumers need (usually the newest frame).
+ * Consumers that need a longer temporal context can use the thumbnail
+ * history, which keeps a downscaled and optionally cropped copy of each frame.
+ */
+struct CameraHistoryOptions {
+    size_t frameDepth = 30;        ///< Full-resolution frames kept (at least 1).
+    size_t thumbnailDepth = 0;     ///< Thumbnails kept. 0 disables the thumbnail history.
+    double thumbnailScale = 0.25;  ///< Scale applied to the (cropped) frame for each thumbnail.
+    cv::Rect thumbnailRoi;         ///< Region of the rotated frame to keep. Empty keeps the whole frame.
+};
+
+/**
+ * @brief Where camera frames come from: the Pi camera (CameraModule) or a log replay (CameraReplay).
+ *
+ * Only the consumer side is abstract; setting a source up is left to the
+ * concrete class. See CameraModule for the full description of each method.
+ */
+class CameraSource
+{
+public:
+    virtual ~CameraSource() = default;
+
+    /**
+     * @brief Get the latest frame. @return false if no frame has arrived yet.
+     */
+    virtual bool getFrame(TimedFrame &outTimedFrame) const = 0;
+
+    /**
+     * @brief Number of frames in the buffer.
+     */
+    virtual size_t bufferSize() const = 0;
+
+    /**
+     * @brief Copy every buffered frame, oldest to newest. The pixel data is shared.
+     */
+    virtual bool getAllTimedFrame(std::vector<TimedFrame> &outTimedFrames) const = 0;
+
+    /**
+     * @brief Share every buffered frame, oldest to newest, without copying them.
+     */
+    virtual bool getFrameSnapshot(RingBufferSnapshot<TimedFrame> &outSnapshot) const = 0;
+
+    /**
+     * @brief Share the frames covering [@p from, @p to], oldest to newest, without copying them.
+     */
+    virtual bool getFrameSnapshotBetween(
+        std::chrono::steady_clock::time_point from,
+        std::chrono::steady_clock::time_point to,
+        RingBufferSnapshot<TimedFrame> &outSnapshot
+    ) const = 0;
+
+    /**
+     * @brief Get the latest thumbnail. @return false if there is none or thumbnails are disabled.
+     */
+    virtual bool getThumbnail(TimedFrame &outTimedFrame) const = 0;
+
+    /**
+     * @brief Copy every buffered thumbnail, oldest to newest.
+     */
+    virtual bool getAllThumbnails(std::vector<TimedFrame> &outTimedFrames) const = 0;
+
+    /**
+     * @brief Share every buffered thumbnail, oldest to newest, without copying them.
+     */
+    virtual bool getThumbnailSnapshot(RingBufferSnapshot<TimedFrame> &outSnapshot) const = 0;
+
+    /**
+     * @brief Share the thumbnails covering [@p from, @p to], oldest to newest, without copying them.
+     */
+    virtual bool getThumbnailSnapshotBetween(
+        std::chrono::steady_clock::time_point from,
+        std::chrono::steady_clock::time_point to,
+        RingBufferSnapshot<TimedFrame> &outSnapshot
+    ) const = 0;
+
+    /**
+     * @brief Block until at least one frame is available, then return the latest.
+     */
+    virtual bool waitForFrame(TimedFrame &outTimedFrame) = 0;
+
+    /**
+     * @brief Sequence number of the latest frame: the number of frames published so far (0 if none).
+     */
+    virtual uint64_t sequence() const = 0;
+
+    /**
+     * @brief Block until a frame newer than @p sequence is available. @return false on timeout.
+     */
+    virtual bool waitForNewer(uint64_t sequence, std::chrono::milliseconds timeout) = 0;
+
+    /**
+     * @brief Also notify @p signal after every new frame, or stop doing so with nullptr.
+     */
+    virtual void setUpdateSignal(UpdateSignal *signal) = 0;
+
+    /**
+     * @brief Set the name, scheduling policy and CPU set of the thread publishing the frames. Call before it starts.
+     */
+    virtual void setThreadConfig(const ThreadConfig &config) = 0;
+
+    /**
+     * @brief How regularly frames are published: the mean interval, its jitter and extremes.
+     */
+    virtual JitterStats threadJitter() const = 0;
+
+    /**
+     * @brief Start writing every published frame to the source's Logger, if it has one.
+     */
+    virtual void startLogging() = 0;
+
+    /**
+     * @brief Stop writing frames to the Logger.
+     */
+    virtual void stopLogging() = 0;
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "lidar_struct.h"
+#include "lock_free_ring_buffer.hpp"
+#include "thread_config.h"
+#include "update_signal.hpp"
+
+/**
+ * @brief Where LIDAR scans come from: the SLAMTEC device (LidarModule) or a log replay (LidarReplay).
+ *
+ * Only the consumer side is abstract. Setting a source up (initialize(),
+ * start(), a replay's log folder) is left to the concrete class, so the
+ * challenge apps construct the one they need and hand this interface to
+ * their controller.
+ *
+ * See LidarModule for the full description of each method.
+ */
+class LidarSource
+{
+public:
+    virtual ~LidarSource() = default;
+
+    /**
+     * @brief Get the latest scan, expanded to floats. @return false if no scan has arrived yet.
+     */
+    virtual bool getData(TimedLidarData &outTimedLidarData) const = 0;
+
+    /**
+     * @brief Get the latest scan in its compact fixed-point form. @return false if no scan has arrived yet.
+     */
+    virtual bool getCompactData(TimedCompactLidarData &outTimedCompactLidarData) const = 0;
+
+    /**
+     * @brief Block until at least one scan is available, then return the latest.
+     */
+    virtual bool waitForData(TimedLidarData &outTimedLidarData) = 0;
+
+    /**
+     * @brief Sequence number of the latest scan: the number of scans published so far (0 if none).
+     */
+    virtual uint64_t sequence() const = 0;
+
+    /**
+     * @brief Block until a scan newer than @p sequence is available. @return false on timeout.
+     */
+    virtual bool waitForNewer(uint64_t sequence, std::chrono::milliseconds timeout) = 0;
+
+    /**
+     * @brief Also notify @p signal after every new scan, or stop doing so with nullptr.
+     */
+    virtual void setUpdateSignal(UpdateSignal *signal) = 0;
+
+    /**
+     * @brief Set the name, scheduling policy and CPU set of the thread publishing the scans. Call before it starts.
+     */
+    virtual void setThreadConfig(const ThreadConfig &config) = 0;
+
+    /**
+     * @brief How regularly scans are published: the mean interval, its jitter and extremes.
+     */
+    virtual JitterStats threadJitter() const = 0;
+
+    /**
+     * @brief Number of scans in the buffer.
+     */
+    virtual size_t bufferSize() const = 0;
+
+    /**
+     * @brief Copy every buffered scan, oldest to newest, expanded to floats.
+     */
+    virtual bool getAllTimedLidarData(std::vector<TimedLidarData> &outTimedLidarData) const = 0;
+
+    /**
+     * @brief Copy every buffered scan, oldest to newest, in compact form.
+     */
+    virtual bool getAllCompactLidarData(std::vector<TimedCompactLidarData> &outTimedCompactLidarData) const = 0;
+
+    /**
+     * @brief Share every buffered scan, oldest to newest, without copying them.
+     */
+    virtual bool getCompactSnapshot(RingBufferSnapshot<TimedCompactLidarData> &outSnapshot) const = 0;
+
+    /**
+     * @brief Share the scans covering [@p from, @p to], oldest to newest, without copying them.
+     */
+    virtual bool getCompactSnapshotBetween(
+        std::chrono::steady_clock::time_point from,
+        std::chrono::steady_clock::time_point to,
+        RingBufferSnapshot<TimedCompactLidarData> &outSnapshot
+    ) const = 0;
+
+    /**
+     * @brief Hit/miss counters of the scan storage pool.
+     */
+    virtual PoolStats scanPoolStats() const = 0;
+
+    /**
+     * @brief Start writing every published scan to the source's Logger, if it has one.
+     */
+    virtual void startLogging() = 0;
+
+    /**
+     * @brief Stop writing scans to the Logger.
+     */
+    virtual void stopLogging() = 0;
+};
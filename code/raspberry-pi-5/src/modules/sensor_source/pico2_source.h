@@ -0,0 +1,108 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "lock_free_ring_buffer.hpp"
+#include "pico2_struct.h"
+#include "thread_config.h"
+#include "update_signal.hpp"
+
+/**
+ * @brief Where IMU and encoder samples come from, and where movement commands go:
+ * the Pico2 over I2C (Pico2Module) or a log replay (Pico2Replay).
+ *
+ * Only the consumer side is abstract; setting a source up is left to the
+ * concrete class. See Pico2Module for the full description of each method.
+ */
+class Pico2Source
+{
+public:
+    virtual ~Pico2Source() = default;
+
+    /**
+     * @brief Send motor speed and steering commands. @return true if the command was accepted.
+     */
+    virtual bool setMovementInfo(float motorSpeed, float steeringPercent) = 0;
+
+    /**
+     * @brief Get the latest sample. @return false if no sample has arrived yet.
+     */
+    virtual bool getData(TimedPico2Data &outData) const = 0;
+
+    /**
+     * @brief Copy every buffered sample in chronological order.
+     */
+    virtual bool getAllTimedData(std::vector<TimedPico2Data> &outData) const = 0;
+
+    /**
+     * @brief Share every buffered sample in chronological order without copying them.
+     */
+    virtual bool getSnapshot(RingBufferSnapshot<TimedPico2Data> &outSnapshot) const = 0;
+
+    /**
+     * @brief Share the newest @p count samples (or fewer) in chronological order.
+     */
+    virtual bool getLatestSnapshot(size_t count, RingBufferSnapshot<TimedPico2Data> &outSnapshot) const = 0;
+
+    /**
+     * @brief Share the samples newer than @p since, preceded by the last one at or before it.
+     */
+    virtual bool getSnapshotSince(std::chrono::steady_clock::time_point since, RingBufferSnapshot<TimedPico2Data> &outSnapshot) const = 0;
+
+    /**
+     * @brief Share the samples covering [@p from, @p to] in chronological order.
+     */
+    virtual bool getSnapshotBetween(
+        std::chrono::steady_clock::time_point from,
+        std::chrono::steady_clock::time_point to,
+        RingBufferSnapshot<TimedPico2Data> &outSnapshot
+    ) const = 0;
+
+    /**
+     * @brief Number of samples in the buffer.
+     */
+    virtual size_t bufferSize() const = 0;
+
+    /**
+     * @brief Block until at least one sample is available, then return the latest.
+     */
+    virtual bool waitForData(TimedPico2Data &outData) = 0;
+
+    /**
+     * @brief Sequence number of the latest sample: the number of samples published so far (0 if none).
+     */
+    virtual uint64_t sequence() const = 0;
+
+    /**
+     * @brief Block until a sample newer than @p sequence is available. @return false on timeout.
+     */
+    virtual bool waitForNewer(uint64_t sequence, std::chrono::milliseconds timeout) = 0;
+
+    /**
+     * @brief Also notify @p signal after every new sample, or stop doing so with nullptr.
+     */
+    virtual void setUpdateSignal(UpdateSignal *signal) = 0;
+
+    /**
+     * @brief Set the name, scheduling policy and CPU set of the thread publishing the samples. Call before it starts.
+     */
+    virtual void setThreadConfig(const ThreadConfig &config) = 0;
+
+    /**
+     * @brief How regularly samples are published: the mean interval, its jitter and extremes.
+     */
+    virtual JitterStats threadJitter() const = 0;
+
+    /**
+     * @brief Start writing every published sample to the source's Logger, if it has one.
+     */
+    virtual void startLogging() = 0;
+
+    /**
+     * @brief Stop writing samples to the Logger.
+     */
+    virtual void stopLogging() = 0;
+};
@@ -26,6 +26,22 @@ namespace
         return results;
     }
 
+    // Shared by the std and the std::pmr overloads of computeBlockAngles
+    template <typename BlockAngles>
+    void appendBlockAngles(const ColorMasks &masks, int imageWidth, float hfov, BlockAngles &results) {
+        // Red blocks
+        for (const auto &contour : masks.red.contours) {
+            float angle = pixelToAngle(static_cast<int>(contour.centroid.x), imageWidth, hfov);
+            results.push_back(BlockAngle{angle, contour.area, contour.centroid, Color::RED});
+        }
+
+        // Green blocks
+        for (const auto &contour : masks.green.contours) {
+            float angle = pixelToAngle(static_cast<int>(contour.centroid.x), imageWidth, hfov);
+            results.push_back(BlockAngle{angle, contour.area, contour.centroid, Color::GREEN});
+        }
+    }
+
 }  // namespace
 
 ColorMasks filterColors(const TimedFrame &timedFrame, double areaThreshold) {
@@ -34,12 +50,15 @@ ColorMasks filterColors(const TimedFrame &timedFrame, double areaThreshold) {
     CV_Assert(!input.empty());
     CV_Assert(input.type() == CV_8UC3);
 
-    // Fill the top part with black
+    // Ignore the top part. Only the bottom is converted; the top stays (0, 0, 0),
+    // which no range below accepts. The input frame is shared with the ring
+    // buffer and the log encoder, so it must not be modified here.
     int topRows = static_cast<int>(input.rows * 0.50);
-    input(cv::Rect(0, 0, input.cols, topRows)) = cv::Scalar(0, 0, 0);
+    cv::Rect bottom(0, topRows, input.cols, input.rows - topRows);
 
-    cv::Mat hsv;
-    cv::cvtColor(input, hsv, cv::COLOR_BGR2HSV);
+    cv::Mat hsv = cv::Mat::zeros(input.size(), CV_8UC3);
+    cv::Mat hsvBottom = hsv(bottom);
+    cv::cvtColor(input(bottom), hsvBottom, cv::COLOR_BGR2HSV);
 
     // Red
     cv::Mat maskRed1, maskRed2, maskRed;
@@ -115,19 +134,13 @@ float pixelToAngle(int pixelX, int imageWidth, float hfov) {
 
 std::vector<BlockAngle> computeBlockAngles(const ColorMasks &masks, int imageWidth, float hfov) {
     std::vector<BlockAngle> results;
+    appendBlockAngles(masks, imageWidth, hfov, results);
+    return results;
+}
 
-    // Red blocks
-    for (const auto &contour : masks.red.contours) {
-        float angle = pixelToAngle(static_cast<int>(contour.centroid.x), imageWidth, hfov);
-        results.push_back(BlockAngle{angle, contour.area, contour.centroid, Color::RED});
-    }
-
-    // Green blocks
-    for (const auto &contour : masks.green.contours) {
-        float angle = pixelToAngle(static_cast<int>(contour.centroid.x), imageWidth, hfov);
-        results.push_back(BlockAngle{angle, contour.area, contour.centroid, Color::GREEN});
-    }
-
+std::pmr::vector<BlockAngle> computeBlockAngles(const ColorMasks &masks, std::pmr::memory_resource *memory, int imageWidth, float hfov) {
+    std::pmr::vector<BlockAngle> results(memory);
+    appendBlockAngles(masks, imageWidth, hfov, results);
     return results;
 }
 
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <memory_resource>
 #include <opencv2/opencv.hpp>
+#include <vector>
 
 #include "camera_struct.h"
 
@@ -145,4 +147,19 @@ struct BlockAngle {
  */
 std::vector<BlockAngle> computeBlockAngles(const ColorMasks &masks, int imageWidth = 1296, float hfov = 110.0f);
 
+/**
+ * @brief computeBlockAngles() with the result allocated from @p memory, e.g. a per-tick arena.
+ *
+ * @note filterColors() has no such overload: its masks are cv::Mat and its contours come from cv::findContours,
+ *       which only fill std::vector.
+ *
+ * @param memory Resource for the result, e.g. TickArena::resource().
+ */
+std::pmr::vector<BlockAngle> computeBlockAngles(
+    const ColorMasks &masks,
+    std::pmr::memory_resource *memory,
+    int imageWidth = 1296,
+    float hfov = 110.0f
+);
+
 }  // namespace camera_processor
@@ -8,106 +8,84 @@ namespace combined_processor
 
 constexpr float WHEEL_DIAMETER = 0.055f;
 
-RobotDeltaPose aproximateRobotPose(const TimedLidarData &timedLidarData, const std::vector<TimedPico2Data> &timedPico2Datas) {
-    RobotDeltaPose deltaPose{0.0f, 0.0f, 0.0f};
-
-    if (timedPico2Datas.empty()) return deltaPose;
-
-    // Find index of latest Pico2 sample before LIDAR timestamp
-    int index = -1;
-    for (int i = static_cast<int>(timedPico2Datas.size()) - 1; i >= 0; --i) {
-        if (timedPico2Datas[i].timestamp <= timedLidarData.timestamp) {
-            index = i;
-            break;  // stop at first valid sample
-        }
-    }
-    if (index < 0) return deltaPose;
-
-    float lastHeading = timedPico2Datas[index].euler.h;
-
-    // Initialize robot pose relative to LIDAR timestamp
-    float totalDeltaX = 0.0f;
-    float totalDeltaY = 0.0f;
-    float totalDeltaH = 0.0f;
+namespace
+{
 
-    // Loop from index+1 to latest Pico2 data
-    for (size_t i = index + 1; i < timedPico2Datas.size(); ++i) {
-        const auto &prev = timedPico2Datas[i - 1];
-        const auto &curr = timedPico2Datas[i];
+    // Shared by the vector and snapshot overloads; sampleAt(i) returns the i-th Pico2 sample, oldest first
+    template <typename SampleAt>
+    RobotDeltaPose integrateRobotPose(const TimedLidarData &timedLidarData, size_t sampleCount, SampleAt sampleAt) {
+        RobotDeltaPose deltaPose{0.0f, 0.0f, 0.0f};
 
-        // Calculate heading difference
-        float dHeading = curr.euler.h - prev.euler.h;
-        dHeading = std::fmod(dHeading + 180.0f, 360.0f) - 180.0f;
+        if (sampleCount == 0) return deltaPose;
 
-        totalDeltaH += dHeading;
-        totalDeltaH = std::fmod(totalDeltaH, 360.0f);
-        if (totalDeltaH < 0.0f) totalDeltaH += 360.0f;
+        // Find index of latest Pico2 sample before LIDAR timestamp
+        int index = -1;
+        for (int i = static_cast<int>(sampleCount) - 1; i >= 0; --i) {
+            if (sampleAt(i).timestamp <= timedLidarData.timestamp) {
+                index = i;
+                break;  // stop at first valid sample
+            }
+        }
+        if (index < 0) return deltaPose;
 
-        // Calculate encoder delta distance
-        double dDistance = (curr.encoderAngle - prev.encoderAngle) * (M_PI * WHEEL_DIAMETER) / 360.0;
+        float lastHeading = sampleAt(index).euler.h;
 
-        // Convert relative movement to x/y
-        float headingRad = dHeading * M_PI / 180.0f;
-        totalDeltaX += dDistance * std::sin(headingRad);
-        totalDeltaY += dDistance * std::cos(headingRad);
-    }
+        // Initialize robot pose relative to LIDAR timestamp
+        float totalDeltaX = 0.0f;
+        float totalDeltaY = 0.0f;
+        float totalDeltaH = 0.0f;
 
-    if (totalDeltaX >= 0.15f) return {0.0f, 0.0f, 0.0f};
-    if (totalDeltaY >= 0.15f) return {0.0f, 0.0f, 0.0f};
-    if (totalDeltaH >= 20.0f and totalDeltaH <= 180.0f)
-        return {0.0f, 0.0f, 0.0f};
-    else if (totalDeltaH <= 340.0f and totalDeltaH > 180.0f)
-        return {0.0f, 0.0f, 0.0f};
+        // Loop from index+1 to latest Pico2 data
+        for (size_t i = index + 1; i < sampleCount; ++i) {
+            const auto &prev = sampleAt(i - 1);
+            const auto &curr = sampleAt(i);
 
-    deltaPose.deltaX = totalDeltaX;
-    deltaPose.deltaY = totalDeltaY;
-    deltaPose.deltaH = totalDeltaH;
+            // Calculate heading difference
+            float dHeading = curr.euler.h - prev.euler.h;
+            dHeading = std::fmod(dHeading + 180.0f, 360.0f) - 180.0f;
 
-    return deltaPose;
-}
+            totalDeltaH += dHeading;
+            totalDeltaH = std::fmod(totalDeltaH, 360.0f);
+            if (totalDeltaH < 0.0f) totalDeltaH += 360.0f;
 
-std::optional<SyncedLidarCamera> syncLidarCamera(
-    const std::vector<TimedFrame> &timedFrames,
-    const std::vector<TimedLidarData> &timedLidarDatas,
-    std::chrono::milliseconds cameraDelay
-) {
-    if (timedFrames.empty() || timedLidarDatas.empty()) return std::nullopt;
+            // Calculate encoder delta distance
+            double dDistance = (curr.encoderAngle - prev.encoderAngle) * (M_PI * WHEEL_DIAMETER) / 360.0;
 
-    for (const auto &frame : timedFrames) {
-        auto adjustedTime = frame.timestamp + cameraDelay;
+            // Convert relative movement to x/y
+            float headingRad = dHeading * M_PI / 180.0f;
+            totalDeltaX += dDistance * std::sin(headingRad);
+            totalDeltaY += dDistance * std::cos(headingRad);
+        }
 
-        // Find lidar data closest in time
-        const TimedLidarData *bestMatch = nullptr;
-        auto bestDiff = std::chrono::milliseconds::max();
+        if (totalDeltaX >= 0.15f) return {0.0f, 0.0f, 0.0f};
+        if (totalDeltaY >= 0.15f) return {0.0f, 0.0f, 0.0f};
+        if (totalDeltaH >= 20.0f and totalDeltaH <= 180.0f)
+            return {0.0f, 0.0f, 0.0f};
+        else if (totalDeltaH <= 340.0f and totalDeltaH > 180.0f)
+            return {0.0f, 0.0f, 0.0f};
 
-        for (const auto &lidar : timedLidarDatas) {
-            auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(adjustedTime - lidar.timestamp);
-            if (std::abs(diff.count()) < bestDiff.count()) {
-                bestDiff = diff;
-                bestMatch = &lidar;
-            }
-        }
+        deltaPose.deltaX = totalDeltaX;
+        deltaPose.deltaY = totalDeltaY;
+        deltaPose.deltaH = totalDeltaH;
 
-        if (bestMatch) {
-            return SyncedLidarCamera{frame, *bestMatch};
-        }
+        return deltaPose;
     }
 
-    return std::nullopt;
-}
+    template <typename T, typename Allocator>
+    using Rebind = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
 
-std::vector<TrafficLightInfo> combineTrafficLightInfo(
-    const std::vector<camera_processor::BlockAngle> &blockAngles,
-    const std::vector<cv::Point2f> &lidarPoints,
-    cv::Point2f cameraOffset,
-    float trafficLightRadius
-) {
-    std::vector<TrafficLightInfo> trafficLightInfos;
-    std::vector<cv::Point2f> avaliableLidarPoints = lidarPoints;
+    // A vector of T with the allocator of the caller, so one implementation serves the std and the std::pmr overloads
+    template <typename T, typename Allocator>
+    using Vector = std::vector<T, Rebind<T, Allocator>>;
 
     // ---- Helper: ray-circle intersection ----
-    auto rayCircleIntersect =
-        [](const cv::Point2f &rayOrigin, const cv::Point2f &rayDir, const cv::Point2f &circleCenter, float radius, float &tHit) -> bool {
+    bool rayCircleIntersect(
+        const cv::Point2f &rayOrigin,
+        const cv::Point2f &rayDir,
+        const cv::Point2f &circleCenter,
+        float radius,
+        float &tHit
+    ) {
         cv::Point2f oc = rayOrigin - circleCenter;
         float b = 2.0f * (oc.x * rayDir.x + oc.y * rayDir.y);
         float c = oc.x * oc.x + oc.y * oc.y - radius * radius;
@@ -127,177 +105,285 @@ std::vector<TrafficLightInfo> combineTrafficLightInfo(
             return true;
         }
         return false;
-    };
+    }
 
-    // ---- Track which lidar points were hit, and by what colors ----
-    std::unordered_map<size_t, std::vector<camera_processor::BlockAngle>> lidarHits;
+    template <typename BlockAngles, typename Points, typename Allocator>
+    Vector<TrafficLightInfo, Allocator> matchTrafficLights(
+        const BlockAngles &blockAngles,
+        const Points &lidarPoints,
+        cv::Point2f cameraOffset,
+        float trafficLightRadius,
+        const Allocator &allocator
+    ) {
+        Vector<TrafficLightInfo, Allocator> trafficLightInfos(allocator);
+        Vector<cv::Point2f, Allocator> avaliableLidarPoints(lidarPoints.begin(), lidarPoints.end(), allocator);
+
+        // ---- Track which lidar points were hit, and by what colors ----
+        using Hits = Vector<camera_processor::BlockAngle, Allocator>;
+        using HitsAllocator = Rebind<std::pair<const size_t, Hits>, Allocator>;
+        std::unordered_map<size_t, Hits, std::hash<size_t>, std::equal_to<size_t>, HitsAllocator> lidarHits(allocator);
+
+        for (const auto &block : blockAngles) {
+            float rayAngle = (90.0f - block.angle) * static_cast<float>(M_PI) / 180.0f;
+            cv::Point2f rayDir{std::cos(rayAngle), std::sin(rayAngle)};
+
+            size_t bestIndex = std::numeric_limits<size_t>::max();
+            float bestTHit = std::numeric_limits<float>::max();
+
+            for (size_t i = 0; i < avaliableLidarPoints.size(); ++i) {
+                float tHit;
+                if (rayCircleIntersect(cameraOffset, rayDir, avaliableLidarPoints[i], trafficLightRadius, tHit)) {
+                    if (tHit < bestTHit) {  // keep the nearest intersection
+                        bestTHit = tHit;
+                        bestIndex = i;
+                    }
+                }
+            }
 
-    for (const auto &block : blockAngles) {
-        float rayAngle = (90.0f - block.angle) * static_cast<float>(M_PI) / 180.0f;
-        cv::Point2f rayDir{std::cos(rayAngle), std::sin(rayAngle)};
+            if (bestIndex != std::numeric_limits<size_t>::max()) {
+                // only record the closest hit for this ray
+                lidarHits[bestIndex].push_back(block);
+            }
+        }
 
-        size_t bestIndex = std::numeric_limits<size_t>::max();
-        float bestTHit = std::numeric_limits<float>::max();
+        // ---- Conflict resolution: discard if multiple colors hit the same point ----
+        for (auto &kv : lidarHits) {
+            auto &blocks = kv.second;
+            bool conflict = false;
 
-        for (size_t i = 0; i < avaliableLidarPoints.size(); ++i) {
-            float tHit;
-            if (rayCircleIntersect(cameraOffset, rayDir, avaliableLidarPoints[i], trafficLightRadius, tHit)) {
-                if (tHit < bestTHit) {  // keep the nearest intersection
-                    bestTHit = tHit;
-                    bestIndex = i;
+            camera_processor::Color firstColor = blocks[0].color;
+            for (auto &b : blocks) {
+                if (b.color != firstColor) {
+                    conflict = true;
+                    break;
                 }
             }
-        }
 
-        if (bestIndex != std::numeric_limits<size_t>::max()) {
-            // only record the closest hit for this ray
-            lidarHits[bestIndex].push_back(block);
+            if (!conflict) {
+                cv::Point2f rel = lidarPoints[kv.first] - cameraOffset;
+                float angle = 90.0f - (std::atan2(rel.y, rel.x) * 180.0f / static_cast<float>(M_PI));
+
+                if (angle >= -54.0f && angle <= 54.0f) {
+                    for (auto &b : blocks) {
+                        trafficLightInfos.push_back(TrafficLightInfo{lidarPoints[kv.first], b});
+                    }
+                }
+            }
         }
+
+        return trafficLightInfos;
     }
 
-    // ---- Conflict resolution: discard if multiple colors hit the same point ----
-    for (auto &kv : lidarHits) {
-        auto &blocks = kv.second;
-        bool conflict = false;
+    template <typename TrafficLights, typename Allocator>
+    Vector<ClassifiedTrafficLight, Allocator> locateTrafficLights(
+        const TrafficLights &trafficLights,
+        const lidar_processor::ResolvedWalls &resolvedWalls,
+        RotationDirection turnDirection,
+        Segment currentSegment,
+        const Allocator &allocator
+    ) {
+        Vector<ClassifiedTrafficLight, Allocator> results(allocator);
+        results.reserve(trafficLights.size());
+
+        // Pick outer/inner walls
+        std::optional<lidar_processor::LineSegment> outerWall, innerWall;
+        if (turnDirection == RotationDirection::CLOCKWISE) {
+            outerWall = resolvedWalls.leftWall;
+            innerWall = resolvedWalls.rightWall;
+        } else {
+            outerWall = resolvedWalls.rightWall;
+            innerWall = resolvedWalls.leftWall;
+        }
+
+        for (const auto &tl : trafficLights) {
+            const cv::Point2f &p = tl.lidarPosition;
 
-        camera_processor::Color firstColor = blocks[0].color;
-        for (auto &b : blocks) {
-            if (b.color != firstColor) {
-                conflict = true;
-                break;
+            // --- Distances ---
+            float frontDist = 0.0f;
+            if (resolvedWalls.frontWall) {
+                frontDist = resolvedWalls.frontWall->perpendicularDistance(p.x, p.y);
+            } else if (resolvedWalls.backWall) {
+                frontDist = 3.0f - resolvedWalls.backWall->perpendicularDistance(p.x, p.y);
+            }
+
+            float outerDist = 0.0f;
+            if (outerWall) {
+                outerDist = outerWall->perpendicularDistance(p.x, p.y);
+            } else if (innerWall) {
+                outerDist = 1.0f - innerWall->perpendicularDistance(p.x, p.y);
             }
-        }
 
-        if (!conflict) {
-            cv::Point2f rel = lidarPoints[kv.first] - cameraOffset;
-            float angle = 90.0f - (std::atan2(rel.y, rel.x) * 180.0f / static_cast<float>(M_PI));
+            // --- SegmentLocation: A/B/C depending on rotation ---
+            Segment seg;
+            SegmentLocation loc;
+            WallSide side;
+            if (outerDist < 0.900) {
+                if (turnDirection == RotationDirection::CLOCKWISE) {
+                    seg = currentSegment;
+
+                    if (frontDist > 0.80 && frontDist < 1.15f)
+                        loc = SegmentLocation::C;  // front
+                    else if (frontDist > 1.35 && frontDist < 1.65f)
+                        loc = SegmentLocation::B;  // mid
+                    else if (frontDist > 1.85 && frontDist < 2.15)
+                        loc = SegmentLocation::A;  // back
+                    else
+                        continue;
+                } else {
+                    seg = currentSegment;
+
+                    if (frontDist > 0.80 && frontDist < 1.15f)
+                        loc = SegmentLocation::A;  // front (reverse)
+                    else if (frontDist > 1.35 && frontDist < 1.65f)
+                        loc = SegmentLocation::B;  // mid
+                    else if (frontDist > 1.85 && frontDist < 2.15)
+                        loc = SegmentLocation::C;  // back
+                    else
+                        continue;
+                }
 
-            if (angle >= -54.0f && angle <= 54.0f) {
-                for (auto &b : blocks) {
-                    trafficLightInfos.push_back(TrafficLightInfo{lidarPoints[kv.first], b});
+                if (outerDist < 0.480)
+                    side = WallSide::OUTER;
+                else if (outerDist > 0.520)
+                    side = WallSide::INNER;
+                else
+                    continue;
+            } else {
+                if (turnDirection == RotationDirection::CLOCKWISE) {
+                    float nextHeading = currentSegment.toHeading() + 90.0f;
+                    nextHeading = std::fmod(nextHeading + 360.0f, 360.0f);
+                    seg = Segment::fromHeading(nextHeading);
+
+                    if (outerDist > 0.900 && outerDist < 1.15f)
+                        loc = SegmentLocation::A;  // front
+                    else if (outerDist > 1.35 && outerDist < 1.65f)
+                        loc = SegmentLocation::B;  // mid
+                    else if (outerDist > 1.85 && outerDist < 2.15)
+                        loc = SegmentLocation::C;  // back
+                    else
+                        continue;
+                } else {
+                    float nextHeading = currentSegment.toHeading() - 90.0f;
+                    nextHeading = std::fmod(nextHeading + 360.0f, 360.0f);
+                    seg = Segment::fromHeading(nextHeading);
+
+                    if (outerDist >= 0.900 && outerDist < 1.15f)
+                        loc = SegmentLocation::C;  // front
+                    else if (outerDist > 1.35 && outerDist < 1.65f)
+                        loc = SegmentLocation::B;  // mid
+                    else if (outerDist > 1.85 && outerDist < 2.15)
+                        loc = SegmentLocation::A;  // back
+                    else
+                        continue;
                 }
+
+                if (frontDist < 0.480)
+                    side = WallSide::OUTER;
+                else if (frontDist > 0.520)
+                    side = WallSide::INNER;
+                else
+                    continue;
             }
+
+            // --- Pack result ---
+            results.push_back(ClassifiedTrafficLight{tl, TrafficLightLocation{seg, loc, side}});
         }
+
+        return results;
     }
 
-    return trafficLightInfos;
+}  // namespace
+
+RobotDeltaPose aproximateRobotPose(const TimedLidarData &timedLidarData, const std::vector<TimedPico2Data> &timedPico2Datas) {
+    return integrateRobotPose(timedLidarData, timedPico2Datas.size(), [&](size_t i) -> const TimedPico2Data & {
+        return timedPico2Datas[i];
+    });
 }
 
-std::vector<ClassifiedTrafficLight> classifyTrafficLights(
-    const std::vector<TrafficLightInfo> &trafficLights,
-    const lidar_processor::ResolvedWalls &resolvedWalls,
-    RotationDirection turnDirection,
-    Segment currentSegment
+RobotDeltaPose aproximateRobotPose(const TimedLidarData &timedLidarData, const RingBufferSnapshot<TimedPico2Data> &timedPico2Datas) {
+    return integrateRobotPose(timedLidarData, timedPico2Datas.size(), [&](size_t i) -> const TimedPico2Data & {
+        return *timedPico2Datas[i];
+    });
+}
 
+std::optional<SyncedLidarCamera> syncLidarCamera(
+    const std::vector<TimedFrame> &timedFrames,
+    const std::vector<TimedLidarData> &timedLidarDatas,
+    std::chrono::milliseconds cameraDelay
 ) {
-    std::vector<ClassifiedTrafficLight> results;
-    results.reserve(trafficLights.size());
-
-    // Pick outer/inner walls
-    std::optional<lidar_processor::LineSegment> outerWall, innerWall;
-    if (turnDirection == RotationDirection::CLOCKWISE) {
-        outerWall = resolvedWalls.leftWall;
-        innerWall = resolvedWalls.rightWall;
-    } else {
-        outerWall = resolvedWalls.rightWall;
-        innerWall = resolvedWalls.leftWall;
-    }
+    if (timedFrames.empty() || timedLidarDatas.empty()) return std::nullopt;
+
+    for (const auto &frame : timedFrames) {
+        auto adjustedTime = frame.timestamp + cameraDelay;
 
-    for (const auto &tl : trafficLights) {
-        const cv::Point2f &p = tl.lidarPosition;
+        // Find lidar data closest in time
+        const TimedLidarData *bestMatch = nullptr;
+        auto bestDiff = std::chrono::milliseconds::max();
 
-        // --- Distances ---
-        float frontDist = 0.0f;
-        if (resolvedWalls.frontWall) {
-            frontDist = resolvedWalls.frontWall->perpendicularDistance(p.x, p.y);
-        } else if (resolvedWalls.backWall) {
-            frontDist = 3.0f - resolvedWalls.backWall->perpendicularDistance(p.x, p.y);
+        for (const auto &lidar : timedLidarDatas) {
+            auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(adjustedTime - lidar.timestamp);
+            if (std::abs(diff.count()) < bestDiff.count()) {
+                bestDiff = diff;
+                bestMatch = &lidar;
+            }
         }
 
-        float outerDist = 0.0f;
-        if (outerWall) {
-            outerDist = outerWall->perpendicularDistance(p.x, p.y);
-        } else if (innerWall) {
-            outerDist = 1.0f - innerWall->perpendicularDistance(p.x, p.y);
+        if (bestMatch) {
+            return SyncedLidarCamera{frame, *bestMatch};
         }
+    }
 
-        // --- SegmentLocation: A/B/C depending on rotation ---
-        Segment seg;
-        SegmentLocation loc;
-        WallSide side;
-        if (outerDist < 0.900) {
-            if (turnDirection == RotationDirection::CLOCKWISE) {
-                seg = currentSegment;
-
-                if (frontDist > 0.80 && frontDist < 1.15f)
-                    loc = SegmentLocation::C;  // front
-                else if (frontDist > 1.35 && frontDist < 1.65f)
-                    loc = SegmentLocation::B;  // mid
-                else if (frontDist > 1.85 && frontDist < 2.15)
-                    loc = SegmentLocation::A;  // back
-                else
-                    continue;
-            } else {
-                seg = currentSegment;
-
-                if (frontDist > 0.80 && frontDist < 1.15f)
-                    loc = SegmentLocation::A;  // front (reverse)
-                else if (frontDist > 1.35 && frontDist < 1.65f)
-                    loc = SegmentLocation::B;  // mid
-                else if (frontDist > 1.85 && frontDist < 2.15)
-                    loc = SegmentLocation::C;  // back
-                else
-                    continue;
-            }
+    return std::nullopt;
+}
 
-            if (outerDist < 0.480)
-                side = WallSide::OUTER;
-            else if (outerDist > 0.520)
-                side = WallSide::INNER;
-            else
-                continue;
-        } else {
-            if (turnDirection == RotationDirection::CLOCKWISE) {
-                float nextHeading = currentSegment.toHeading() + 90.0f;
-                nextHeading = std::fmod(nextHeading + 360.0f, 360.0f);
-                seg = Segment::fromHeading(nextHeading);
-
-                if (outerDist > 0.900 && outerDist < 1.15f)
-                    loc = SegmentLocation::A;  // front
-                else if (outerDist > 1.35 && outerDist < 1.65f)
-                    loc = SegmentLocation::B;  // mid
-                else if (outerDist > 1.85 && outerDist < 2.15)
-                    loc = SegmentLocation::C;  // back
-                else
-                    continue;
-            } else {
-                float nextHeading = currentSegment.toHeading() - 90.0f;
-                nextHeading = std::fmod(nextHeading + 360.0f, 360.0f);
-                seg = Segment::fromHeading(nextHeading);
-
-                if (outerDist >= 0.900 && outerDist < 1.15f)
-                    loc = SegmentLocation::C;  // front
-                else if (outerDist > 1.35 && outerDist < 1.65f)
-                    loc = SegmentLocation::B;  // mid
-                else if (outerDist > 1.85 && outerDist < 2.15)
-                    loc = SegmentLocation::A;  // back
-                else
-                    continue;
-            }
+std::vector<TrafficLightInfo> combineTrafficLightInfo(
+    const std::vector<camera_processor::BlockAngle> &blockAngles,
+    const std::vector<cv::Point2f> &lidarPoints,
+    cv::Point2f cameraOffset,
+    float trafficLightRadius
+) {
+    return matchTrafficLights(blockAngles, lidarPoints, cameraOffset, trafficLightRadius, std::allocator<TrafficLightInfo>());
+}
 
-            if (frontDist < 0.480)
-                side = WallSide::OUTER;
-            else if (frontDist > 0.520)
-                side = WallSide::INNER;
-            else
-                continue;
-        }
+std::pmr::vector<TrafficLightInfo> combineTrafficLightInfo(
+    const std::pmr::vector<camera_processor::BlockAngle> &blockAngles,
+    const std::pmr::vector<cv::Point2f> &lidarPoints,
+    std::pmr::memory_resource *memory,
+    cv::Point2f cameraOffset,
+    float trafficLightRadius
+) {
+    return matchTrafficLights(
+        blockAngles,
+        lidarPoints,
+        cameraOffset,
+        trafficLightRadius,
+        std::pmr::polymorphic_allocator<TrafficLightInfo>(memory)
+    );
+}
 
-        // --- Pack result ---
-        results.push_back(ClassifiedTrafficLight{tl, TrafficLightLocation{seg, loc, side}});
-    }
+std::vector<ClassifiedTrafficLight> classifyTrafficLights(
+    const std::vector<TrafficLightInfo> &trafficLights,
+    const lidar_processor::ResolvedWalls &resolvedWalls,
+    RotationDirection turnDirection,
+    Segment currentSegment
+) {
+    return locateTrafficLights(trafficLights, resolvedWalls, turnDirection, currentSegment, std::allocator<ClassifiedTrafficLight>());
+}
 
-    return results;
+std::pmr::vector<ClassifiedTrafficLight> classifyTrafficLights(
+    const std::pmr::vector<TrafficLightInfo> &trafficLights,
+    const lidar_processor::ResolvedWalls &resolvedWalls,
+    RotationDirection turnDirection,
+    Segment currentSegment,
+    std::pmr::memory_resource *memory
+) {
+    return locateTrafficLights(
+        trafficLights,
+        resolvedWalls,
+        turnDirection,
+        currentSegment,
+        std::pmr::polymorphic_allocator<ClassifiedTrafficLight>(memory)
+    );
 }
 
 void drawTrafficLightInfo(cv::Mat &img, const TrafficLightInfo &info, float scale, int radius) {
@@ -5,11 +5,14 @@
 #include "direction.h"
 #include "lidar_processor.h"
 #include "lidar_struct.h"
+#include "lock_free_ring_buffer.hpp"
 #include "pico2_struct.h"
 #include "ring_buffer.hpp"
 #include "robot_pose_struct.h"
 
+#include <memory_resource>
 #include <optional>
+#include <vector>
 
 namespace combined_processor
 {
@@ -31,6 +34,19 @@ struct SyncedLidarCamera {
  */
 RobotDeltaPose aproximateRobotPose(const TimedLidarData &timedLidarData, const std::vector<TimedPico2Data> &timedPico2Datas);
 
+/**
+ * @brief Approximate the robot's movement since the LIDAR scan from a snapshot of Pico2 samples.
+ *
+ * Same as above, without copying the samples. Only the last sample at or before
+ * the LIDAR timestamp and the newer ones are used, so a snapshot taken with
+ * Pico2Module::getSnapshotSince(timedLidarData.timestamp, ...) is enough.
+ *
+ * @param timedLidarData The LIDAR scan with timestamp.
+ * @param timedPico2Datas Time-ordered snapshot of Pico2 samples.
+ * @return RobotDeltaPose containing deltaX, deltaY, and deltaH.
+ */
+RobotDeltaPose aproximateRobotPose(const TimedLidarData &timedLidarData, const RingBufferSnapshot<TimedPico2Data> &timedPico2Datas);
+
 /**
  * @brief Synchronize a camera frame with a lidar scan, accounting for delay.
  *
@@ -75,6 +91,19 @@ std::vector<TrafficLightInfo> combineTrafficLightInfo(
     float trafficLightRadius = 0.08f
 );
 
+/**
+ * @brief combineTrafficLightInfo() with the result and the matching bookkeeping allocated from @p memory.
+ *
+ * @param memory Resource for all allocations, e.g. TickArena::resource().
+ */
+std::pmr::vector<TrafficLightInfo> combineTrafficLightInfo(
+    const std::pmr::vector<camera_processor::BlockAngle> &blockAngles,
+    const std::pmr::vector<cv::Point2f> &lidarPoints,
+    std::pmr::memory_resource *memory,
+    cv::Point2f cameraOffset = {0.0f, 0.11f},
+    float trafficLightRadius = 0.08f
+);
+
 /**
  * @brief Represents the classified location of a traffic light relative to the robot's path and walls.
  */
@@ -132,6 +161,19 @@ std::vector<ClassifiedTrafficLight> classifyTrafficLights(
     Segment currentSegment
 );
 
+/**
+ * @brief classifyTrafficLights() with the result allocated from @p memory.
+ *
+ * @param memory Resource for the result, e.g. TickArena::resource().
+ */
+std::pmr::vector<ClassifiedTrafficLight> classifyTrafficLights(
+    const std::pmr::vector<TrafficLightInfo> &trafficLights,
+    const lidar_processor::ResolvedWalls &resolvedWalls,
+    RotationDirection turnDirection,
+    Segment currentSegment,
+    std::pmr::memory_resource *memory
+);
+
 /**
  * @brief Draws traffic light info on an image.
  *
@@ -6,6 +6,10 @@ namespace lidar_processor
 namespace
 {
 
+    // A vector of T with the allocator of the caller, so one implementation serves the std and the std::pmr overloads
+    template <typename T, typename Allocator>
+    using Vector = std::vector<T, typename std::allocator_traits<Allocator>::template rebind_alloc<T>>;
+
     /**
      * @brief Convert LiDAR coordinates to standard Cartesian coordinates.
      *
@@ -90,11 +94,12 @@ namespace
     }
 
     // --- Recursive Split Step ---
+    template <typename Points, typename Segments>
     void splitSegment(
-        const std::vector<cv::Point2f> &points,
+        const Points &points,
         int start,
         int end,
-        std::vector<LineSegment> &segments,
+        Segments &segments,
         float threshold,
         int minPointsPerSegment,
         float maxPointGap,
@@ -142,8 +147,9 @@ namespace
     }
 
     // --- Merge Step: Merge collinear & close segments ---
-    std::vector<LineSegment> mergeSegments(const std::vector<LineSegment> &segments, float angleThresholdDeg, float gapThreshold) {
-        std::vector<LineSegment> mergedSegments;
+    template <typename Segments>
+    Segments mergeSegments(const Segments &segments, float angleThresholdDeg, float gapThreshold) {
+        Segments mergedSegments(segments.get_allocator());
         if (segments.empty()) return mergedSegments;
 
         mergedSegments.push_back(segments.front());
@@ -192,18 +198,16 @@ namespace
         return mergedSegments;
     }
 
-    std::vector<LineSegment> mergeAlignedSegments(
-        const std::vector<LineSegment> &segments,
-        float angleThresholdDeg,
-        float collinearThreshold
-    ) {
-        std::vector<LineSegment> mergedSegments = segments;
+    template <typename Segments>
+    Segments mergeAlignedSegments(const Segments &segments, float angleThresholdDeg, float collinearThreshold) {
+        // Allocator-extended copy: a plain copy of a std::pmr::vector would use the default resource
+        Segments mergedSegments(segments, segments.get_allocator());
         bool merged;
 
         do {
             merged = false;
-            std::vector<LineSegment> newSegments;
-            std::vector<bool> used(mergedSegments.size(), false);
+            Segments newSegments(segments.get_allocator());
+            Vector<bool, typename Segments::allocator_type> used(mergedSegments.size(), false, segments.get_allocator());
 
             for (size_t i = 0; i < mergedSegments.size(); ++i) {
                 if (used[i]) continue;
@@ -249,7 +253,7 @@ namespace
                     }
 
                     // Project endpoints onto current line direction to extend the segment
-                    std::vector<cv::Point2f> pts = {start, end, otherStart, otherEnd};
+                    const cv::Point2f pts[] = {start, end, otherStart, otherEnd};
                     auto proj = [&](const cv::Point2f &pt) { return (pt - start).dot(dir); };
 
                     double minProj = proj(pts[0]);
@@ -285,427 +289,607 @@ namespace
         return mergedSegments;
     }
 
-}  // namespace
-
-TimedLidarData filterLidarData(const TimedLidarData &timedLidarData, float minDistance) {
-    TimedLidarData filteredLidarData;
-    filteredLidarData.timestamp = timedLidarData.timestamp;
-
-    for (const auto &node : timedLidarData.lidarData) {
-        if (node.distance < minDistance) continue;
-        if (node.distance < 0.005) continue;
-        if (node.distance > 3.200) continue;
-        if ((node.angle > 340 || node.angle < 200) && node.distance > 0.700) continue;
-
-        filteredLidarData.lidarData.push_back(node);
-    }
+    template <typename Allocator>
+    using RelativeWallsWith = BasicRelativeWalls<typename std::allocator_traits<Allocator>::template rebind_alloc<LineSegment>>;
 
-    return filteredLidarData;
-}
+    template <typename Allocator>
+    Vector<LineSegment, Allocator> extractLines(
+        const TimedLidarData &timedLidarData,
+        const RobotDeltaPose &robotDeltaPose,
+        float splitThreshold,
+        int minPoints,
+        float maxPointGap,
+        float minLength,
+        float mergeAngleThreshold,
+        float mergeGapThreshold,
+        const Allocator &allocator
+    ) {
+        // Convert polar to Cartesian (in meters)
+        Vector<cv::Point2f, Allocator> points(allocator);
+        points.reserve(timedLidarData.lidarData.size());
 
-std::vector<LineSegment> getLines(
-    const TimedLidarData &timedLidarData,
-    const RobotDeltaPose &robotDeltaPose,
-    float splitThreshold,
-    int minPoints,
-    float maxPointGap,
-    float minLength,
-    float mergeAngleThreshold,
-    float mergeGapThreshold
-) {
-    // Convert polar to Cartesian (in meters)
-    std::vector<cv::Point2f> points;
-    points.reserve(timedLidarData.lidarData.size());
+        for (const auto &node : timedLidarData.lidarData) {
+            float rad = node.angle * static_cast<float>(M_PI) / 180.0f;
 
-    for (const auto &node : timedLidarData.lidarData) {
-        float rad = node.angle * static_cast<float>(M_PI) / 180.0f;
+            float lidarX = node.distance * std::sin(rad);
+            float lidarY = node.distance * std::cos(rad);
+            float x, y;
+            lidarToCartesian(lidarX, lidarY, x, y);
 
-        float lidarX = node.distance * std::sin(rad);
-        float lidarY = node.distance * std::cos(rad);
-        float x, y;
-        lidarToCartesian(lidarX, lidarY, x, y);
+            points.emplace_back(x, y);
+        }
 
-        points.emplace_back(x, y);
-    }
+        Vector<LineSegment, Allocator> rawSegments(allocator);
+        if (!points.empty()) {
+            splitSegment(points, 0, points.size() - 1, rawSegments, splitThreshold, minPoints, maxPointGap, minLength);
+        }
 
-    std::vector<LineSegment> rawSegments;
-    if (!points.empty()) {
-        splitSegment(points, 0, points.size() - 1, rawSegments, splitThreshold, minPoints, maxPointGap, minLength);
-    }
+        auto mergedSegments = mergeSegments(rawSegments, mergeAngleThreshold, mergeGapThreshold);
+
+        // Apply delta transform: translate (-deltaX, -deltaY) and rotate (-deltaH)
+        float radH = robotDeltaPose.deltaH * static_cast<float>(M_PI) / 180.0f;
+        float cosH = std::cos(radH);
+        float sinH = std::sin(radH);
+
+        for (auto &seg : mergedSegments) {
+            // Translate
+            float x1t = seg.x1 - robotDeltaPose.deltaX;
+            float y1t = seg.y1 - robotDeltaPose.deltaY;
+            float x2t = seg.x2 - robotDeltaPose.deltaX;
+            float y2t = seg.y2 - robotDeltaPose.deltaY;
+
+            // Rotate around (0,0)
+            seg.x1 = x1t * cosH - y1t * sinH;
+            seg.y1 = x1t * sinH + y1t * cosH;
+            seg.x2 = x2t * cosH - y2t * sinH;
+            seg.y2 = x2t * sinH + y2t * cosH;
+        }
 
-    auto mergedSegments = mergeSegments(rawSegments, mergeAngleThreshold, mergeGapThreshold);
-
-    // Apply delta transform: translate (-deltaX, -deltaY) and rotate (-deltaH)
-    float radH = robotDeltaPose.deltaH * static_cast<float>(M_PI) / 180.0f;
-    float cosH = std::cos(radH);
-    float sinH = std::sin(radH);
-
-    for (auto &seg : mergedSegments) {
-        // Translate
-        float x1t = seg.x1 - robotDeltaPose.deltaX;
-        float y1t = seg.y1 - robotDeltaPose.deltaY;
-        float x2t = seg.x2 - robotDeltaPose.deltaX;
-        float y2t = seg.y2 - robotDeltaPose.deltaY;
-
-        // Rotate around (0,0)
-        seg.x1 = x1t * cosH - y1t * sinH;
-        seg.y1 = x1t * sinH + y1t * cosH;
-        seg.x2 = x2t * cosH - y2t * sinH;
-        seg.y2 = x2t * sinH + y2t * cosH;
+        return mergedSegments;
     }
 
-    return mergedSegments;
-}
-
-RelativeWalls getRelativeWalls(
-    const std::vector<LineSegment> &lineSegments,
-    Direction targetDirection,
-    float heading,
-    float minLength,
-    float angleThresholdDeg,
-    float collinearThreshold
-) {
-    std::vector<LineSegment> filteredSegments;
+    template <typename Segments, typename Allocator>
+    RelativeWallsWith<Allocator> groupRelativeWalls(
+        const Segments &lineSegments,
+        Direction targetDirection,
+        float heading,
+        float minLength,
+        float angleThresholdDeg,
+        float collinearThreshold,
+        const Allocator &allocator
+    ) {
+        Vector<LineSegment, Allocator> filteredSegments(allocator);
 
-    for (const auto &segment : lineSegments) {
-        float length = std::hypot(segment.x2 - segment.x1, segment.y2 - segment.y1);
-        if (length >= minLength) {
-            filteredSegments.push_back(segment);
+        for (const auto &segment : lineSegments) {
+            float length = std::hypot(segment.x2 - segment.x1, segment.y2 - segment.y1);
+            if (length >= minLength) {
+                filteredSegments.push_back(segment);
+            }
         }
-    }
 
-    std::vector<LineSegment> mergedSegments = mergeAlignedSegments(filteredSegments, angleThresholdDeg, collinearThreshold);
+        auto mergedSegments = mergeAlignedSegments(filteredSegments, angleThresholdDeg, collinearThreshold);
 
-    RelativeWalls relativeWalls;
+        RelativeWallsWith<Allocator> relativeWalls(allocator);
 
-    for (const auto &segment : mergedSegments) {
-        // Angle of the segment’s perpendicular relative to the robot’s forward direction
-        float perpAngleRobotFrame = segment.perpendicularDirection(0.0f, 0.0f);
+        for (const auto &segment : mergedSegments) {
+            // Angle of the segment’s perpendicular relative to the robot’s forward direction
+            float perpAngleRobotFrame = segment.perpendicularDirection(0.0f, 0.0f);
 
-        // Angle of the segment’s perpendicular relative to the target direction frame
-        float perpAngleTargetFrame = std::fmod(perpAngleRobotFrame - (heading - targetDirection.toHeading()) + 360.0f, 360.0f);
+            // Angle of the segment’s perpendicular relative to the target direction frame
+            float perpAngleTargetFrame = std::fmod(perpAngleRobotFrame - (heading - targetDirection.toHeading()) + 360.0f, 360.0f);
 
-        float perpDistance = segment.perpendicularDistance(0.0f, 0.0f);
+            float perpDistance = segment.perpendicularDistance(0.0f, 0.0f);
 
-        if (perpAngleTargetFrame >= 315.0f || perpAngleTargetFrame < 45.0f) {
-            relativeWalls.rightWalls.push_back(segment);
-        } else if (perpAngleTargetFrame >= 45.0f && perpAngleTargetFrame < 135.0f) {
-            relativeWalls.frontWalls.push_back(segment);
-        } else if (perpAngleTargetFrame >= 135.0f && perpAngleTargetFrame < 225.0f) {
-            relativeWalls.leftWalls.push_back(segment);
-        } else {
-            relativeWalls.backWalls.push_back(segment);
-        }
-    }
-
-    return relativeWalls;
-}
-
-std::optional<RotationDirection> getTurnDirection(const RelativeWalls &walls) {
-    if (walls.frontWalls.empty()) return std::nullopt;
-    if (walls.leftWalls.empty() && walls.rightWalls.empty()) return std::nullopt;
-
-    // Pick the highest front line
-    const LineSegment *frontLine = &walls.frontWalls[0];
-    float frontMidY = (frontLine->y1 + frontLine->y2) / 2.0f;
-    for (const auto &line : walls.frontWalls) {
-        float midY = (line.y1 + line.y2) / 2.0f;
-        if (midY > frontMidY) {
-            frontLine = &line;
-            frontMidY = midY;
+            if (perpAngleTargetFrame >= 315.0f || perpAngleTargetFrame < 45.0f) {
+                relativeWalls.rightWalls.push_back(segment);
+            } else if (perpAngleTargetFrame >= 45.0f && perpAngleTargetFrame < 135.0f) {
+                relativeWalls.frontWalls.push_back(segment);
+            } else if (perpAngleTargetFrame >= 135.0f && perpAngleTargetFrame < 225.0f) {
+                relativeWalls.leftWalls.push_back(segment);
+            } else {
+                relativeWalls.backWalls.push_back(segment);
+            }
         }
-    }
 
-    // Determine left and right points of the front line
-    float frontLeftX, frontLeftY, frontRightX, frontRightY;
-    if (frontLine->x1 < frontLine->x2) {
-        frontLeftX = frontLine->x1;
-        frontLeftY = frontLine->y1;
-        frontRightX = frontLine->x2;
-        frontRightY = frontLine->y2;
-    } else {
-        frontLeftX = frontLine->x2;
-        frontLeftY = frontLine->y2;
-        frontRightX = frontLine->x1;
-        frontRightY = frontLine->y1;
+        return relativeWalls;
     }
 
-    // Check left walls
-    for (const auto &leftLine : walls.leftWalls) {
-        float leftHigherX, leftHigherY;
-        if (leftLine.y1 < leftLine.y2) {
-            leftHigherX = leftLine.x1;
-            leftHigherY = leftLine.y1;
-        } else {
-            leftHigherX = leftLine.x2;
-            leftHigherY = leftLine.y2;
+    template <typename Walls>
+    std::optional<RotationDirection> detectTurnDirection(const Walls &walls) {
+        if (walls.frontWalls.empty()) return std::nullopt;
+        if (walls.leftWalls.empty() && walls.rightWalls.empty()) return std::nullopt;
+
+        // Pick the highest front line
+        const LineSegment *frontLine = &walls.frontWalls[0];
+        float frontMidY = (frontLine->y1 + frontLine->y2) / 2.0f;
+        for (const auto &line : walls.frontWalls) {
+            float midY = (line.y1 + line.y2) / 2.0f;
+            if (midY > frontMidY) {
+                frontLine = &line;
+                frontMidY = midY;
+            }
         }
 
-        // Check for left wall that is far away in x direction from front wall
-        float dir = leftLine.perpendicularDirection(frontLeftX, frontLeftY);
-        if (dir > 90.0f && dir < 270.0f) {
-            if (leftLine.perpendicularDistance(0.0f, 0.0f) > 1.70f) return RotationDirection::COUNTER_CLOCKWISE;
-
-            continue;
+        // Determine left and right points of the front line
+        float frontLeftX, frontLeftY, frontRightX, frontRightY;
+        if (frontLine->x1 < frontLine->x2) {
+            frontLeftX = frontLine->x1;
+            frontLeftY = frontLine->y1;
+            frontRightX = frontLine->x2;
+            frontRightY = frontLine->y2;
+        } else {
+            frontLeftX = frontLine->x2;
+            frontLeftY = frontLine->y2;
+            frontRightX = frontLine->x1;
+            frontRightY = frontLine->y1;
         }
 
-        if (frontLine->perpendicularDistance(leftHigherX, leftHigherY) < 0.30) return RotationDirection::CLOCKWISE;
+        // Check left walls
+        for (const auto &leftLine : walls.leftWalls) {
+            float leftHigherX, leftHigherY;
+            if (leftLine.y1 < leftLine.y2) {
+                leftHigherX = leftLine.x1;
+                leftHigherY = leftLine.y1;
+            } else {
+                leftHigherX = leftLine.x2;
+                leftHigherY = leftLine.y2;
+            }
 
-        if (leftLine.perpendicularDistance(frontLeftX, frontLeftY) > 0.30f) {
+            // Check for left wall that is far away in x direction from front wall
             float dir = leftLine.perpendicularDirection(frontLeftX, frontLeftY);
-            if (dir > 270.0f || dir < 90.0f) return RotationDirection::COUNTER_CLOCKWISE;
-        }
-    }
+            if (dir > 90.0f && dir < 270.0f) {
+                if (leftLine.perpendicularDistance(0.0f, 0.0f) > 1.70f) return RotationDirection::COUNTER_CLOCKWISE;
 
-    // Check right walls
-    for (const auto &rightLine : walls.rightWalls) {
-        float rightHigherX, rightHigherY;
-        if (rightLine.y1 < rightLine.y2) {
-            rightHigherX = rightLine.x1;
-            rightHigherY = rightLine.y1;
-        } else {
-            rightHigherX = rightLine.x2;
-            rightHigherY = rightLine.y2;
-        }
+                continue;
+            }
 
-        // Check for right wall that is far away in x direction from front wall
-        float dir = rightLine.perpendicularDirection(frontRightX, frontRightY);
-        if (dir > 270.0f || dir < 90.0f) {
-            if (rightLine.perpendicularDistance(0.0f, 0.0f) > 1.70f) return RotationDirection::CLOCKWISE;
+            if (frontLine->perpendicularDistance(leftHigherX, leftHigherY) < 0.30) return RotationDirection::CLOCKWISE;
 
-            continue;
+            if (leftLine.perpendicularDistance(frontLeftX, frontLeftY) > 0.30f) {
+                float dir = leftLine.perpendicularDirection(frontLeftX, frontLeftY);
+                if (dir > 270.0f || dir < 90.0f) return RotationDirection::COUNTER_CLOCKWISE;
+            }
         }
 
-        if (frontLine->perpendicularDistance(rightHigherX, rightHigherY) < 0.30) return RotationDirection::COUNTER_CLOCKWISE;
+        // Check right walls
+        for (const auto &rightLine : walls.rightWalls) {
+            float rightHigherX, rightHigherY;
+            if (rightLine.y1 < rightLine.y2) {
+                rightHigherX = rightLine.x1;
+                rightHigherY = rightLine.y1;
+            } else {
+                rightHigherX = rightLine.x2;
+                rightHigherY = rightLine.y2;
+            }
 
-        if (rightLine.perpendicularDistance(frontRightX, frontRightY) > 0.30f) {
+            // Check for right wall that is far away in x direction from front wall
             float dir = rightLine.perpendicularDirection(frontRightX, frontRightY);
-            if (dir > 90.0f && dir < 270.0f) return RotationDirection::CLOCKWISE;
-        }
-    }
+            if (dir > 270.0f || dir < 90.0f) {
+                if (rightLine.perpendicularDistance(0.0f, 0.0f) > 1.70f) return RotationDirection::CLOCKWISE;
 
-    return std::nullopt;  // unknown if no rule matched
-}
+                continue;
+            }
 
-ResolvedWalls resolveWalls(const RelativeWalls &relativeWalls) {
-    ResolvedWalls resolveWalls;
-
-    for (auto &newWall : relativeWalls.leftWalls) {
-        float newDist = newWall.perpendicularDistance(0.0f, 0.0f);
-        if (newDist > 1.20f) continue;
-        if (resolveWalls.leftWall.has_value()) {
-            LineSegment curWall = resolveWalls.leftWall.value();
-            float curDist = curWall.perpendicularDistance(0.0f, 0.0f);
-            if (curDist <= newDist) continue;
+            if (frontLine->perpendicularDistance(rightHigherX, rightHigherY) < 0.30) return RotationDirection::COUNTER_CLOCKWISE;
+
+            if (rightLine.perpendicularDistance(frontRightX, frontRightY) > 0.30f) {
+                float dir = rightLine.perpendicularDirection(frontRightX, frontRightY);
+                if (dir > 90.0f && dir < 270.0f) return RotationDirection::CLOCKWISE;
+            }
         }
-        resolveWalls.leftWall = newWall;
+
+        return std::nullopt;  // unknown if no rule matched
     }
-    for (auto &newWall : relativeWalls.rightWalls) {
-        float newDist = newWall.perpendicularDistance(0.0f, 0.0f);
-        if (newDist > 1.20f) continue;
-        if (resolveWalls.rightWall.has_value()) {
-            LineSegment curWall = resolveWalls.rightWall.value();
-            float curDist = curWall.perpendicularDistance(0.0f, 0.0f);
-            if (curDist <= newDist) continue;
+
+    template <typename Walls>
+    ResolvedWalls selectWalls(const Walls &relativeWalls) {
+        ResolvedWalls resolveWalls;
+
+        for (auto &newWall : relativeWalls.leftWalls) {
+            float newDist = newWall.perpendicularDistance(0.0f, 0.0f);
+            if (newDist > 1.20f) continue;
+            if (resolveWalls.leftWall.has_value()) {
+                LineSegment curWall = resolveWalls.leftWall.value();
+                float curDist = curWall.perpendicularDistance(0.0f, 0.0f);
+                if (curDist <= newDist) continue;
+            }
+            resolveWalls.leftWall = newWall;
         }
-        resolveWalls.rightWall = newWall;
-    }
-    for (auto &newWall : relativeWalls.frontWalls) {
-        float newDist = newWall.perpendicularDistance(0.0f, 0.0f);
-        if (resolveWalls.frontWall.has_value()) {
-            LineSegment curWall = resolveWalls.frontWall.value();
-            float curDist = curWall.perpendicularDistance(0.0f, 0.0f);
-            if (curDist >= newDist) continue;
+        for (auto &newWall : relativeWalls.rightWalls) {
+            float newDist = newWall.perpendicularDistance(0.0f, 0.0f);
+            if (newDist > 1.20f) continue;
+            if (resolveWalls.rightWall.has_value()) {
+                LineSegment curWall = resolveWalls.rightWall.value();
+                float curDist = curWall.perpendicularDistance(0.0f, 0.0f);
+                if (curDist <= newDist) continue;
+            }
+            resolveWalls.rightWall = newWall;
         }
-        resolveWalls.frontWall = newWall;
-    }
-    for (auto &newWall : relativeWalls.backWalls) {
-        float newDist = newWall.perpendicularDistance(0.0f, 0.0f);
-        if (resolveWalls.backWall.has_value()) {
-            LineSegment curWall = resolveWalls.backWall.value();
-            float curDist = curWall.perpendicularDistance(0.0f, 0.0f);
-            if (curDist >= newDist) continue;
+        for (auto &newWall : relativeWalls.frontWalls) {
+            float newDist = newWall.perpendicularDistance(0.0f, 0.0f);
+            if (resolveWalls.frontWall.has_value()) {
+                LineSegment curWall = resolveWalls.frontWall.value();
+                float curDist = curWall.perpendicularDistance(0.0f, 0.0f);
+                if (curDist >= newDist) continue;
+            }
+            resolveWalls.frontWall = newWall;
+        }
+        for (auto &newWall : relativeWalls.backWalls) {
+            float newDist = newWall.perpendicularDistance(0.0f, 0.0f);
+            if (resolveWalls.backWall.has_value()) {
+                LineSegment curWall = resolveWalls.backWall.value();
+                float curDist = curWall.perpendicularDistance(0.0f, 0.0f);
+                if (curDist >= newDist) continue;
+            }
+            resolveWalls.backWall = newWall;
         }
-        resolveWalls.backWall = newWall;
-    }
 
-    for (auto &newWall : relativeWalls.leftWalls) {
-        float newDist = newWall.perpendicularDistance(0.0f, 0.0f);
-        if (newDist <= 1.20f) continue;
-        if (newDist >= 3.20f) continue;
-        if (resolveWalls.farLeftWall.has_value()) {
-            LineSegment curWall = resolveWalls.farLeftWall.value();
-            float curDist = curWall.perpendicularDistance(0.0f, 0.0f);
-            if (curDist >= newDist) continue;
+        for (auto &newWall : relativeWalls.leftWalls) {
+            float newDist = newWall.perpendicularDistance(0.0f, 0.0f);
+            if (newDist <= 1.20f) continue;
+            if (newDist >= 3.20f) continue;
+            if (resolveWalls.farLeftWall.has_value()) {
+                LineSegment curWall = resolveWalls.farLeftWall.value();
+                float curDist = curWall.perpendicularDistance(0.0f, 0.0f);
+                if (curDist >= newDist) continue;
+            }
+            resolveWalls.farLeftWall = newWall;
         }
-        resolveWalls.farLeftWall = newWall;
-    }
-    for (auto &newWall : relativeWalls.rightWalls) {
-        float newDist = newWall.perpendicularDistance(0.0f, 0.0f);
-        if (newDist <= 1.20f) continue;
-        if (newDist >= 3.20f) continue;
-        if (resolveWalls.farRightWall.has_value()) {
-            LineSegment curWall = resolveWalls.farRightWall.value();
-            float curDist = curWall.perpendicularDistance(0.0f, 0.0f);
-            if (curDist >= newDist) continue;
+        for (auto &newWall : relativeWalls.rightWalls) {
+            float newDist = newWall.perpendicularDistance(0.0f, 0.0f);
+            if (newDist <= 1.20f) continue;
+            if (newDist >= 3.20f) continue;
+            if (resolveWalls.farRightWall.has_value()) {
+                LineSegment curWall = resolveWalls.farRightWall.value();
+                float curDist = curWall.perpendicularDistance(0.0f, 0.0f);
+                if (curDist >= newDist) continue;
+            }
+            resolveWalls.farRightWall = newWall;
         }
-        resolveWalls.farRightWall = newWall;
-    }
 
-    return resolveWalls;
-}
+        return resolveWalls;
+    }
 
-std::vector<LineSegment> getParkingWalls(
-    const std::vector<LineSegment> &lineSegments,
-    Direction targetDirection,
-    float heading,
-    float maxLength
-) {
-    std::vector<LineSegment> filteredSegments;
+    template <typename Segments, typename Allocator>
+    Vector<LineSegment, Allocator> filterParkingWalls(
+        const Segments &lineSegments,
+        Direction targetDirection,
+        float heading,
+        float maxLength,
+        const Allocator &allocator
+    ) {
+        Vector<LineSegment, Allocator> filteredSegments(allocator);
 
-    for (const auto &segment : lineSegments) {
-        // Angle of the segment’s perpendicular relative to the robot’s forward direction
-        float perpAngleRobotFrame = segment.perpendicularDirection(0.0f, 0.0f);
+        for (const auto &segment : lineSegments) {
+            // Angle of the segment’s perpendicular relative to the robot’s forward direction
+            float perpAngleRobotFrame = segment.perpendicularDirection(0.0f, 0.0f);
 
-        // Angle of the segment’s perpendicular relative to the target direction frame
-        float perpAngleTargetFrame = std::fmod(perpAngleRobotFrame - (heading - targetDirection.toHeading()) + 360.0f, 360.0f);
+            // Angle of the segment’s perpendicular relative to the target direction frame
+            float perpAngleTargetFrame = std::fmod(perpAngleRobotFrame - (heading - targetDirection.toHeading()) + 360.0f, 360.0f);
 
-        if (not((perpAngleTargetFrame > 85.0f && perpAngleTargetFrame < 95.0f) ||
-                (perpAngleTargetFrame > 265.0f && perpAngleTargetFrame < 285.0f)))
-            continue;
+            if (not((perpAngleTargetFrame > 85.0f && perpAngleTargetFrame < 95.0f) ||
+                    (perpAngleTargetFrame > 265.0f && perpAngleTargetFrame < 285.0f)))
+                continue;
 
-        if (segment.length() <= maxLength) {
-            filteredSegments.push_back(segment);
+            if (segment.length() <= maxLength) {
+                filteredSegments.push_back(segment);
+            }
         }
+
+        return filteredSegments;
     }
 
-    return filteredSegments;
-}
+    template <typename Allocator>
+    Vector<cv::Point2f, Allocator> findTrafficLightPoints(
+        const TimedLidarData &timedLidarData,
+        const ResolvedWalls &resolveWalls,
+        const RobotDeltaPose &robotDeltaPose,
+        std::optional<RotationDirection> turnDirection,
+        float distanceThreshold,
+        size_t minClusterSize,
+        const Allocator &allocator
+    ) {
+        // Convert polar to Cartesian (in meters)
+        Vector<cv::Point2f, Allocator> points(allocator);
+        points.reserve(timedLidarData.lidarData.size());
 
-std::vector<cv::Point2f> getTrafficLightPoints(
-    const TimedLidarData &timedLidarData,
-    const ResolvedWalls &resolveWalls,
-    const RobotDeltaPose &robotDeltaPose,
-    std::optional<RotationDirection> turnDirection,
-    float distanceThreshold,
-    size_t minClusterSize
-) {
-    // Convert polar to Cartesian (in meters)
-    std::vector<cv::Point2f> points;
-    points.reserve(timedLidarData.lidarData.size());
+        for (const auto &node : timedLidarData.lidarData) {
+            float rad = node.angle * static_cast<float>(M_PI) / 180.0f;
 
-    for (const auto &node : timedLidarData.lidarData) {
-        float rad = node.angle * static_cast<float>(M_PI) / 180.0f;
+            float lidarX = node.distance * std::sin(rad);
+            float lidarY = node.distance * std::cos(rad);
+            float x, y;
+            lidarToCartesian(lidarX, lidarY, x, y);
 
-        float lidarX = node.distance * std::sin(rad);
-        float lidarY = node.distance * std::cos(rad);
-        float x, y;
-        lidarToCartesian(lidarX, lidarY, x, y);
+            points.emplace_back(x, y);
+        }
 
-        points.emplace_back(x, y);
-    }
+        Vector<cv::Point2f, Allocator> filteredPoints(allocator);
+        for (auto &point : points) {
+            if (not resolveWalls.frontWall) return Vector<cv::Point2f, Allocator>(allocator);
+            float frontDistance = resolveWalls.frontWall->perpendicularDistance(point.x, point.y);
 
-    std::vector<cv::Point2f> filteredPoints;
-    for (auto &point : points) {
-        if (not resolveWalls.frontWall) return {};
-        float frontDistance = resolveWalls.frontWall->perpendicularDistance(point.x, point.y);
+            std::optional<LineSegment> outerWall, innerWall, farOuterWall;
+            if (turnDirection.value_or(RotationDirection::CLOCKWISE) == RotationDirection::CLOCKWISE) {
+                outerWall = resolveWalls.leftWall;
+                innerWall = resolveWalls.rightWall;
 
-        std::optional<LineSegment> outerWall, innerWall, farOuterWall;
-        if (turnDirection.value_or(RotationDirection::CLOCKWISE) == RotationDirection::CLOCKWISE) {
-            outerWall = resolveWalls.leftWall;
-            innerWall = resolveWalls.rightWall;
+                farOuterWall = resolveWalls.farRightWall;
+            } else {
+                outerWall = resolveWalls.rightWall;
+                innerWall = resolveWalls.leftWall;
 
-            farOuterWall = resolveWalls.farRightWall;
-        } else {
-            outerWall = resolveWalls.rightWall;
-            innerWall = resolveWalls.leftWall;
+                farOuterWall = resolveWalls.farLeftWall;
+            }
 
-            farOuterWall = resolveWalls.farLeftWall;
-        }
+            float outerDistance;
+            if (outerWall) {
+                outerDistance = outerWall->perpendicularDistance(point.x, point.y);
+            } else if (innerWall) {
+                outerDistance = 1.00f - innerWall->perpendicularDistance(point.x, point.y);
+            } else {
+                return Vector<cv::Point2f, Allocator>(allocator);
+            }
 
-        float outerDistance;
-        if (outerWall) {
-            outerDistance = outerWall->perpendicularDistance(point.x, point.y);
-        } else if (innerWall) {
-            outerDistance = 1.00f - innerWall->perpendicularDistance(point.x, point.y);
-        } else {
-            return {};
-        }
+            // TODO: Clean up this magic number
+            const float outerEdge = 0.30f;
+            const float innerEdge = 0.70f;
 
-        // TODO: Clean up this magic number
-        const float outerEdge = 0.30f;
-        const float innerEdge = 0.70f;
+            if (farOuterWall) {
+                float outerFarDistance = farOuterWall->perpendicularDistance(point.x, point.y);
 
-        if (farOuterWall) {
-            float outerFarDistance = farOuterWall->perpendicularDistance(point.x, point.y);
+                if (frontDistance < outerEdge or frontDistance > 3.00f - outerEdge or outerDistance < outerEdge or
+                    outerFarDistance < outerEdge)
+                    continue;
+                if (frontDistance > innerEdge and outerDistance > innerEdge and outerFarDistance > innerEdge) continue;
+            } else {
+                if (frontDistance < outerEdge or frontDistance > 3.00f - outerEdge or outerDistance < outerEdge or
+                    outerDistance > 3.00f - outerEdge)
+                    continue;
+                if (frontDistance > innerEdge and outerDistance > innerEdge) continue;
+            }
 
-            if (frontDistance < outerEdge or frontDistance > 3.00f - outerEdge or outerDistance < outerEdge or outerFarDistance < outerEdge)
-                continue;
-            if (frontDistance > innerEdge and outerDistance > innerEdge and outerFarDistance > innerEdge) continue;
-        } else {
-            if (frontDistance < outerEdge or frontDistance > 3.00f - outerEdge or outerDistance < outerEdge or
-                outerDistance > 3.00f - outerEdge)
-                continue;
-            if (frontDistance > innerEdge and outerDistance > innerEdge) continue;
+            filteredPoints.push_back(point);
         }
 
-        filteredPoints.push_back(point);
-    }
+        Vector<cv::Point2f, Allocator> averages(allocator);
+        if (filteredPoints.empty()) return averages;
 
-    std::vector<cv::Point2f> averages;
-    if (filteredPoints.empty()) return averages;
+        Vector<bool, Allocator> visited(filteredPoints.size(), false, allocator);
 
-    std::vector<bool> visited(filteredPoints.size(), false);
+        // Reused by every cluster, so only the largest one allocates
+        Vector<cv::Point2f, Allocator> currentCluster(allocator);
+        for (size_t i = 0; i < filteredPoints.size(); ++i) {
+            if (visited[i]) continue;
 
-    for (size_t i = 0; i < filteredPoints.size(); ++i) {
-        if (visited[i]) continue;
+            currentCluster.clear();
+            currentCluster.push_back(filteredPoints[i]);
+            visited[i] = true;
 
-        std::vector<cv::Point2f> currentCluster;
-        currentCluster.push_back(filteredPoints[i]);
-        visited[i] = true;
+            size_t idx = 0;
+            while (idx < currentCluster.size()) {
+                cv::Point2f p = currentCluster[idx];
 
-        size_t idx = 0;
-        while (idx < currentCluster.size()) {
-            cv::Point2f p = currentCluster[idx];
+                for (size_t j = 0; j < filteredPoints.size(); ++j) {
+                    if (visited[j]) continue;
 
-            for (size_t j = 0; j < filteredPoints.size(); ++j) {
-                if (visited[j]) continue;
+                    float dist = std::hypot(p.x - filteredPoints[j].x, p.y - filteredPoints[j].y);
+                    if (dist < distanceThreshold) {
+                        currentCluster.push_back(filteredPoints[j]);
+                        visited[j] = true;
+                    }
+                }
+                ++idx;
+            }
 
-                float dist = std::hypot(p.x - filteredPoints[j].x, p.y - filteredPoints[j].y);
-                if (dist < distanceThreshold) {
-                    currentCluster.push_back(filteredPoints[j]);
-                    visited[j] = true;
+            if (currentCluster.size() >= minClusterSize) {
+                // compute average
+                float sumX = 0, sumY = 0;
+                for (auto &pt : currentCluster) {
+                    sumX += pt.x;
+                    sumY += pt.y;
                 }
+                averages.emplace_back(sumX / currentCluster.size(), sumY / currentCluster.size());
             }
-            ++idx;
         }
 
-        if (currentCluster.size() >= minClusterSize) {
-            // compute average
-            float sumX = 0, sumY = 0;
-            for (auto &pt : currentCluster) {
-                sumX += pt.x;
-                sumY += pt.y;
-            }
-            averages.emplace_back(sumX / currentCluster.size(), sumY / currentCluster.size());
+        float radH = robotDeltaPose.deltaH * static_cast<float>(M_PI) / 180.0f;
+        float cosH = std::cos(radH);
+        float sinH = std::sin(radH);
+
+        for (auto &pt : averages) {
+            // Translate
+            float xt = pt.x - robotDeltaPose.deltaX;
+            float yt = pt.y - robotDeltaPose.deltaY;
+
+            // Rotate around (0,0)
+            pt.x = xt * cosH - yt * sinH;
+            pt.y = xt * sinH + yt * cosH;
         }
+
+        return averages;
     }
 
-    float radH = robotDeltaPose.deltaH * static_cast<float>(M_PI) / 180.0f;
-    float cosH = std::cos(radH);
-    float sinH = std::sin(radH);
+}  // namespace
 
-    for (auto &pt : averages) {
-        // Translate
-        float xt = pt.x - robotDeltaPose.deltaX;
-        float yt = pt.y - robotDeltaPose.deltaY;
+void filterLidarData(const TimedLidarData &timedLidarData, TimedLidarData &filteredLidarData, float minDistance) {
+    filteredLidarData.timestamp = timedLidarData.timestamp;
+    filteredLidarData.lidarData.clear();
 
-        // Rotate around (0,0)
-        pt.x = xt * cosH - yt * sinH;
-        pt.y = xt * sinH + yt * cosH;
+    for (const auto &node : timedLidarData.lidarData) {
+        if (node.distance < minDistance) continue;
+        if (node.distance < 0.005) continue;
+        if (node.distance > 3.200) continue;
+        if ((node.angle > 340 || node.angle < 200) && node.distance > 0.700) continue;
+
+        filteredLidarData.lidarData.push_back(node);
     }
+}
+
+TimedLidarData filterLidarData(const TimedLidarData &timedLidarData, float minDistance) {
+    TimedLidarData filteredLidarData;
+    filterLidarData(timedLidarData, filteredLidarData, minDistance);
+    return filteredLidarData;
+}
 
-    return averages;
+std::vector<LineSegment> getLines(
+    const TimedLidarData &timedLidarData,
+    const RobotDeltaPose &robotDeltaPose,
+    float splitThreshold,
+    int minPoints,
+    float maxPointGap,
+    float minLength,
+    float mergeAngleThreshold,
+    float mergeGapThreshold
+) {
+    return extractLines(
+        timedLidarData,
+        robotDeltaPose,
+        splitThreshold,
+        minPoints,
+        maxPointGap,
+        minLength,
+        mergeAngleThreshold,
+        mergeGapThreshold,
+        std::allocator<LineSegment>()
+    );
+}
+
+std::pmr::vector<LineSegment> getLines(
+    const TimedLidarData &timedLidarData,
+    const RobotDeltaPose &robotDeltaPose,
+    std::pmr::memory_resource *memory,
+    float splitThreshold,
+    int minPoints,
+    float maxPointGap,
+    float minLength,
+    float mergeAngleThreshold,
+    float mergeGapThreshold
+) {
+    return extractLines(
+        timedLidarData,
+        robotDeltaPose,
+        splitThreshold,
+        minPoints,
+        maxPointGap,
+        minLength,
+        mergeAngleThreshold,
+        mergeGapThreshold,
+        std::pmr::polymorphic_allocator<LineSegment>(memory)
+    );
+}
+
+RelativeWalls getRelativeWalls(
+    const std::vector<LineSegment> &lineSegments,
+    Direction targetDirection,
+    float heading,
+    float minLength,
+    float angleThresholdDeg,
+    float collinearThreshold
+) {
+    return groupRelativeWalls(
+        lineSegments,
+        targetDirection,
+        heading,
+        minLength,
+        angleThresholdDeg,
+        collinearThreshold,
+        std::allocator<LineSegment>()
+    );
+}
+
+pmr::RelativeWalls getRelativeWalls(
+    const std::pmr::vector<LineSegment> &lineSegments,
+    Direction targetDirection,
+    float heading,
+    std::pmr::memory_resource *memory,
+    float minLength,
+    float angleThresholdDeg,
+    float collinearThreshold
+) {
+    return groupRelativeWalls(
+        lineSegments,
+        targetDirection,
+        heading,
+        minLength,
+        angleThresholdDeg,
+        collinearThreshold,
+        std::pmr::polymorphic_allocator<LineSegment>(memory)
+    );
+}
+
+std::optional<RotationDirection> getTurnDirection(const RelativeWalls &walls) {
+    return detectTurnDirection(walls);
+}
+
+std::optional<RotationDirection> getTurnDirection(const pmr::RelativeWalls &walls) {
+    return detectTurnDirection(walls);
+}
+
+ResolvedWalls resolveWalls(const RelativeWalls &relativeWalls) {
+    return selectWalls(relativeWalls);
+}
+
+ResolvedWalls resolveWalls(const pmr::RelativeWalls &relativeWalls) {
+    return selectWalls(relativeWalls);
+}
+
+std::vector<LineSegment> getParkingWalls(
+    const std::vector<LineSegment> &lineSegments,
+    Direction targetDirection,
+    float heading,
+    float maxLength
+) {
+    return filterParkingWalls(lineSegments, targetDirection, heading, maxLength, std::allocator<LineSegment>());
+}
+
+std::pmr::vector<LineSegment> getParkingWalls(
+    const std::pmr::vector<LineSegment> &lineSegments,
+    Direction targetDirection,
+    float heading,
+    std::pmr::memory_resource *memory,
+    float maxLength
+) {
+    return filterParkingWalls(lineSegments, targetDirection, heading, maxLength, std::pmr::polymorphic_allocator<LineSegment>(memory));
+}
+
+std::vector<cv::Point2f> getTrafficLightPoints(
+    const TimedLidarData &timedLidarData,
+    const ResolvedWalls &resolveWalls,
+    const RobotDeltaPose &robotDeltaPose,
+    std::optional<RotationDirection> turnDirection,
+    float distanceThreshold,
+    size_t minClusterSize
+) {
+    return findTrafficLightPoints(
+        timedLidarData,
+        resolveWalls,
+        robotDeltaPose,
+        turnDirection,
+        distanceThreshold,
+        minClusterSize,
+        std::allocator<cv::Point2f>()
+    );
+}
+
+std::pmr::vector<cv::Point2f> getTrafficLightPoints(
+    const TimedLidarData &timedLidarData,
+    const ResolvedWalls &resolveWalls,
+    const RobotDeltaPose &robotDeltaPose,
+    std::optional<RotationDirection> turnDirection,
+    std::pmr::memory_resource *memory,
+    float distanceThreshold,
+    size_t minClusterSize
+) {
+    return findTrafficLightPoints(
+        timedLidarData,
+        resolveWalls,
+        robotDeltaPose,
+        turnDirection,
+        distanceThreshold,
+        minClusterSize,
+        std::pmr::polymorphic_allocator<cv::Point2f>(memory)
+    );
 }
 
 void drawLidarData(cv::Mat &img, const TimedLidarData &timedLidarDatas, float scale) {
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <memory_resource>
 #include <opencv2/opencv.hpp>
 #include <optional>
+#include <vector>
 
 #include "direction.h"
 #include "lidar_struct.h"
@@ -77,14 +79,32 @@ struct LineSegment {
 
 /**
  * @brief Groups LiDAR-detected walls by relative robot position.
+ *
+ * @tparam Allocator Allocator of the segment vectors. Use RelativeWalls, or pmr::RelativeWalls for walls allocated from a
+ *         std::pmr::memory_resource.
  */
-struct RelativeWalls {
-    std::vector<LineSegment> frontWalls;  ///< Candidate segments in front
-    std::vector<LineSegment> rightWalls;  ///< Candidate segments to the right
-    std::vector<LineSegment> backWalls;   ///< Candidate segments behind
-    std::vector<LineSegment> leftWalls;   ///< Candidate segments to the left
+template <typename Allocator>
+struct BasicRelativeWalls {
+    BasicRelativeWalls() = default;
+    explicit BasicRelativeWalls(const Allocator &allocator)
+        : frontWalls(allocator)
+        , rightWalls(allocator)
+        , backWalls(allocator)
+        , leftWalls(allocator) {}
+
+    std::vector<LineSegment, Allocator> frontWalls;  ///< Candidate segments in front
+    std::vector<LineSegment, Allocator> rightWalls;  ///< Candidate segments to the right
+    std::vector<LineSegment, Allocator> backWalls;   ///< Candidate segments behind
+    std::vector<LineSegment, Allocator> leftWalls;   ///< Candidate segments to the left
 };
 
+using RelativeWalls = BasicRelativeWalls<std::allocator<LineSegment>>;
+
+namespace pmr
+{
+using RelativeWalls = BasicRelativeWalls<std::pmr::polymorphic_allocator<LineSegment>>;
+}  // namespace pmr
+
 /**
  * @brief Holds resolved single wall segments from candidate walls.
  */
@@ -110,6 +130,15 @@ struct ResolvedWalls {
  */
 TimedLidarData filterLidarData(const TimedLidarData &timedLidarData, float minDistance = 0.05f);
 
+/**
+ * @brief filterLidarData() into an existing TimedLidarData, whose capacity is reused.
+ *
+ * @param timedLidarData Source lidar data with timestamp and raw points.
+ * @param filteredLidarData Replaced by the filtered points and the source timestamp.
+ * @param minDistance Minimum accepted distance in meters. Defaults to 0.05f.
+ */
+void filterLidarData(const TimedLidarData &timedLidarData, TimedLidarData &filteredLidarData, float minDistance = 0.05f);
+
 /**
  * @brief Extract line segments from timed LiDAR data by converting points to Cartesian coordinates,
  *        splitting them based on deviation from a best-fit line, and merging approximately collinear segments.
@@ -142,6 +171,25 @@ std::vector<LineSegment> getLines(
     float mergeGapThreshold = 0.20f
 );
 
+/**
+ * @brief getLines() with the result and every intermediate point and segment allocated from @p memory.
+ *
+ * Meant for a per-tick arena (see TickArena): the scan's points and segments then never go through malloc.
+ *
+ * @param memory Resource for all allocations, e.g. TickArena::resource().
+ */
+std::pmr::vector<LineSegment> getLines(
+    const TimedLidarData &timedLidarData,
+    const RobotDeltaPose &robotDeltaPose,
+    std::pmr::memory_resource *memory,
+    float splitThreshold = 0.05f,
+    int minPoints = 10,
+    float maxPointGap = 0.10f,
+    float minLength = 0.10f,
+    float mergeAngleThreshold = 18.0f,
+    float mergeGapThreshold = 0.20f
+);
+
 /**
  * @brief Determine relative walls around the robot
  *
@@ -162,6 +210,21 @@ RelativeWalls getRelativeWalls(
     float collinearThreshold = 0.22f
 );
 
+/**
+ * @brief getRelativeWalls() with the result and every intermediate segment allocated from @p memory.
+ *
+ * @param memory Resource for all allocations, e.g. TickArena::resource().
+ */
+pmr::RelativeWalls getRelativeWalls(
+    const std::pmr::vector<LineSegment> &lineSegments,
+    Direction targetDirection,
+    float heading,
+    std::pmr::memory_resource *memory,
+    float minLength = 0.30f,
+    float angleThresholdDeg = 25.0f,
+    float collinearThreshold = 0.22f
+);
+
 /**
  * @brief Determine the robot's turn direction based on relative walls.
  *
@@ -169,6 +232,7 @@ RelativeWalls getRelativeWalls(
  * @return Optional RotationDirection; empty if turn direction can't be determined.
  */
 std::optional<RotationDirection> getTurnDirection(const RelativeWalls &walls);
+std::optional<RotationDirection> getTurnDirection(const pmr::RelativeWalls &walls);
 
 /**
  * @brief Selects a single representative wall per side from relative walls.
@@ -177,6 +241,7 @@ std::optional<RotationDirection> getTurnDirection(const RelativeWalls &walls);
  * @return ResolvedWalls struct containing one wall per side if available.
  */
 ResolvedWalls resolveWalls(const RelativeWalls &relativeWalls);
+ResolvedWalls resolveWalls(const pmr::RelativeWalls &relativeWalls);
 
 /**
  * @brief Extract walls relevant for parking from relative walls.
@@ -194,6 +259,19 @@ std::vector<LineSegment> getParkingWalls(
     float maxLength = 0.25f
 );
 
+/**
+ * @brief getParkingWalls() with the result allocated from @p memory.
+ *
+ * @param memory Resource for all allocations, e.g. TickArena::resource().
+ */
+std::pmr::vector<LineSegment> getParkingWalls(
+    const std::pmr::vector<LineSegment> &lineSegments,
+    Direction targetDirection,
+    float heading,
+    std::pmr::memory_resource *memory,
+    float maxLength = 0.25f
+);
+
 /**
  * @brief Detect traffic light points from LiDAR data and resolved walls.
  *
@@ -213,6 +291,21 @@ std::vector<cv::Point2f> getTrafficLightPoints(
     size_t minClusterSize = 10
 );
 
+/**
+ * @brief getTrafficLightPoints() with the result and every intermediate point and cluster allocated from @p memory.
+ *
+ * @param memory Resource for all allocations, e.g. TickArena::resource().
+ */
+std::pmr::vector<cv::Point2f> getTrafficLightPoints(
+    const TimedLidarData &timedLidarData,
+    const ResolvedWalls &resolveWalls,
+    const RobotDeltaPose &robotDeltaPose,
+    std::optional<RotationDirection> turnDirection,
+    std::pmr::memory_resource *memory,
+    float distanceThreshold = 0.05f,
+    size_t minClusterSize = 10
+);
+
 /**
  * @brief Draw LiDAR scan points onto an existing image.
  *
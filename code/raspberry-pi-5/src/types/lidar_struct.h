@@ -1,6 +1,8 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <thread>
 #include <vector>
 
@@ -18,3 +20,113 @@ struct TimedLidarData {
     std::vector<RawLidarNode> lidarData;
     std::chrono::steady_clock::time_point timestamp;
 };
+
+/**
+ * A LIDAR scan in the fixed-point form reported by the SLAMTEC driver, stored struct-of-arrays.
+ *
+ * All nodes live in one buffer laid out column by column: count x dist_mm_q2 (uint32_t),
+ * then count x angle_z_q14 (uint16_t), then count x quality (uint8_t). That is 7 bytes per
+ * node instead of the 12 of a padded RawLidarNode, and it is exactly the payload of a
+ * log_records::LIDAR_SCAN_COMPACT record, so logging and loading are single copies.
+ * Conversion to degrees and meters is left to the consumer.
+ */
+struct CompactLidarScan {
+    static constexpr size_t NODE_BYTES = sizeof(uint32_t) + sizeof(uint16_t) + sizeof(uint8_t);
+
+    std::vector<uint8_t> bytes;  ///< Column storage, NODE_BYTES * size() bytes
+    size_t count = 0;            ///< Number of nodes
+
+    void resize(size_t nodeCount) {
+        count = nodeCount;
+        bytes.resize(nodeCount * NODE_BYTES);
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    uint32_t *distanceQ2() {
+        return reinterpret_cast<uint32_t *>(bytes.data());
+    }
+    const uint32_t *distanceQ2() const {
+        return reinterpret_cast<const uint32_t *>(bytes.data());
+    }
+
+    uint16_t *angleQ14() {
+        return reinterpret_cast<uint16_t *>(bytes.data() + count * sizeof(uint32_t));
+    }
+    const uint16_t *angleQ14() const {
+        return reinterpret_cast<const uint16_t *>(bytes.data() + count * sizeof(uint32_t));
+    }
+
+    uint8_t *quality() {
+        return bytes.data() + count * (sizeof(uint32_t) + sizeof(uint16_t));
+    }
+    const uint8_t *quality() const {
+        return bytes.data() + count * (sizeof(uint32_t) + sizeof(uint16_t));
+    }
+
+    /// Angle of node @p i in degrees.
+    float angle(size_t i) const {
+        return angleQ14()[i] * 90.f / (1 << 14);
+    }
+
+    /// Distance of node @p i in meters.
+    float distance(size_t i) const {
+        return distanceQ2()[i] / 1000.f / (1 << 2);
+    }
+
+    RawLidarNode node(size_t i) const {
+        return {angle(i), distance(i), quality()[i]};
+    }
+
+    /**
+     * Convert every node to a RawLidarNode.
+     */
+    void toNodes(std::vector<RawLidarNode> &out) const {
+        out.resize(count);
+        const uint32_t *distances = distanceQ2();
+        const uint16_t *angles = angleQ14();
+        const uint8_t *qualities = quality();
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = {angles[i] * 90.f / (1 << 14), distances[i] / 1000.f / (1 << 2), qualities[i]};
+        }
+    }
+
+    /**
+     * Load the scan from a serialized column buffer (e.g. a log record payload).
+     * @return false if @p size is not a multiple of NODE_BYTES.
+     */
+    bool assign(const uint8_t *data, size_t size) {
+        if (size % NODE_BYTES != 0) return false;
+        resize(size / NODE_BYTES);
+        if (size > 0) std::memcpy(bytes.data(), data, size);
+        return true;
+    }
+};
+
+struct TimedCompactLidarData {
+    CompactLidarScan scan;
+    std::chrono::steady_clock::time_point timestamp;
+
+    /**
+     * Convert to the expanded float form used by the processors.
+     */
+    TimedLidarData expand() const {
+        TimedLidarData timedLidarData{{}, timestamp};
+        scan.toNodes(timedLidarData.lidarData);
+        return timedLidarData;
+    }
+
+    /**
+     * Convert into an existing TimedLidarData, reusing its capacity.
+     */
+    void expand(TimedLidarData &timedLidarData) const {
+        timedLidarData.timestamp = timestamp;
+        scan.toNodes(timedLidarData.lidarData);
+    }
+};
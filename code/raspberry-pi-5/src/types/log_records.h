@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "../shared/types/imu_struct.h"
+#include "lidar_struct.h"
+#include "log_format.h"
+
+/**
+ * @brief Record types stored in the binary logs.
+ *
+ * Writers (modules and apps) and readers (log_viewer, log_to_video) share
+ * these definitions. Every log file lists all of them in its header, so a
+ * reader can tell what a file contains without knowing how it was written.
+ */
+namespace log_records
+{
+
+/// Type identifiers stored in every record. Never reuse or renumber.
+enum RecordType : uint16_t
+{
+    RAW = 0,                   ///< Untyped bytes; also what every legacy (headerless) entry reads as
+    PICO2_SAMPLE = 1,          ///< Pico2Record
+    LIDAR_SCAN = 2,            ///< Array of RawLidarNode (written by older builds)
+    CAMERA_FRAME = 3,          ///< Encoded image bytes (cv::imencode output)
+    LOOP_TIMESTAMPS = 4,       ///< LoopTimestampsRecord
+    OPEN_LOOP_TIMESTAMPS = 5,  ///< OpenLoopTimestampsRecord
+    LIDAR_SCAN_COMPACT = 6,    ///< CompactLidarScan columns
+
+    UNKNOWN = 0xFFFF  ///< Reported by readers for a type whose layout in the file differs from this build
+};
+
+/**
+ * @brief One Pico2 sample as logged by Pico2Module (timestamp is the record timestamp).
+ */
+struct Pico2Record {
+    ImuAccel accel;
+    ImuEuler euler;
+    double encoderAngle;
+};
+
+/**
+ * @brief Sensor timestamps used by one main loop iteration (scan map and obstacle challenge).
+ */
+struct LoopTimestampsRecord {
+    uint64_t lidarTimestamp_ns;
+    uint64_t pico2Timestamp_ns;
+    uint64_t cameraTimestamp_ns;
+};
+
+/**
+ * @brief Sensor timestamps used by one open challenge main loop iteration (no camera).
+ */
+struct OpenLoopTimestampsRecord {
+    uint64_t lidarTimestamp_ns;
+    uint64_t pico2Timestamp_ns;
+};
+
+using log_format::FieldDescriptor;
+using log_format::FieldType;
+using log_format::RecordDescriptor;
+using log_format::RecordKind;
+
+inline constexpr FieldDescriptor BYTE_FIELDS[] = {
+    {"byte", FieldType::UINT8, 0},
+};
+
+inline constexpr FieldDescriptor PICO2_FIELDS[] = {
+    {"accel.x", FieldType::FLOAT32, offsetof(Pico2Record, accel.x)},
+    {"accel.y", FieldType::FLOAT32, offsetof(Pico2Record, accel.y)},
+    {"accel.z", FieldType::FLOAT32, offsetof(Pico2Record, accel.z)},
+    {"euler.h", FieldType::FLOAT32, offsetof(Pico2Record, euler.h)},
+    {"euler.r", FieldType::FLOAT32, offsetof(Pico2Record, euler.r)},
+    {"euler.p", FieldType::FLOAT32, offsetof(Pico2Record, euler.p)},
+    {"encoderAngle", FieldType::FLOAT64, offsetof(Pico2Record, encoderAngle)},
+};
+
+inline constexpr FieldDescriptor LIDAR_NODE_FIELDS[] = {
+    {"angle", FieldType::FLOAT32, offsetof(RawLidarNode, angle)},
+    {"distance", FieldType::FLOAT32, offsetof(RawLidarNode, distance)},
+    {"quality", FieldType::UINT8, offsetof(RawLidarNode, quality)},
+};
+
+/// Column order of CompactLidarScan; offsets are multiplied by the node count to find each column.
+inline constexpr FieldDescriptor LIDAR_COMPACT_FIELDS[] = {
+    {"dist_mm_q2", FieldType::UINT32, 0},
+    {"angle_z_q14", FieldType::UINT16, sizeof(uint32_t)},
+    {"quality", FieldType::UINT8, sizeof(uint32_t) + sizeof(uint16_t)},
+};
+
+inline constexpr FieldDescriptor LOOP_TIMESTAMPS_FIELDS[] = {
+    {"lidarTimestamp_ns", FieldType::UINT64, offsetof(LoopTimestampsRecord, lidarTimestamp_ns)},
+    {"pico2Timestamp_ns", FieldType::UINT64, offsetof(LoopTimestampsRecord, pico2Timestamp_ns)},
+    {"cameraTimestamp_ns", FieldType::UINT64, offsetof(LoopTimestampsRecord, cameraTimestamp_ns)},
+};
+
+inline constexpr FieldDescriptor OPEN_LOOP_TIMESTAMPS_FIELDS[] = {
+    {"lidarTimestamp_ns", FieldType::UINT64, offsetof(OpenLoopTimestampsRecord, lidarTimestamp_ns)},
+    {"pico2Timestamp_ns", FieldType::UINT64, offsetof(OpenLoopTimestampsRecord, pico2Timestamp_ns)},
+};
+
+/// Descriptor of a record (FIXED) or array element (ARRAY) of type T.
+template <typename T, size_t N>
+constexpr RecordDescriptor describe(uint16_t typeId, const char *name, RecordKind kind, const FieldDescriptor (&fields)[N]) {
+    return {typeId, name, kind, sizeof(T), alignof(T), fields, static_cast<uint16_t>(N)};
+}
+
+/// Every record type known to this build, written into the header of each log file.
+inline constexpr RecordDescriptor RECORD_TYPES[] = {
+    describe<uint8_t>(RAW, "raw", RecordKind::ARRAY, BYTE_FIELDS),
+    describe<Pico2Record>(PICO2_SAMPLE, "pico2_sample", RecordKind::FIXED, PICO2_FIELDS),
+    describe<RawLidarNode>(LIDAR_SCAN, "lidar_scan", RecordKind::ARRAY, LIDAR_NODE_FIELDS),
+    describe<uint8_t>(CAMERA_FRAME, "camera_frame", RecordKind::ARRAY, BYTE_FIELDS),
+    describe<LoopTimestampsRecord>(LOOP_TIMESTAMPS, "loop_timestamps", RecordKind::FIXED, LOOP_TIMESTAMPS_FIELDS),
+    describe<OpenLoopTimestampsRecord>(OPEN_LOOP_TIMESTAMPS, "open_loop_timestamps", RecordKind::FIXED, OPEN_LOOP_TIMESTAMPS_FIELDS),
+    {LIDAR_SCAN_COMPACT, "lidar_scan_compact", RecordKind::COLUMNS, CompactLidarScan::NODE_BYTES, alignof(uint32_t), LIDAR_COMPACT_FIELDS, 3},
+};
+
+/**
+ * @brief Look up the descriptor of a record type.
+ * @return nullptr if @p typeId is not known to this build.
+ */
+constexpr const RecordDescriptor *findRecordType(uint16_t typeId) {
+    for (const auto &type : RECORD_TYPES) {
+        if (type.typeId == typeId) return &type;
+    }
+    return nullptr;
+}
+
+}  // namespace log_records
+
+namespace log_format
+{
+
+template <>
+struct RecordTraits<log_records::Pico2Record> {
+    static constexpr const RecordDescriptor &descriptor = *log_records::findRecordType(log_records::PICO2_SAMPLE);
+};
+
+template <>
+struct RecordTraits<log_records::LoopTimestampsRecord> {
+    static constexpr const RecordDescriptor &descriptor = *log_records::findRecordType(log_records::LOOP_TIMESTAMPS);
+};
+
+template <>
+struct RecordTraits<log_records::OpenLoopTimestampsRecord> {
+    static constexpr const RecordDescriptor &descriptor = *log_records::findRecordType(log_records::OPEN_LOOP_TIMESTAMPS);
+};
+
+template <>
+struct RecordTraits<RawLidarNode> {
+    static constexpr const RecordDescriptor &descriptor = *log_records::findRecordType(log_records::LIDAR_SCAN);
+};
+
+}  // namespace log_format
@@ -0,0 +1,202 @@
+#include "alloc_counter.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+
+// Trivially constructible, so reading them from operator new never runs a thread_local initializer
+thread_local AllocCounts threadCounts_;
+thread_local AllocSink *threadSink_ = nullptr;
+
+void countAllocation(size_t size) {
+    threadCounts_.allocations++;
+    threadCounts_.bytes += size;
+    if (threadSink_) threadSink_->addAllocation(size);
+}
+
+void countDeallocation(void *pointer) {
+    if (!pointer) return;
+    threadCounts_.deallocations++;
+    if (threadSink_) threadSink_->addDeallocation();
+}
+
+void *allocate(size_t size, size_t alignment) {
+    countAllocation(size);
+    if (size == 0) size = 1;
+
+    while (true) {
+        void *pointer = nullptr;
+        if (alignment <= alignof(std::max_align_t)) {
+            pointer = std::malloc(size);
+        } else if (posix_memalign(&pointer, alignment, size) != 0) {
+            pointer = nullptr;
+        }
+        if (pointer) return pointer;
+
+        // As the default operator new does: let the new-handler free memory, or give up
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void *allocateNoThrow(size_t size, size_t alignment) noexcept {
+    try {
+        return allocate(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void deallocate(void *pointer) noexcept {
+    countDeallocation(pointer);
+    std::free(pointer);
+}
+
+}  // namespace
+
+AllocCounts alloc_counter::threadCounts() {
+    return threadCounts_;
+}
+
+ScopedAllocCounter::ScopedAllocCounter()
+    : start_(threadCounts_) {}
+
+AllocCounts ScopedAllocCounter::counts() const {
+    return threadCounts_ - start_;
+}
+
+AllocCounts AllocSink::counts() const {
+    return {
+        allocations_.load(std::memory_order_relaxed),
+        bytes_.load(std::memory_order_relaxed),
+        deallocations_.load(std::memory_order_relaxed)
+    };
+}
+
+void AllocSink::reset() {
+    allocations_.store(0, std::memory_order_relaxed);
+    bytes_.store(0, std::memory_order_relaxed);
+    deallocations_.store(0, std::memory_order_relaxed);
+}
+
+void AllocSink::addAllocation(size_t size) {
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    bytes_.fetch_add(size, std::memory_order_relaxed);
+}
+
+void AllocSink::addDeallocation() {
+    deallocations_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void AllocTally::add(const AllocCounts &counts) {
+    stats_.samples++;
+    if (counts.allocations > 0) stats_.allocatingSamples++;
+    stats_.maxAllocations = std::max(stats_.maxAllocations, counts.allocations);
+    stats_.maxBytes = std::max(stats_.maxBytes, counts.bytes);
+    totalAllocations_ += counts.allocations;
+    totalBytes_ += counts.bytes;
+}
+
+AllocTallyStats AllocTally::stats() const {
+    AllocTallyStats stats = stats_;
+    if (stats.samples > 0) {
+        stats.meanAllocations = static_cast<double>(totalAllocations_) / stats.samples;
+        stats.meanBytes = static_cast<double>(totalBytes_) / stats.samples;
+    }
+    return stats;
+}
+
+ScopedAllocSink::ScopedAllocSink(AllocSink &sink)
+    : previous_(threadSink_) {
+    threadSink_ = &sink;
+}
+
+ScopedAllocSink::~ScopedAllocSink() {
+    threadSink_ = previous_;
+}
+
+// ===== Global operator new / delete replacements =====
+
+void *operator new(size_t size) {
+    return allocate(size, 0);
+}
+
+void *operator new[](size_t size) {
+    return allocate(size, 0);
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+    return allocate(size, static_cast<size_t>(alignment));
+}
+
+void *operator new[](size_t size, std::align_val_t alignment) {
+    return allocate(size, static_cast<size_t>(alignment));
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+    return allocateNoThrow(size, 0);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+    return allocateNoThrow(size, 0);
+}
+
+void *operator new(size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return allocateNoThrow(size, static_cast<size_t>(alignment));
+}
+
+void *operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept {
+    return allocateNoThrow(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void *pointer) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete[](void *pointer) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete(void *pointer, size_t) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete[](void *pointer, size_t) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete(void *pointer, size_t, std::align_val_t) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete[](void *pointer, size_t, std::align_val_t) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete(void *pointer, const std::nothrow_t &) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t, const std::nothrow_t &) noexcept {
+    deallocate(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t, const std::nothrow_t &) noexcept {
+    deallocate(pointer);
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Heap allocations counted through the global operator new.
+ */
+struct AllocCounts {
+    uint64_t allocations = 0;    ///< Calls to operator new
+    uint64_t bytes = 0;          ///< Bytes requested from operator new
+    uint64_t deallocations = 0;  ///< Calls to operator delete with a non-null pointer
+
+    AllocCounts operator-(const AllocCounts &other) const {
+        return {allocations - other.allocations, bytes - other.bytes, deallocations - other.deallocations};
+    }
+
+    AllocCounts operator+(const AllocCounts &other) const {
+        return {allocations + other.allocations, bytes + other.bytes, deallocations + other.deallocations};
+    }
+};
+
+/**
+ * @brief Counts the heap allocations of every thread, to find and remove allocations from the control tick.
+ *
+ * Linking this library replaces the global operator new and operator delete
+ * (all their forms) with versions that count, per thread, before calling
+ * malloc and free. Counting is a few thread-local increments, so it can
+ * stay linked in competition builds.
+ *
+ * Only allocations that go through operator new are counted: std containers,
+ * std::string, make_shared and so on. cv::Mat pixel buffers come from
+ * cv::fastMalloc and are not counted.
+ *
+ * **Example usage:**
+ * @code
+ * ScopedAllocCounter counter;
+ * auto lines = lidar_processor::getLines(...);
+ * AllocCounts counts = counter.counts();  // Allocations made by getLines on this thread
+ * @endcode
+ */
+namespace alloc_counter
+{
+
+/**
+ * @brief Allocations made by the calling thread since it started.
+ */
+AllocCounts threadCounts();
+
+}  // namespace alloc_counter
+
+/**
+ * @brief Allocations made by the calling thread since construction.
+ */
+class ScopedAllocCounter
+{
+public:
+    ScopedAllocCounter();
+
+    /**
+     * @brief Allocations made by the calling thread since construction. Must be called on the constructing thread.
+     */
+    AllocCounts counts() const;
+
+private:
+    AllocCounts start_;
+};
+
+/**
+ * @brief Collects the allocations of every thread that attaches to it, e.g. all the threads working on one tick.
+ *
+ * A thread attaches with a ScopedAllocSink; its allocations are then added
+ * to the sink as well as to its own counts.
+ */
+class AllocSink
+{
+public:
+    /**
+     * @brief Allocations made by attached threads since the last reset().
+     */
+    AllocCounts counts() const;
+
+    /**
+     * @brief Start counting from zero again.
+     */
+    void reset();
+
+    /**
+     * @brief Add an allocation of @p size bytes. Called by operator new.
+     */
+    void addAllocation(size_t size);
+
+    /**
+     * @brief Add a deallocation. Called by operator delete.
+     */
+    void addDeallocation();
+
+private:
+    std::atomic<uint64_t> allocations_{0};
+    std::atomic<uint64_t> bytes_{0};
+    std::atomic<uint64_t> deallocations_{0};
+};
+
+/**
+ * @brief Summary of the allocations of repeated work, such as the control ticks.
+ */
+struct AllocTallyStats {
+    uint64_t samples = 0;            ///< Runs added
+    uint64_t allocatingSamples = 0;  ///< Runs that allocated at least once
+    double meanAllocations = 0.0;    ///< Allocations per run
+    double meanBytes = 0.0;          ///< Bytes allocated per run
+    uint64_t maxAllocations = 0;     ///< Most allocations in one run
+    uint64_t maxBytes = 0;           ///< Most bytes allocated in one run
+};
+
+/**
+ * @brief Adds up the allocations of each run of some repeated work. Single thread only.
+ */
+class AllocTally
+{
+public:
+    /**
+     * @brief Add the allocations of one run.
+     */
+    void add(const AllocCounts &counts);
+
+    /**
+     * @brief Summary of the runs added so far.
+     */
+    AllocTallyStats stats() const;
+
+private:
+    AllocTallyStats stats_;
+    uint64_t totalAllocations_ = 0;
+    uint64_t totalBytes_ = 0;
+};
+
+/**
+ * @brief Attaches the calling thread to a sink until destruction. Scopes nest; the innermost sink is used.
+ */
+class ScopedAllocSink
+{
+public:
+    explicit ScopedAllocSink(AllocSink &sink);
+    ~ScopedAllocSink();
+
+    ScopedAllocSink(const ScopedAllocSink &) = delete;
+    ScopedAllocSink &operator=(const ScopedAllocSink &) = delete;
+
+private:
+    AllocSink *previous_;
+};
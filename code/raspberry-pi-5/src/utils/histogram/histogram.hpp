@@ -0,0 +1,127 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * @brief A fixed-range histogram of non-negative values (e.g. latencies in microseconds) with percentile queries.
+ *
+ * Values fall into `bucketCount` buckets of `bucketWidth` each, plus one
+ * overflow bucket. record() is lock-free and never allocates, so a real-time
+ * thread can record every period while another thread reads percentiles.
+ * Percentiles are resolved to the upper edge of their bucket; those landing
+ * in the overflow bucket are reported as the largest value recorded.
+ *
+ * **Example usage:**
+ * @code
+ * Histogram lateness_us(10.0, 2000);  // 10 us buckets up to 20 ms
+ * lateness_us.record(42.0);
+ * double p99 = lateness_us.percentile(0.99);
+ * @endcode
+ */
+class Histogram
+{
+public:
+    /**
+     * @brief Create an empty histogram covering [0, bucketWidth * bucketCount).
+     */
+    Histogram(double bucketWidth, size_t bucketCount);
+
+    Histogram(const Histogram &) = delete;
+    Histogram &operator=(const Histogram &) = delete;
+
+    /**
+     * @brief Add a value. Negative values count as 0. Safe from any thread.
+     */
+    void record(double value);
+
+    /**
+     * @brief Number of values recorded.
+     */
+    uint64_t count() const;
+
+    /**
+     * @brief Mean of the values recorded, or 0 if none.
+     */
+    double mean() const;
+
+    /**
+     * @brief Largest value recorded, or 0 if none.
+     */
+    double max() const;
+
+    /**
+     * @brief Smallest value v such that at least @p fraction of the values are <= v, at bucket resolution.
+     * @param fraction Between 0 and 1, e.g. 0.99 for the 99th percentile.
+     * @return 0 if nothing was recorded.
+     */
+    double percentile(double fraction) const;
+
+private:
+    double bucketWidth_;
+    size_t bucketCount_;
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets_;  ///< bucketCount_ buckets plus the overflow bucket
+
+    std::atomic<uint64_t> count_{0};
+    std::atomic<double> sum_{0.0};
+    std::atomic<double> max_{0.0};
+};
+
+// ===== Definitions =====
+
+inline Histogram::Histogram(double bucketWidth, size_t bucketCount)
+    : bucketWidth_(bucketWidth)
+    , bucketCount_(std::max<size_t>(bucketCount, 1))
+    , buckets_(std::make_unique<std::atomic<uint64_t>[]>(bucketCount_ + 1)) {}
+
+inline void Histogram::record(double value) {
+    value = std::max(value, 0.0);
+
+    double scaled = value / bucketWidth_;
+    size_t bucket = scaled < static_cast<double>(bucketCount_) ? static_cast<size_t>(scaled) : bucketCount_;
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    // std::atomic<double> has no fetch_add before C++20
+    double sum = sum_.load(std::memory_order_relaxed);
+    while (!sum_.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed)) {}
+
+    double max = max_.load(std::memory_order_relaxed);
+    while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+
+    count_.fetch_add(1, std::memory_order_relaxed);
+}
+
+inline uint64_t Histogram::count() const {
+    return count_.load(std::memory_order_relaxed);
+}
+
+inline double Histogram::mean() const {
+    uint64_t count = count_.load(std::memory_order_relaxed);
+    return count > 0 ? sum_.load(std::memory_order_relaxed) / count : 0.0;
+}
+
+inline double Histogram::max() const {
+    return max_.load(std::memory_order_relaxed);
+}
+
+inline double Histogram::percentile(double fraction) const {
+    // Count the buckets themselves, so the rank stays within what is summed below while writers are recording
+    uint64_t total = 0;
+    for (size_t i = 0; i <= bucketCount_; ++i) {
+        total += buckets_[i].load(std::memory_order_relaxed);
+    }
+    if (total == 0) return 0.0;
+
+    uint64_t rank = static_cast<uint64_t>(std::ceil(std::clamp(fraction, 0.0, 1.0) * total));
+    rank = std::max<uint64_t>(rank, 1);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucketCount_; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) return std::min(bucketWidth_ * (i + 1), max());
+    }
+    return max();
+}
@@ -0,0 +1,303 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Binary layout of the self-describing log files written by Logger.
+ *
+ * A log file starts with a header:
+ *
+ *     [magic: "KMLG"][version: uint16_t][typeCount: uint16_t][headerSize: uint32_t]
+ *     typeCount x [typeId: uint16_t][kind: uint8_t][size: uint32_t][alignment: uint16_t]
+ *                 [nameLength: uint8_t][name][fieldCount: uint16_t]
+ *                 fieldCount x [nameLength: uint8_t][name][fieldType: uint8_t][offset: uint32_t]
+ *
+ * followed by records:
+ *
+ *     [typeId: varint][timestamp delta: zigzag varint][byteSize: varint, ARRAY and COLUMNS types only]
+ *     [zero padding up to the type's alignment][payload]
+ *
+ * The timestamp delta is relative to the previous record (the first record is
+ * relative to 0). Padding is computed from the start of the file, so a payload
+ * in a memory-mapped file is aligned for its type and fixed-size records can
+ * be reinterpreted in place. All integers are little-endian.
+ */
+namespace log_format
+{
+
+constexpr char MAGIC[4] = {'K', 'M', 'L', 'G'};
+constexpr uint16_t VERSION = 1;
+
+/// Size of the fixed part of the header (magic, version, typeCount, headerSize).
+constexpr size_t FIXED_HEADER_SIZE = sizeof(MAGIC) + sizeof(uint16_t) + sizeof(uint16_t) + sizeof(uint32_t);
+
+/// Upper bound of a record's framing: three varints plus padding for alignments up to 16.
+constexpr size_t MAX_RECORD_HEADER_SIZE = 3 * 10 + 15;
+
+/**
+ * @brief Scalar type of a described field.
+ */
+enum class FieldType : uint8_t
+{
+    UINT8 = 1,
+    UINT16,
+    UINT32,
+    UINT64,
+    INT8,
+    INT16,
+    INT32,
+    INT64,
+    FLOAT32,
+    FLOAT64
+};
+
+/**
+ * @brief How the payload size of a record type is determined.
+ */
+enum class RecordKind : uint8_t
+{
+    FIXED = 0,   ///< Every record is exactly `size` bytes; no size is stored per record.
+    ARRAY = 1,   ///< A byte size is stored per record; the payload is an array of `size`-byte elements.
+    COLUMNS = 2  ///< Like ARRAY, but stored struct-of-arrays: the column of a field at offset `o` starts at `o * count`.
+};
+
+/**
+ * @brief Describes one scalar field of a record (or array element).
+ */
+struct FieldDescriptor {
+    const char *name;  ///< Field name, e.g. "accel.x"
+    FieldType type;    ///< Scalar type
+    uint32_t offset;   ///< Byte offset within the record or element
+};
+
+/**
+ * @brief Compile-time description of a record type, shared by writers and readers.
+ */
+struct RecordDescriptor {
+    uint16_t typeId;                ///< Identifier stored in every record
+    const char *name;               ///< Human-readable name
+    RecordKind kind;                ///< FIXED or ARRAY
+    uint32_t size;                  ///< Record size (FIXED) or element size (ARRAY, COLUMNS)
+    uint16_t alignment;             ///< Required payload alignment (at most 16)
+    const FieldDescriptor *fields;  ///< Field layout of the record or element
+    uint16_t fieldCount;            ///< Number of entries in fields
+};
+
+/**
+ * @brief Maps a record struct to its descriptor. Specialise with a `static constexpr RecordDescriptor descriptor`.
+ */
+template <typename Record>
+struct RecordTraits;
+
+/**
+ * @brief Field layout read back from a file header.
+ */
+struct FieldSchema {
+    std::string name;
+    FieldType type;
+    uint32_t offset;
+};
+
+/**
+ * @brief Record type description read back from a file header.
+ */
+struct RecordSchema {
+    uint16_t typeId;
+    std::string name;
+    RecordKind kind;
+    uint32_t size;
+    uint16_t alignment;
+    std::vector<FieldSchema> fields;
+};
+
+constexpr uint64_t zigzagEncode(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+constexpr int64_t zigzagDecode(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+/**
+ * @brief Write @p value as a LEB128 varint.
+ * @return Number of bytes written (at most 10).
+ */
+inline size_t encodeVarint(uint64_t value, uint8_t *out) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = static_cast<uint8_t>(value);
+    return n;
+}
+
+/**
+ * @brief Read a LEB128 varint and advance @p pos past it.
+ * @return false if the varint is truncated or longer than 10 bytes.
+ */
+inline bool decodeVarint(const uint8_t *&pos, const uint8_t *end, uint64_t &value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 70 && pos < end; shift += 7) {
+        uint8_t byte = *pos++;
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Number of zero bytes needed to move @p offset up to a multiple of @p alignment.
+ */
+constexpr size_t paddingFor(uint64_t offset, uint16_t alignment) {
+    return alignment > 1 ? static_cast<size_t>((alignment - offset % alignment) % alignment) : 0;
+}
+
+namespace detail
+{
+
+    template <typename T>
+    void append(std::vector<uint8_t> &out, T value) {
+        uint8_t bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    inline void appendName(std::vector<uint8_t> &out, const char *name) {
+        size_t length = std::min<size_t>(std::strlen(name), 255);
+        out.push_back(static_cast<uint8_t>(length));
+        out.insert(out.end(), name, name + length);
+    }
+
+    template <typename T>
+    bool read(const uint8_t *&pos, const uint8_t *end, T &value) {
+        if (static_cast<size_t>(end - pos) < sizeof(T)) return false;
+        std::memcpy(&value, pos, sizeof(T));
+        pos += sizeof(T);
+        return true;
+    }
+
+    inline bool readName(const uint8_t *&pos, const uint8_t *end, std::string &name) {
+        uint8_t length;
+        if (!read(pos, end, length) || static_cast<size_t>(end - pos) < length) return false;
+        name.assign(reinterpret_cast<const char *>(pos), length);
+        pos += length;
+        return true;
+    }
+
+}  // namespace detail
+
+/**
+ * @brief Serialize a file header describing @p count record types.
+ */
+inline std::vector<uint8_t> encodeHeader(const RecordDescriptor *types, size_t count) {
+    std::vector<uint8_t> out(MAGIC, MAGIC + sizeof(MAGIC));
+    detail::append<uint16_t>(out, VERSION);
+    detail::append<uint16_t>(out, static_cast<uint16_t>(count));
+    detail::append<uint32_t>(out, 0);  // headerSize, patched below
+
+    for (size_t i = 0; i < count; ++i) {
+        const RecordDescriptor &type = types[i];
+        detail::append<uint16_t>(out, type.typeId);
+        detail::append<uint8_t>(out, static_cast<uint8_t>(type.kind));
+        detail::append<uint32_t>(out, type.size);
+        detail::append<uint16_t>(out, type.alignment);
+        detail::appendName(out, type.name);
+        detail::append<uint16_t>(out, type.fieldCount);
+
+        for (uint16_t f = 0; f < type.fieldCount; ++f) {
+            detail::appendName(out, type.fields[f].name);
+            detail::append<uint8_t>(out, static_cast<uint8_t>(type.fields[f].type));
+            detail::append<uint32_t>(out, type.fields[f].offset);
+        }
+    }
+
+    uint32_t headerSize = static_cast<uint32_t>(out.size());
+    std::memcpy(out.data() + sizeof(MAGIC) + 2 * sizeof(uint16_t), &headerSize, sizeof(headerSize));
+    return out;
+}
+
+/**
+ * @brief Check whether a buffer starts with the log file magic.
+ */
+inline bool hasMagic(const uint8_t *data, size_t size) {
+    return size >= sizeof(MAGIC) && std::memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+/**
+ * @brief Parse a file header.
+ *
+ * @param data Start of the file.
+ * @param size Size of the file.
+ * @param[out] types Record types described by the header.
+ * @param[out] headerSize Offset of the first record.
+ * @return false if the header is missing, truncated or of an unsupported version.
+ */
+inline bool decodeHeader(const uint8_t *data, size_t size, std::vector<RecordSchema> &types, size_t &headerSize) {
+    if (!hasMagic(data, size)) return false;
+
+    const uint8_t *pos = data + sizeof(MAGIC);
+    const uint8_t *end = data + size;
+
+    uint16_t version, count;
+    uint32_t declaredSize;
+    if (!detail::read(pos, end, version) || !detail::read(pos, end, count) || !detail::read(pos, end, declaredSize)) return false;
+    if (version != VERSION || declaredSize > size) return false;
+
+    end = data + declaredSize;
+    types.clear();
+    types.reserve(count);
+
+    for (uint16_t i = 0; i < count; ++i) {
+        RecordSchema type;
+        uint8_t kind;
+        uint16_t fieldCount;
+        if (!detail::read(pos, end, type.typeId) || !detail::read(pos, end, kind) || !detail::read(pos, end, type.size) ||
+            !detail::read(pos, end, type.alignment) || !detail::readName(pos, end, type.name) || !detail::read(pos, end, fieldCount))
+        {
+            return false;
+        }
+        if (kind > static_cast<uint8_t>(RecordKind::COLUMNS) || type.alignment == 0 || type.alignment > 16) return false;
+        type.kind = static_cast<RecordKind>(kind);
+
+        type.fields.resize(fieldCount);
+        for (auto &field : type.fields) {
+            uint8_t fieldType;
+            if (!detail::readName(pos, end, field.name) || !detail::read(pos, end, fieldType) || !detail::read(pos, end, field.offset)) {
+                return false;
+            }
+            field.type = static_cast<FieldType>(fieldType);
+        }
+
+        types.push_back(std::move(type));
+    }
+
+    headerSize = declaredSize;
+    return true;
+}
+
+/**
+ * @brief Check whether a record type read from a file has the layout of a compiled descriptor.
+ */
+inline bool sameLayout(const RecordSchema &schema, const RecordDescriptor &descriptor) {
+    if (schema.typeId != descriptor.typeId || schema.kind != descriptor.kind || schema.size != descriptor.size ||
+        schema.alignment != descriptor.alignment || schema.fields.size() != descriptor.fieldCount)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < schema.fields.size(); ++i) {
+        const auto &field = descriptor.fields[i];
+        if (schema.fields[i].name != field.name || schema.fields[i].type != field.type || schema.fields[i].offset != field.offset) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace log_format
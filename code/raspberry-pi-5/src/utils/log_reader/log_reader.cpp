@@ -1,33 +1,282 @@
 #include "log_reader.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
 #include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 LogReader::LogReader(const std::string &filename)
     : filePath_(filename) {}
 
 bool LogReader::readAll(std::vector<LogEntry> &entries) {
-    std::ifstream file(filePath_, std::ios::binary);
-    if (!file.is_open()) {
+    MappedLogReader reader(filePath_);
+    if (!reader.open()) return false;
+
+    entries.clear();
+    for (const auto &entry : reader) {
+        entries.push_back(LogEntry{entry.timestamp, std::vector<uint8_t>(entry.data, entry.data + entry.size)});
+    }
+
+    return true;
+}
+
+namespace
+{
+
+constexpr size_t LEGACY_HEADER_SIZE = sizeof(uint64_t) + sizeof(size_t);
+
+}  // namespace
+
+MappedLogReader::Iterator::Iterator(const MappedLogReader *reader, const uint8_t *pos, uint64_t previousTimestamp)
+    : reader_(reader)
+    , pos_(pos)
+    , end_(reader->mapped_ + reader->size_)
+    , previousTimestamp_(previousTimestamp) {
+    load();
+}
+
+void MappedLogReader::Iterator::load() {
+    if (pos_ == end_) return;
+
+    bool ok = reader_->legacy_ ? loadLegacy() : loadRecord();
+    if (!ok) pos_ = end_;
+}
+
+bool MappedLogReader::Iterator::loadRecord() {
+    const uint8_t *p = pos_;
+
+    uint64_t typeId, delta;
+    if (!log_format::decodeVarint(p, end_, typeId) || !log_format::decodeVarint(p, end_, delta)) return false;
+
+    const FileRecordType *type = reader_->findType(typeId);
+    if (type == nullptr) return false;
+
+    uint64_t dataSize = type->schema->size;
+    if (type->schema->kind != log_format::RecordKind::FIXED && !log_format::decodeVarint(p, end_, dataSize)) return false;
+
+    size_t padding = log_format::paddingFor(static_cast<uint64_t>(p - reader_->mapped_), type->schema->alignment);
+    if (static_cast<size_t>(end_ - p) < padding || dataSize > static_cast<size_t>(end_ - p) - padding) return false;
+    p += padding;
+
+    uint64_t timestamp = previousTimestamp_ + static_cast<uint64_t>(log_format::zigzagDecode(delta));
+    current_ = LogEntryView{timestamp, p, static_cast<size_t>(dataSize), type->reportedType};
+    return true;
+}
+
+bool MappedLogReader::Iterator::loadLegacy() {
+    size_t remaining = static_cast<size_t>(end_ - pos_);
+    if (remaining < LEGACY_HEADER_SIZE) return false;
+
+    uint64_t ts;
+    size_t dataSize;
+    std::memcpy(&ts, pos_, sizeof(ts));
+    std::memcpy(&dataSize, pos_ + sizeof(ts), sizeof(dataSize));
+
+    if (dataSize > remaining - LEGACY_HEADER_SIZE) return false;
+
+    current_ = LogEntryView{ts, pos_ + LEGACY_HEADER_SIZE, dataSize, log_records::RAW};
+    return true;
+}
+
+MappedLogReader::Iterator &MappedLogReader::Iterator::operator++() {
+    previousTimestamp_ = current_.timestamp;
+    pos_ = current_.data + current_.size;
+    load();
+    return *this;
+}
+
+MappedLogReader::MappedLogReader(const std::string &filename)
+    : filePath_(filename) {}
+
+MappedLogReader::~MappedLogReader() {
+    if (mapped_) {
+        munmap(const_cast<uint8_t *>(mapped_), size_);
+    }
+}
+
+bool MappedLogReader::open() {
+    if (opened_) return true;
+
+    int fd = ::open(filePath_.c_str(), O_RDONLY);
+    if (fd < 0) {
         std::cerr << "Failed to open log file: " << filePath_ << std::endl;
         return false;
     }
 
-    entries.clear();
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        std::cerr << "Failed to stat log file: " << filePath_ << std::endl;
+        close(fd);
+        return false;
+    }
+
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ > 0) {
+        void *addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            std::cerr << "Failed to map log file: " << filePath_ << std::endl;
+            close(fd);
+            size_ = 0;
+            return false;
+        }
+
+        // Entries are mostly visited front to back; let the kernel read ahead
+        madvise(addr, size_, MADV_SEQUENTIAL);
+        mapped_ = static_cast<const uint8_t *>(addr);
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+
+    if (!loadHeader()) {
+        std::cerr << "Unsupported log file header: " << filePath_ << std::endl;
+        return false;
+    }
+
+    opened_ = true;
+
+    loadIndex();
+    return true;
+}
+
+bool MappedLogReader::loadHeader() {
+    types_.clear();
+    typeTable_.clear();
+
+    if (!log_format::hasMagic(mapped_, size_)) {
+        legacy_ = true;
+        dataStart_ = 0;
+        return true;
+    }
+
+    legacy_ = false;
+    if (!log_format::decodeHeader(mapped_, size_, types_, dataStart_)) return false;
+
+    // Entries of a type this build knows under a different layout cannot be
+    // interpreted safely, so they are reported as UNKNOWN
+    for (const auto &schema : types_) {
+        uint16_t reportedType = schema.typeId;
+        const log_format::RecordDescriptor *known = log_records::findRecordType(schema.typeId);
+        if (known != nullptr && !log_format::sameLayout(schema, *known)) {
+            std::cerr << "Log record type " << schema.name << " in " << filePath_ << " does not match this build" << std::endl;
+            reportedType = log_records::UNKNOWN;
+        }
+        typeTable_.push_back({&schema, reportedType});
+    }
+
+    return true;
+}
+
+const MappedLogReader::FileRecordType *MappedLogReader::findType(uint64_t typeId) const {
+    for (const auto &type : typeTable_) {
+        if (type.schema->typeId == typeId) return &type;
+    }
+    return nullptr;
+}
+
+void MappedLogReader::loadIndex() {
+    index_.clear();
+
+    std::ifstream file(filePath_ + ".idx", std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return;
+
+    size_t count = static_cast<size_t>(file.tellg()) / sizeof(LogIndexEntry);
+    file.seekg(0);
+
+    index_.resize(count);
+    file.read(reinterpret_cast<char *>(index_.data()), static_cast<std::streamsize>(count * sizeof(LogIndexEntry)));
+    if (!file) {
+        index_.clear();
+        return;
+    }
+
+    // The log may have been cut short after the index was written; drop
+    // entries past the end and reject an index that is out of order
+    while (!index_.empty() && index_.back().offset >= size_) {
+        index_.pop_back();
+    }
+
+    for (size_t i = 0; i < index_.size(); ++i) {
+        bool outOfOrder = i > 0 && (index_[i].offset <= index_[i - 1].offset || index_[i].timestamp < index_[i - 1].timestamp);
+        if (index_[i].offset < dataStart_ || outOfOrder) {
+            std::cerr << "Ignoring inconsistent index for log file: " << filePath_ << std::endl;
+            index_.clear();
+            return;
+        }
+    }
+}
+
+MappedLogReader::Iterator MappedLogReader::begin() const {
+    return Iterator(this, mapped_ + dataStart_, 0);
+}
 
-    while (file) {
-        uint64_t ts = 0;
-        size_t dataSize = 0;
+MappedLogReader::Iterator MappedLogReader::end() const {
+    return Iterator(this, mapped_ + size_, 0);
+}
+
+MappedLogReader::Iterator MappedLogReader::indexedStart(uint64_t timestamp) const {
+    auto it = std::lower_bound(index_.begin(), index_.end(), timestamp, [](const LogIndexEntry &e, uint64_t ts) {
+        return e.timestamp < ts;
+    });
+    if (it == index_.begin()) return begin();
 
-        file.read(reinterpret_cast<char *>(&ts), sizeof(ts));
-        if (!file) break;
+    --it;
 
-        file.read(reinterpret_cast<char *>(&dataSize), sizeof(dataSize));
-        if (!file) break;
+    // Timestamps are stored as deltas; recover the base from the indexed one
+    const uint8_t *pos = mapped_ + it->offset;
+    uint64_t previousTimestamp = 0;
+    if (!legacy_) {
+        const uint8_t *p = pos;
+        uint64_t typeId, delta;
+        if (log_format::decodeVarint(p, mapped_ + size_, typeId) && log_format::decodeVarint(p, mapped_ + size_, delta)) {
+            previousTimestamp = it->timestamp - static_cast<uint64_t>(log_format::zigzagDecode(delta));
+        }
+    }
+    return Iterator(this, pos, previousTimestamp);
+}
 
-        std::vector<uint8_t> buffer(dataSize);
-        file.read(reinterpret_cast<char *>(buffer.data()), dataSize);
-        if (!file) break;
+MappedLogReader::Iterator MappedLogReader::seek(uint64_t timestamp) const {
+    Iterator it = indexedStart(timestamp);
+    Iterator last = end();
+    while (it != last && it->timestamp < timestamp) {
+        ++it;
+    }
+    return it;
+}
 
-        entries.push_back(LogEntry{ts, std::move(buffer)});
+bool MappedLogReader::findClosest(uint64_t timestamp, LogEntryView &entry) const {
+    Iterator it = indexedStart(timestamp);
+    Iterator last = end();
+    if (it == last) return false;
+
+    // Only reached when the target is before the first entry
+    if (it->timestamp >= timestamp) {
+        entry = *it;
+        return true;
+    }
+
+    LogEntryView previous = *it;
+    while (it != last && it->timestamp < timestamp) {
+        previous = *it;
+        ++it;
+    }
+
+    if (it == last || timestamp - previous.timestamp <= it->timestamp - timestamp) {
+        entry = previous;
+    } else {
+        entry = *it;
+    }
+    return true;
+}
+
+bool MappedLogReader::readAll(std::vector<LogEntryView> &entries) const {
+    if (!opened_) return false;
+
+    entries.clear();
+    for (const auto &entry : *this) {
+        entries.push_back(entry);
     }
 
     return true;
@@ -1,9 +1,15 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <iterator>
 #include <string>
 #include <vector>
 
+#include "log_format.h"
+#include "log_records.h"
+
 /**
  * @brief Represents a single generic log entry
  */
@@ -12,11 +18,80 @@ struct LogEntry {
     std::vector<uint8_t> data;  ///< Raw data bytes
 };
 
+/**
+ * @brief A non-owning view of a log entry inside a memory-mapped log file.
+ *
+ * The data pointer is only valid while the MappedLogReader that produced it
+ * is alive. In files with a log_format header the payload is aligned for its
+ * record type; in legacy files it is not, so use readRecord() / readArray()
+ * unless the type is known to match.
+ */
+struct LogEntryView {
+    uint64_t timestamp;   ///< Timestamp in nanoseconds
+    const uint8_t *data;  ///< Pointer to the raw data bytes inside the mapping
+    size_t size;          ///< Number of data bytes
+    uint16_t type;        ///< log_records::RecordType (RAW for legacy files)
+};
+
+/**
+ * @brief One entry of the sidecar index written by Logger (`<log file>.idx`).
+ */
+struct LogIndexEntry {
+    uint64_t timestamp;  ///< Timestamp of the indexed entry in nanoseconds
+    uint64_t offset;     ///< Byte offset of the indexed entry in the log file
+};
+
+/**
+ * @brief Copy a fixed-size record out of an entry.
+ *
+ * Accepts entries of the record's type and untyped (RAW) entries of the right
+ * size, which is how every entry of a legacy log reads.
+ *
+ * @return false if the entry holds a different type or size.
+ */
+template <typename Record>
+bool readRecord(const LogEntryView &entry, Record &out) {
+    constexpr const log_format::RecordDescriptor &type = log_format::RecordTraits<Record>::descriptor;
+    if (entry.type != type.typeId && entry.type != log_records::RAW) return false;
+    if (entry.size != sizeof(Record)) return false;
+
+    std::memcpy(&out, entry.data, sizeof(Record));
+    return true;
+}
+
+/**
+ * @brief Copy an array record out of an entry. Accepts the element's type and RAW entries.
+ * @return false if the entry holds a different type or its size is not a multiple of the element size.
+ */
+template <typename Element>
+bool readArray(const LogEntryView &entry, std::vector<Element> &out) {
+    constexpr const log_format::RecordDescriptor &type = log_format::RecordTraits<Element>::descriptor;
+    if (entry.type != type.typeId && entry.type != log_records::RAW) return false;
+    if (entry.size % sizeof(Element) != 0) return false;
+
+    out.resize(entry.size / sizeof(Element));
+    if (entry.size > 0) std::memcpy(out.data(), entry.data, entry.size);
+    return true;
+}
+
+/**
+ * @brief Reinterpret a fixed-size record in place, without copying.
+ * @return nullptr unless the entry is of the record's type, has its size and is suitably aligned.
+ */
+template <typename Record>
+const Record *recordCast(const LogEntryView &entry) {
+    constexpr const log_format::RecordDescriptor &type = log_format::RecordTraits<Record>::descriptor;
+    if (entry.type != type.typeId || entry.size != sizeof(Record)) return nullptr;
+    if (reinterpret_cast<uintptr_t>(entry.data) % alignof(Record) != 0) return nullptr;
+
+    return reinterpret_cast<const Record *>(entry.data);
+}
+
 /**
  * @brief A utility class for reading and parsing all entries from a binary log file.
  *
- * The file format is assumed to be a concatenation of entries, where each entry
- * begins with a uint64_t timestamp, followed by a variable length of raw data.
+ * Reads both the log_format files written by Logger and legacy files (a plain
+ * concatenation of [uint64_t timestamp][size_t size][data] entries).
  */
 class LogReader
 {
@@ -38,3 +113,231 @@ public:
 private:
     std::string filePath_;
 };
+
+/**
+ * @brief Zero-copy reader that memory-maps a binary log file.
+ *
+ * Entries are returned as LogEntryView objects pointing into the mapping, so
+ * no payload is copied and the kernel pages the file in on demand. Memory use
+ * stays flat regardless of the log size, and iteration can start as soon as
+ * the file is mapped.
+ *
+ * Files starting with the log_format header are decoded using the record
+ * types listed in it. Files without it are read as the legacy format, with
+ * every entry reported as log_records::RAW. Record types whose layout in the
+ * header differs from this build are reported as log_records::UNKNOWN.
+ *
+ * A truncated final entry (e.g. from a crash mid-write) ends the iteration,
+ * the same way LogReader::readAll stops at it.
+ *
+ * If the sidecar index written by Logger is present, seek() and findClosest()
+ * binary-search it and then scan at most one index interval of entries.
+ * Without an index they fall back to a linear scan from the start.
+ * Both assume timestamps do not decrease through the file.
+ */
+class MappedLogReader
+{
+public:
+    /**
+     * @brief Forward iterator over the entries of a mapped log file.
+     */
+    class Iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = LogEntryView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const LogEntryView *;
+        using reference = const LogEntryView &;
+
+        Iterator() = default;
+
+        reference operator*() const {
+            return current_;
+        }
+        pointer operator->() const {
+            return &current_;
+        }
+
+        Iterator &operator++();
+        Iterator operator++(int) {
+            Iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        bool operator==(const Iterator &other) const {
+            return pos_ == other.pos_;
+        }
+        bool operator!=(const Iterator &other) const {
+            return pos_ != other.pos_;
+        }
+
+    private:
+        friend class MappedLogReader;
+
+        /**
+         * @param reader Reader that owns the mapping.
+         * @param pos Start of the first entry to decode.
+         * @param previousTimestamp Timestamp the first entry's delta is relative to.
+         */
+        Iterator(const MappedLogReader *reader, const uint8_t *pos, uint64_t previousTimestamp);
+
+        /**
+         * @brief Decode the entry at pos_, or move to the end if it is truncated or corrupt.
+         */
+        void load();
+
+        /**
+         * @brief Decode one entry at pos_ in the log_format framing.
+         */
+        bool loadRecord();
+
+        /**
+         * @brief Decode one entry at pos_ in the legacy framing.
+         */
+        bool loadLegacy();
+
+        const MappedLogReader *reader_ = nullptr;
+        const uint8_t *pos_ = nullptr;
+        const uint8_t *end_ = nullptr;
+        uint64_t previousTimestamp_ = 0;
+        LogEntryView current_{0, nullptr, 0, log_records::RAW};
+    };
+
+    /**
+     * @brief Constructs a MappedLogReader object. The file is not mapped until open() is called.
+     * @param filename The full path to the binary log file to be processed.
+     */
+    MappedLogReader(const std::string &filename);
+
+    /**
+     * @brief Unmaps the file.
+     */
+    ~MappedLogReader();
+
+    MappedLogReader(const MappedLogReader &) = delete;
+    MappedLogReader &operator=(const MappedLogReader &) = delete;
+
+    /**
+     * @brief Map the log file into memory (read-only), parse its header and load its index, if any.
+     *
+     * A missing or inconsistent index is ignored; seeking then scans linearly.
+     *
+     * @return true if the file was opened and mapped, false otherwise (e.g., file not found or unsupported header).
+     */
+    bool open();
+
+    /**
+     * @brief Check whether the file is currently mapped.
+     */
+    bool isOpen() const {
+        return opened_;
+    }
+
+    /**
+     * @brief Check whether the file uses the legacy format (no log_format header).
+     */
+    bool isLegacy() const {
+        return legacy_;
+    }
+
+    /**
+     * @brief Record types listed in the file header (empty for legacy files).
+     */
+    const std::vector<log_format::RecordSchema> &recordTypes() const {
+        return types_;
+    }
+
+    /**
+     * @brief Size of the mapped file in bytes.
+     */
+    size_t fileSize() const {
+        return size_;
+    }
+
+    /**
+     * @brief Iterator to the first entry, or end() if the file is empty or not mapped.
+     */
+    Iterator begin() const;
+
+    /**
+     * @brief Past-the-end iterator.
+     */
+    Iterator end() const;
+
+    /**
+     * @brief Check whether a usable sidecar index was loaded.
+     */
+    bool hasIndex() const {
+        return !index_.empty();
+    }
+
+    /**
+     * @brief Iterator to the first entry whose timestamp is not earlier than @p timestamp.
+     * @return end() if every entry is earlier.
+     */
+    Iterator seek(uint64_t timestamp) const;
+
+    /**
+     * @brief Find the entry whose timestamp is closest to @p timestamp.
+     *
+     * On a tie the earlier entry is returned.
+     *
+     * @param timestamp Target timestamp in nanoseconds.
+     * @param[out] entry The closest entry.
+     * @return false if the log has no entries.
+     */
+    bool findClosest(uint64_t timestamp, LogEntryView &entry) const;
+
+    /**
+     * @brief Collect a view of every entry for random access.
+     *
+     * Only the views are stored; payloads stay in the mapping.
+     *
+     * @param entries Vector that is cleared and filled with the entry views.
+     * @return true if the file is mapped, false otherwise.
+     */
+    bool readAll(std::vector<LogEntryView> &entries) const;
+
+private:
+    /**
+     * @brief A record type from the file header and the type id reported for its entries.
+     */
+    struct FileRecordType {
+        const log_format::RecordSchema *schema;
+        uint16_t reportedType;
+    };
+
+    /**
+     * @brief Parse the log_format header, if present, and check its record types against this build.
+     * @return false if the file has the magic but an unreadable or unsupported header.
+     */
+    bool loadHeader();
+
+    /**
+     * @brief Read `<log file>.idx` into index_, leaving it empty if it is missing or does not match the log.
+     */
+    void loadIndex();
+
+    /**
+     * @brief Look up a record type listed in the file header.
+     * @return nullptr if the header does not list @p typeId.
+     */
+    const FileRecordType *findType(uint64_t typeId) const;
+
+    /**
+     * @brief Iterator to the last indexed entry earlier than @p timestamp, or begin() if there is none.
+     */
+    Iterator indexedStart(uint64_t timestamp) const;
+
+    std::string filePath_;
+    std::vector<LogIndexEntry> index_;              ///< Sparse timestamp to offset index, empty if unavailable
+    std::vector<log_format::RecordSchema> types_;  ///< Record types from the file header
+    std::vector<FileRecordType> typeTable_;        ///< Lookup table over types_
+    bool legacy_ = true;                           ///< No log_format header
+    size_t dataStart_ = 0;                         ///< Offset of the first entry
+    const uint8_t *mapped_ = nullptr;              ///< Start of the read-only mapping
+    size_t size_ = 0;                              ///< Length of the mapping in bytes
+    bool opened_ = false;
+};
@@ -1,6 +1,55 @@
 #include "logger.h"
+#include "trace.h"
 
-Logger::Logger(const std::string &filename) {
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+Logger::Logger(const std::string &filename, size_t indexInterval)
+    : indexInterval_(indexInterval) {
+    openFile(filename);
+}
+
+Logger::Logger(const std::string &filename, const AsyncOptions &options, size_t indexInterval)
+    : indexInterval_(indexInterval)
+    , async_(true)
+    , options_(options) {
+    openFile(filename);
+
+    frontBuffer_.resize(options_.bufferCapacity);
+    backBuffer_.resize(options_.bufferCapacity);
+
+    writerName_ = "log " + std::filesystem::path(filename).filename().string();
+    writerThread_ = std::thread(&Logger::writerLoop, this);
+}
+
+Logger::~Logger() {
+    if (async_) {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping_ = true;
+        }
+        dataAvailable_.notify_all();
+        spaceAvailable_.notify_all();
+
+        if (writerThread_.joinable()) {
+            writerThread_.join();
+        }
+    }
+
+    if (file.is_open()) {
+        file.flush();
+        file.close();
+    }
+
+    if (indexFile_.is_open()) {
+        indexFile_.flush();
+        indexFile_.close();
+    }
+}
+
+void Logger::openFile(const std::string &filename) {
     std::filesystem::path filePath(filename);
     auto dir = filePath.parent_path();
     if (!dir.empty() && !std::filesystem::exists(dir)) {
@@ -13,21 +62,185 @@ Logger::Logger(const std::string &filename) {
     if (!file.is_open()) {
         throw std::runtime_error("Failed to open log file: " + filename);
     }
-}
 
-Logger::~Logger() {
-    if (file.is_open()) {
-        file.flush();
-        file.close();
+    if (indexInterval_ > 0) {
+        indexFile_.open(indexFilename(filename), std::ios::binary | std::ios::out);
+        if (!indexFile_.is_open()) {
+            throw std::runtime_error("Failed to open index file: " + indexFilename(filename));
+        }
     }
+
+    auto header = log_format::encodeHeader(log_records::RECORD_TYPES, std::size(log_records::RECORD_TYPES));
+    file.write(reinterpret_cast<const char *>(header.data()), static_cast<std::streamsize>(header.size()));
+    fileOffset_ = header.size();
 }
 
 void Logger::writeData(uint64_t timestamp_ns, const void *data, size_t dataSize) {
-    std::lock_guard<std::mutex> lock(mtx);
+    writeData(timestamp_ns, log_records::RAW, data, dataSize);
+}
+
+void Logger::writeData(uint64_t timestamp_ns, uint16_t typeId, const void *data, size_t dataSize) {
+    if (data == nullptr) dataSize = 0;
+
+    const log_format::RecordDescriptor *type = log_records::findRecordType(typeId);
+    if (type == nullptr) {
+        throw std::invalid_argument("Unknown log record type: " + std::to_string(typeId));
+    }
+    if (type->kind == log_format::RecordKind::FIXED ? dataSize != type->size : dataSize % type->size != 0) {
+        throw std::invalid_argument("Invalid size " + std::to_string(dataSize) + " for log record type " + type->name);
+    }
+
+    if (!async_) {
+        std::lock_guard<std::mutex> lock(mtx);
+        encodeRecord(timestamp_ns, typeId, data, dataSize);
+        return;
+    }
+
+    const size_t recordSize = RECORD_HEADER_SIZE + dataSize;
+
+    std::unique_lock<std::mutex> lock(mtx);
+
+    if (recordSize > options_.bufferCapacity || dataSize > std::numeric_limits<uint32_t>::max() || stopping_) {
+        droppedRecords_.fetch_add(1, std::memory_order_relaxed);
+        droppedBytes_.fetch_add(recordSize, std::memory_order_relaxed);
+        return;
+    }
+
+    if (frontUsed_ + recordSize > options_.bufferCapacity) {
+        switch (options_.policy) {
+        case BackpressurePolicy::BLOCK:
+            spaceAvailable_.wait(lock, [&] { return frontUsed_ + recordSize <= options_.bufferCapacity || stopping_; });
+            if (stopping_) {
+                droppedRecords_.fetch_add(1, std::memory_order_relaxed);
+                droppedBytes_.fetch_add(recordSize, std::memory_order_relaxed);
+                return;
+            }
+            break;
+        case BackpressurePolicy::DROP_OLDEST:
+            dropOldestRecords(recordSize);
+            break;
+        case BackpressurePolicy::DROP_NEWEST:
+            droppedRecords_.fetch_add(1, std::memory_order_relaxed);
+            droppedBytes_.fetch_add(recordSize, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    PendingHeader header{timestamp_ns, static_cast<uint32_t>(dataSize), typeId, 0};
+    char *dst = frontBuffer_.data() + frontUsed_;
+    std::memcpy(dst, &header, sizeof(header));
+    if (dataSize > 0) {
+        std::memcpy(dst + RECORD_HEADER_SIZE, data, dataSize);
+    }
+    frontUsed_ += recordSize;
+
+    lock.unlock();
+    dataAvailable_.notify_one();
+}
+
+void Logger::dropOldestRecords(size_t needed) {
+    // Records are stored back to back behind a PendingHeader, so the
+    // boundaries can be recovered by walking the size fields.
+    size_t offset = 0;
+    while (offset < frontUsed_ && frontUsed_ - offset + needed > options_.bufferCapacity) {
+        PendingHeader header;
+        std::memcpy(&header, frontBuffer_.data() + offset, sizeof(header));
+
+        size_t recordSize = RECORD_HEADER_SIZE + header.dataSize;
+        offset += recordSize;
+
+        droppedRecords_.fetch_add(1, std::memory_order_relaxed);
+        droppedBytes_.fetch_add(recordSize, std::memory_order_relaxed);
+    }
+
+    std::memmove(frontBuffer_.data(), frontBuffer_.data() + offset, frontUsed_ - offset);
+    frontUsed_ -= offset;
+}
+
+void Logger::encodeRecord(uint64_t timestamp_ns, uint16_t typeId, const void *data, size_t dataSize) {
+    const log_format::RecordDescriptor &type = *log_records::findRecordType(typeId);
+
+    uint8_t header[log_format::MAX_RECORD_HEADER_SIZE];
+    size_t headerSize = log_format::encodeVarint(typeId, header);
+    headerSize += log_format::encodeVarint(log_format::zigzagEncode(static_cast<int64_t>(timestamp_ns - lastTimestamp_)), header + headerSize);
+    if (type.kind != log_format::RecordKind::FIXED) {
+        headerSize += log_format::encodeVarint(dataSize, header + headerSize);
+    }
+
+    // Pad so the payload lands on its natural alignment in the file
+    size_t padding = log_format::paddingFor(fileOffset_ + headerSize, type.alignment);
+    std::memset(header + headerSize, 0, padding);
+    headerSize += padding;
+
+    file.write(reinterpret_cast<const char *>(header), static_cast<std::streamsize>(headerSize));
+    if (dataSize > 0) {
+        file.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(dataSize));
+    }
+
+    lastTimestamp_ = timestamp_ns;
+    indexRecord(timestamp_ns, headerSize + dataSize);
+}
+
+void Logger::encodeRecords(const char *records, size_t size) {
+    size_t offset = 0;
+    while (offset < size) {
+        PendingHeader header;
+        std::memcpy(&header, records + offset, sizeof(header));
+
+        encodeRecord(header.timestamp_ns, header.typeId, records + offset + RECORD_HEADER_SIZE, header.dataSize);
+        offset += RECORD_HEADER_SIZE + header.dataSize;
+    }
+}
+
+void Logger::indexRecord(uint64_t timestamp_ns, size_t recordSize) {
+    if (indexInterval_ > 0 && recordCount_ % indexInterval_ == 0) {
+        indexFile_.write(reinterpret_cast<const char *>(&timestamp_ns), sizeof(timestamp_ns));
+        indexFile_.write(reinterpret_cast<const char *>(&fileOffset_), sizeof(fileOffset_));
+    }
+
+    fileOffset_ += recordSize;
+    recordCount_++;
+}
+
+void Logger::flush() {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    if (async_) {
+        spaceAvailable_.wait(lock, [this] { return (frontUsed_ == 0 && !writing_) || stopping_; });
+    }
+
+    // The writer thread only touches the streams while writing_ is set, which
+    // cannot become true again while this lock is held.
+    file.flush();
+    if (indexFile_.is_open()) indexFile_.flush();
+}
+
+void Logger::writerLoop() {
+    trace::registerThread(writerName_);
+
+    std::unique_lock<std::mutex> lock(mtx);
+
+    while (true) {
+        dataAvailable_.wait(lock, [this] { return frontUsed_ > 0 || stopping_; });
+        if (frontUsed_ == 0 && stopping_) break;
+
+        std::swap(frontBuffer_, backBuffer_);
+        backUsed_ = frontUsed_;
+        frontUsed_ = 0;
+        writing_ = true;
+
+        lock.unlock();
+        spaceAvailable_.notify_all();
+
+        // Framing and index offsets are only final once records leave the
+        // pending buffer, since DROP_OLDEST can still remove records from it
+        trace::begin("write records");
+        encodeRecords(backBuffer_.data(), backUsed_);
+        trace::end("write records");
 
-    file.write(reinterpret_cast<const char *>(&timestamp_ns), sizeof(timestamp_ns));
-    file.write(reinterpret_cast<const char *>(&dataSize), sizeof(dataSize));
-    if (dataSize > 0 && data != nullptr) {
-        file.write(reinterpret_cast<const char *>(data), dataSize);
+        lock.lock();
+        writing_ = false;
+        backUsed_ = 0;
+        spaceAvailable_.notify_all();
     }
 }
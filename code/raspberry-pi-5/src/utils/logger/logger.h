@@ -1,39 +1,104 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <mutex>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "log_format.h"
+#include "log_records.h"
 
 /**
  * @class Logger
  * @brief Thread-safe binary logger for various sensor data streams.
  *
  * The Logger class provides a mechanism to serialize and save different types
- * of sensor data into a single binary file. Each log entry contains a type
- * identifier, a timestamp, and the raw payload. Access is synchronized using
- * a mutex to allow safe logging from multiple threads.
+ * of sensor data into a single binary file. The file starts with a header
+ * that describes every record type in log_records (see log_format.h), and
+ * each record carries a type identifier, a varint timestamp delta, and the
+ * payload aligned for its type. Access is synchronized using a mutex to allow
+ * safe logging from multiple threads.
+ *
+ * In asynchronous mode, writeData() only copies the record into a preallocated
+ * in-memory buffer. A dedicated writer thread swaps that buffer with a second
+ * one, encodes the record framing and drains it to disk, so neither encoding
+ * nor a slow SD card ever stalls the producing sensor thread.
+ *
+ * Unless disabled, a sidecar index file (`<filename>.idx`) is written next to
+ * the log. It holds one [timestamp: uint64_t][offset: uint64_t] pair for every
+ * indexInterval-th record, which lets readers seek by timestamp with a binary
+ * search instead of scanning the whole log.
  */
 class Logger
 {
 public:
     /**
-     * @brief Constructs a Logger and opens the output file.
+     * @brief What writeData() does when the asynchronous buffer is full.
+     */
+    enum class BackpressurePolicy
+    {
+        BLOCK,        ///< Wait for the writer thread to free space.
+        DROP_OLDEST,  ///< Discard the oldest pending records to make room.
+        DROP_NEWEST   ///< Discard the record being written.
+    };
+
+    /**
+     * @brief Configuration for the asynchronous (double-buffered) mode.
+     */
+    struct AsyncOptions {
+        size_t bufferCapacity = 4 * 1024 * 1024;                      ///< Capacity of each of the two buffers, in bytes.
+        BackpressurePolicy policy = BackpressurePolicy::DROP_NEWEST;  ///< Behaviour when the pending buffer is full.
+    };
+
+    /// Default number of records between two index entries.
+    static constexpr size_t DEFAULT_INDEX_INTERVAL = 16;
+
+    /**
+     * @brief Constructs a synchronous Logger and opens the output file.
+     *
+     * Every writeData() call writes straight to the file stream on the caller's thread.
+     *
+     * @param filename Path to the binary log file.
+     * @param indexInterval Index every N-th record in `<filename>.idx`. 0 disables the index.
+     * @throws std::runtime_error if the file cannot be opened.
+     */
+    Logger(const std::string &filename, size_t indexInterval = DEFAULT_INDEX_INTERVAL);
+
+    /**
+     * @brief Constructs an asynchronous Logger and starts its writer thread.
+     *
+     * Both buffers are allocated up front; writeData() never allocates.
+     *
      * @param filename Path to the binary log file.
+     * @param options Buffer capacity and backpressure policy.
+     * @param indexInterval Index every N-th record in `<filename>.idx`. 0 disables the index.
      * @throws std::runtime_error if the file cannot be opened.
      */
-    Logger(const std::string &filename);
+    Logger(const std::string &filename, const AsyncOptions &options, size_t indexInterval = DEFAULT_INDEX_INTERVAL);
 
     /**
-     * @brief Destructor closes the log file.
+     * @brief Destructor drains any pending records, stops the writer thread and closes the log file.
      */
     ~Logger();
 
+    Logger(const Logger &) = delete;
+    Logger &operator=(const Logger &) = delete;
+
     /**
-     * @brief Write a block of raw data with a timestamp.
+     * @brief Write a block of untyped data (log_records::RAW) with a timestamp.
      *
-     * Format:
-     * [timestamp: uint64_t][dataSize: size_t][data bytes]
+     * In asynchronous mode the record is copied into the pending buffer and
+     * encoded and written later by the writer thread. A record larger than the
+     * buffer capacity can never fit and is always dropped.
      *
      * @param timestamp_ns Timestamp in nanoseconds
      * @param data Pointer to raw bytes
@@ -41,6 +106,71 @@ public:
      */
     void writeData(uint64_t timestamp_ns, const void *data, size_t dataSize);
 
+    /**
+     * @brief Write a record of the given type with a timestamp.
+     *
+     * @param timestamp_ns Timestamp in nanoseconds
+     * @param typeId One of log_records::RecordType
+     * @param data Pointer to the payload
+     * @param dataSize Payload size; must equal the record size for FIXED types and be a multiple of the element size for ARRAY and COLUMNS types
+     * @throws std::invalid_argument if the type is unknown or the size does not match it.
+     */
+    void writeData(uint64_t timestamp_ns, uint16_t typeId, const void *data, size_t dataSize);
+
+    /**
+     * @brief Write a fixed-size record described by log_format::RecordTraits<Record>.
+     */
+    template <typename Record>
+    void writeRecord(uint64_t timestamp_ns, const Record &record) {
+        static_assert(std::is_trivially_copyable_v<Record>, "Log records must be trivially copyable");
+        static_assert(log_format::RecordTraits<Record>::descriptor.kind == log_format::RecordKind::FIXED, "Use writeArray for arrays");
+        writeData(timestamp_ns, log_format::RecordTraits<Record>::descriptor.typeId, &record, sizeof(Record));
+    }
+
+    /**
+     * @brief Write an array record whose elements are described by log_format::RecordTraits<Element>.
+     */
+    template <typename Element>
+    void writeArray(uint64_t timestamp_ns, const Element *elements, size_t count) {
+        static_assert(std::is_trivially_copyable_v<Element>, "Log records must be trivially copyable");
+        static_assert(log_format::RecordTraits<Element>::descriptor.kind == log_format::RecordKind::ARRAY, "Use writeRecord for fixed records");
+        writeData(timestamp_ns, log_format::RecordTraits<Element>::descriptor.typeId, elements, count * sizeof(Element));
+    }
+
+    /**
+     * @brief Block until every record accepted so far has been handed to the file, then flush the log and index streams.
+     */
+    void flush();
+
+    /**
+     * @brief Check whether this logger runs in asynchronous mode.
+     * @return true if a writer thread drains the records.
+     */
+    bool isAsync() const {
+        return async_;
+    }
+
+    /**
+     * @brief Number of records discarded because of backpressure.
+     */
+    uint64_t droppedRecords() const {
+        return droppedRecords_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Number of bytes (header and payload) discarded because of backpressure.
+     */
+    uint64_t droppedBytes() const {
+        return droppedBytes_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Path of the sidecar index file for a log file.
+     */
+    static std::string indexFilename(const std::string &filename) {
+        return filename + ".idx";
+    }
+
     /**
      * @brief Generate a timestamped folder.
      *
@@ -71,6 +201,74 @@ public:
     }
 
 private:
+    /**
+     * @brief Header of a record waiting in the in-memory buffers (not the on-disk framing).
+     */
+    struct PendingHeader {
+        uint64_t timestamp_ns;
+        uint32_t dataSize;
+        uint16_t typeId;
+        uint16_t reserved;
+    };
+
+    static constexpr size_t RECORD_HEADER_SIZE = sizeof(PendingHeader);
+
+    /**
+     * @brief Open the output file (and index file, if enabled), creating the parent directory if needed, and write the file header.
+     */
+    void openFile(const std::string &filename);
+
+    /**
+     * @brief Encode one record's framing, write it and its payload to the file, and index it.
+     *
+     * Only called with the lock held (synchronous mode) or from the writer thread.
+     */
+    void encodeRecord(uint64_t timestamp_ns, uint16_t typeId, const void *data, size_t dataSize);
+
+    /**
+     * @brief Call encodeRecord() for every record in a block of pending records.
+     */
+    void encodeRecords(const char *records, size_t size);
+
+    /**
+     * @brief Account for a record written at the current file offset, adding an index entry every indexInterval_ records.
+     */
+    void indexRecord(uint64_t timestamp_ns, size_t recordSize);
+
+    /**
+     * @brief Remove whole records from the front of the pending buffer until @p needed bytes are free.
+     */
+    void dropOldestRecords(size_t needed);
+
+    /**
+     * @brief Writer thread: swaps the pending buffer out and writes it to disk.
+     */
+    void writerLoop();
+
     std::ofstream file;  ///< Output file stream for the log
     std::mutex mtx;      ///< Mutex for thread-safe writes
+
+    std::ofstream indexFile_;     ///< Sidecar index stream, open only when indexing is enabled
+    size_t indexInterval_;        ///< Records between two index entries (0 = disabled)
+    uint64_t fileOffset_ = 0;     ///< Offset in the log file of the next record
+    uint64_t recordCount_ = 0;    ///< Records written to the log file so far
+    uint64_t lastTimestamp_ = 0;  ///< Timestamp of the previous record, base of the next delta
+
+    bool async_ = false;
+    AsyncOptions options_;
+
+    std::vector<char> frontBuffer_;  ///< Pending records, filled by producers.
+    std::vector<char> backBuffer_;   ///< Records being written by the writer thread.
+    size_t frontUsed_ = 0;
+    size_t backUsed_ = 0;
+    bool writing_ = false;
+    bool stopping_ = false;
+
+    std::condition_variable dataAvailable_;   ///< Signals the writer thread.
+    std::condition_variable spaceAvailable_;  ///< Signals blocked producers and flush().
+    std::thread writerThread_;
+    std::string writerName_;  ///< Track name of the writer thread in a trace, e.g. "log lidar.bin"
+
+    std::atomic<uint64_t> droppedRecords_{0};
+    std::atomic<uint64_t> droppedBytes_{0};
 };
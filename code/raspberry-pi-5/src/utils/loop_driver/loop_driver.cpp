@@ -0,0 +1,65 @@
+#include "loop_driver.h"
+
+#include <algorithm>
+
+LoopDriver::LoopDriver(std::chrono::steady_clock::duration period)
+    : schedule_(period) {}
+
+void LoopDriver::addTrigger(const std::string &name, SequenceSource sequence) {
+    uint64_t current = sequence();
+    triggers_.push_back({name, std::move(sequence), current, 0});
+}
+
+UpdateSignal &LoopDriver::signal() {
+    return signal_;
+}
+
+bool LoopDriver::waitForTick() {
+    auto waitStart = std::chrono::steady_clock::now();
+
+    // The tick the fixed cadence would have started next
+    auto deadline = schedule_.nextDeadline();
+
+    bool triggered = signal_.waitUntil(deadline, [this] {
+        return std::any_of(triggers_.begin(), triggers_.end(), [](const Trigger &trigger) {
+            return trigger.sequence() != trigger.lastSeen;
+        });
+    });
+
+    auto now = std::chrono::steady_clock::now();
+    for (auto &trigger : triggers_) {
+        uint64_t current = trigger.sequence();
+        if (current != trigger.lastSeen) trigger.ticks += triggered ? 1 : 0;
+        trigger.lastSeen = current;
+    }
+
+    stats_.ticks++;
+    if (triggered) {
+        stats_.triggeredTicks++;
+        double saved_ms = std::max(0.0, std::chrono::duration<double, std::milli>(deadline - now).count());
+        stats_.savedTotal_ms += saved_ms;
+        stats_.savedMax_ms = std::max(stats_.savedMax_ms, saved_ms);
+
+        schedule_.restart(now);
+    } else {
+        schedule_.complete(now, waitStart);
+    }
+
+    return triggered;
+}
+
+LoopDriver::Stats LoopDriver::stats() const {
+    return stats_;
+}
+
+PeriodicStats LoopDriver::periodStats() const {
+    return schedule_.stats();
+}
+
+std::vector<std::pair<std::string, uint64_t>> LoopDriver::triggerCounts() const {
+    std::vector<std::pair<std::string, uint64_t>> counts;
+    for (const auto &trigger : triggers_) {
+        counts.emplace_back(trigger.name, trigger.ticks);
+    }
+    return counts;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "periodic_executor.h"
+#include "update_signal.hpp"
+
+/**
+ * @brief Paces a control loop on new sensor data instead of a fixed sleep.
+ *
+ * Each trigger is a sequence number source, such as LidarModule::sequence().
+ * The producers notify signal() (see LidarModule::setUpdateSignal()), and
+ * waitForTick() returns as soon as any trigger's sequence has moved, or once
+ * the period has elapsed since the previous tick. With no new data the loop
+ * keeps a fixed cadence on absolute deadlines (see PeriodicExecutor), and a
+ * fresh scan is handled right away instead of waiting out the rest of the period.
+ *
+ * For every tick started by a trigger, the driver records how much earlier it
+ * started than the fixed cadence would have, which is the latency saved.
+ *
+ * **Example usage:**
+ * @code
+ * LoopDriver loopDriver(std::chrono::milliseconds(33));
+ * loopDriver.addTrigger("lidar", [&] { return lidar.sequence(); });
+ * lidar.setUpdateSignal(&loopDriver.signal());
+ *
+ * while (running) {
+ *     loopDriver.waitForTick();
+ *     robot.update(dt);
+ * }
+ * @endcode
+ */
+class LoopDriver
+{
+public:
+    using SequenceSource = std::function<uint64_t()>;
+
+    /**
+     * @brief Counters of the ticks so far.
+     */
+    struct Stats {
+        uint64_t ticks = 0;           ///< Calls to waitForTick() that returned
+        uint64_t triggeredTicks = 0;  ///< Ticks started by new data from a trigger
+        double savedTotal_ms = 0.0;   ///< Sum of the time each triggered tick started before the fixed cadence would have
+        double savedMax_ms = 0.0;     ///< Largest single saving
+    };
+
+    /**
+     * @brief Create the driver.
+     * @param period Longest time between two ticks, the cadence of the loop without new data.
+     */
+    explicit LoopDriver(std::chrono::steady_clock::duration period);
+
+    LoopDriver(const LoopDriver &) = delete;
+    LoopDriver &operator=(const LoopDriver &) = delete;
+
+    /**
+     * @brief Start a tick whenever @p sequence moves past the value seen at the previous tick.
+     *
+     * Add every trigger before the first waitForTick().
+     *
+     * @param name Name used in the statistics.
+     * @param sequence Returns the producer's current sequence number.
+     */
+    void addTrigger(const std::string &name, SequenceSource sequence);
+
+    /**
+     * @brief The signal the trigger producers should notify after every new sample.
+     */
+    UpdateSignal &signal();
+
+    /**
+     * @brief Block until a trigger has new data or the period has elapsed since the previous tick.
+     * @return true if the tick was started by a trigger, false if by the period.
+     */
+    bool waitForTick();
+
+    /**
+     * @brief Tick counters and latency saved so far.
+     */
+    Stats stats() const;
+
+    /**
+     * @brief Overruns, lateness and jitter of the ticks started by the period rather than by a trigger.
+     */
+    PeriodicStats periodStats() const;
+
+    /**
+     * @brief Number of ticks each trigger started, in the order they were added.
+     */
+    std::vector<std::pair<std::string, uint64_t>> triggerCounts() const;
+
+private:
+    struct Trigger {
+        std::string name;
+        SequenceSource sequence;
+        uint64_t lastSeen;  ///< Sequence number at the previous tick
+        uint64_t ticks;     ///< Ticks this trigger started
+    };
+
+    PeriodicExecutor schedule_;  ///< Deadline of the next period tick; restarted by every triggered tick
+
+    UpdateSignal signal_;
+    std::vector<Trigger> triggers_;
+
+    Stats stats_;
+};
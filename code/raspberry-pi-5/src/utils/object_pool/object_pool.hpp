@@ -0,0 +1,134 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Hit/miss counters of an ObjectPool.
+ */
+struct PoolStats {
+    uint64_t hits = 0;    ///< acquire() calls served by a released object
+    uint64_t misses = 0;  ///< acquire() calls that had to allocate a new object
+    size_t size = 0;      ///< Objects owned by the pool
+};
+
+/**
+ * @brief A growing pool of reference-counted objects that are reused once every other holder has released them.
+ *
+ * The pool keeps one `std::shared_ptr` to each of its objects. An object is
+ * free again when that is the only reference left, i.e. when the ring buffer
+ * slots and every reader snapshot holding it have let go. Nothing has to be
+ * handed back explicitly, and readers keep using plain `std::shared_ptr`.
+ *
+ * Reused objects keep their previous contents, so a caller refilling them in
+ * place also reuses their heap storage (e.g. a vector's capacity). Once the
+ * pool has grown to the number of objects alive at the same time, acquire()
+ * no longer allocates.
+ *
+ * `acquire()` must only be called from one thread at a time; `stats()` may
+ * be called from any thread.
+ *
+ * @tparam T The pooled type. Must be default-constructible.
+ *
+ * **Example usage:**
+ * @code
+ * ObjectPool<std::vector<int>> pool;
+ * std::shared_ptr<std::vector<int>> item = pool.acquire();  // miss, allocates
+ * item->assign(100, 0);
+ * item.reset();                                             // released
+ * item = pool.acquire();                                    // hit, same vector, capacity kept
+ * @endcode
+ */
+template <typename T>
+class ObjectPool
+{
+public:
+    /**
+     * @brief Construct a pool.
+     * @param initialSize Number of objects to allocate up front.
+     */
+    explicit ObjectPool(size_t initialSize = 0);
+
+    ObjectPool(const ObjectPool &) = delete;
+    ObjectPool &operator=(const ObjectPool &) = delete;
+
+    /**
+     * @brief Get an object nobody else holds, allocating a new one if there is none.
+     * @return The object, with whatever contents it had when it was released.
+     */
+    std::shared_ptr<T> acquire();
+
+    /**
+     * @brief Like acquire(), but only hands out an object once @p claim accepts it.
+     *
+     * For objects that readers can still reach without holding a reference,
+     * such as the slots of a LockFreeRingBuffer: @p claim is called on every
+     * object nobody else held when it was checked, new ones included, and
+     * returns false to skip it. Such a reader may take a reference between
+     * that check and the claim, so @p claim gets the pool's own pointer to
+     * check use_count() again once it has shut the readers out.
+     *
+     * @param claim Callable taking `const std::shared_ptr<T> &` and returning `bool`. It must accept new objects.
+     */
+    template <typename Claim>
+    std::shared_ptr<T> acquire(Claim &&claim);
+
+    /**
+     * @brief Hit/miss counters and current pool size.
+     */
+    PoolStats stats() const;
+
+private:
+    std::vector<std::shared_ptr<T>> objects_;  ///< Every pooled object; use_count() == 1 means free
+    size_t next_ = 0;                          ///< Where the next search for a free object starts
+
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+    std::atomic<size_t> size_{0};
+};
+
+// ===== Definitions =====
+
+template <typename T>
+ObjectPool<T>::ObjectPool(size_t initialSize) {
+    objects_.reserve(initialSize);
+    for (size_t i = 0; i < initialSize; ++i) {
+        objects_.push_back(std::make_shared<T>());
+    }
+    size_.store(objects_.size(), std::memory_order_relaxed);
+}
+
+template <typename T>
+std::shared_ptr<T> ObjectPool<T>::acquire() {
+    return acquire([](T &) { return true; });
+}
+
+template <typename T>
+template <typename Claim>
+std::shared_ptr<T> ObjectPool<T>::acquire(Claim &&claim) {
+    // Start after the last object handed out, which is the least likely to be free again
+    for (size_t i = 0; i < objects_.size(); ++i) {
+        size_t index = (next_ + i) % objects_.size();
+        if (objects_[index].use_count() != 1) continue;
+
+        // The last other holder released it with a release decrement; see its writes before reusing it
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (!claim(objects_[index])) continue;
+        next_ = index + 1;
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return objects_[index];
+    }
+
+    objects_.push_back(std::make_shared<T>());
+    claim(objects_.back());
+    next_ = 0;
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    size_.store(objects_.size(), std::memory_order_relaxed);
+    return objects_.back();
+}
+
+template <typename T>
+PoolStats ObjectPool<T>::stats() const {
+    return {hits_.load(std::memory_order_relaxed), misses_.load(std::memory_order_relaxed), size_.load(std::memory_order_relaxed)};
+}
@@ -0,0 +1,92 @@
+#include "periodic_executor.h"
+
+#include <cerrno>
+#include <cmath>
+#include <ctime>
+
+namespace
+{
+
+timespec toTimespec(PeriodicExecutor::Clock::time_point timePoint) {
+    auto sinceEpoch = std::chrono::duration_cast<std::chrono::nanoseconds>(timePoint.time_since_epoch()).count();
+
+    timespec ts{};
+    ts.tv_sec = static_cast<time_t>(sinceEpoch / 1000000000);
+    ts.tv_nsec = static_cast<long>(sinceEpoch % 1000000000);
+    return ts;
+}
+
+double toMicroseconds(PeriodicExecutor::Clock::duration duration) {
+    return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+}  // namespace
+
+PeriodicExecutor::PeriodicExecutor(Clock::duration period)
+    : period_(period)
+    , deadline_(Clock::now() + period) {}
+
+bool PeriodicExecutor::waitForNextPeriod() {
+    auto waitStart = Clock::now();
+
+    if (waitStart < deadline_) {
+        // steady_clock is CLOCK_MONOTONIC on Linux, so its time points are absolute times on that clock
+        timespec deadline = toTimespec(deadline_);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {}
+    }
+
+    bool onTime = waitStart < deadline_;
+    complete(Clock::now(), waitStart);
+    return onTime;
+}
+
+PeriodicExecutor::Clock::time_point PeriodicExecutor::nextDeadline() const {
+    return deadline_;
+}
+
+void PeriodicExecutor::complete(Clock::time_point wake, Clock::time_point waitStart) {
+    periods_.fetch_add(1, std::memory_order_relaxed);
+
+    if (waitStart >= deadline_) {
+        overruns_.fetch_add(1, std::memory_order_relaxed);
+        lateness_us_.record(toMicroseconds(wake - deadline_));
+        hasLastWake_ = false;  // A late body, not a late wake-up: keep it out of the jitter
+
+        // Skip the periods that already went by instead of running a burst of late bodies
+        auto behind = wake - deadline_;
+        auto skipped = behind / period_;
+        missedPeriods_.fetch_add(static_cast<uint64_t>(skipped), std::memory_order_relaxed);
+        deadline_ += period_ * (skipped + 1);
+        return;
+    }
+
+    lateness_us_.record(toMicroseconds(wake - deadline_));
+    if (hasLastWake_) jitter_us_.record(std::abs(toMicroseconds(wake - lastWake_) - toMicroseconds(period_)));
+
+    lastWake_ = wake;
+    hasLastWake_ = true;
+    deadline_ += period_;
+}
+
+void PeriodicExecutor::restart(Clock::time_point from) {
+    deadline_ = from + period_;
+    hasLastWake_ = false;
+}
+
+PeriodicExecutor::Clock::duration PeriodicExecutor::period() const {
+    return period_;
+}
+
+PeriodicStats PeriodicExecutor::stats() const {
+    PeriodicStats stats;
+    stats.periods = periods_.load(std::memory_order_relaxed);
+    stats.overruns = overruns_.load(std::memory_order_relaxed);
+    stats.missedPeriods = missedPeriods_.load(std::memory_order_relaxed);
+    stats.latenessP50_us = lateness_us_.percentile(0.50);
+    stats.latenessP99_us = lateness_us_.percentile(0.99);
+    stats.latenessMax_us = lateness_us_.max();
+    stats.jitterP50_us = jitter_us_.percentile(0.50);
+    stats.jitterP99_us = jitter_us_.percentile(0.99);
+    stats.jitterMax_us = jitter_us_.max();
+    return stats;
+}
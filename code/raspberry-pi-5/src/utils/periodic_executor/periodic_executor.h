@@ -0,0 +1,116 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "histogram.hpp"
+
+/**
+ * @brief Timing statistics of a periodic loop, in microseconds.
+ */
+struct PeriodicStats {
+    uint64_t periods = 0;         ///< Deadlines reached
+    uint64_t overruns = 0;        ///< Deadlines already passed when the loop came back to wait (the work took too long)
+    uint64_t missedPeriods = 0;   ///< Whole periods skipped after overruns to get back on schedule
+    double latenessP50_us = 0.0;  ///< Median delay of the loop after its deadline, overruns included
+    double latenessP99_us = 0.0;  ///< 99th percentile of the same
+    double latenessMax_us = 0.0;  ///< Worst-case lateness
+    double jitterP50_us = 0.0;    ///< Median |interval - period| between consecutive wake-ups
+    double jitterP99_us = 0.0;    ///< 99th percentile of the same
+    double jitterMax_us = 0.0;    ///< Worst of the same
+};
+
+/**
+ * @brief Runs a loop at a fixed rate by sleeping until absolute deadlines.
+ *
+ * Every deadline is the previous one plus the period, so the time spent in
+ * the loop body and the wake-up delays never add up into drift, unlike
+ * `sleep_for(period - elapsed)`. The sleep is a clock_nanosleep() with
+ * TIMER_ABSTIME on CLOCK_MONOTONIC, the clock behind std::chrono::steady_clock.
+ *
+ * When the body takes longer than a period, the deadline has already passed
+ * by the time the loop waits again. That is an overrun: the executor returns
+ * at once, and skips whole periods rather than running several bodies back
+ * to back to catch up.
+ *
+ * Loops that wait on something else as well (see LoopDriver) can keep the
+ * schedule with nextDeadline(), complete() and restart() instead of
+ * waitForNextPeriod().
+ *
+ * Only the loop's thread may call the non-const methods; stats() may be
+ * called from any thread.
+ *
+ * **Example usage:**
+ * @code
+ * PeriodicExecutor executor(std::chrono::milliseconds(8));  // 125 Hz
+ * executor.restart();
+ * while (running) {
+ *     executor.waitForNextPeriod();
+ *     poll();
+ * }
+ * PeriodicStats stats = executor.stats();
+ * @endcode
+ */
+class PeriodicExecutor
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Create the executor. The first deadline is one period after construction, or after restart().
+     */
+    explicit PeriodicExecutor(Clock::duration period);
+
+    PeriodicExecutor(const PeriodicExecutor &) = delete;
+    PeriodicExecutor &operator=(const PeriodicExecutor &) = delete;
+
+    /**
+     * @brief Sleep until the next deadline, then move the deadline one period on.
+     * @return false if the deadline had already passed (an overrun), true otherwise.
+     */
+    bool waitForNextPeriod();
+
+    /**
+     * @brief The deadline the loop is waiting for.
+     */
+    Clock::time_point nextDeadline() const;
+
+    /**
+     * @brief Record a wake-up at @p wake for the current deadline, then move the deadline one period on.
+     *
+     * For loops that did the waiting themselves, e.g. on a condition variable until nextDeadline().
+     *
+     * @param wake When the loop woke up.
+     * @param waitStart When the loop started waiting. It is an overrun if the deadline had passed by then.
+     */
+    void complete(Clock::time_point wake, Clock::time_point waitStart);
+
+    /**
+     * @brief Start the schedule over: the next deadline is one period after @p from.
+     *
+     * For a loop woken early by an event. The interval up to the next wake-up is not counted as jitter.
+     */
+    void restart(Clock::time_point from = Clock::now());
+
+    /**
+     * @brief The period.
+     */
+    Clock::duration period() const;
+
+    /**
+     * @brief Overruns, and wake-up lateness and jitter percentiles, so far.
+     */
+    PeriodicStats stats() const;
+
+private:
+    Clock::duration period_;
+    Clock::time_point deadline_;
+    Clock::time_point lastWake_;
+    bool hasLastWake_ = false;  ///< lastWake_ ended a full period, so the next interval counts as jitter
+
+    std::atomic<uint64_t> periods_{0};
+    std::atomic<uint64_t> overruns_{0};
+    std::atomic<uint64_t> missedPeriods_{0};
+    Histogram lateness_us_{10.0, 5000};  ///< 10 us buckets up to 50 ms
+    Histogram jitter_us_{10.0, 5000};
+};
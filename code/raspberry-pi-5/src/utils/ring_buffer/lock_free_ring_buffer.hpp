@@ -0,0 +1,446 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "object_pool.hpp"
+
+/**
+ * @brief Immutable, reference-counted views of buffered elements, oldest first.
+ */
+template <typename T>
+using RingBufferSnapshot = std::vector<std::shared_ptr<const T>>;
+
+/**
+ * @brief A fixed-size circular buffer with one writer thread and any number of reader threads, without a lock.
+ *
+ * Drop-in for a `RingBuffer<T>` guarded by a `std::mutex` in the sensor modules.
+ * Each element is written into a slot taken from an `ObjectPool`, tagged with
+ * its index, and published by storing the slot's address in its cell with an
+ * atomic release store; only then is the write counter advanced. Readers load
+ * the counter, then the cells, pin each slot with an atomic counter while they
+ * check its tag and take a reference, and copy the elements without holding
+ * anything the writer waits for. Neither side ever blocks the other, and
+ * every atomic used is lock-free on the targets we build for.
+ *
+ * The writer only refills a slot that no reader references and no reader has
+ * pinned, so a reader can never see a partly written element. It first marks
+ * the slot claimed, which stops new pins, and only then checks the references,
+ * so a reader that shares the slot just before the claim is still seen. If the writer
+ * laps a reader while it is collecting (more than `capacity` pushes during one
+ * `getAll()`), the overwritten oldest elements are left out instead of being
+ * returned out of order.
+ *
+ * Besides copying (`latest()`, `getAll()`), readers can take a snapshot: the
+ * shared pointers themselves. A snapshot costs one reference count per
+ * element, whatever the size of `T`, and keeps those elements alive after
+ * the writer has overwritten their slots.
+ *
+ * Slots are recycled once they have dropped out of the buffer and out of every
+ * snapshot, so pushing stops allocating once the pool has warmed up.
+ * `pushRecycled()` goes further and fills the recycled element in place, so
+ * large elements also reuse their own storage. `T` must be default-constructible.
+ *
+ * `push()` and `pushRecycled()` must only be called from one thread at a time.
+ *
+ * @tparam T The type of elements stored in the buffer.
+ *
+ * **Example usage:**
+ * @code
+ * LockFreeRingBuffer<int> buffer(3);
+ * buffer.push(1);                // sensor thread
+ * auto latest = buffer.latest(); // any thread, returns 1
+ *
+ * RingBufferSnapshot<int> history;
+ * buffer.snapshot(history);      // shares the elements, no copies
+ * @endcode
+ *
+ * The time-windowed queries (`snapshotSince()`, `snapshotBetween()`) need a
+ * `timestamp` member on `T`, as on the `Timed*` sensor structs, and walk back
+ * from the newest element, so their cost follows the size of the result rather
+ * than the capacity.
+ */
+template <typename T>
+class LockFreeRingBuffer
+{
+public:
+    /**
+     * @brief Construct a ring buffer with a given capacity.
+     * @param capacity The maximum number of elements the buffer can hold.
+     * @throws std::invalid_argument if @p capacity is 0.
+     */
+    explicit LockFreeRingBuffer(size_t capacity);
+
+    /**
+     * @brief Add a new element to the buffer (copy version). Writer thread only.
+     *
+     * If the buffer is full, the oldest element is overwritten.
+     *
+     * @param item The element to be copied into the buffer.
+     */
+    void push(const T &item);
+
+    /**
+     * @brief Add a new element to the buffer (move version). Writer thread only.
+     *
+     * If the buffer is full, the oldest element is overwritten.
+     *
+     * @param item The element to be moved into the buffer.
+     */
+    void push(T &&item);
+
+    /**
+     * @brief Add a new element by filling a recycled one in place. Writer thread only.
+     *
+     * The element handed to @p fill is one nobody references anymore, or a new
+     * default-constructed one if there is none, and still holds its old
+     * contents, so resizing its containers reuses their storage.
+     *
+     * @param fill Callable taking `T &`, which must overwrite every field.
+     */
+    template <typename Fill>
+    void pushRecycled(Fill &&fill);
+
+    /**
+     * @brief Hit/miss counters of the slot pool used by push() and pushRecycled().
+     */
+    PoolStats poolStats() const;
+
+    /**
+     * @brief Retrieve the most recent element added to the buffer.
+     * @return The latest element, or `std::nullopt` if the buffer is empty.
+     */
+    std::optional<T> latest() const;
+
+    /**
+     * @brief Get all elements from oldest to newest.
+     * @return A vector containing all elements in chronological order.
+     */
+    std::vector<T> getAll() const;
+
+    /**
+     * @brief Share the most recent element without copying it.
+     * @return The latest element, or `nullptr` if the buffer is empty.
+     */
+    std::shared_ptr<const T> latestShared() const;
+
+    /**
+     * @brief Share all elements from oldest to newest without copying them.
+     *
+     * @param[out] out Replaced with the elements. Its capacity is reused, so a
+     *             caller that keeps the vector around does not allocate.
+     */
+    void snapshot(RingBufferSnapshot<T> &out) const;
+
+    /**
+     * @brief Share the newest @p count elements (or fewer), oldest first.
+     */
+    void snapshotLatest(size_t count, RingBufferSnapshot<T> &out) const;
+
+    /**
+     * @brief Share the elements that were the latest at some point since @p since, oldest first.
+     *
+     * That is every element newer than @p since, preceded by the newest element
+     * at or before it (the value that was current at @p since), if still buffered.
+     */
+    template <typename TimePoint>
+    void snapshotSince(TimePoint since, RingBufferSnapshot<T> &out) const;
+
+    /**
+     * @brief Share the elements that were the latest at some point in [@p from, @p to], oldest first.
+     *
+     * Like snapshotSince(), but also leaves out elements newer than @p to.
+     */
+    template <typename TimePoint>
+    void snapshotBetween(TimePoint from, TimePoint to, RingBufferSnapshot<T> &out) const;
+
+    /**
+     * @brief Call @p visitor with every element, oldest to newest, without copying them.
+     *
+     * Elements are loaded one at a time, so the visitor always sees a complete
+     * element, but the writer may push while the visit is in progress.
+     *
+     * @param visitor Callable taking `const T &`.
+     */
+    template <typename Visitor>
+    void forEach(Visitor &&visitor) const;
+
+    /**
+     * @brief Number of elements pushed so far, which is also the sequence number of the latest one (0 if none).
+     *
+     * Unlike size(), it keeps counting once the buffer is full, so a reader
+     * can tell whether anything was pushed since it last looked.
+     */
+    uint64_t sequence() const;
+
+    /**
+     * @brief Get the current number of elements stored in the buffer.
+     * @return Number of elements.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Check if the buffer is empty.
+     * @return `true` if no elements are stored, otherwise `false`.
+     */
+    bool empty() const;
+
+    /**
+     * @brief Check if the buffer is full.
+     * @return `true` if the number of stored elements equals the capacity, otherwise `false`.
+     */
+    bool full() const;
+
+private:
+    struct Slot {
+        static constexpr uint64_t CLAIMED = uint64_t(1) << 63;  ///< Set in `pins` while the writer refills the slot
+
+        std::atomic<uint64_t> pins{0};  ///< Readers checking the slot right now, plus CLAIMED while it is refilled
+        uint64_t index = 0;             ///< Position in the push order, so readers can tell a replaced slot apart
+        std::weak_ptr<Slot> self;       ///< The pool's reference, which readers share to keep the slot alive
+        T value;
+    };
+
+    /**
+     * @brief Take a slot from the pool that no reader references or has pinned, and mark it CLAIMED.
+     */
+    std::shared_ptr<Slot> claimSlot();
+
+    /**
+     * @brief Make a filled, claimed slot visible to readers as element `slot->index`.
+     */
+    void publish(std::shared_ptr<Slot> slot);
+
+    /**
+     * @brief Load element @p index, or `nullptr` if the writer has already replaced it.
+     */
+    std::shared_ptr<const T> load(uint64_t index) const;
+
+    /**
+     * @brief Walk back from the newest element, collecting those current at some point in [from, to]; without @p to, up to the newest.
+     */
+    template <typename TimePoint>
+    void snapshotWindow(TimePoint from, std::optional<TimePoint> to, RingBufferSnapshot<T> &out) const;
+
+    size_t capacity_;                               ///< Maximum number of elements the buffer can hold.
+    std::unique_ptr<std::atomic<Slot *>[]> cells_;  ///< Element `i` is published in cell `i % capacity_`.
+    std::vector<std::shared_ptr<Slot>> owned_;      ///< The buffer's reference to the slot of each cell; writer thread only.
+    std::atomic<uint64_t> written_{0};              ///< Number of elements pushed so far.
+    ObjectPool<Slot> pool_;                         ///< Every slot; writer thread only.
+};
+
+// ===== Definitions =====
+
+template <typename T>
+LockFreeRingBuffer<T>::LockFreeRingBuffer(size_t capacity)
+    : capacity_(capacity)
+    , cells_(new std::atomic<Slot *>[capacity]())
+    , owned_(capacity)
+    , pool_(capacity + 1) {
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<Slot *>::is_always_lock_free);
+    if (capacity == 0) throw std::invalid_argument("LockFreeRingBuffer: capacity must be at least 1");
+}
+
+template <typename T>
+void LockFreeRingBuffer<T>::push(const T &item) {
+    pushRecycled([&item](T &value) { value = item; });
+}
+
+template <typename T>
+void LockFreeRingBuffer<T>::push(T &&item) {
+    pushRecycled([&item](T &value) { value = std::move(item); });
+}
+
+template <typename T>
+template <typename Fill>
+void LockFreeRingBuffer<T>::pushRecycled(Fill &&fill) {
+    std::shared_ptr<Slot> slot = claimSlot();
+    slot->index = written_.load(std::memory_order_relaxed);
+    fill(slot->value);
+    publish(std::move(slot));
+}
+
+template <typename T>
+std::shared_ptr<typename LockFreeRingBuffer<T>::Slot> LockFreeRingBuffer<T>::claimSlot() {
+    std::shared_ptr<Slot> slot = pool_.acquire([](const std::shared_ptr<Slot> &candidate) {
+        // Fails while a reader that loaded the slot before it left the buffer is still checking it
+        uint64_t unpinned = 0;
+        if (!candidate->pins.compare_exchange_strong(unpinned, Slot::CLAIMED, std::memory_order_acquire, std::memory_order_relaxed)) {
+            return false;
+        }
+
+        // Such a reader may have pinned the slot, taken a reference and unpinned it after the pool found it free. Its
+        // unpin comes before our claim, so its reference shows here; readers pinning it from now on see CLAIMED.
+        if (candidate.use_count() != 1) {
+            candidate->pins.fetch_sub(Slot::CLAIMED, std::memory_order_relaxed);
+            return false;
+        }
+        // The reference may also have been dropped meanwhile; see the reader's last use before refilling the slot
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+    });
+    if (slot->self.expired()) slot->self = slot;  // New slot, never seen by a reader
+    return slot;
+}
+
+template <typename T>
+void LockFreeRingBuffer<T>::publish(std::shared_ptr<Slot> slot) {
+    uint64_t index = slot->index;
+    size_t cell = index % capacity_;
+
+    // Readers that pin the slot from now on see its new contents
+    slot->pins.fetch_sub(Slot::CLAIMED, std::memory_order_release);
+    cells_[cell].store(slot.get(), std::memory_order_release);
+    owned_[cell] = std::move(slot);  // Drops the buffer's reference to the element it replaces
+    written_.store(index + 1, std::memory_order_release);
+}
+
+template <typename T>
+PoolStats LockFreeRingBuffer<T>::poolStats() const {
+    return pool_.stats();
+}
+
+template <typename T>
+std::optional<T> LockFreeRingBuffer<T>::latest() const {
+    std::shared_ptr<const T> item = latestShared();
+    if (!item) return std::nullopt;
+    return *item;
+}
+
+template <typename T>
+std::shared_ptr<const T> LockFreeRingBuffer<T>::latestShared() const {
+    while (true) {
+        uint64_t written = written_.load(std::memory_order_acquire);
+        if (written == 0) return nullptr;
+
+        // Only fails if the writer has lapped us meanwhile, and then there is an even newer element
+        if (std::shared_ptr<const T> item = load(written - 1)) return item;
+    }
+}
+
+template <typename T>
+void LockFreeRingBuffer<T>::snapshot(RingBufferSnapshot<T> &out) const {
+    uint64_t end = written_.load(std::memory_order_acquire);
+    uint64_t begin = end > capacity_ ? end - capacity_ : 0;
+
+    out.clear();
+    out.reserve(end - begin);
+    for (uint64_t i = begin; i < end; ++i) {
+        // Elements lapped by the writer meanwhile are the oldest ones, so skipping them keeps the order
+        if (std::shared_ptr<const T> item = load(i)) out.push_back(std::move(item));
+    }
+}
+
+template <typename T>
+std::shared_ptr<const T> LockFreeRingBuffer<T>::load(uint64_t index) const {
+    Slot *slot = cells_[index % capacity_].load(std::memory_order_acquire);
+    if (!slot) return nullptr;
+
+    // Slots are only freed with the pool, so the pointer stays valid even if the slot has left the buffer.
+    // While pinned, the writer cannot claim it, so its tag and element hold still until we share it.
+    std::shared_ptr<Slot> owner;
+    uint64_t pins = slot->pins.fetch_add(1, std::memory_order_acquire);
+    if (!(pins & Slot::CLAIMED) && slot->index == index) owner = slot->self.lock();
+    slot->pins.fetch_sub(1, std::memory_order_release);
+    if (!owner) return nullptr;
+
+    // Shares ownership of the slot, but points at the element inside it
+    return std::shared_ptr<const T>(owner, &slot->value);
+}
+
+template <typename T>
+void LockFreeRingBuffer<T>::snapshotLatest(size_t count, RingBufferSnapshot<T> &out) const {
+    uint64_t end = written_.load(std::memory_order_acquire);
+    uint64_t begin = end > count ? end - count : 0;
+    if (end - begin > capacity_) begin = end - capacity_;
+
+    out.clear();
+    for (uint64_t i = end; i > begin; --i) {
+        std::shared_ptr<const T> item = load(i - 1);
+        if (!item) break;  // Lapped; older elements are gone too
+        out.push_back(std::move(item));
+    }
+    std::reverse(out.begin(), out.end());
+}
+
+template <typename T>
+template <typename TimePoint>
+void LockFreeRingBuffer<T>::snapshotSince(TimePoint since, RingBufferSnapshot<T> &out) const {
+    snapshotWindow<TimePoint>(since, std::nullopt, out);
+}
+
+template <typename T>
+template <typename TimePoint>
+void LockFreeRingBuffer<T>::snapshotBetween(TimePoint from, TimePoint to, RingBufferSnapshot<T> &out) const {
+    snapshotWindow<TimePoint>(from, to, out);
+}
+
+template <typename T>
+template <typename TimePoint>
+void LockFreeRingBuffer<T>::snapshotWindow(TimePoint from, std::optional<TimePoint> to, RingBufferSnapshot<T> &out) const {
+    uint64_t end = written_.load(std::memory_order_acquire);
+    uint64_t begin = end > capacity_ ? end - capacity_ : 0;
+
+    out.clear();
+    for (uint64_t i = end; i > begin; --i) {
+        std::shared_ptr<const T> item = load(i - 1);
+        if (!item) break;  // Lapped; older elements are gone too
+        if (to && item->timestamp > *to) continue;
+
+        bool reachedFrom = item->timestamp <= from;
+        out.push_back(std::move(item));
+        if (reachedFrom) break;
+    }
+    std::reverse(out.begin(), out.end());
+}
+
+template <typename T>
+template <typename Visitor>
+void LockFreeRingBuffer<T>::forEach(Visitor &&visitor) const {
+    uint64_t end = written_.load(std::memory_order_acquire);
+    uint64_t begin = end > capacity_ ? end - capacity_ : 0;
+
+    for (uint64_t i = begin; i < end; ++i) {
+        std::shared_ptr<const T> item = load(i);
+        if (item) visitor(*item);
+    }
+}
+
+template <typename T>
+std::vector<T> LockFreeRingBuffer<T>::getAll() const {
+    RingBufferSnapshot<T> items;
+    snapshot(items);
+
+    std::vector<T> result;
+    result.reserve(items.size());
+    for (const auto &item : items) {
+        result.push_back(*item);
+    }
+    return result;
+}
+
+template <typename T>
+uint64_t LockFreeRingBuffer<T>::sequence() const {
+    return written_.load(std::memory_order_acquire);
+}
+
+template <typename T>
+size_t LockFreeRingBuffer<T>::size() const {
+    uint64_t written = written_.load(std::memory_order_acquire);
+    return written < capacity_ ? static_cast<size_t>(written) : capacity_;
+}
+
+template <typename T>
+bool LockFreeRingBuffer<T>::empty() const {
+    return written_.load(std::memory_order_acquire) == 0;
+}
+
+template <typename T>
+bool LockFreeRingBuffer<T>::full() const {
+    return written_.load(std::memory_order_acquire) >= capacity_;
+}
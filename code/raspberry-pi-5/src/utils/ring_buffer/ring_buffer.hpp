@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 #include <optional>
 #include <vector>
 
@@ -21,6 +22,9 @@
  * auto latest = buffer.latest(); // returns 4
  * auto all = buffer.getAll();    // returns {2, 3, 4}
  * @endcode
+ *
+ * The time-windowed queries (`getSince()`, `getBetween()`) need a `timestamp`
+ * member on `T`, as on the `Timed*` sensor structs.
  */
 template <typename T>
 class RingBuffer
@@ -62,6 +66,35 @@ public:
      */
     std::vector<T> getAll() const;
 
+    /**
+     * @brief Get the newest @p count elements (or fewer), oldest first.
+     */
+    std::vector<T> getLatest(size_t count) const;
+
+    /**
+     * @brief Get the elements that were the latest at some point since @p since, oldest first.
+     *
+     * That is every element newer than @p since, preceded by the newest element
+     * at or before it (the value that was current at @p since), if still buffered.
+     */
+    template <typename TimePoint>
+    std::vector<T> getSince(TimePoint since) const;
+
+    /**
+     * @brief Get the elements that were the latest at some point in [@p from, @p to], oldest first.
+     *
+     * Like getSince(), but also leaves out elements newer than @p to.
+     */
+    template <typename TimePoint>
+    std::vector<T> getBetween(TimePoint from, TimePoint to) const;
+
+    /**
+     * @brief Call @p visitor with every element, oldest to newest, without copying them.
+     * @param visitor Callable taking `const T &`.
+     */
+    template <typename Visitor>
+    void forEach(Visitor &&visitor) const;
+
     /**
      * @brief Get the current number of elements stored in the buffer.
      * @return Number of elements.
@@ -81,6 +114,17 @@ public:
     bool full() const;
 
 private:
+    /**
+     * @brief Element @p i counted from the oldest one.
+     */
+    const T &at(size_t i) const;
+
+    /**
+     * @brief Copy the elements current at some point in [from, to]; without @p to, up to the newest.
+     */
+    template <typename TimePoint>
+    std::vector<T> getWindow(TimePoint from, std::optional<TimePoint> to) const;
+
     size_t capacity_;        ///< Maximum number of elements the buffer can hold.
     std::vector<T> buffer_;  ///< Internal storage for elements.
     size_t head_;            ///< Index where the next element will be written.
@@ -128,6 +172,64 @@ std::vector<T> RingBuffer<T>::getAll() const {
     return result;
 }
 
+template <typename T>
+const T &RingBuffer<T>::at(size_t i) const {
+    return buffer_[(head_ + capacity_ - size_ + i) % capacity_];
+}
+
+template <typename T>
+std::vector<T> RingBuffer<T>::getLatest(size_t count) const {
+    size_t first = size_ > count ? size_ - count : 0;
+
+    std::vector<T> result;
+    result.reserve(size_ - first);
+    for (size_t i = first; i < size_; ++i) {
+        result.push_back(at(i));
+    }
+    return result;
+}
+
+template <typename T>
+template <typename TimePoint>
+std::vector<T> RingBuffer<T>::getSince(TimePoint since) const {
+    return getWindow<TimePoint>(since, std::nullopt);
+}
+
+template <typename T>
+template <typename TimePoint>
+std::vector<T> RingBuffer<T>::getBetween(TimePoint from, TimePoint to) const {
+    return getWindow<TimePoint>(from, to);
+}
+
+template <typename T>
+template <typename TimePoint>
+std::vector<T> RingBuffer<T>::getWindow(TimePoint from, std::optional<TimePoint> to) const {
+    // Walk back from the newest element so only the window itself is scanned
+    size_t last = size_;
+    while (last > 0 && to && at(last - 1).timestamp > *to) --last;
+
+    size_t first = last;
+    while (first > 0) {
+        --first;
+        if (at(first).timestamp <= from) break;
+    }
+
+    std::vector<T> result;
+    result.reserve(last - first);
+    for (size_t i = first; i < last; ++i) {
+        result.push_back(at(i));
+    }
+    return result;
+}
+
+template <typename T>
+template <typename Visitor>
+void RingBuffer<T>::forEach(Visitor &&visitor) const {
+    for (size_t i = 0; i < size_; ++i) {
+        visitor(at(i));
+    }
+}
+
 template <typename T>
 size_t RingBuffer<T>::size() const {
     return size_;
@@ -0,0 +1,114 @@
+#include "stage_profiler.h"
+
+#include <filesystem>
+#include <iostream>
+
+StageProfiler::StageProfiler(const std::vector<std::string> &stageNames, double bucketWidth_us, size_t bucketCount)
+    : names_(stageNames)
+    , allocations_(std::make_unique<std::atomic<uint64_t>[]>(stageNames.size()))
+    , allocatedBytes_(std::make_unique<std::atomic<uint64_t>[]>(stageNames.size())) {
+    histograms_.reserve(names_.size());
+    for (size_t i = 0; i < names_.size(); ++i) {
+        histograms_.push_back(std::make_unique<Histogram>(bucketWidth_us, bucketCount));
+    }
+}
+
+StageProfiler::~StageProfiler() {
+    stopReporting();
+}
+
+void StageProfiler::record(StageId stage, std::chrono::steady_clock::duration duration) {
+    histograms_[stage]->record(std::chrono::duration<double, std::micro>(duration).count());
+}
+
+void StageProfiler::recordAllocations(StageId stage, const AllocCounts &counts) {
+    allocations_[stage].fetch_add(counts.allocations, std::memory_order_relaxed);
+    allocatedBytes_[stage].fetch_add(counts.bytes, std::memory_order_relaxed);
+}
+
+const char *StageProfiler::name(StageId stage) const {
+    return names_[stage].c_str();
+}
+
+std::vector<StageStats> StageProfiler::stats() const {
+    std::vector<StageStats> result;
+    result.reserve(names_.size());
+    for (size_t i = 0; i < names_.size(); ++i) {
+        const Histogram &histogram = *histograms_[i];
+        StageStats stage{
+            names_[i],
+            histogram.count(),
+            histogram.mean(),
+            histogram.percentile(0.50),
+            histogram.percentile(0.99),
+            histogram.max()
+        };
+        if (stage.count > 0) {
+            stage.allocations = static_cast<double>(allocations_[i].load(std::memory_order_relaxed)) / stage.count;
+            stage.allocatedBytes = static_cast<double>(allocatedBytes_[i].load(std::memory_order_relaxed)) / stage.count;
+        }
+        result.push_back(stage);
+    }
+    return result;
+}
+
+bool StageProfiler::startReporting(const std::string &path, std::chrono::milliseconds interval) {
+    if (reportThread_.joinable()) {
+        std::cerr << "[StageProfiler] Already reporting." << std::endl;
+        return false;
+    }
+
+    bool newFile = !std::filesystem::exists(path);
+    reportFile_.open(path, std::ios::app);
+    if (!reportFile_) {
+        std::cerr << "[StageProfiler] Failed to open " << path << std::endl;
+        return false;
+    }
+    if (newFile) reportFile_ << "elapsed_s,stage,count,mean_us,p50_us,p99_us,max_us,allocs_per_run,bytes_per_run\n";
+
+    reportInterval_ = interval;
+    reportStart_ = std::chrono::steady_clock::now();
+    stopping_ = false;
+    reportThread_ = std::thread(&StageProfiler::reportLoop, this);
+    return true;
+}
+
+void StageProfiler::stopReporting() {
+    if (!reportThread_.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(reportMutex_);
+        stopping_ = true;
+    }
+    reportWake_.notify_all();
+    reportThread_.join();
+    reportFile_.close();
+}
+
+void StageProfiler::reportLoop() {
+    std::unique_lock<std::mutex> lock(reportMutex_);
+    while (!stopping_) {
+        reportWake_.wait_for(lock, reportInterval_, [this] { return stopping_; });
+        writeSnapshot();
+    }
+}
+
+void StageProfiler::writeSnapshot() {
+    double elapsed_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - reportStart_).count();
+    for (const StageStats &stage : stats()) {
+        reportFile_ << elapsed_s << ',' << stage.name << ',' << stage.count << ',' << stage.mean_us << ',' << stage.p50_us << ','
+                    << stage.p99_us << ',' << stage.max_us << ',' << stage.allocations << ',' << stage.allocatedBytes << '\n';
+    }
+    reportFile_.flush();
+}
+
+ScopedStageTimer::ScopedStageTimer(StageProfiler &profiler, StageProfiler::StageId stage)
+    : profiler_(profiler)
+    , stage_(stage)
+    , trace_(profiler.name(stage))
+    , start_(std::chrono::steady_clock::now()) {}
+
+ScopedStageTimer::~ScopedStageTimer() {
+    profiler_.record(stage_, std::chrono::steady_clock::now() - start_);
+    profiler_.recordAllocations(stage_, allocations_.counts());
+}
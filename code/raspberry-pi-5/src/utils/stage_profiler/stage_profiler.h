@@ -0,0 +1,170 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "alloc_counter.h"
+#include "histogram.hpp"
+#include "trace.h"
+
+/**
+ * @brief Latency statistics of one stage, in microseconds.
+ */
+struct StageStats {
+    std::string name;             ///< Stage name given to the profiler
+    uint64_t count = 0;           ///< Runs timed
+    double mean_us = 0.0;         ///< Mean duration
+    double p50_us = 0.0;          ///< Median duration, at bucket resolution
+    double p99_us = 0.0;          ///< 99th percentile, at bucket resolution
+    double max_us = 0.0;          ///< Longest run
+    double allocations = 0.0;     ///< Mean heap allocations per run, on the thread that ran the stage
+    double allocatedBytes = 0.0;  ///< Mean bytes allocated per run
+};
+
+/**
+ * @brief Per-stage latency histograms, cheap enough to leave on in competition runs.
+ *
+ * Stages are fixed at construction and identified by their index, typically
+ * an enum of the app. Timing a stage costs two steady_clock reads and a few
+ * relaxed atomic operations (well under a microsecond), never locks and never
+ * allocates, so stages may be timed from any thread, including the workers
+ * of a TaskGraph. A ScopedStageTimer also counts the heap allocations made
+ * during the stage on its thread (see alloc_counter).
+ *
+ * startReporting() appends a snapshot of every stage to a CSV file at a
+ * fixed interval from a background thread, so a run leaves its timing
+ * next to its logs even if it is cut short.
+ *
+ * **Example usage:**
+ * @code
+ * enum Stage { FILTER_LIDAR_DATA, GET_LINES, STAGE_COUNT };
+ * StageProfiler profiler({"filterLidarData", "getLines"});
+ * profiler.startReporting(logFolder + "/stage_latency.csv", std::chrono::seconds(5));
+ *
+ * auto filtered = profiler.measure(FILTER_LIDAR_DATA, [&] { return lidar_processor::filterLidarData(scan); });
+ * {
+ *     ScopedStageTimer timer(profiler, GET_LINES);
+ *     lines = lidar_processor::getLines(filtered, ...);
+ * }
+ * @endcode
+ */
+class StageProfiler
+{
+public:
+    using StageId = size_t;
+
+    /**
+     * @brief Create a histogram for every stage.
+     * @param stageNames Name of each stage; a stage's id is its index.
+     * @param bucketWidth_us Histogram resolution.
+     * @param bucketCount Number of buckets; longer runs are counted in an overflow bucket.
+     */
+    explicit StageProfiler(const std::vector<std::string> &stageNames, double bucketWidth_us = 10.0, size_t bucketCount = 5000);
+
+    /**
+     * @brief Stop reporting, writing a final snapshot.
+     */
+    ~StageProfiler();
+
+    StageProfiler(const StageProfiler &) = delete;
+    StageProfiler &operator=(const StageProfiler &) = delete;
+
+    /**
+     * @brief Add one run of @p stage. Safe from any thread.
+     */
+    void record(StageId stage, std::chrono::steady_clock::duration duration);
+
+    /**
+     * @brief Add the allocations of one run of @p stage. Safe from any thread.
+     */
+    void recordAllocations(StageId stage, const AllocCounts &counts);
+
+    /**
+     * @brief Call @p function and record how long it took as a run of @p stage.
+     * @return What @p function returns.
+     */
+    template <typename Function>
+    decltype(auto) measure(StageId stage, Function &&function);
+
+    /**
+     * @brief Name of @p stage. The string lives as long as the profiler.
+     */
+    const char *name(StageId stage) const;
+
+    /**
+     * @brief Count, mean, p50, p99 and max of every stage, in stage order.
+     */
+    std::vector<StageStats> stats() const;
+
+    /**
+     * @brief Append a snapshot of every stage to a CSV file every @p interval, from a background thread.
+     *
+     * Start it before the calling thread gets a real-time configuration, since the
+     * reporting thread inherits it.
+     *
+     * @return false if the file cannot be opened or reporting is already running.
+     */
+    bool startReporting(const std::string &path, std::chrono::milliseconds interval);
+
+    /**
+     * @brief Write a final snapshot and stop the reporting thread.
+     */
+    void stopReporting();
+
+private:
+    void reportLoop();
+    void writeSnapshot();
+
+    std::vector<std::string> names_;
+    std::vector<std::unique_ptr<Histogram>> histograms_;
+    std::unique_ptr<std::atomic<uint64_t>[]> allocations_;     ///< Per stage, since construction
+    std::unique_ptr<std::atomic<uint64_t>[]> allocatedBytes_;  ///< Per stage, since construction
+
+    std::thread reportThread_;
+    std::mutex reportMutex_;
+    std::condition_variable reportWake_;
+    bool stopping_ = false;
+    std::chrono::milliseconds reportInterval_{0};
+    std::ofstream reportFile_;
+    std::chrono::steady_clock::time_point reportStart_;
+};
+
+/**
+ * @brief Records the time from its construction to its destruction as one run of a stage,
+ * together with the allocations the calling thread made in that time.
+ *
+ * While tracing is on, the run is also a span named after the stage on the calling thread's trace track.
+ */
+class ScopedStageTimer
+{
+public:
+    ScopedStageTimer(StageProfiler &profiler, StageProfiler::StageId stage);
+    ~ScopedStageTimer();
+
+    ScopedStageTimer(const ScopedStageTimer &) = delete;
+    ScopedStageTimer &operator=(const ScopedStageTimer &) = delete;
+
+private:
+    StageProfiler &profiler_;
+    StageProfiler::StageId stage_;
+    trace::ScopedTrace trace_;
+    ScopedAllocCounter allocations_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// ===== Definitions =====
+
+template <typename Function>
+decltype(auto) StageProfiler::measure(StageId stage, Function &&function) {
+    // The timer stops after the result is constructed
+    ScopedStageTimer timer(*this, stage);
+    return std::forward<Function>(function)();
+}
@@ -0,0 +1,215 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.hpp"
+
+/**
+ * @brief A fixed graph of stages (a DAG) that runs once per call to run(), spread over a persistent ThreadPool.
+ *
+ * Nodes are declared once, with the nodes they depend on, and run() executes
+ * the whole graph every control tick: a node starts as soon as all of its
+ * dependencies have finished, so independent stages (e.g. camera color masks
+ * and lidar line extraction) run at the same time. The calling thread takes
+ * part instead of idling, and a finished node carries on with one of the
+ * nodes it unblocked itself, so a chain of stages stays on one thread.
+ *
+ * Nodes share data through state they capture (typically members of the
+ * owner), and every write made by a node is visible to the nodes depending
+ * on it and to the caller once run() returns.
+ *
+ * run() must not be called from a worker of the same pool, nor from two
+ * threads at once. Declaring nodes allocates, and reserves room in the pool's
+ * queue for every node. run() itself then does not allocate, as long as the
+ * node callables fit in std::function's small buffer (e.g. `[this]`) and
+ * nothing else fills the pool's queue at the same time.
+ *
+ * **Example usage:**
+ * @code
+ * ThreadPool pool(2);
+ * TaskGraph graph(pool);
+ * auto lines = graph.addNode("lines", [this] { lines_ = getLines(scan_); });
+ * auto masks = graph.addNode("masks", [this] { masks_ = filterColors(frame_); });
+ * graph.addNode("points", [this] { points_ = getPoints(lines_); }, {lines});
+ *
+ * graph.run();  // lines -> points on one thread, masks on another
+ * fuse(masks_, points_);
+ * @endcode
+ */
+class TaskGraph
+{
+public:
+    using NodeId = size_t;
+
+    /**
+     * @brief Create an empty graph.
+     * @param pool Workers running the nodes the calling thread does not. Must outlive the graph.
+     */
+    explicit TaskGraph(ThreadPool &pool);
+
+    TaskGraph(const TaskGraph &) = delete;
+    TaskGraph &operator=(const TaskGraph &) = delete;
+
+    /**
+     * @brief Declare a node.
+     *
+     * @param name Name of the stage, for diagnostics.
+     * @param work Runs once per run(), after every node in @p dependencies.
+     * @param dependencies Nodes that must finish first. They must already be declared, so the graph stays acyclic.
+     * @return Id to list this node as a dependency of later nodes.
+     * @throws std::out_of_range If a dependency has not been declared.
+     */
+    NodeId addNode(const std::string &name, std::function<void()> work, const std::vector<NodeId> &dependencies = {});
+
+    /**
+     * @brief Run every node once and wait for all of them.
+     *
+     * If a node throws, the nodes that have not started yet are skipped and
+     * the first exception is rethrown here once the running ones have finished.
+     */
+    void run();
+
+    /**
+     * @brief Number of declared nodes.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Name given to a node by addNode().
+     */
+    const std::string &name(NodeId node) const;
+
+private:
+    static constexpr NodeId NO_NODE = std::numeric_limits<NodeId>::max();
+
+    struct Node {
+        std::string name;
+        std::function<void()> work;
+        std::vector<NodeId> dependents;  ///< Nodes waiting on this one
+        size_t dependencyCount;          ///< Number of nodes this one waits on
+    };
+
+    /**
+     * @brief Run @p node, then whichever of the nodes it unblocks comes first, and so on.
+     *
+     * The other unblocked nodes are posted to the pool.
+     */
+    void execute(NodeId node);
+
+    ThreadPool &pool_;
+    std::vector<Node> nodes_;
+    std::vector<NodeId> roots_;  ///< Nodes without dependencies, started by run()
+
+    std::unique_ptr<std::atomic<size_t>[]> pending_;  ///< Per node: dependencies not finished yet in the current run
+    std::atomic<size_t> remaining_{0};                ///< Nodes not finished yet in the current run
+    std::atomic<bool> failed_{false};                 ///< A node threw; the rest are skipped
+
+    std::mutex mutex_;
+    std::condition_variable finished_;
+    bool done_ = false;         ///< Set by the last node of a run, under mutex_
+    std::exception_ptr error_;  ///< First exception of the current run, under mutex_
+};
+
+// ===== Definitions =====
+
+inline TaskGraph::TaskGraph(ThreadPool &pool)
+    : pool_(pool) {}
+
+inline TaskGraph::NodeId TaskGraph::addNode(const std::string &name, std::function<void()> work, const std::vector<NodeId> &dependencies) {
+    NodeId id = nodes_.size();
+    for (NodeId dependency : dependencies) {
+        if (dependency >= id) throw std::out_of_range("TaskGraph: node '" + name + "' depends on an undeclared node");
+    }
+
+    nodes_.push_back({name, std::move(work), {}, dependencies.size()});
+    for (NodeId dependency : dependencies) {
+        nodes_[dependency].dependents.push_back(id);
+    }
+    if (dependencies.empty()) roots_.push_back(id);
+
+    pending_ = std::make_unique<std::atomic<size_t>[]>(nodes_.size());
+    pool_.reserve(nodes_.size());  // At most every node but the first is posted in one run
+    return id;
+}
+
+inline void TaskGraph::run() {
+    if (nodes_.empty()) return;
+
+    for (NodeId id = 0; id < nodes_.size(); ++id) {
+        pending_[id].store(nodes_[id].dependencyCount, std::memory_order_relaxed);
+    }
+    remaining_.store(nodes_.size(), std::memory_order_relaxed);
+    failed_.store(false, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = false;
+        error_ = nullptr;
+    }
+
+    // The mutex above publishes the reset counters to the workers picking up the posted roots
+    for (size_t i = 1; i < roots_.size(); ++i) {
+        NodeId root = roots_[i];
+        pool_.post([this, root] { execute(root); });
+    }
+    execute(roots_.front());
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        finished_.wait(lock, [this] { return done_; });
+        error = std::exchange(error_, nullptr);
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+inline size_t TaskGraph::size() const {
+    return nodes_.size();
+}
+
+inline const std::string &TaskGraph::name(NodeId node) const {
+    return nodes_.at(node).name;
+}
+
+inline void TaskGraph::execute(NodeId node) {
+    while (node != NO_NODE) {
+        if (!failed_.load(std::memory_order_relaxed)) {
+            try {
+                nodes_[node].work();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!error_) error_ = std::current_exception();
+                failed_.store(true, std::memory_order_relaxed);
+            }
+        }
+
+        NodeId next = NO_NODE;
+        for (NodeId dependent : nodes_[node].dependents) {
+            // acq_rel: the last dependency to finish sees the writes of all the others
+            if (pending_[dependent].fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+
+            if (next == NO_NODE) {
+                next = dependent;
+            } else {
+                pool_.post([this, dependent] { execute(dependent); });
+            }
+        }
+
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // Notify under the lock so run() cannot return, and the graph go away, before this thread lets go of it
+            std::lock_guard<std::mutex> lock(mutex_);
+            done_ = true;
+            finished_.notify_all();
+        }
+        node = next;
+    }
+}
@@ -0,0 +1,102 @@
+#include "thread_config.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+bool applyThreadConfig(const ThreadConfig &config) {
+    bool ok = true;
+    pthread_t self = pthread_self();
+
+    if (!config.name.empty()) {
+        // The kernel limit is 16 bytes including the terminator
+        std::string name = config.name.substr(0, 15);
+        int error = pthread_setname_np(self, name.c_str());
+        if (error != 0) {
+            std::cerr << "[ThreadConfig] Failed to name thread '" << name << "': " << std::strerror(error) << std::endl;
+            ok = false;
+        }
+    }
+
+    const std::string label = config.name.empty() ? "thread" : "'" + config.name + "'";
+
+    if (!config.cpus.empty()) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (int cpu : config.cpus) {
+            CPU_SET(cpu, &cpus);
+        }
+        int error = pthread_setaffinity_np(self, sizeof(cpus), &cpus);
+        if (error != 0) {
+            std::cerr << "[ThreadConfig] Failed to set CPU affinity of " << label << ": " << std::strerror(error) << std::endl;
+            ok = false;
+        }
+    }
+
+    if (config.policy != SchedulingPolicy::INHERIT) {
+        int policy = config.policy == SchedulingPolicy::FIFO ? SCHED_FIFO : SCHED_OTHER;
+        sched_param param{};
+        if (policy == SCHED_FIFO) {
+            param.sched_priority = std::clamp(config.priority, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+        }
+        int error = pthread_setschedparam(self, policy, &param);
+        if (error != 0) {
+            std::cerr << "[ThreadConfig] Failed to set scheduling policy of " << label << ": " << std::strerror(error)
+                      << (error == EPERM ? " (needs root or CAP_SYS_NICE)" : "") << std::endl;
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+bool lockProcessMemory() {
+    rlimit limit{};
+    if (geteuid() != 0 && getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+        std::cerr << "[ThreadConfig] Not locking memory: RLIMIT_MEMLOCK is limited, future allocations could fail" << std::endl;
+        return false;
+    }
+
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        std::cerr << "[ThreadConfig] Failed to lock memory: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+void JitterMeter::mark() {
+    auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (last_) {
+        double interval_ms = std::chrono::duration<double, std::milli>(now - *last_).count();
+
+        count_++;
+        double delta = interval_ms - mean_ms_;
+        mean_ms_ += delta / count_;
+        m2_ += delta * (interval_ms - mean_ms_);
+
+        min_ms_ = count_ == 1 ? interval_ms : std::min(min_ms_, interval_ms);
+        max_ms_ = count_ == 1 ? interval_ms : std::max(max_ms_, interval_ms);
+    }
+    last_ = now;
+}
+
+JitterStats JitterMeter::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    JitterStats stats;
+    stats.intervals = count_;
+    stats.mean_ms = mean_ms_;
+    stats.stddev_ms = count_ > 1 ? std::sqrt(m2_ / (count_ - 1)) : 0.0;
+    stats.min_ms = min_ms_;
+    stats.max_ms = max_ms_;
+    return stats;
+}
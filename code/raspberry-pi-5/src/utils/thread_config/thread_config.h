@@ -0,0 +1,96 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Linux scheduling policy of a thread.
+ */
+enum class SchedulingPolicy
+{
+    INHERIT,  ///< Leave the policy and priority as they are
+    OTHER,    ///< SCHED_OTHER, the normal time-shared policy
+    FIFO      ///< SCHED_FIFO, real-time: runs until it blocks or a higher priority thread is ready
+};
+
+/**
+ * @brief Name, scheduling policy and CPU set of a thread.
+ *
+ * The modules apply it to their thread when it starts (see
+ * LidarModule::setThreadConfig()), the apps apply one to the control loop
+ * with applyThreadConfig().
+ */
+struct ThreadConfig {
+    std::string name;                                     ///< Shown by top/htop, at most 15 characters. Empty keeps the name
+    SchedulingPolicy policy = SchedulingPolicy::INHERIT;  ///< Scheduling policy
+    int priority = 0;                                     ///< SCHED_FIFO priority, 1 (lowest) to 99. Ignored otherwise
+    std::vector<int> cpus;                                ///< CPUs the thread may run on. Empty allows every CPU
+};
+
+/**
+ * @brief Apply a configuration to the calling thread.
+ *
+ * Each part is applied on its own. A part that fails (e.g. SCHED_FIFO
+ * without root or CAP_SYS_NICE) is reported to std::cerr and skipped, and
+ * the thread keeps running with its previous setting.
+ *
+ * @return true if every part was applied.
+ */
+bool applyThreadConfig(const ThreadConfig &config);
+
+/**
+ * @brief Lock every current and future page of the process in RAM (mlockall).
+ *
+ * Stops page faults from stalling a real-time thread, e.g. the first touch
+ * of a freshly allocated buffer. Skipped, with a warning, when the process
+ * may not lock unlimited memory: locking future pages beyond the limit would
+ * make later allocations fail.
+ *
+ * @return true if the memory is locked.
+ */
+bool lockProcessMemory();
+
+/**
+ * @brief Interval statistics of a periodic thread, in milliseconds.
+ */
+struct JitterStats {
+    uint64_t intervals = 0;  ///< Number of intervals measured
+    double mean_ms = 0.0;    ///< Mean interval
+    double stddev_ms = 0.0;  ///< Standard deviation of the interval, the jitter
+    double min_ms = 0.0;     ///< Shortest interval
+    double max_ms = 0.0;     ///< Longest interval
+};
+
+/**
+ * @brief Measures how regularly a loop runs.
+ *
+ * The loop's thread calls mark() once per iteration, and any thread may
+ * read stats(). A thread that gets its CPU late shows up as a wider spread
+ * of intervals, so this reports the scheduling jitter the thread actually
+ * sees, whatever it waits on (a sleep, a device, a condition variable).
+ */
+class JitterMeter
+{
+public:
+    /**
+     * @brief Record the start of an iteration.
+     */
+    void mark();
+
+    /**
+     * @brief Intervals between the marks so far.
+     */
+    JitterStats stats() const;
+
+private:
+    mutable std::mutex mutex_;  ///< Only contended while stats() runs
+    std::optional<std::chrono::steady_clock::time_point> last_;
+    uint64_t count_ = 0;
+    double mean_ms_ = 0.0;
+    double m2_ = 0.0;  ///< Sum of squared deviations from the mean (Welford)
+    double min_ms_ = 0.0;
+    double max_ms_ = 0.0;
+};
@@ -0,0 +1,197 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief A fixed-size pool of worker threads executing submitted tasks in FIFO order.
+ *
+ * Each submitted callable returns a `std::future` for its result. Tasks must
+ * not block waiting on other tasks of the same pool; ordering between results
+ * is left to the caller (e.g. by keeping the futures in submission order).
+ *
+ * Queued tasks are kept in a circular buffer that only grows when it is full,
+ * so once it is large enough (see reserve()), post() does not allocate for
+ * tasks that fit in std::function's small buffer.
+ *
+ * **Example usage:**
+ * @code
+ * ThreadPool pool;                                   // one thread per core
+ * auto square = pool.submit([](int x) { return x * x; }, 7);
+ * int result = square.get();                         // 49
+ * @endcode
+ */
+class ThreadPool
+{
+public:
+    /**
+     * @brief Start the worker threads.
+     * @param threadCount Number of workers. 0 uses std::thread::hardware_concurrency().
+     * @param onWorkerStart Called on each worker, with its index, before it takes any task. Workers
+     *                      otherwise inherit the scheduling of the constructing thread, so this is
+     *                      where to apply their own ThreadConfig.
+     */
+    explicit ThreadPool(size_t threadCount = 0, std::function<void(size_t)> onWorkerStart = nullptr);
+
+    /**
+     * @brief Finish every queued task, then join the workers.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @brief Queue a task.
+     *
+     * @param function Callable to run on a worker thread.
+     * @param args Arguments, copied or moved into the task.
+     * @return A future that receives the result, or the exception thrown by the task.
+     */
+    template <typename Function, typename... Args>
+    auto submit(Function &&function, Args &&...args) -> std::future<std::invoke_result_t<std::decay_t<Function>, std::decay_t<Args>...>>;
+
+    /**
+     * @brief Queue a task without a future, for callers that track completion themselves (e.g. `TaskGraph`).
+     *
+     * Nothing catches exceptions thrown by @p task, so it must not throw.
+     */
+    void post(std::function<void()> task);
+
+    /**
+     * @brief Make room for @p taskCount queued tasks, so queuing that many does not allocate.
+     */
+    void reserve(size_t taskCount);
+
+    /**
+     * @brief Number of worker threads.
+     */
+    size_t size() const;
+
+private:
+    void workerLoop(size_t worker);
+
+    /**
+     * @brief Append a task to the queue. Called with mutex_ held.
+     */
+    void enqueue(std::function<void()> &&task);
+
+    /**
+     * @brief Move the queued tasks into a buffer of @p capacity slots, oldest first. Called with mutex_ held.
+     */
+    void grow(size_t capacity);
+
+    std::function<void(size_t)> onWorkerStart_;
+    std::vector<std::thread> workers_;
+    std::vector<std::function<void()>> tasks_;  ///< Circular queue; its size is the capacity
+    size_t head_ = 0;                           ///< Slot of the oldest queued task
+    size_t queued_ = 0;                         ///< Number of queued tasks
+    std::mutex mutex_;
+    std::condition_variable taskAvailable_;
+    bool stopping_ = false;
+};
+
+// ===== Definitions =====
+
+inline ThreadPool::ThreadPool(size_t threadCount, std::function<void(size_t)> onWorkerStart)
+    : onWorkerStart_(std::move(onWorkerStart))
+    , tasks_(16) {
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    workers_.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+inline ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    taskAvailable_.notify_all();
+
+    for (auto &worker : workers_) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+template <typename Function, typename... Args>
+auto ThreadPool::submit(Function &&function, Args &&...args)
+    -> std::future<std::invoke_result_t<std::decay_t<Function>, std::decay_t<Args>...>> {
+    using Result = std::invoke_result_t<std::decay_t<Function>, std::decay_t<Args>...>;
+
+    // std::function needs a copyable target, so the packaged_task lives behind a shared_ptr
+    auto task = std::make_shared<std::packaged_task<Result()>>(
+        [function = std::forward<Function>(function), argsTuple = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+            return std::apply(std::move(function), std::move(argsTuple));
+        }
+    );
+    std::future<Result> result = task->get_future();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        enqueue([task] { (*task)(); });
+    }
+    taskAvailable_.notify_one();
+    return result;
+}
+
+inline void ThreadPool::post(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        enqueue(std::move(task));
+    }
+    taskAvailable_.notify_one();
+}
+
+inline void ThreadPool::reserve(size_t taskCount) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (taskCount > tasks_.size()) grow(taskCount);
+}
+
+inline void ThreadPool::enqueue(std::function<void()> &&task) {
+    if (queued_ == tasks_.size()) grow(tasks_.size() * 2);
+    tasks_[(head_ + queued_) % tasks_.size()] = std::move(task);
+    ++queued_;
+}
+
+inline void ThreadPool::grow(size_t capacity) {
+    std::vector<std::function<void()>> tasks(capacity);
+    for (size_t i = 0; i < queued_; ++i) {
+        tasks[i] = std::move(tasks_[(head_ + i) % tasks_.size()]);
+    }
+    tasks_ = std::move(tasks);
+    head_ = 0;
+}
+
+inline size_t ThreadPool::size() const {
+    return workers_.size();
+}
+
+inline void ThreadPool::workerLoop(size_t worker) {
+    if (onWorkerStart_) onWorkerStart_(worker);
+
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            taskAvailable_.wait(lock, [this] { return stopping_ || queued_ > 0; });
+            if (queued_ == 0) return;  // Stopping and fully drained
+
+            task = std::move(tasks_[head_]);
+            tasks_[head_] = nullptr;  // Releases the slot's captures now rather than when it is reused
+            head_ = (head_ + 1) % tasks_.size();
+            --queued_;
+        }
+        task();
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+
+/**
+ * @brief Heap use of a TickArena beyond its buffer.
+ */
+struct TickArenaStats {
+    size_t capacity = 0;         ///< Size of the arena's own buffer
+    uint64_t overflows = 0;      ///< Blocks taken from the heap because the buffer was full, since construction
+    uint64_t overflowBytes = 0;  ///< Bytes of those blocks
+};
+
+/**
+ * @brief A fixed buffer handed out by a monotonic std::pmr resource and reclaimed all at once, once per tick.
+ *
+ * Allocating from the arena is a pointer bump and freeing does nothing, so
+ * the temporary containers of a tick (points, segments, clusters) neither
+ * call malloc nor fragment the heap, and they sit next to each other in the
+ * same few pages. reset() makes the whole buffer available again.
+ *
+ * When the buffer is full the arena falls back to operator new in growing
+ * blocks, which are freed by the next reset(). The fallback is counted in
+ * stats(); a capacity large enough for the busiest tick keeps it at zero.
+ *
+ * Not thread-safe: use one arena per thread (or per TaskGraph node) that
+ * allocates at the same time.
+ *
+ * **Example usage:**
+ * @code
+ * TickArena arena(64 * 1024);
+ *
+ * while (running) {
+ *     arena.reset();
+ *     std::pmr::vector<LineSegment> lines = lidar_processor::getLines(scan, deltaPose, arena.resource());
+ * }  // lines is destroyed before the next reset()
+ * @endcode
+ */
+class TickArena
+{
+public:
+    /**
+     * @brief Construct an arena.
+     * @param capacity Size of the buffer, allocated once here.
+     */
+    explicit TickArena(size_t capacity);
+
+    TickArena(const TickArena &) = delete;
+    TickArena &operator=(const TickArena &) = delete;
+
+    /**
+     * @brief Memory resource to pass to std::pmr containers and the allocator-aware processor overloads.
+     */
+    std::pmr::memory_resource *resource();
+
+    /**
+     * @brief Reclaim everything allocated since the last reset.
+     *
+     * Containers allocated from the arena must be destroyed, or emptied by
+     * assigning them a new empty container with the same allocator, before
+     * calling it.
+     */
+    void reset();
+
+    /**
+     * @brief Buffer size and the heap fallback so far.
+     */
+    TickArenaStats stats() const;
+
+private:
+    /**
+     * @brief Upstream of the monotonic resource, which only sees the blocks that did not fit in the buffer.
+     */
+    class OverflowResource : public std::pmr::memory_resource
+    {
+    public:
+        uint64_t overflows = 0;
+        uint64_t overflowBytes = 0;
+
+    private:
+        void *do_allocate(size_t bytes, size_t alignment) override;
+        void do_deallocate(void *pointer, size_t bytes, size_t alignment) override;
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override;
+    };
+
+    size_t capacity_;
+    std::unique_ptr<std::byte[]> buffer_;
+    OverflowResource overflow_;
+    std::pmr::monotonic_buffer_resource arena_;
+};
+
+// ===== Definitions =====
+
+inline TickArena::TickArena(size_t capacity)
+    : capacity_(capacity)
+    , buffer_(std::make_unique<std::byte[]>(capacity))
+    , arena_(buffer_.get(), capacity, &overflow_) {}
+
+inline std::pmr::memory_resource *TickArena::resource() {
+    return &arena_;
+}
+
+inline void TickArena::reset() {
+    // Frees the overflow blocks and starts again at the beginning of the buffer
+    arena_.release();
+}
+
+inline TickArenaStats TickArena::stats() const {
+    return {capacity_, overflow_.overflows, overflow_.overflowBytes};
+}
+
+inline void *TickArena::OverflowResource::do_allocate(size_t bytes, size_t alignment) {
+    overflows++;
+    overflowBytes += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+inline void TickArena::OverflowResource::do_deallocate(void *pointer, size_t bytes, size_t alignment) {
+    std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+}
+
+inline bool TickArena::OverflowResource::do_is_equal(const std::pmr::memory_resource &other) const noexcept {
+    return this == &other;
+}
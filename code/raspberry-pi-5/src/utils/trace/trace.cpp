@@ -0,0 +1,353 @@
+#include "trace.h"
+
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace trace
+{
+
+namespace
+{
+
+enum class EventType : uint8_t
+{
+    BEGIN,
+    END,
+    INSTANT,
+    COUNTER
+};
+
+struct Event {
+    int64_t timestamp_ns;  ///< steady_clock time since its epoch
+    const char *name;
+    double value;  ///< Counter value, unused otherwise
+    EventType type;
+};
+
+/**
+ * @brief Event ring of one thread: only that thread pushes, only the drain thread pops.
+ */
+class EventRing
+{
+public:
+    EventRing(size_t capacity, std::string threadName, long tid)
+        : mask_(capacity - 1)
+        , events_(std::make_unique<Event[]>(capacity))
+        , threadName_(std::move(threadName))
+        , tid_(tid) {}
+
+    /**
+     * @brief Add an event, or count it as dropped if the ring is full. Owning thread only.
+     */
+    void push(const Event &event) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) > mask_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        events_[head & mask_] = event;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Call @p visitor on every event pushed so far, oldest first, and free their slots. Drain thread only.
+     */
+    template <typename Visitor>
+    void drain(Visitor &&visitor) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t head = head_.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+            visitor(events_[tail & mask_]);
+        }
+        tail_.store(tail, std::memory_order_release);
+    }
+
+    uint64_t dropped() const {
+        return dropped_.load(std::memory_order_relaxed);
+    }
+
+    const std::string &threadName() const {
+        return threadName_;
+    }
+
+    long tid() const {
+        return tid_;
+    }
+
+    /**
+     * @brief Names of the spans written as begun but not yet ended, innermost last. Drain thread only.
+     */
+    std::vector<const char *> &openSpans() {
+        return openSpans_;
+    }
+
+private:
+    size_t mask_;
+    std::unique_ptr<Event[]> events_;
+
+    alignas(64) std::atomic<uint64_t> head_{0};  ///< Next slot to write, advanced by the owning thread
+    alignas(64) std::atomic<uint64_t> tail_{0};  ///< Next slot to read, advanced by the drain thread
+    std::atomic<uint64_t> dropped_{0};
+
+    std::string threadName_;
+    long tid_;  ///< Kernel thread id, as shown by top -H
+    std::vector<const char *> openSpans_;
+};
+
+size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+void writeEscaped(std::ostream &out, const char *text) {
+    for (const char *c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out << '\\' << *c;
+        } else if (static_cast<unsigned char>(*c) >= 0x20) {
+            out << *c;
+        }
+    }
+}
+
+/**
+ * @brief Microseconds with nanosecond digits, without going through a double.
+ */
+void writeTimestamp(std::ostream &out, int64_t timestamp_ns) {
+    out << timestamp_ns / 1000 << '.' << std::setw(3) << std::setfill('0') << timestamp_ns % 1000;
+}
+
+class Session
+{
+public:
+    ~Session() {
+        finish();
+    }
+
+    bool begin(const std::string &path, size_t eventsPerThread, std::chrono::milliseconds drainInterval) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (started_) {
+            std::cerr << "[Trace] Tracing can only be started once per process." << std::endl;
+            return false;
+        }
+
+        file_.open(path, std::ios::trunc);
+        if (!file_) {
+            std::cerr << "[Trace] Failed to open " << path << std::endl;
+            return false;
+        }
+        file_ << "[\n";
+
+        eventsPerThread_ = roundUpToPowerOfTwo(std::max<size_t>(eventsPerThread, 2));
+        drainInterval_ = drainInterval;
+        pid_ = getpid();
+        started_ = true;
+        enabled_.store(true, std::memory_order_release);
+        drainThread_ = std::thread(&Session::drainLoop, this);
+        return true;
+    }
+
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!started_ || stopping_) return;
+            enabled_.store(false, std::memory_order_release);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        drainThread_.join();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        closeOpenSpans();
+        file_ << "\n]\n";
+        file_.close();
+    }
+
+    bool enabled() const {
+        return enabled_.load(std::memory_order_relaxed);
+    }
+
+    EventRing *registerThread(const std::string &name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!started_ || stopping_) return nullptr;
+
+        std::string threadName = name;
+        if (threadName.empty()) {
+            char buffer[16] = {};
+            pthread_getname_np(pthread_self(), buffer, sizeof(buffer));
+            threadName = buffer;
+        }
+
+        rings_.push_back(std::make_unique<EventRing>(eventsPerThread_, threadName, static_cast<long>(syscall(SYS_gettid))));
+        EventRing &ring = *rings_.back();
+
+        writeSeparator();
+        file_ << R"({"name":"thread_name","ph":"M","pid":)" << pid_ << R"(,"tid":)" << ring.tid() << R"(,"args":{"name":")";
+        writeEscaped(file_, ring.threadName().c_str());
+        file_ << R"("}})";
+        return &ring;
+    }
+
+    TraceStats stats() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        TraceStats stats;
+        stats.events = written_;
+        stats.threads = rings_.size();
+        for (const auto &ring : rings_) {
+            stats.dropped += ring->dropped();
+        }
+        return stats;
+    }
+
+private:
+    void drainLoop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        // Drains once more after stop(), even if it came before the first drain
+        bool stopping = false;
+        while (!stopping) {
+            wake_.wait_for(lock, drainInterval_, [this] { return stopping_; });
+            stopping = stopping_;
+            for (const auto &ring : rings_) {
+                ring->drain([&](const Event &event) { writeEvent(*ring, event); });
+            }
+            file_.flush();
+        }
+    }
+
+    /**
+     * @brief End the spans still open once recording has stopped, at the current time.
+     *
+     * Their own end() comes after recording stopped and is never recorded, so
+     * without this the viewers would show them as running to the end of time.
+     */
+    void closeOpenSpans() {
+        int64_t timestamp_ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+        for (const auto &ring : rings_) {
+            while (!ring->openSpans().empty()) {
+                writeEvent(*ring, {timestamp_ns, ring->openSpans().back(), 0.0, EventType::END});
+            }
+        }
+    }
+
+    void writeSeparator() {
+        if (!firstRecord_) file_ << ",\n";
+        firstRecord_ = false;
+    }
+
+    void writeEvent(EventRing &ring, const Event &event) {
+        static const char *const PHASES[] = {"B", "E", "i", "C"};
+
+        if (event.type == EventType::BEGIN) {
+            ring.openSpans().push_back(event.name);
+        } else if (event.type == EventType::END && !ring.openSpans().empty()) {
+            ring.openSpans().pop_back();
+        }
+
+        writeSeparator();
+        file_ << R"({"name":")";
+        writeEscaped(file_, event.name);
+        file_ << R"(","ph":")" << PHASES[static_cast<size_t>(event.type)] << R"(","ts":)";
+        writeTimestamp(file_, event.timestamp_ns);
+        file_ << R"(,"pid":)" << pid_ << R"(,"tid":)" << ring.tid();
+        if (event.type == EventType::INSTANT) file_ << R"(,"s":"t")";
+        if (event.type == EventType::COUNTER) file_ << R"(,"args":{"value":)" << event.value << '}';
+        file_ << '}';
+        ++written_;
+    }
+
+    std::atomic<bool> enabled_{false};
+
+    std::mutex mutex_;  ///< Guards everything below; never taken to record an event
+    std::condition_variable wake_;
+    bool started_ = false;
+    bool stopping_ = false;
+    std::vector<std::unique_ptr<EventRing>> rings_;  ///< Kept until exit, since threads keep pointers to them
+    std::ofstream file_;
+    bool firstRecord_ = true;
+    uint64_t written_ = 0;
+    size_t eventsPerThread_ = 0;
+    std::chrono::milliseconds drainInterval_{0};
+    int pid_ = 0;
+    std::thread drainThread_;
+};
+
+Session &session() {
+    static Session instance;
+    return instance;
+}
+
+thread_local EventRing *threadRing = nullptr;
+
+void record(EventType type, const char *name, double value) {
+    Session &current = session();
+    if (!current.enabled()) return;
+    if (!threadRing) threadRing = current.registerThread("");
+    if (!threadRing) return;
+
+    int64_t timestamp_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    threadRing->push({timestamp_ns, name, value, type});
+}
+
+}  // namespace
+
+bool start(const std::string &path, size_t eventsPerThread, std::chrono::milliseconds drainInterval) {
+    return session().begin(path, eventsPerThread, drainInterval);
+}
+
+void stop() {
+    session().finish();
+}
+
+bool enabled() {
+    return session().enabled();
+}
+
+void registerThread(const std::string &name) {
+    if (!threadRing) threadRing = session().registerThread(name);
+}
+
+void begin(const char *name) {
+    record(EventType::BEGIN, name, 0.0);
+}
+
+void end(const char *name) {
+    record(EventType::END, name, 0.0);
+}
+
+void instant(const char *name) {
+    record(EventType::INSTANT, name, 0.0);
+}
+
+void counter(const char *name, double value) {
+    record(EventType::COUNTER, name, value);
+}
+
+TraceStats stats() {
+    return session().stats();
+}
+
+ScopedTrace::ScopedTrace(const char *name)
+    : name_(name)
+    , active_(enabled()) {
+    if (active_) begin(name_);
+}
+
+ScopedTrace::~ScopedTrace() {
+    if (active_) end(name_);
+}
+
+}  // namespace trace
@@ -0,0 +1,135 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief A timeline of what every thread of the robot does, exported as a Chrome trace.
+ *
+ * Each thread records begin/end spans, instants and counters into its own
+ * lock-free ring; a drain thread moves them into a Chrome trace file (JSON
+ * array format) that chrome://tracing and ui.perfetto.dev open. Where the
+ * aggregate histograms of StageProfiler or PeriodicExecutor show how long
+ * things take, the timeline shows how the sensor threads, the logger writers
+ * and the control loop interleave: contention, idle gaps, late wake-ups.
+ *
+ * Recording never locks and never allocates once the thread's ring exists,
+ * and costs a single atomic load while tracing is off, so the trace points
+ * can stay in the code. A thread whose ring is full drops its new events
+ * until the next drain, and the drops are counted.
+ *
+ * Event names must outlive the trace (string literals, or strings that are
+ * kept until stop()); only their address is recorded. Timestamps are
+ * steady_clock, the clock of the log records, so the trace lines up with
+ * the .bin logs of the same run.
+ *
+ * **Example usage:**
+ * @code
+ * trace::start(logFolder + "/trace.json");
+ *
+ * // In a thread
+ * trace::registerThread("lidar");  // optional: allocates the ring up front
+ * {
+ *     trace::ScopedTrace span("grabScan");
+ *     grabScan();
+ * }
+ * trace::counter("scan nodes", count);
+ *
+ * trace::stop();
+ * @endcode
+ */
+namespace trace
+{
+
+/**
+ * @brief Totals of a trace session.
+ */
+struct TraceStats {
+    uint64_t events = 0;   ///< Events written to the trace file
+    uint64_t dropped = 0;  ///< Events lost to a full ring
+    size_t threads = 0;    ///< Threads that recorded events
+};
+
+/**
+ * @brief Start tracing to a Chrome trace file. Only one session per process.
+ *
+ * Call it before starting the threads to trace, and before the calling thread
+ * gets a real-time configuration, since the drain thread inherits it.
+ *
+ * @param path Output file, usually trace.json in the run's log folder.
+ * @param eventsPerThread Ring capacity of each thread, rounded up to a power of two.
+ * @param drainInterval How often the drain thread empties the rings.
+ * @return false if the file cannot be opened or tracing was already started.
+ */
+bool start(
+    const std::string &path,
+    size_t eventsPerThread = 8192,
+    std::chrono::milliseconds drainInterval = std::chrono::milliseconds(100)
+);
+
+/**
+ * @brief Stop recording, drain the remaining events and close the file.
+ *
+ * Spans still open are ended at this point in the file, since their end()
+ * comes too late to be recorded.
+ */
+void stop();
+
+/**
+ * @brief True between start() and stop().
+ */
+bool enabled();
+
+/**
+ * @brief Allocate the calling thread's ring now instead of at its first event, and name its track.
+ *
+ * Does nothing while tracing is off or if the thread already has a ring.
+ *
+ * @param name Track name. Empty uses the thread's name (see applyThreadConfig()).
+ */
+void registerThread(const std::string &name = "");
+
+/**
+ * @brief Open a span on the calling thread. Spans nest and must be closed by end() on the same thread.
+ */
+void begin(const char *name);
+
+/**
+ * @brief Close the innermost open span of the calling thread.
+ */
+void end(const char *name);
+
+/**
+ * @brief Mark a point in time, such as a scan arriving.
+ */
+void instant(const char *name);
+
+/**
+ * @brief Set the value of a counter track.
+ */
+void counter(const char *name, double value);
+
+/**
+ * @brief Events written, events dropped and threads seen so far.
+ */
+TraceStats stats();
+
+/**
+ * @brief A span from its construction to its destruction.
+ */
+class ScopedTrace
+{
+public:
+    explicit ScopedTrace(const char *name);
+    ~ScopedTrace();
+
+    ScopedTrace(const ScopedTrace &) = delete;
+    ScopedTrace &operator=(const ScopedTrace &) = delete;
+
+private:
+    const char *name_;
+    bool active_;  ///< Whether begin() was recorded, so a span opened before start() writes no unmatched end
+};
+
+}  // namespace trace
@@ -0,0 +1,84 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
+/**
+ * @brief Wakes threads waiting for new data, e.g. a consumer waiting for the next sensor sample.
+ *
+ * Producers call notify() after publishing new data; waiters block until a
+ * predicate over that data holds. The data itself is not guarded by the
+ * signal (the sensor buffers are lock-free), the mutex only makes sure a
+ * notification cannot slip in between a waiter checking its predicate and
+ * going to sleep.
+ *
+ * One signal can be shared by several producers, so a consumer can wait for
+ * whichever of them publishes first.
+ *
+ * **Example usage:**
+ * @code
+ * UpdateSignal signal;
+ * buffer.push(sample);  // producer
+ * signal.notify();
+ *
+ * signal.waitFor(std::chrono::milliseconds(50), [&] { return buffer.sequence() > seen; });  // consumer
+ * @endcode
+ */
+class UpdateSignal
+{
+public:
+    /**
+     * @brief Wake every waiter so it re-checks its predicate.
+     */
+    void notify();
+
+    /**
+     * @brief Block until @p ready returns true.
+     */
+    template <typename Predicate>
+    void wait(Predicate &&ready);
+
+    /**
+     * @brief Block until @p ready returns true or @p deadline passes.
+     * @return The last result of @p ready.
+     */
+    template <typename Clock, typename Duration, typename Predicate>
+    bool waitUntil(const std::chrono::time_point<Clock, Duration> &deadline, Predicate &&ready);
+
+    /**
+     * @brief Block until @p ready returns true or @p timeout elapses.
+     * @return The last result of @p ready.
+     */
+    template <typename Rep, typename Period, typename Predicate>
+    bool waitFor(const std::chrono::duration<Rep, Period> &timeout, Predicate &&ready);
+
+private:
+    std::mutex mutex_;
+    std::condition_variable updated_;
+};
+
+// ===== Definitions =====
+
+inline void UpdateSignal::notify() {
+    // Taking the lock orders this notification after any waiter's predicate check
+    std::lock_guard<std::mutex> lock(mutex_);
+    updated_.notify_all();
+}
+
+template <typename Predicate>
+void UpdateSignal::wait(Predicate &&ready) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    updated_.wait(lock, std::forward<Predicate>(ready));
+}
+
+template <typename Clock, typename Duration, typename Predicate>
+bool UpdateSignal::waitUntil(const std::chrono::time_point<Clock, Duration> &deadline, Predicate &&ready) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return updated_.wait_until(lock, deadline, std::forward<Predicate>(ready));
+}
+
+template <typename Rep, typename Period, typename Predicate>
+bool UpdateSignal::waitFor(const std::chrono::duration<Rep, Period> &timeout, Predicate &&ready) {
+    return waitUntil(std::chrono::steady_clock::now() + timeout, std::forward<Predicate>(ready));
+}